@@ -106,6 +106,9 @@ private:
     error_code ec_;
     std::atomic<bool> ecb_;         // `true` when ec_ set
 
+    std::uint64_t flushWanted_ = 0; // flush requests made
+    std::uint64_t flushDone_ = 0;   // flush requests committed
+
     std::size_t dataWriteSize_;
     std::size_t logWriteSize_;
 
@@ -401,6 +404,26 @@ public:
     insert(void const* key, void const* data,
         nsize_t bytes, error_code& ec);
 
+    /** Commit the inserted data.
+
+        This function blocks until all data inserted before
+        the call is written and synced to the data and key
+        files, instead of waiting for the periodic commit.
+
+        @par Requirements
+
+        The database must be open.
+
+        @par Thread safety
+
+        Safe to call concurrently with any function
+        except @ref close.
+
+        @param ec Set to the error, if any occurred.
+    */
+    void
+    flush(error_code& ec);
+
 private:
     template<class Callback>
     void
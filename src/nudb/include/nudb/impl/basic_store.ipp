@@ -341,6 +341,24 @@ insert(
         std::this_thread::sleep_for(milliseconds{25});
 }
 
+template<class Hasher, class File>
+void
+basic_store<Hasher, File>::
+flush(error_code& ec)
+{
+    using namespace detail;
+    BOOST_ASSERT(is_open());
+    unique_lock_type m{m_};
+    // The commit thread does the work, so
+    // commits are never run concurrently
+    auto const wanted = ++flushWanted_;
+    cv_.notify_all();
+    cv_.wait(m,
+        [&]{ return flushDone_ >= wanted || ecb_; });
+    if(ecb_)
+        ec = ec_;
+}
+
 // Fetch key in loaded bucket b or its spills.
 //
 template<class Hasher, class File>
@@ -744,13 +762,17 @@ run()
     for(;;)
     {
         unique_lock_type m{m_};
+        auto const wanted = flushWanted_;
         if(! s_->p1.empty())
         {
             std::size_t work;
             commit(m, work, ec_);
             if(ec_)
             {
+                if(! m.owns_lock())
+                    m.lock();
                 ecb_.store(true);
+                cv_.notify_all();
                 return;
             }
             BOOST_ASSERT(m.owns_lock());
@@ -767,10 +789,15 @@ run()
                 "\n";
         #endif
         }
+        if(flushDone_ != wanted)
+        {
+            flushDone_ = wanted;
+            cv_.notify_all();
+        }
         s_->p1.periodic_activity();
 
         cv_.wait_until(m, s_->when + seconds{1},
-            [this]{ return ! open_; });
+            [this]{ return ! open_ || flushWanted_ != flushDone_; });
         if(! open_)
             break;
         s_->when = clock_type::now();
@@ -145,7 +145,8 @@ RCLConsensus::relay(RCLCxPeerPos const& peerPos)
     auto const sig = peerPos.getSignature();
     prop.set_signature(sig.data(), sig.size());
 
-    app_.overlay().relay(prop, peerPos.getSuppressionID());
+    app_.overlay().relay(prop, peerPos.getSuppressionID(),
+        peerPos.getPublicKey());
 }
 
 void
@@ -305,8 +306,8 @@ RCLConsensus::onClose(
     {
         Serializer s(2048);
         tx.first->add(s);
-        initialSet->addItem(
-            SHAMapItem(tx.first->getTransactionID(), std::move(s)),
+        initialSet->addGiveItem(
+            make_shamapitem(tx.first->getTransactionID(), s.slice()),
             true,
             false);
     }
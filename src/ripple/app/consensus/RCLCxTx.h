@@ -90,8 +90,8 @@ public:
         bool
         insert(Tx const& t)
         {
-            return map_->addItem(
-                SHAMapItem{t.id(), t.tx_.peekData()}, true, false);
+            return map_->addGiveItem(
+                make_shamapitem(t.id(), t.tx_.slice()), true, false);
         }
 
         /** Remove a transaction from the set.
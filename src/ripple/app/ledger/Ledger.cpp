@@ -21,6 +21,7 @@
 #include <ripple/app/ledger/Ledger.h>
 #include <ripple/app/ledger/AcceptedLedger.h>
 #include <ripple/app/ledger/InboundLedgers.h>
+#include <ripple/app/ledger/LedgerSaver.h>
 #include <ripple/app/ledger/LedgerMaster.h>
 #include <ripple/consensus/LedgerTiming.h>
 #include <ripple/app/ledger/LedgerToJson.h>
@@ -546,9 +547,8 @@ Ledger::rawInsert(std::shared_ptr<SLE> const& sle)
 {
     Serializer ss;
     sle->add(ss);
-    auto item = std::make_shared<
-        SHAMapItem const>(sle->key(),
-            std::move(ss));
+    auto item = make_shamapitem(
+        sle->key(), ss.slice());
     // VFALCO NOTE addGiveItem should take ownership
     if (! stateMap_->addGiveItem(
             std::move(item), false, false))
@@ -560,9 +560,8 @@ Ledger::rawReplace(std::shared_ptr<SLE> const& sle)
 {
     Serializer ss;
     sle->add(ss);
-    auto item = std::make_shared<
-        SHAMapItem const>(sle->key(),
-            std::move(ss));
+    auto item = make_shamapitem(
+        sle->key(), ss.slice());
     // VFALCO NOTE updateGiveItem should take ownership
     if (! stateMap_->updateGiveItem(
             std::move(item), false, false))
@@ -582,8 +581,7 @@ Ledger::rawTxInsert (uint256 const& key,
         metaData->getDataLength () + 16);
     s.addVL (txn->peekData ());
     s.addVL (metaData->peekData ());
-    auto item = std::make_shared<
-        SHAMapItem const> (key, std::move(s));
+    auto item = make_shamapitem (key, s.slice());
     if (! txMap().addGiveItem
             (std::move(item), true, true))
         LogicError("duplicate_tx: " + to_string(key));
@@ -799,7 +797,8 @@ void Ledger::updateSkipList ()
 static bool saveValidatedLedger (
     Application& app,
     std::shared_ptr<Ledger const> const& ledger,
-    bool current)
+    bool current,
+    bool synchronous)
 {
     auto j = app.journal ("Ledger");
 
@@ -810,18 +809,9 @@ static bool saveValidatedLedger (
         return true;
     }
 
-    // TODO(tom): Fix this hard-coded SQL!
     JLOG (j.trace())
         << "saveValidatedLedger "
         << (current ? "" : "fromAcquire ") << ledger->info().seq;
-    static boost::format deleteLedger (
-        "DELETE FROM Ledgers WHERE LedgerSeq = %u;");
-    static boost::format deleteTrans1 (
-        "DELETE FROM Transactions WHERE LedgerSeq = %u;");
-    static boost::format deleteTrans2 (
-        "DELETE FROM AccountTransactions WHERE LedgerSeq = %u;");
-    static boost::format deleteAcctTrans (
-        "DELETE FROM AccountTransactions WHERE TransID = '%s';");
 
     auto seq = ledger->info().seq;
 
@@ -873,141 +863,26 @@ static bool saveValidatedLedger (
         return false;
     }
 
+    for (auto const& vt : aLedger->getMap ())
     {
-        auto db = app.getLedgerDB ().checkoutDb();
-        *db << boost::str (deleteLedger % seq);
-    }
-
-    {
-        auto db = app.getTxnDB ().checkoutDb ();
-
-        soci::transaction tr(*db);
-
-        *db << boost::str (deleteTrans1 % seq);
-        *db << boost::str (deleteTrans2 % seq);
+        app.getMasterTransaction ().inLedger (
+            vt.second->getTransactionID (), seq);
 
-        std::string const ledgerSeq (std::to_string (seq));
-
-        for (auto const& vt : aLedger->getMap ())
+        if (vt.second->getAffected ().empty ())
         {
-            uint256 transactionID = vt.second->getTransactionID ();
-
-            app.getMasterTransaction ().inLedger (
-                transactionID, seq);
-
-            std::string const txnId (to_string (transactionID));
-            std::string const txnSeq (std::to_string (vt.second->getTxnSeq ()));
-
-            *db << boost::str (deleteAcctTrans % transactionID);
-
-            auto const& accts = vt.second->getAffected ();
-
-            if (!accts.empty ())
-            {
-                std::string sql (
-                    "INSERT INTO AccountTransactions "
-                    "(TransID, Account, LedgerSeq, TxnSeq) VALUES ");
-
-                // Try to make an educated guess on how much space we'll need
-                // for our arguments. In argument order we have:
-                // 64 + 34 + 10 + 10 = 118 + 10 extra = 128 bytes
-                sql.reserve (sql.length () + (accts.size () * 128));
-
-                bool first = true;
-                for (auto const& account : accts)
-                {
-                    if (!first)
-                        sql += ", ('";
-                    else
-                    {
-                        sql += "('";
-                        first = false;
-                    }
-
-                    sql += txnId;
-                    sql += "','";
-                    sql += app.accountIDCache().toBase58(account);
-                    sql += "',";
-                    sql += ledgerSeq;
-                    sql += ",";
-                    sql += txnSeq;
-                    sql += ")";
-                }
-                sql += ";";
-                JLOG (j.trace()) << "ActTx: " << sql;
-                *db << sql;
-            }
-            else
-            {
-                JLOG (j.warn())
-                    << "Transaction in ledger " << seq
-                    << " affects no accounts";
-                JLOG (j.warn())
-                    << vt.second->getTxn()->getJson(0);
-            }
-
-            *db <<
-               (STTx::getMetaSQLInsertReplaceHeader () +
-                vt.second->getTxn ()->getMetaSQL (
-                    seq, vt.second->getEscMeta ()) + ";");
+            JLOG (j.warn())
+                << "Transaction in ledger " << seq
+                << " affects no accounts";
+            JLOG (j.warn())
+                << vt.second->getTxn()->getJson(0);
         }
-
-        tr.commit ();
-    }
-
-    {
-        static std::string addLedger(
-            R"sql(INSERT OR REPLACE INTO Ledgers
-                (LedgerHash,LedgerSeq,PrevHash,TotalCoins,ClosingTime,PrevClosingTime,
-                CloseTimeRes,CloseFlags,AccountSetHash,TransSetHash)
-            VALUES
-                (:ledgerHash,:ledgerSeq,:prevHash,:totalCoins,:closingTime,:prevClosingTime,
-                :closeTimeRes,:closeFlags,:accountSetHash,:transSetHash);)sql");
-        static std::string updateVal(
-            R"sql(UPDATE Validations SET LedgerSeq = :ledgerSeq, InitialSeq = :initialSeq
-                WHERE LedgerHash = :ledgerHash;)sql");
-
-        auto db (app.getLedgerDB ().checkoutDb ());
-
-        soci::transaction tr(*db);
-
-        auto const hash = to_string (ledger->info().hash);
-        auto const parentHash = to_string (ledger->info().parentHash);
-        auto const drops = to_string (ledger->info().drops);
-        auto const closeTime =
-            ledger->info().closeTime.time_since_epoch().count();
-        auto const parentCloseTime =
-            ledger->info().parentCloseTime.time_since_epoch().count();
-        auto const closeTimeResolution =
-            ledger->info().closeTimeResolution.count();
-        auto const closeFlags = ledger->info().closeFlags;
-        auto const accountHash = to_string (ledger->info().accountHash);
-        auto const txHash = to_string (ledger->info().txHash);
-
-        *db << addLedger,
-            soci::use(hash),
-            soci::use(seq),
-            soci::use(parentHash),
-            soci::use(drops),
-            soci::use(closeTime),
-            soci::use(parentCloseTime),
-            soci::use(closeTimeResolution),
-            soci::use(closeFlags),
-            soci::use(accountHash),
-            soci::use(txHash);
-
-
-        *db << updateVal,
-            soci::use(seq),
-            soci::use(seq),
-            soci::use(hash);
-
-        tr.commit();
     }
 
-    // Clients can now trust the database for
-    // information about this ledger sequence.
-    app.pendingSaves().finishWork(seq);
+    // The pending save is finished once the SQL databases are written,
+    // which may be later, together with other ledgers, unless the
+    // caller needs to wait for it.
+    app.getLedgerSaver ().save (
+        makeSavedLedger (*aLedger, app.accountIDCache ()), synchronous);
     return true;
 }
 
@@ -1049,10 +924,11 @@ bool pendSaveValidated (
     }
 
     if (isSynchronous)
-        return saveValidatedLedger(app, ledger, isCurrent);
+        return saveValidatedLedger(app, ledger, isCurrent, true);
 
+    // Acquired ledgers are written in batches while catching up
     auto job = [ledger, &app, isCurrent] (Job&) {
-        saveValidatedLedger(app, ledger, isCurrent);
+        saveValidatedLedger(app, ledger, isCurrent, isCurrent);
     };
 
     if (isCurrent)
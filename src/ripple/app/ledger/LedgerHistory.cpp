@@ -63,7 +63,7 @@ LedgerHistory::insert(
 
     assert (ledger->stateMap().getHash ().isNonZero ());
 
-    LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
+    std::unique_lock <std::recursive_mutex> sl (mLedgersByIndexMutex);
 
     const bool alreadyHad = m_ledgers_by_hash.canonicalize (
         ledger->info().hash, ledger, true);
@@ -75,7 +75,7 @@ LedgerHistory::insert(
 
 LedgerHash LedgerHistory::getLedgerHash (LedgerIndex index)
 {
-    LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
+    std::unique_lock <std::recursive_mutex> sl (mLedgersByIndexMutex);
     auto it = mLedgersByIndex.find (index);
 
     if (it != mLedgersByIndex.end ())
@@ -88,7 +88,7 @@ std::shared_ptr<Ledger const>
 LedgerHistory::getLedgerBySeq (LedgerIndex index)
 {
     {
-        LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
+        std::unique_lock <std::recursive_mutex> sl (mLedgersByIndexMutex);
         auto it = mLedgersByIndex.find (index);
 
         if (it != mLedgersByIndex.end ())
@@ -108,7 +108,7 @@ LedgerHistory::getLedgerBySeq (LedgerIndex index)
 
     {
         // Add this ledger to the local tracking by index
-        LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
+        std::unique_lock <std::recursive_mutex> sl (mLedgersByIndexMutex);
 
         assert (ret->isImmutable ());
         m_ledgers_by_hash.canonicalize (ret->info().hash, ret);
@@ -390,7 +390,7 @@ void LedgerHistory::handleMismatch (
         }
         else
         {
-            if ((*b)->peekData() != (*v)->peekData())
+            if ((*b)->slice() != (*v)->slice())
             {
                 // Same transaction with different metadata
                 log_metadata_difference(
@@ -415,8 +415,8 @@ void LedgerHistory::builtLedger (
     LedgerHash hash = ledger->info().hash;
     assert (!hash.isZero());
 
-    ConsensusValidated::ScopedLockType sl (
-        m_consensus_validated.peekMutex());
+    std::lock_guard <std::recursive_mutex> sl (
+        m_consensus_validated_mutex);
 
     auto entry = std::make_shared<cv_entry>();
     m_consensus_validated.canonicalize(index, entry, false);
@@ -448,8 +448,8 @@ void LedgerHistory::validatedLedger (
     LedgerHash hash = ledger->info().hash;
     assert (!hash.isZero());
 
-    ConsensusValidated::ScopedLockType sl (
-        m_consensus_validated.peekMutex());
+    std::lock_guard <std::recursive_mutex> sl (
+        m_consensus_validated_mutex);
 
     auto entry = std::make_shared<cv_entry>();
     m_consensus_validated.canonicalize(index, entry, false);
@@ -478,7 +478,7 @@ void LedgerHistory::validatedLedger (
 bool LedgerHistory::fixIndex (
     LedgerIndex ledgerIndex, LedgerHash const& ledgerHash)
 {
-    LedgersByHash::ScopedLockType sl (m_ledgers_by_hash.peekMutex ());
+    std::unique_lock <std::recursive_mutex> sl (mLedgersByIndexMutex);
     auto it = mLedgersByIndex.find (ledgerIndex);
 
     if ((it != mLedgersByIndex.end ()) && (it->second != ledgerHash) )
@@ -26,6 +26,8 @@
 #include <ripple/beast/insight/Collector.h>
 #include <ripple/beast/insight/Event.h>
 
+#include <mutex>
+
 namespace ripple {
 
 // VFALCO TODO Rename to OldLedgers ?
@@ -127,10 +129,16 @@ private:
     using ConsensusValidated = TaggedCache <LedgerIndex, cv_entry>;
     ConsensusValidated m_consensus_validated;
 
+    // Serializes updates to the built and validated hashes of an entry
+    std::recursive_mutex m_consensus_validated_mutex;
+
 
     // Maps ledger indexes to the corresponding hash.
     std::map <LedgerIndex, LedgerHash> mLedgersByIndex; // validated ledgers
 
+    // Guards mLedgersByIndex, and keeps it consistent with the cache
+    std::recursive_mutex mLedgersByIndexMutex;
+
     beast::Journal j_;
 };
 
@@ -252,6 +252,24 @@ private:
         std::shared_ptr<Ledger const> ledger);
 
     void getFetchPack(LedgerHash missingHash, LedgerIndex missingIndex);
+
+    // Queue a job to fill the shard store, if none is queued.
+    void newShardWork();
+
+    // Copy part of the ledger the shard store wants. Runs as a job,
+    // which queues another while there is more to copy.
+    void fetchForShard();
+
+    // Acquire the next ledger the shard store wants, store its header,
+    // and prepare mShardCopy. Returns false if there is nothing to copy.
+    bool startShardCopy(NodeStore::DatabaseShard& shardStore);
+
+    // Copy up to shardNodesPerJob of the nodes of the ledger in
+    // mShardCopy into the shard store, skipping the nodes it shares
+    // with the ledger stored before it. Returns false if the shard
+    // store rejected a node.
+    bool storeShardNodes(
+        NodeStore::DatabaseShard& shardStore, bool& done);
     boost::optional<LedgerHash> getLedgerHashForHistory(LedgerIndex index);
     std::size_t getNeededValidations();
     void advanceThread();
@@ -294,6 +312,21 @@ private:
     // The last ledger we handled fetching history
     std::shared_ptr<Ledger const> mHistLedger;
 
+    // The last ledger we copied into the shard store
+    std::shared_ptr<Ledger const> mShardLedger;
+
+    // A ledger being copied into the shard store, a few
+    // nodes per job. Only the shard job uses it.
+    struct ShardCopy
+    {
+        std::shared_ptr<Ledger const> ledger;
+        // The ledger stored before, whose nodes are skipped
+        std::shared_ptr<Ledger const> next;
+        SHAMap::FetchPackStack stack;
+        bool stateDone = false;
+    };
+    boost::optional<ShardCopy> mShardCopy;
+
     // Fully validated ledger, whether or not we have the ledger resident.
     std::pair <uint256, LedgerIndex> mLastValidLedger;
 
@@ -321,6 +354,7 @@ private:
 
     int     mPathFindThread;    // Pathfinder jobs dispatched
     bool    mPathFindNewRequest;
+    bool    mShardFetching;     // Shard job dispatched
 
     std::atomic <std::uint32_t> mPubLedgerClose;
     std::atomic <std::uint32_t> mPubLedgerSeq;
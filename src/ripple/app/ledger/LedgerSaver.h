@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_LEDGERSAVER_H_INCLUDED
+#define RIPPLE_APP_LEDGER_LEDGERSAVER_H_INCLUDED
+
+#include <ripple/basics/Blob.h>
+#include <ripple/ledger/ReadView.h>
+#include <ripple/protocol/AccountID.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ripple {
+
+class AcceptedLedger;
+class Application;
+class DatabaseCon;
+
+/** The SQL rows that record a validated ledger and its transactions. */
+struct SavedLedger
+{
+    struct Transaction
+    {
+        std::string id;
+        std::string type;
+        std::string account;
+        std::uint32_t sequence = 0;
+        std::uint32_t txnSeq = 0;
+        Blob raw;
+        Blob meta;
+
+        // The accounts the transaction affects, in base58
+        std::vector<std::string> affected;
+    };
+
+    LedgerInfo info;
+    std::vector<Transaction> transactions;
+};
+
+/** Returns the rows recording an accepted ledger. */
+SavedLedger
+makeSavedLedger (AcceptedLedger const& ledger,
+    AccountIDCache const& accountIDCache);
+
+//------------------------------------------------------------------------------
+
+/** Writes validated ledgers to the transaction and ledger databases.
+
+    Statements are prepared once, on first use, and reused for every
+    ledger. The account transaction rows of all the ledgers in a write
+    are bound in bulk, and each database is updated in one transaction
+    per write.
+
+    The caller must not write from more than one thread at once.
+*/
+class SavedLedgerWriter
+{
+public:
+    SavedLedgerWriter (DatabaseCon& txnDB, DatabaseCon& ledgerDB);
+    ~SavedLedgerWriter ();
+
+    SavedLedgerWriter (SavedLedgerWriter const&) = delete;
+    SavedLedgerWriter& operator= (SavedLedgerWriter const&) = delete;
+
+    /** Write ledgers, replacing any rows already recorded for them.
+
+        Each database is locked only while it is being updated. The
+        ledger headers are removed first and written last, so clients
+        never find a header whose transactions are incomplete.
+    */
+    void
+    write (std::vector<SavedLedger> const& ledgers);
+
+private:
+    struct TxnStatements;
+    struct LedgerStatements;
+
+    DatabaseCon& txnDB_;
+    DatabaseCon& ledgerDB_;
+    std::unique_ptr<TxnStatements> txn_;
+    std::unique_ptr<LedgerStatements> ledger_;
+};
+
+//------------------------------------------------------------------------------
+
+/** Saves validated ledgers to the SQL databases, in batches.
+
+    While catching up, ledgers are prepared faster than they can be
+    written. The ledgers that queue up behind a write are written
+    together by the next one, up to batchSize at a time.
+*/
+class LedgerSaver
+{
+public:
+    /** The most ledgers written in one database transaction. */
+    static std::size_t constexpr batchSize = 32;
+
+    explicit
+    LedgerSaver (Application& app);
+    ~LedgerSaver ();
+
+    /** Write a ledger, or queue it to be written with others.
+
+        The ledger's pending save is finished once it is written.
+
+        @param synchronous If true, the ledger has been written
+                           when this returns.
+    */
+    void
+    save (SavedLedger&& ledger, bool synchronous);
+
+private:
+    // Write queued ledgers until there are none
+    void
+    write ();
+
+    Application& app_;
+
+    std::mutex mutex_;
+    std::deque<SavedLedger> queue_;
+    bool scheduled_ = false;
+
+    // Held while writing, protects writer_
+    std::mutex writeMutex_;
+    std::unique_ptr<SavedLedgerWriter> writer_;
+};
+
+} // ripple
+
+#endif
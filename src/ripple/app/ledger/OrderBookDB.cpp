@@ -25,6 +25,7 @@
 #include <ripple/core/Config.h>
 #include <ripple/core/JobQueue.h>
 #include <ripple/protocol/Indexes.h>
+#include <algorithm>
 
 namespace ripple {
 
@@ -45,16 +46,28 @@ void OrderBookDB::invalidate ()
 void OrderBookDB::setup(
     std::shared_ptr<ReadView const> const& ledger)
 {
+    if (app_.config().PATH_SEARCH_MAX == 0)
+    {
+        // pathfinding has been disabled
+        return;
+    }
+
     {
         std::lock_guard <std::recursive_mutex> sl (mLock);
         auto seq = ledger->info().seq;
 
-        // Do a full update every 256 ledgers
         if (mSeq != 0)
         {
-            if (seq == mSeq)
+            if (seq == mSeq + 1)
+            {
+                mSeq = seq;
+                if (mUpdateSeq != 0)
+                    mPending.push_back (ledger);
+                else
+                    applyLedger (*ledger);
                 return;
-            if ((seq > mSeq) && ((seq - mSeq) < 256))
+            }
+            if (seq == mSeq)
                 return;
             if ((seq < mSeq) && ((mSeq - seq) < 16))
                 return;
@@ -64,13 +77,11 @@ void OrderBookDB::setup(
             << "Advancing from " << mSeq << " to " << seq;
 
         mSeq = seq;
+        mUpdateSeq = seq;
+        mPending.clear ();
     }
 
-    if (app_.config().PATH_SEARCH_MAX == 0)
-    {
-        // nothing to do
-    }
-    else if (app_.config().standalone())
+    if (app_.config().standalone())
         update(ledger);
     else
         app_.getJobQueue().addJob(
@@ -81,7 +92,7 @@ void OrderBookDB::setup(
 void OrderBookDB::update(
     std::shared_ptr<ReadView const> const& ledger)
 {
-    hash_set< uint256 > seen;
+    hash_map< uint256, BookEntry > entries;
     OrderBookDB::IssueToOrderBook destMap;
     OrderBookDB::IssueToOrderBook sourceMap;
     hash_set< Issue > XRPBooks;
@@ -116,15 +127,17 @@ void OrderBookDB::update(
                     sfTakerGetsCurrency));
 
                 uint256 index = getBookBase (book);
-                if (seen.insert (index).second)
+                auto& entry = entries[index];
+                if (! entry.book)
                 {
-                    auto orderBook = std::make_shared<OrderBook> (index, book);
-                    sourceMap[book.in].push_back (orderBook);
-                    destMap[book.out].push_back (orderBook);
+                    entry.book = std::make_shared<OrderBook> (index, book);
+                    sourceMap[book.in].push_back (entry.book);
+                    destMap[book.out].push_back (entry.book);
                     if (isXRP(book.out))
                         XRPBooks.insert(book.in);
                     ++books;
                 }
+                ++entry.roots;
             }
         }
     }
@@ -133,7 +146,12 @@ void OrderBookDB::update(
         JLOG (j_.info())
             << "OrderBookDB::update encountered a missing node";
         std::lock_guard <std::recursive_mutex> sl (mLock);
-        mSeq = 0;
+        if (mUpdateSeq == ledger->info().seq)
+        {
+            mSeq = 0;
+            mUpdateSeq = 0;
+            mPending.clear ();
+        }
         return;
     }
 
@@ -142,45 +160,210 @@ void OrderBookDB::update(
     {
         std::lock_guard <std::recursive_mutex> sl (mLock);
 
+        // A later update replaced this one
+        if (mUpdateSeq != ledger->info().seq)
+            return;
+
+        mBooks.swap(entries);
         mXRPBooks.swap(XRPBooks);
         mSourceMap.swap(sourceMap);
         mDestMap.swap(destMap);
+
+        // Books only in the open ledger were not in the rebuild
+        mUnconfirmed.clear ();
+
+        // Catch up with the ledgers validated during the update
+        mUpdateSeq = 0;
+        auto const pending = std::move (mPending);
+        mPending.clear ();
+        for (auto const& next : pending)
+            applyLedger (*next);
     }
     app_.getLedgerMaster().newOrderBookDB();
 }
 
-void OrderBookDB::addOrderBook(Book const& book)
+void OrderBookDB::applyLedger (ReadView const& ledger)
 {
-    bool toXRP = isXRP (book.out);
-    std::lock_guard <std::recursive_mutex> sl (mLock);
+    // Missing fields in the metadata hold their default value, which
+    // for a currency or issuer means XRP.
+    auto const h160 = [](STObject const& fields, SF_U160 const& field)
+    {
+        return fields.isFieldPresent (field) ?
+            fields.getFieldH160 (field) : uint160 ();
+    };
 
-    if (toXRP)
+    try
     {
-        // We don't want to search through all the to-XRP or from-XRP order
-        // books!
-        for (auto ob: mSourceMap[book.in])
+        // The transactions are listed by hash. A directory can be created
+        // and deleted in the same ledger, so apply them in the order they
+        // were applied to the ledger instead.
+        std::vector<std::shared_ptr<STObject const>> metas;
+        for (auto const& tx : ledger.txs)
         {
-            if (isXRP (ob->getCurrencyOut ())) // also to XRP
-                return;
+            if (tx.second)
+                metas.push_back (tx.second);
         }
-    }
-    else
-    {
-        for (auto ob: mDestMap[book.out])
+        std::sort (metas.begin (), metas.end (),
+            [](auto const& a, auto const& b)
+            {
+                return a->getFieldU32 (sfTransactionIndex) <
+                    b->getFieldU32 (sfTransactionIndex);
+            });
+
+        for (auto const& meta : metas)
         {
-            if (ob->getCurrencyIn() == book.in.currency &&
-                ob->getIssuerIn() == book.in.account)
+            for (auto const& node : meta->getFieldArray (sfAffectedNodes))
             {
-                return;
+                bool const created = node.getFName () == sfCreatedNode;
+                if ((! created && node.getFName () != sfDeletedNode) ||
+                    node.getFieldU16 (sfLedgerEntryType) != ltDIR_NODE)
+                {
+                    continue;
+                }
+
+                auto const fields = dynamic_cast<STObject const*> (
+                    node.peekAtPField (created ? sfNewFields : sfFinalFields));
+                auto const& index = node.getFieldH256 (sfLedgerIndex);
+                if (! fields ||
+                    ! fields->isFieldPresent (sfExchangeRate) ||
+                    ! fields->isFieldPresent (sfRootIndex) ||
+                    fields->getFieldH256 (sfRootIndex) != index)
+                {
+                    // Not the first page of an order book directory
+                    continue;
+                }
+
+                if (created)
+                {
+                    Book book;
+                    book.in.currency.copyFrom (
+                        h160 (*fields, sfTakerPaysCurrency));
+                    book.in.account.copyFrom (
+                        h160 (*fields, sfTakerPaysIssuer));
+                    book.out.account.copyFrom (
+                        h160 (*fields, sfTakerGetsIssuer));
+                    book.out.currency.copyFrom (
+                        h160 (*fields, sfTakerGetsCurrency));
+                    addBookRoot (book);
+                }
+                else
+                {
+                    removeBookRoot (getQualityIndex (index));
+                }
             }
         }
     }
-    uint256 index = getBookBase(book);
-    auto orderBook = std::make_shared<OrderBook> (index, book);
+    catch (std::exception const& e)
+    {
+        JLOG (j_.warn())
+            << "OrderBookDB::applyLedger " << ledger.info().seq
+            << ": " << e.what ();
+        mSeq = 0;
+    }
+
+    pruneUnconfirmed (ledger.info().seq);
+}
+
+void OrderBookDB::addBookRoot (Book const& book)
+{
+    uint256 const index = getBookBase (book);
+    auto& entry = mBooks[index];
+    if (! entry.book)
+    {
+        entry.book = std::make_shared<OrderBook> (index, book);
+        mSourceMap[book.in].push_back (entry.book);
+        mDestMap[book.out].push_back (entry.book);
+        if (isXRP (book.out))
+            mXRPBooks.insert (book.in);
+    }
+    ++entry.roots;
+}
+
+void OrderBookDB::removeBookRoot (uint256 const& bookBase)
+{
+    auto const it = mBooks.find (bookBase);
+    if (it == mBooks.end ())
+    {
+        JLOG (j_.debug())
+            << "OrderBookDB: no book for deleted directory " << bookBase;
+        return;
+    }
+
+    if (--it->second.roots > 0)
+        return;
+
+    eraseBook (bookBase);
+}
+
+void OrderBookDB::eraseBook (uint256 const& bookBase)
+{
+    auto const it = mBooks.find (bookBase);
+    if (it == mBooks.end ())
+        return;
+
+    auto const book = it->second.book;
+    auto const erase = [&book](IssueToOrderBook& map, Issue const& issue)
+    {
+        auto const list = map.find (issue);
+        if (list == map.end ())
+            return;
+        list->second.erase (std::remove (list->second.begin (),
+            list->second.end (), book), list->second.end ());
+        if (list->second.empty ())
+            map.erase (list);
+    };
+    erase (mSourceMap, book->book().in);
+    erase (mDestMap, book->book().out);
+    if (isXRP (book->book().out))
+        mXRPBooks.erase (book->book().in);
+    mBooks.erase (it);
+}
+
+void OrderBookDB::pruneUnconfirmed (std::uint32_t seq)
+{
+    for (auto it = mUnconfirmed.begin (); it != mUnconfirmed.end ();)
+    {
+        auto const book = mBooks.find (it->first);
+        if (book == mBooks.end () || book->second.roots > 0)
+        {
+            // Removed, or confirmed by a validated directory
+            it = mUnconfirmed.erase (it);
+        }
+        else if (it->second == 0)
+        {
+            it->second = seq;
+            ++it;
+        }
+        else if (seq >= it->second + unconfirmedLedgers)
+        {
+            JLOG (j_.debug())
+                << "OrderBookDB: dropping unconfirmed book " << it->first;
+            eraseBook (it->first);
+            it = mUnconfirmed.erase (it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void OrderBookDB::addOrderBook(Book const& book)
+{
+    std::lock_guard <std::recursive_mutex> sl (mLock);
+
+    // The book is counted when its directory is validated. Until then
+    // it is only kept for a few ledgers.
+    uint256 const index = getBookBase (book);
+    if (mBooks.count (index))
+        return;
 
-    mSourceMap[book.in].push_back (orderBook);
-    mDestMap[book.out].push_back (orderBook);
-    if (toXRP)
+    mUnconfirmed[index] = mSeq;
+    auto& entry = mBooks[index];
+    entry.book = std::make_shared<OrderBook> (index, book);
+    mSourceMap[book.in].push_back (entry.book);
+    mDestMap[book.out].push_back (entry.book);
+    if (isXRP (book.out))
         mXRPBooks.insert(book.in);
 }
 
@@ -247,6 +430,7 @@ void OrderBookDB::processTxn (
         // entries for the same book, or if it touches multiple books and a
         // single client has subscribed to those books.
         hash_set<std::uint64_t> havePublished;
+        InfoSub::Message const msg (jvObj);
 
         // Check if this is an offer or an offer cancel or a payment that
         // consumes an offer.
@@ -284,7 +468,7 @@ void OrderBookDB::processTxn (
                             auto listeners = getBookListeners(b);
                             if (listeners)
                             {
-                                listeners->publish(jvObj, havePublished);
+                                listeners->publish(msg, havePublished);
                             }
                         }
                     }
@@ -34,6 +34,13 @@ class OrderBookDB
 public:
     OrderBookDB (Application& app, Stoppable& parent);
 
+    /** Bring the books up to date with a newly validated ledger.
+
+        The ledger after the last one seen updates the books from the
+        directories its transactions created and deleted. Any other
+        ledger, such as the first or one after a gap, rebuilds them
+        from every entry in the ledger.
+    */
     void setup (std::shared_ptr<ReadView const> const& ledger);
     void update (std::shared_ptr<ReadView const> const& ledger);
     void invalidate ();
@@ -61,10 +68,35 @@ public:
     using IssueToOrderBook = hash_map <Issue, OrderBook::List>;
 
 private:
-    void rawAddBook(Book const&);
+    // Count one more directory for a book, adding the book if needed
+    void addBookRoot (Book const&);
+
+    // Count one less directory for a book, removing it if none remain
+    void removeBookRoot (uint256 const& bookBase);
+
+    // Apply the book directories a ledger created and deleted
+    void applyLedger (ReadView const& ledger);
+
+    // Remove a book from every index
+    void eraseBook (uint256 const& bookBase);
+
+    // Drop open ledger books that validated ledgers have not confirmed
+    void pruneUnconfirmed (std::uint32_t seq);
 
     Application& app_;
 
+    struct BookEntry
+    {
+        OrderBook::pointer book;
+
+        // The quality directories in the ledger for this book. Books
+        // added for new offers in the open ledger start at zero.
+        int roots = 0;
+    };
+
+    // by book base
+    hash_map <uint256, BookEntry> mBooks;
+
     // by ci/ii
     IssueToOrderBook mSourceMap;
 
@@ -80,8 +112,23 @@ private:
 
     BookToListenersMap mListeners;
 
+    // Books added for offers in the open ledger that no validated
+    // ledger has a directory for yet. Each maps to the validated ledger
+    // it has been waiting since, or zero if none was seen yet.
+    hash_map <uint256, std::uint32_t> mUnconfirmed;
+
+    // How many validated ledgers an open ledger book may wait
+    static std::uint32_t constexpr unconfirmedLedgers = 4;
+
+    // The last ledger applied to the books, or zero to rebuild them
     std::uint32_t mSeq;
 
+    // The ledger a full update is in progress for, or zero
+    std::uint32_t mUpdateSeq = 0;
+
+    // Ledgers validated while a full update was in progress
+    std::vector <std::shared_ptr<ReadView const>> mPending;
+
     beast::Journal j_;
 };
 
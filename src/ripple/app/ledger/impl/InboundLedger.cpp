@@ -858,10 +858,26 @@ bool InboundLedger::takeTxNode (const std::vector<SHAMapNodeID>& nodeIDs,
     TransactionStateSF filter(mLedger->txMap().family(),
         app_.getLedgerMaster());
 
+    // Runs of non-root nodes are added together, so that they
+    // can be hashed together
+    std::vector<std::pair<SHAMapNodeID, Slice>> nodes;
+    auto addNodes = [&]()
+    {
+        if (!nodes.empty ())
+        {
+            san += mLedger->txMap().addKnownNodes (nodes, &filter);
+            nodes.clear ();
+        }
+        return san.isGood();
+    };
+
     while (nodeIDit != nodeIDs.cend ())
     {
         if (nodeIDit->isRoot ())
         {
+            if (!addNodes ())
+                return false;
+
             san += mLedger->txMap().addRootNode (
                 SHAMapHash{mLedger->info().txHash},
                     makeSlice(*nodeDatait), snfWIRE, &filter);
@@ -870,16 +886,16 @@ bool InboundLedger::takeTxNode (const std::vector<SHAMapNodeID>& nodeIDs,
         }
         else
         {
-            san +=  mLedger->txMap().addKnownNode (
-                *nodeIDit, makeSlice(*nodeDatait), &filter);
-            if (!san.isGood())
-                return false;
+            nodes.emplace_back (*nodeIDit, makeSlice(*nodeDatait));
         }
 
         ++nodeIDit;
         ++nodeDatait;
     }
 
+    if (!addNodes ())
+        return false;
+
     if (!mLedger->txMap().isSynching ())
     {
         mHaveTransactions = true;
@@ -930,10 +946,32 @@ bool InboundLedger::takeAsNode (const std::vector<SHAMapNodeID>& nodeIDs,
     AccountStateSF filter(mLedger->stateMap().family(),
         app_.getLedgerMaster());
 
+    // Runs of non-root nodes are added together, so that they
+    // can be hashed together
+    std::vector<std::pair<SHAMapNodeID, Slice>> nodes;
+    auto addNodes = [&]()
+    {
+        if (!nodes.empty ())
+        {
+            san += mLedger->stateMap().addKnownNodes (nodes, &filter);
+            nodes.clear ();
+        }
+        if (!san.isGood ())
+        {
+            JLOG (m_journal.warn()) <<
+                "Unable to add AS node";
+            return false;
+        }
+        return true;
+    };
+
     while (nodeIDit != nodeIDs.cend ())
     {
         if (nodeIDit->isRoot ())
         {
+            if (!addNodes ())
+                return false;
+
             san += mLedger->stateMap().addRootNode (
                 SHAMapHash{mLedger->info().accountHash},
                     makeSlice(*nodeDatait), snfWIRE, &filter);
@@ -946,20 +984,16 @@ bool InboundLedger::takeAsNode (const std::vector<SHAMapNodeID>& nodeIDs,
         }
         else
         {
-            san += mLedger->stateMap().addKnownNode (
-                *nodeIDit, makeSlice(*nodeDatait), &filter);
-            if (!san.isGood ())
-            {
-                JLOG (m_journal.warn()) <<
-                    "Unable to add AS node";
-                return false;
-            }
+            nodes.emplace_back (*nodeIDit, makeSlice(*nodeDatait));
         }
 
         ++nodeIDit;
         ++nodeDatait;
     }
 
+    if (!addNodes ())
+        return false;
+
     if (!mLedger->stateMap().isSynching ())
     {
         mHaveState = true;
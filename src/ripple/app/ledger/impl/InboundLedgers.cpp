@@ -23,6 +23,7 @@
 #include <ripple/app/main/Application.h>
 #include <ripple/app/misc/NetworkOPs.h>
 #include <ripple/basics/DecayingSample.h>
+#include <ripple/basics/flat_hash_map.h>
 #include <ripple/basics/Log.h>
 #include <ripple/core/JobQueue.h>
 #include <ripple/protocol/JsonFields.h>
@@ -406,7 +407,7 @@ private:
     using ScopedLockType = std::unique_lock <std::recursive_mutex>;
     std::recursive_mutex mLock;
 
-    using MapType = hash_map <uint256, std::shared_ptr<InboundLedger>>;
+    using MapType = flat_hash_map <uint256, std::shared_ptr<InboundLedger>>;
     MapType mLedgers;
 
     beast::aged_map <uint256, std::uint32_t> mRecentFailures;
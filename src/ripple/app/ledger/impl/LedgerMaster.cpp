@@ -40,6 +40,7 @@
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/basics/UptimeTimer.h>
 #include <ripple/core/TimeKeeper.h>
+#include <ripple/nodestore/DatabaseShard.h>
 #include <ripple/overlay/Overlay.h>
 #include <ripple/overlay/Peer.h>
 #include <ripple/protocol/digest.h>
@@ -60,6 +61,9 @@ using namespace std::chrono_literals;
 // Don't acquire history if ledger is too old
 auto constexpr MAX_LEDGER_AGE_ACQUIRE = 1min;
 
+// Nodes copied into the shard store by one job
+auto constexpr shardNodesPerJob = 4096;
+
 LedgerMaster::LedgerMaster (Application& app, Stopwatch& stopwatch,
     Stoppable& parent,
     beast::insight::Collector::ptr const& collector, beast::Journal journal)
@@ -77,6 +81,7 @@ LedgerMaster::LedgerMaster (Application& app, Stopwatch& stopwatch,
     , mFillInProgress (0)
     , mPathFindThread (0)
     , mPathFindNewRequest (false)
+    , mShardFetching (false)
     , mPubLedgerClose (0)
     , mPubLedgerSeq (0)
     , mValidLedgerSign (0)
@@ -1679,6 +1684,8 @@ void LedgerMaster::doAdvance ()
                         progress = true;
                     }
                 }
+                if (! progress && app_.getShardStore ())
+                    newShardWork ();
             }
             else
             {
@@ -1709,6 +1716,7 @@ void LedgerMaster::doAdvance ()
 
                 {
                     ScopedUnlockType sul(m_mutex);
+                    app_.getOrderBookDB().setup(ledger);
                     app_.getOPs().pubLedger(ledger);
                 }
             }
@@ -1722,6 +1730,159 @@ void LedgerMaster::doAdvance ()
     } while (mAdvanceWork);
 }
 
+void
+LedgerMaster::newShardWork ()
+{
+    if (! mShardFetching)
+    {
+        mShardFetching = true;
+        app_.getJobQueue().addJob (
+            jtLEDGER_DATA, "fetchForShard",
+            [this] (Job&) { fetchForShard(); });
+    }
+}
+
+void
+LedgerMaster::fetchForShard ()
+{
+    auto& shardStore = *app_.getShardStore ();
+
+    bool more = mShardCopy || startShardCopy (shardStore);
+    if (more)
+    {
+        auto const seq = mShardCopy->ledger->info ().seq;
+        bool done = false;
+        if (! storeShardNodes (shardStore, done))
+        {
+            JLOG (m_journal.warn()) <<
+                "Shard store rejected ledger " << seq;
+            mShardCopy.reset ();
+            more = false;
+        }
+        else if (done)
+        {
+            auto ledger = std::move (mShardCopy->ledger);
+            mShardCopy.reset ();
+            shardStore.setStored (seq);
+            JLOG (m_journal.trace()) <<
+                "fetchForShard stored " << seq;
+
+            ScopedLockType sl (m_mutex);
+            mShardLedger = std::move (ledger);
+        }
+    }
+
+    // Each job does a limited amount of work, and queues
+    // the next for as long as there is something to copy
+    ScopedLockType sl (m_mutex);
+    if (more)
+        app_.getJobQueue().addJob (
+            jtLEDGER_DATA, "fetchForShard",
+            [this] (Job&) { fetchForShard(); });
+    else
+        mShardFetching = false;
+}
+
+bool
+LedgerMaster::startShardCopy (NodeStore::DatabaseShard& shardStore)
+{
+    auto const seq = shardStore.prepare (mValidLedgerSeq);
+    if (! seq)
+        return false;
+
+    auto const hash = getLedgerHashForHistory (*seq);
+    if (! hash)
+    {
+        JLOG (m_journal.debug()) <<
+            "fetchForShard can't find hash for " << *seq;
+        return false;
+    }
+    assert (hash->isNonZero ());
+
+    auto ledger = getLedgerByHash (*hash);
+    if (! ledger)
+    {
+        if (app_.getInboundLedgers ().isFailure (*hash))
+        {
+            JLOG (m_journal.debug()) <<
+                "fetchForShard found failed acquire";
+            return false;
+        }
+        ledger = app_.getInboundLedgers ().acquire (
+            *hash, *seq, InboundLedger::fcHISTORY);
+        if (! ledger)
+            return false;
+    }
+    assert (ledger->info ().seq == *seq);
+
+    // Ledgers are acquired from the top of a shard down, so the
+    // nodes shared with the ledger stored before this one are
+    // already in the shard.
+    std::shared_ptr<Ledger const> next;
+    {
+        ScopedLockType sl (m_mutex);
+        next = mShardLedger;
+    }
+    if (next && (next->info ().seq != *seq + 1 ||
+        shardStore.seqToShardIndex (*seq + 1) !=
+            shardStore.seqToShardIndex (*seq)))
+    {
+        next.reset ();
+    }
+
+    Serializer s (128);
+    s.add32 (HashPrefix::ledgerMaster);
+    addRaw (ledger->info (), s);
+    if (! shardStore.store (hotLEDGER,
+        std::move (s.modData ()), ledger->info ().hash, *seq))
+    {
+        JLOG (m_journal.warn()) <<
+            "Shard store rejected ledger " << *seq;
+        return false;
+    }
+
+    mShardCopy.emplace ();
+    mShardCopy->ledger = std::move (ledger);
+    mShardCopy->next = std::move (next);
+    return true;
+}
+
+bool
+LedgerMaster::storeShardNodes (
+    NodeStore::DatabaseShard& shardStore, bool& done)
+{
+    auto& copy = *mShardCopy;
+    auto const seq = copy.ledger->info ().seq;
+    bool stored = true;
+
+    auto store = [&](NodeObjectType type)
+    {
+        return [&, type](SHAMapHash const& hash, Blob const& data)
+        {
+            if (stored)
+                stored = shardStore.store (type, Blob (data),
+                    hash.as_uint256 (), seq);
+        };
+    };
+
+    // The first ledger of a shard has no nodes to skip,
+    // so copying its state map takes many jobs
+    if (! copy.stateDone)
+    {
+        copy.stateDone = copy.ledger->stateMap ().getFetchPack (
+            copy.next ? &copy.next->stateMap () : nullptr, true,
+                shardNodesPerJob, copy.stack, store (hotACCOUNT_NODE));
+        done = false;
+    }
+    else
+    {
+        done = copy.ledger->txMap ().getFetchPack (
+            copy.next ? &copy.next->txMap () : nullptr, true,
+                shardNodesPerJob, copy.stack, store (hotTRANSACTION_NODE));
+    }
+    return stored;
+}
+
 void
 LedgerMaster::addFetchPack (
     uint256 const& hash,
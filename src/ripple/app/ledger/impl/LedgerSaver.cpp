@@ -0,0 +1,405 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/LedgerSaver.h>
+#include <ripple/app/ledger/AcceptedLedger.h>
+#include <ripple/app/ledger/PendingSaves.h>
+#include <ripple/app/main/Application.h>
+#include <ripple/core/DatabaseCon.h>
+#include <ripple/core/JobQueue.h>
+#include <ripple/core/SociDB.h>
+#include <ripple/protocol/STTx.h>
+#include <ripple/protocol/TxFormats.h>
+#include <algorithm>
+#include <iterator>
+
+namespace ripple {
+
+SavedLedger
+makeSavedLedger (AcceptedLedger const& ledger,
+    AccountIDCache const& accountIDCache)
+{
+    SavedLedger saved;
+    saved.info = ledger.getLedger ()->info ();
+    saved.transactions.reserve (ledger.getMap ().size ());
+
+    for (auto const& vt : ledger.getMap ())
+    {
+        auto const& txn = *vt.second->getTxn ();
+
+        SavedLedger::Transaction t;
+        t.id = to_string (txn.getTransactionID ());
+
+        auto const format =
+            TxFormats::getInstance ().findByType (txn.getTxnType ());
+        assert (format != nullptr);
+        if (format != nullptr)
+            t.type = format->getName ();
+
+        t.account = toBase58 (txn.getAccountID (sfAccount));
+        t.sequence = txn.getSequence ();
+        t.txnSeq = vt.second->getTxnSeq ();
+
+        Serializer s;
+        txn.add (s);
+        t.raw = std::move (s.modData ());
+        t.meta = vt.second->getRawMeta ();
+
+        auto const& accts = vt.second->getAffected ();
+        t.affected.reserve (accts.size ());
+        for (auto const& account : accts)
+            t.affected.push_back (accountIDCache.toBase58 (account));
+
+        saved.transactions.push_back (std::move (t));
+    }
+
+    return saved;
+}
+
+//------------------------------------------------------------------------------
+
+struct SavedLedgerWriter::TxnStatements
+{
+    // Bound by reference to the statements below
+    std::uint32_t seq;
+    std::vector<std::string> ids;
+    std::vector<std::string> accounts;
+    std::vector<std::uint32_t> ledgerSeqs;
+    std::vector<std::uint32_t> txnSeqs;
+    std::string id;
+    std::string type;
+    std::string account;
+    std::uint32_t sequence;
+    char status = TXN_SQL_VALIDATED;
+    soci::blob raw;
+    soci::blob meta;
+
+    soci::statement deleteTxns;
+    soci::statement deleteAcctTxns;
+    soci::statement deleteAcctTxnsByID;
+    soci::statement insertAcctTxns;
+    soci::statement insertTxn;
+
+    explicit
+    TxnStatements (soci::session& db)
+        : raw (db)
+        , meta (db)
+        , deleteTxns ((db.prepare <<
+            "DELETE FROM Transactions WHERE LedgerSeq = :seq;",
+            soci::use (seq)))
+        , deleteAcctTxns ((db.prepare <<
+            "DELETE FROM AccountTransactions WHERE LedgerSeq = :seq;",
+            soci::use (seq)))
+        , deleteAcctTxnsByID ((db.prepare <<
+            "DELETE FROM AccountTransactions WHERE TransID = :id;",
+            soci::use (ids)))
+        , insertAcctTxns ((db.prepare <<
+            "INSERT INTO AccountTransactions "
+            "(TransID, Account, LedgerSeq, TxnSeq) VALUES "
+            "(:id, :account, :seq, :txnSeq);",
+            soci::use (ids),
+            soci::use (accounts),
+            soci::use (ledgerSeqs),
+            soci::use (txnSeqs)))
+        , insertTxn ((db.prepare <<
+            "INSERT OR REPLACE INTO Transactions "
+            "(TransID, TransType, FromAcct, FromSeq, LedgerSeq, Status, "
+            "RawTxn, TxnMeta) VALUES "
+            "(:id, :type, :account, :sequence, :seq, :status, :raw, :meta);",
+            soci::use (id),
+            soci::use (type),
+            soci::use (account),
+            soci::use (sequence),
+            soci::use (seq),
+            soci::use (status),
+            soci::use (raw),
+            soci::use (meta)))
+    {
+    }
+
+    void
+    write (std::vector<SavedLedger> const& ledgers)
+    {
+        for (auto const& ledger : ledgers)
+        {
+            seq = ledger.info.seq;
+            deleteTxns.execute (true);
+            deleteAcctTxns.execute (true);
+        }
+
+        // Remove any rows left by a transaction that was
+        // previously recorded in a different ledger.
+        ids.clear ();
+        for (auto const& ledger : ledgers)
+            for (auto const& t : ledger.transactions)
+                ids.push_back (t.id);
+        if (! ids.empty ())
+            deleteAcctTxnsByID.execute (true);
+
+        ids.clear ();
+        accounts.clear ();
+        ledgerSeqs.clear ();
+        txnSeqs.clear ();
+        for (auto const& ledger : ledgers)
+        {
+            for (auto const& t : ledger.transactions)
+            {
+                for (auto const& a : t.affected)
+                {
+                    ids.push_back (t.id);
+                    accounts.push_back (a);
+                    ledgerSeqs.push_back (ledger.info.seq);
+                    txnSeqs.push_back (t.txnSeq);
+                }
+            }
+        }
+        if (! ids.empty ())
+            insertAcctTxns.execute (true);
+
+        for (auto const& ledger : ledgers)
+        {
+            seq = ledger.info.seq;
+            for (auto const& t : ledger.transactions)
+            {
+                id = t.id;
+                type = t.type;
+                account = t.account;
+                sequence = t.sequence;
+
+                // A blob is written in place, so shorten it first
+                raw.trim (0);
+                convert (t.raw, raw);
+                meta.trim (0);
+                convert (t.meta, meta);
+
+                insertTxn.execute (true);
+            }
+        }
+    }
+};
+
+struct SavedLedgerWriter::LedgerStatements
+{
+    // Bound by reference to the statements below
+    std::string hash;
+    std::uint32_t seq;
+    std::string parentHash;
+    std::string drops;
+    NetClock::rep closeTime;
+    NetClock::rep parentCloseTime;
+    NetClock::rep closeTimeResolution;
+    int closeFlags;
+    std::string accountHash;
+    std::string txHash;
+
+    soci::statement deleteLedger;
+    soci::statement addLedger;
+    soci::statement updateVal;
+
+    explicit
+    LedgerStatements (soci::session& db)
+        : deleteLedger ((db.prepare <<
+            "DELETE FROM Ledgers WHERE LedgerSeq = :seq;",
+            soci::use (seq)))
+        , addLedger ((db.prepare <<
+            R"sql(INSERT OR REPLACE INTO Ledgers
+                (LedgerHash,LedgerSeq,PrevHash,TotalCoins,ClosingTime,PrevClosingTime,
+                CloseTimeRes,CloseFlags,AccountSetHash,TransSetHash)
+            VALUES
+                (:ledgerHash,:ledgerSeq,:prevHash,:totalCoins,:closingTime,:prevClosingTime,
+                :closeTimeRes,:closeFlags,:accountSetHash,:transSetHash);)sql",
+            soci::use (hash),
+            soci::use (seq),
+            soci::use (parentHash),
+            soci::use (drops),
+            soci::use (closeTime),
+            soci::use (parentCloseTime),
+            soci::use (closeTimeResolution),
+            soci::use (closeFlags),
+            soci::use (accountHash),
+            soci::use (txHash)))
+        , updateVal ((db.prepare <<
+            R"sql(UPDATE Validations SET LedgerSeq = :ledgerSeq, InitialSeq = :initialSeq
+                WHERE LedgerHash = :ledgerHash;)sql",
+            soci::use (seq),
+            soci::use (seq),
+            soci::use (hash)))
+    {
+    }
+
+    void
+    remove (std::vector<SavedLedger> const& ledgers)
+    {
+        for (auto const& ledger : ledgers)
+        {
+            seq = ledger.info.seq;
+            deleteLedger.execute (true);
+        }
+    }
+
+    void
+    write (std::vector<SavedLedger> const& ledgers)
+    {
+        for (auto const& ledger : ledgers)
+        {
+            auto const& info = ledger.info;
+            hash = to_string (info.hash);
+            seq = info.seq;
+            parentHash = to_string (info.parentHash);
+            drops = to_string (info.drops);
+            closeTime = info.closeTime.time_since_epoch ().count ();
+            parentCloseTime =
+                info.parentCloseTime.time_since_epoch ().count ();
+            closeTimeResolution = info.closeTimeResolution.count ();
+            closeFlags = info.closeFlags;
+            accountHash = to_string (info.accountHash);
+            txHash = to_string (info.txHash);
+
+            addLedger.execute (true);
+            updateVal.execute (true);
+        }
+    }
+};
+
+SavedLedgerWriter::SavedLedgerWriter (
+        DatabaseCon& txnDB, DatabaseCon& ledgerDB)
+    : txnDB_ (txnDB)
+    , ledgerDB_ (ledgerDB)
+{
+}
+
+SavedLedgerWriter::~SavedLedgerWriter ()
+{
+    // Finalize the statements while holding their databases
+    {
+        auto db = txnDB_.checkoutDb ();
+        txn_.reset ();
+    }
+    {
+        auto db = ledgerDB_.checkoutDb ();
+        ledger_.reset ();
+    }
+}
+
+void
+SavedLedgerWriter::write (std::vector<SavedLedger> const& ledgers)
+{
+    if (ledgers.empty ())
+        return;
+
+    {
+        auto db = ledgerDB_.checkoutDb ();
+        if (! ledger_)
+            ledger_ = std::make_unique<LedgerStatements> (*db);
+
+        soci::transaction tr (*db);
+        ledger_->remove (ledgers);
+        tr.commit ();
+    }
+
+    {
+        auto db = txnDB_.checkoutDb ();
+        if (! txn_)
+            txn_ = std::make_unique<TxnStatements> (*db);
+
+        soci::transaction tr (*db);
+        txn_->write (ledgers);
+        tr.commit ();
+    }
+
+    {
+        auto db = ledgerDB_.checkoutDb ();
+
+        soci::transaction tr (*db);
+        ledger_->write (ledgers);
+        tr.commit ();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+std::size_t constexpr LedgerSaver::batchSize;
+
+LedgerSaver::LedgerSaver (Application& app)
+    : app_ (app)
+{
+}
+
+LedgerSaver::~LedgerSaver () = default;
+
+void
+LedgerSaver::save (SavedLedger&& ledger, bool synchronous)
+{
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        queue_.push_back (std::move (ledger));
+
+        if (! synchronous)
+        {
+            // A write that is already scheduled will pick this one up
+            if (scheduled_)
+                return;
+            scheduled_ = true;
+        }
+    }
+
+    if (synchronous)
+        return write ();
+
+    app_.getJobQueue ().addJob (jtWRITE, "LedgerSaver::write",
+        [this] (Job&) { write (); });
+}
+
+void
+LedgerSaver::write ()
+{
+    std::lock_guard<std::mutex> writeLock (writeMutex_);
+
+    for (;;)
+    {
+        std::vector<SavedLedger> batch;
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            if (queue_.empty ())
+            {
+                scheduled_ = false;
+                return;
+            }
+
+            auto const n = std::min (queue_.size (), batchSize);
+            batch.reserve (n);
+            std::move (queue_.begin (), queue_.begin () + n,
+                std::back_inserter (batch));
+            queue_.erase (queue_.begin (), queue_.begin () + n);
+        }
+
+        if (! writer_)
+            writer_ = std::make_unique<SavedLedgerWriter> (
+                app_.getTxnDB (), app_.getLedgerDB ());
+        writer_->write (batch);
+
+        // Clients can now trust the database for
+        // information about these ledger sequences.
+        for (auto const& ledger : batch)
+            app_.pendingSaves ().finishWork (ledger.info.seq);
+    }
+}
+
+} // ripple
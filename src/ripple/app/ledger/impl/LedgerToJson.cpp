@@ -251,6 +251,18 @@ void addJson (Json::Value& json, LedgerFill const& fill)
         fillJsonQueue(json, fill);
 }
 
+void addJson (Json::Object& json, LedgerFill const& fill)
+{
+    {
+        // The ledger must be closed before anything else is added.
+        auto&& object = Json::addObject (json, jss::ledger);
+        fillJson (object, fill);
+    }
+
+    if ((fill.options & LedgerFill::dumpQueue) && !fill.txQueue.empty())
+        fillJsonQueue(json, fill);
+}
+
 Json::Value getJson (LedgerFill const& fill)
 {
     Json::Value json;
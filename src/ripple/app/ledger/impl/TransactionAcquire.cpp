@@ -208,10 +208,30 @@ SHAMapAddNode TransactionAcquire::takeNodes (const std::list<SHAMapNodeID>& node
         std::list< Blob >::const_iterator nodeDatait = data.begin ();
         ConsensusTransSetSF sf (app_, app_.getTempNodeCache ());
 
+        // Runs of non-root nodes are added together, so that they
+        // can be hashed together
+        std::vector<std::pair<SHAMapNodeID, Slice>> nodes;
+        auto addNodes = [&]()
+        {
+            if (nodes.empty ())
+                return true;
+            auto const result = mMap->addKnownNodes (nodes, &sf);
+            nodes.clear ();
+            if (result.isInvalid ())
+            {
+                JLOG (j_.warn()) << "TX acquire got bad non-root node";
+                return false;
+            }
+            return true;
+        };
+
         while (nodeIDit != nodeIDs.end ())
         {
             if (nodeIDit->isRoot ())
             {
+                if (!addNodes ())
+                    return SHAMapAddNode::invalid ();
+
                 if (mHaveRoot)
                     JLOG (j_.debug()) << "Got root TXS node, already have it";
                 else if (!mMap->addRootNode (SHAMapHash{getHash ()},
@@ -222,16 +242,18 @@ SHAMapAddNode TransactionAcquire::takeNodes (const std::list<SHAMapNodeID>& node
                 else
                     mHaveRoot = true;
             }
-            else if (!mMap->addKnownNode (*nodeIDit, makeSlice(*nodeDatait), &sf).isGood())
+            else
             {
-                JLOG (j_.warn()) << "TX acquire got bad non-root node";
-                return SHAMapAddNode::invalid ();
+                nodes.emplace_back (*nodeIDit, makeSlice(*nodeDatait));
             }
 
             ++nodeIDit;
             ++nodeDatait;
         }
 
+        if (!addNodes ())
+            return SHAMapAddNode::invalid ();
+
         trigger (peer);
         progress ();
         return SHAMapAddNode::useful ();
@@ -28,6 +28,7 @@
 #include <ripple/app/ledger/LedgerToJson.h>
 #include <ripple/app/ledger/OpenLedger.h>
 #include <ripple/app/ledger/OrderBookDB.h>
+#include <ripple/app/ledger/LedgerSaver.h>
 #include <ripple/app/ledger/PendingSaves.h>
 #include <ripple/app/ledger/InboundTransactions.h>
 #include <ripple/app/ledger/TransactionMaster.h>
@@ -48,13 +49,16 @@
 #include <ripple/json/json_reader.h>
 #include <ripple/core/DeadlineTimer.h>
 #include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/Manager.h>
 #include <ripple/overlay/Cluster.h>
 #include <ripple/overlay/make_Overlay.h>
 #include <ripple/protocol/STParsedJSON.h>
 #include <ripple/resource/Fees.h>
 #include <ripple/beast/asio/io_latency_probe.h>
 #include <ripple/beast/core/LexicalCast.h>
+#include <algorithm>
 #include <fstream>
+#include <thread>
 
 namespace ripple {
 
@@ -73,6 +77,7 @@ private:
     FullBelowCache fullbelow_;
     NodeStore::Database& db_;
     beast::Journal j_;
+    FlushPool flushPool_;
 
     // missing node handler
     std::uint32_t maxSeq = 0;
@@ -108,6 +113,8 @@ public:
                 fullBelowTargetSize, fullBelowExpirationSeconds)
         , db_ (db)
         , j_ (app.journal("SHAMap"))
+        , flushPool_ (std::max (1, std::min (16,
+            static_cast<int> (std::thread::hardware_concurrency ()))))
     {
     }
 
@@ -153,6 +160,12 @@ public:
         return db_;
     }
 
+    FlushPool&
+    flushPool() override
+    {
+        return flushPool_;
+    }
+
     void
     missing_node (std::uint32_t seq) override
     {
@@ -310,6 +323,7 @@ public:
     // These are Stoppable-related
     std::unique_ptr <JobQueue> m_jobQueue;
     std::unique_ptr <NodeStore::Database> m_nodeStore;
+    std::unique_ptr <NodeStore::DatabaseShard> m_shardStore;
     detail::AppFamily family_;
     // VFALCO TODO Make OrderBookDB abstract
     OrderBookDB m_orderBookDB;
@@ -338,6 +352,7 @@ public:
     std::unique_ptr <DatabaseCon> mTxnDB;
     std::unique_ptr <DatabaseCon> mLedgerDB;
     std::unique_ptr <DatabaseCon> mWalletDB;
+    LedgerSaver ledgerSaver_;
     std::unique_ptr <Overlay> m_overlay;
     std::vector <std::unique_ptr<Stoppable>> websocketServers_;
 
@@ -412,6 +427,8 @@ public:
         , m_nodeStore (
             m_shaMapStore->makeDatabase ("NodeStore.main", 4, *m_jobQueue))
 
+        , m_shardStore (makeShardStore ())
+
         , family_ (*this, *m_nodeStore, *m_collectorManager)
 
         , m_orderBookDB (*this, *m_jobQueue)
@@ -483,6 +500,8 @@ public:
 
         , startTimers_ (false)
 
+        , ledgerSaver_ (*this)
+
         , m_signals (get_io_service())
 
         , checkSigs_(true)
@@ -526,6 +545,19 @@ public:
     void checkSigs(bool) override;
     int fdlimit () const override;
 
+    // The optional store of complete historical shards
+    std::unique_ptr <NodeStore::DatabaseShard>
+    makeShardStore ()
+    {
+        auto const& section =
+            config_->section (ConfigSection::shardDatabase ());
+        if (section.empty ())
+            return nullptr;
+        return NodeStore::Manager::instance ().make_DatabaseShard (
+            "ShardStore", m_nodeStoreScheduler, 4, *m_jobQueue,
+                section, logs_->journal ("ShardStore"));
+    }
+
     //--------------------------------------------------------------------------
 
     Logs&
@@ -624,6 +656,11 @@ public:
         return *m_nodeStore;
     }
 
+    NodeStore::DatabaseShard* getShardStore () override
+    {
+        return m_shardStore.get ();
+    }
+
     Application::MutexType& getMasterMutex () override
     {
         return m_masterMutex;
@@ -710,6 +747,11 @@ public:
         return pendingSaves_;
     }
 
+    LedgerSaver& getLedgerSaver () override
+    {
+        return ledgerSaver_;
+    }
+
     AccountIDCache const&
     accountIDCache() const override
     {
@@ -1310,6 +1352,11 @@ int ApplicationImp::fdlimit() const
     // doubled if online delete is enabled).
     needed += std::max(5, m_shaMapStore->fdlimit());
 
+    // the number of fds needed by the shards
+    if (m_shardStore)
+        needed += dynamic_cast<NodeStore::Database&>(
+            *m_shardStore).fdlimit();
+
     // One fd per incoming connection a port can accept, or
     // if no limit is set, assume it'll handle 256 clients.
     for(auto const& p : serverHandler_->setup().ports)
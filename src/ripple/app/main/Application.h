@@ -34,7 +34,7 @@ namespace ripple {
 
 namespace unl { class Manager; }
 namespace Resource { class Manager; }
-namespace NodeStore { class Database; }
+namespace NodeStore { class Database; class DatabaseShard; }
 
 // VFALCO TODO Fix forward declares required for header dependency loops
 class AmendmentTable;
@@ -49,6 +49,7 @@ class InboundLedgers;
 class InboundTransactions;
 class AcceptedLedger;
 class LedgerMaster;
+class LedgerSaver;
 class LoadManager;
 class ManifestCache;
 class NetworkOPs;
@@ -130,6 +131,7 @@ public:
     virtual Cluster&                cluster () = 0;
     virtual Validations&            getValidations () = 0;
     virtual NodeStore::Database&    getNodeStore () = 0;
+    virtual NodeStore::DatabaseShard* getShardStore () = 0;
     virtual InboundLedgers&         getInboundLedgers () = 0;
     virtual InboundTransactions&    getInboundTransactions () = 0;
     virtual TaggedCache <uint256, AcceptedLedger>&
@@ -147,6 +149,7 @@ public:
     virtual PathRequests&           getPathRequests () = 0;
     virtual SHAMapStore&            getSHAMapStore () = 0;
     virtual PendingSaves&           pendingSaves() = 0;
+    virtual LedgerSaver&            getLedgerSaver () = 0;
     virtual AccountIDCache const&   accountIDCache() const = 0;
     virtual OpenLedger&             openLedger() = 0;
     virtual OpenLedger const&       openLedger() const = 0;
@@ -32,6 +32,8 @@
 #include <ripple/crypto/csprng.h>
 #include <ripple/json/to_string.h>
 #include <ripple/net/RPCCall.h>
+#include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/Manager.h>
 #include <ripple/resource/Fees.h>
 #include <ripple/rpc/RPCHandler.h>
 #include <ripple/protocol/BuildInfo.h>
@@ -116,6 +118,23 @@ adjustDescriptorLimit(int needed, beast::Journal j)
     return true;
 }
 
+// Train a dictionary to compress the node database, which
+// must not be in use by a running server.
+int
+trainNodeDictionary (Config const& config,
+    std::size_t sampleCount, beast::Journal j)
+{
+    NodeStore::DummyScheduler scheduler;
+    auto backend = NodeStore::Manager::instance ().make_Backend (
+        config.section (ConfigSection::nodeDatabase ()), scheduler, j);
+    if (! NodeStore::trainDictionary (*backend, sampleCount, j))
+    {
+        std::cerr << "No dictionary was added to the node database.\n";
+        return -1;
+    }
+    return 0;
+}
+
 void printHelp (const po::options_description& desc)
 {
     std::cerr
@@ -241,6 +260,9 @@ int run (int argc, char** argv)
     ("debug", "Enable normally suppressed debug logging")
     ("fg", "Run in the foreground.")
     ("import", importText.c_str ())
+    ("train_dictionary", po::value <std::size_t> ()->implicit_value (100000),
+        "Train a dictionary to compress the node database on a sample of "
+        "the given number of objects, then exit.")
     ("version", "Display the build version.")
     ;
 
@@ -414,6 +436,13 @@ int run (int argc, char** argv)
 
     auto logs = std::make_unique<Logs>(thresh);
 
+    if (vm.count ("train_dictionary"))
+    {
+        return trainNodeDictionary (*config,
+            vm["train_dictionary"].as<std::size_t> (),
+                logs->journal ("NodeObject"));
+    }
+
     // No arguments. Run server.
     if (!vm.count ("parameters"))
     {
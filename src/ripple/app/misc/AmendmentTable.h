@@ -140,9 +140,9 @@ public:
             amendTx.add (s);
 
             initialPosition->addGiveItem (
-                std::make_shared <SHAMapItem> (
+                make_shamapitem (
                     amendTx.getTransactionID(),
-                    s.peekData()),
+                    s.slice()),
                 true,
                 false);
         }
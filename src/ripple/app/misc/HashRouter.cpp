@@ -19,52 +19,231 @@
 
 #include <BeastConfig.h>
 #include <ripple/app/misc/HashRouter.h>
+#include <algorithm>
+#include <cassert>
+#include <limits>
 
 namespace ripple {
 
+HashRouter::PeerSet::PeerSet (PeerSet&& other) noexcept
+    : size_ (other.size_)
+    , capacity_ (other.capacity_)
+{
+    if (capacity_ == inlineCapacity)
+        std::copy (other.inline_, other.inline_ + size_, inline_);
+    else
+        heap_ = other.heap_;
+    other.size_ = 0;
+    other.capacity_ = inlineCapacity;
+}
+
 auto
-HashRouter::emplace (uint256 const& key)
-    -> std::pair<Entry&, bool>
+HashRouter::PeerSet::operator= (PeerSet&& other) noexcept
+    -> PeerSet&
 {
-    auto iter = suppressionMap_.find (key);
+    if (this == &other)
+        return *this;
+    if (capacity_ != inlineCapacity)
+        delete[] heap_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    if (capacity_ == inlineCapacity)
+        std::copy (other.inline_, other.inline_ + size_, inline_);
+    else
+        heap_ = other.heap_;
+    other.size_ = 0;
+    other.capacity_ = inlineCapacity;
+    return *this;
+}
 
-    if (iter != suppressionMap_.end ())
+HashRouter::PeerSet::~PeerSet ()
+{
+    if (capacity_ != inlineCapacity)
+        delete[] heap_;
+}
+
+bool
+HashRouter::PeerSet::insert (PeerShortID peer)
+{
+    if (contains (peer))
+        return false;
+
+    if (size_ == capacity_)
     {
-        suppressionMap_.touch(iter);
-        return std::make_pair(
-            std::ref(iter->second), false);
+        auto const capacity = capacity_ * 2;
+        auto const p = new PeerShortID[capacity];
+        std::copy (begin (), end (), p);
+        if (capacity_ != inlineCapacity)
+            delete[] heap_;
+        heap_ = p;
+        capacity_ = capacity;
+    }
+
+    if (capacity_ == inlineCapacity)
+        inline_[size_] = peer;
+    else
+        heap_[size_] = peer;
+    ++size_;
+    return true;
+}
+
+bool
+HashRouter::PeerSet::contains (PeerShortID peer) const
+{
+    return std::find (begin (), end (), peer) != end ();
+}
+
+//------------------------------------------------------------------------------
+
+HashRouter::HashRouter (Stopwatch& clock,
+        std::chrono::seconds entryHoldTimeInSeconds)
+    : clock_ (clock)
+    , holdTime_ (entryHoldTimeInSeconds)
+{
+    auto const t = now () - holdTime_.count ();
+    limit_ = t;
+    for (auto& p : partitions_)
+    {
+        p.wheel.resize (holdTime_.count () + 1);
+        p.expired = t;
+    }
+}
+
+// The low bits of the hash place the key within the partition's
+// map, so the partition is chosen from the high bits.
+auto
+HashRouter::partition (uint256 const& key)
+    -> Partition&
+{
+    auto constexpr shift =
+        std::numeric_limits <std::size_t>::digits - 8;
+    return partitions_[(hash_ (key) >> shift) % partitions];
+}
+
+auto
+HashRouter::now () const
+    -> Tick
+{
+    using namespace std::chrono;
+    return duration_cast <seconds> (
+        clock_.now ().time_since_epoch ()).count ();
+}
+
+auto
+HashRouter::bucket (Partition& p, Tick tick)
+    -> Bucket&
+{
+    auto const n = static_cast<Tick> (p.wheel.size ());
+    auto& b = p.wheel[static_cast<std::size_t> (((tick % n) + n) % n)];
+    if (b.tick != tick)
+    {
+        // Without an insertion since, keys from a full turn ago may
+        // belong to entries that have not expired. Carry over those
+        // not listed again in a later bucket.
+        auto const last = b.tick;
+        b.keys.erase (std::remove_if (b.keys.begin (), b.keys.end (),
+            [&](uint256 const& key)
+            {
+                auto const iter = p.entries.find (key);
+                return iter == p.entries.end () ||
+                    iter->second.touched () > last;
+            }), b.keys.end ());
+        b.tick = tick;
+    }
+    return b;
+}
+
+auto
+HashRouter::raiseLimit (Tick limit)
+    -> Tick
+{
+    auto current = limit_.load ();
+    while (current < limit &&
+            ! limit_.compare_exchange_weak (current, limit))
+        ;
+    return std::max (current, limit);
+}
+
+void
+HashRouter::expire (Partition& p, Tick limit)
+{
+    if (limit <= p.expired)
+        return;
+
+    // Visit each bucket at most once, however long it has been
+    auto const n = static_cast<Tick> (p.wheel.size ());
+    for (auto t = std::max (p.expired + 1, limit - n + 1); t <= limit; ++t)
+    {
+        auto& b = p.wheel[static_cast<std::size_t> (((t % n) + n) % n)];
+        if (b.tick > limit)
+            continue;
+
+        // Keys touched again since are also listed in a later bucket
+        for (auto const& key : b.keys)
+        {
+            auto const iter = p.entries.find (key);
+            if (iter != p.entries.end () && iter->second.touched () <= limit)
+                p.entries.erase (iter);
+        }
+        b.keys.clear ();
+    }
+
+    p.expired = limit;
+}
+
+auto
+HashRouter::emplace (Partition& p, uint256 const& key, Tick now)
+    -> std::pair<Entry&, bool>
+{
+    auto iter = p.entries.find (key);
+    if (iter != p.entries.end ())
+    {
+        auto& entry = iter->second;
+
+        // An insertion into any partition expires every entry which
+        // has gone unused for the hold time, even if this partition
+        // has not caught up with it yet.
+        if (entry.touched () > limit_.load ())
+        {
+            if (entry.touch (now))
+                bucket (p, now).keys.push_back (key);
+            return std::make_pair(std::ref(entry), false);
+        }
+        p.entries.erase (iter);
     }
 
     // See if any supressions need to be expired
-    expire(suppressionMap_, holdTime_);
+    expire (p, raiseLimit (now - holdTime_.count ()));
 
-    return std::make_pair(std::ref(
-        suppressionMap_.emplace (
-            key, Entry ()).first->second),
-                true);
+    auto& entry = p.entries.try_emplace (key, now).first->second;
+    bucket (p, now).keys.push_back (key);
+    return std::make_pair(std::ref(entry), true);
 }
 
 void HashRouter::addSuppression (uint256 const& key)
 {
-    std::lock_guard <std::mutex> lock (mutex_);
+    auto& p = partition (key);
+    std::lock_guard <std::mutex> lock (p.mutex);
 
-    emplace (key);
+    emplace (p, key, now ());
 }
 
 bool HashRouter::addSuppressionPeer (uint256 const& key, PeerShortID peer)
 {
-    std::lock_guard <std::mutex> lock (mutex_);
+    auto& p = partition (key);
+    std::lock_guard <std::mutex> lock (p.mutex);
 
-    auto result = emplace(key);
+    auto result = emplace(p, key, now ());
     result.first.addPeer(peer);
     return result.second;
 }
 
 bool HashRouter::addSuppressionPeer (uint256 const& key, PeerShortID peer, int& flags)
 {
-    std::lock_guard <std::mutex> lock (mutex_);
+    auto& p = partition (key);
+    std::lock_guard <std::mutex> lock (p.mutex);
 
-    auto result = emplace(key);
+    auto result = emplace(p, key, now ());
     auto& s = result.first;
     s.addPeer (peer);
     flags = s.getFlags ();
@@ -73,18 +252,20 @@ bool HashRouter::addSuppressionPeer (uint256 const& key, PeerShortID peer, int&
 
 int HashRouter::getFlags (uint256 const& key)
 {
-    std::lock_guard <std::mutex> lock (mutex_);
+    auto& p = partition (key);
+    std::lock_guard <std::mutex> lock (p.mutex);
 
-    return emplace(key).first.getFlags ();
+    return emplace(p, key, now ()).first.getFlags ();
 }
 
 bool HashRouter::setFlags (uint256 const& key, int flags)
 {
     assert (flags != 0);
 
-    std::lock_guard <std::mutex> lock (mutex_);
+    auto& p = partition (key);
+    std::lock_guard <std::mutex> lock (p.mutex);
 
-    auto& s = emplace(key).first;
+    auto& s = emplace(p, key, now ()).first;
 
     if ((s.getFlags () & flags) == flags)
         return false;
@@ -97,14 +278,33 @@ auto
 HashRouter::shouldRelay (uint256 const& key)
     -> boost::optional<std::set<PeerShortID>>
 {
-    std::lock_guard <std::mutex> lock (mutex_);
+    PeerSet peers;
+    {
+        auto& p = partition (key);
+        std::lock_guard <std::mutex> lock (p.mutex);
+
+        auto& s = emplace(p, key, now ()).first;
 
-    auto& s = emplace(key).first;
+        if (!s.shouldRelay(clock_.now(), holdTime_))
+            return boost::none;
+
+        peers = s.releasePeerSet();
+    }
 
-    if (!s.shouldRelay(suppressionMap_.clock().now(), holdTime_))
-        return boost::none;
+    // Build the result outside the lock
+    return std::set<PeerShortID>(peers.begin(), peers.end());
+}
 
-    return s.releasePeerSet();
+std::size_t
+HashRouter::size () const
+{
+    std::size_t n = 0;
+    for (auto const& p : partitions_)
+    {
+        std::lock_guard <std::mutex> lock (p.mutex);
+        n += p.entries.size ();
+    }
+    return n;
 }
 
 } // ripple
@@ -23,9 +23,15 @@
 #include <ripple/basics/base_uint.h>
 #include <ripple/basics/chrono.h>
 #include <ripple/basics/CountedObject.h>
-#include <ripple/basics/UnorderedContainers.h>
-#include <ripple/beast/container/aged_unordered_map.h>
+#include <ripple/basics/flat_hash_map.h>
 #include <boost/optional.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
 
 namespace ripple {
 
@@ -50,6 +56,14 @@ namespace ripple {
     This table keeps track of which hashes have been received by which peers.
     It is used to manage the routing and broadcasting of messages in the peer
     to peer overlay.
+
+    Every message from every peer passes through here, so the table is
+    split into independently locked partitions chosen by the hash. An
+    entry that has gone unused for the hold time expires when the next
+    new entry is added. Each partition reclaims expired entries with a
+    time wheel: a ring of buckets, one per second of the hold time,
+    listing the keys touched in that second. Only the keys in buckets
+    that have fallen out of the hold time need to be looked at.
 */
 class HashRouter
 {
@@ -57,7 +71,56 @@ public:
     // The type here *MUST* match the type of Peer::id_t
     using PeerShortID = std::uint32_t;
 
+    /** The number of independently locked partitions. */
+    static std::size_t constexpr partitions = 16;
+
+    /** A set of peers, stored inline while it is small.
+
+        Most items are heard from a handful of peers before they are
+        relayed, so the common case needs no allocation.
+    */
+    class PeerSet
+    {
+    public:
+        static std::size_t constexpr inlineCapacity = 4;
+
+        PeerSet () = default;
+        PeerSet (PeerSet&& other) noexcept;
+        PeerSet& operator= (PeerSet&& other) noexcept;
+        PeerSet (PeerSet const&) = delete;
+        PeerSet& operator= (PeerSet const&) = delete;
+        ~PeerSet ();
+
+        /** Add a peer, returning `false` if it was already present. */
+        bool insert (PeerShortID peer);
+
+        bool contains (PeerShortID peer) const;
+
+        std::size_t size () const { return size_; }
+        bool empty () const { return size_ == 0; }
+
+        PeerShortID const* begin () const { return data (); }
+        PeerShortID const* end () const { return data () + size_; }
+
+    private:
+        PeerShortID const* data () const
+        {
+            return capacity_ == inlineCapacity ? inline_ : heap_;
+        }
+
+        std::uint32_t size_ = 0;
+        std::uint32_t capacity_ = inlineCapacity;
+        union
+        {
+            PeerShortID inline_[inlineCapacity];
+            PeerShortID* heap_;
+        };
+    };
+
 private:
+    // Whole seconds on the router's clock
+    using Tick = std::int64_t;
+
     /** An entry in the routing table.
     */
     class Entry : public CountedObject <Entry>
@@ -65,8 +128,9 @@ private:
     public:
         static char const* getCountedObjectName () { return "HashRouterEntry"; }
 
-        Entry ()
+        explicit Entry (Tick now)
             : flags_ (0)
+            , touched_ (now)
         {
         }
 
@@ -87,7 +151,7 @@ private:
         }
 
         /** Return set of peers we've relayed to and reset tracking */
-        std::set<PeerShortID> releasePeerSet()
+        PeerSet releasePeerSet()
         {
             return std::move(peers_);
         }
@@ -107,14 +171,48 @@ private:
             return true;
         }
 
+        Tick touched () const
+        {
+            return touched_;
+        }
+
+        /** Record a use, returning `true` if the tick changed. */
+        bool touch (Tick now)
+        {
+            if (touched_ == now)
+                return false;
+            touched_ = now;
+            return true;
+        }
+
     private:
         int flags_;
-        std::set <PeerShortID> peers_;
+        Tick touched_;
+        PeerSet peers_;
         // This could be generalized to a map, if more
         // than one flag needs to expire independently.
         boost::optional<Stopwatch::time_point> relayed_;
     };
 
+    // The keys touched during one tick
+    struct Bucket
+    {
+        Tick tick = 0;
+        std::vector <uint256> keys;
+    };
+
+    struct Partition
+    {
+        std::mutex mutable mutex;
+        flat_hash_map <uint256, Entry> entries;
+
+        // Indexed by tick modulo its size
+        std::vector <Bucket> wheel;
+
+        // Entries last touched at or before this tick are gone
+        Tick expired;
+    };
+
 public:
     static inline std::chrono::seconds getDefaultHoldTime ()
     {
@@ -123,11 +221,7 @@ public:
         return 300s;
     }
 
-    HashRouter (Stopwatch& clock, std::chrono::seconds entryHoldTimeInSeconds)
-        : suppressionMap_(clock)
-        , holdTime_ (entryHoldTimeInSeconds)
-    {
-    }
+    HashRouter (Stopwatch& clock, std::chrono::seconds entryHoldTimeInSeconds);
 
     HashRouter& operator= (HashRouter const&) = delete;
 
@@ -164,17 +258,35 @@ public:
     */
     boost::optional<std::set<PeerShortID>> shouldRelay(uint256 const& key);
 
+    /** Returns the number of entries in the table. */
+    std::size_t size () const;
+
 private:
+    Partition& partition (uint256 const& key);
+
+    Tick now () const;
+
     // pair.second indicates whether the entry was created
-    std::pair<Entry&, bool> emplace (uint256 const&);
+    std::pair<Entry&, bool> emplace (
+        Partition& p, uint256 const& key, Tick now);
 
-    std::mutex mutable mutex_;
+    // Removes the entries last touched at or before the limit
+    void expire (Partition& p, Tick limit);
 
-    // Stores all suppressed hashes and their expiration time
-    beast::aged_unordered_map<uint256, Entry, Stopwatch::clock_type,
-        hardened_hash<strong_hash>> suppressionMap_;
+    // Raises limit_, returning its new value
+    Tick raiseLimit (Tick limit);
 
+    Bucket& bucket (Partition& p, Tick tick);
+
+    Stopwatch& clock_;
     std::chrono::seconds const holdTime_;
+    flat_hash <uint256> hash_;
+    std::array <Partition, partitions> partitions_;
+
+    // As before sharding, an insertion expires every entry unused for
+    // the hold time. This is the last touch at or before which entries
+    // are expired, and partitions catch up with it lazily.
+    std::atomic <Tick> limit_;
 };
 
 } // ripple
@@ -46,6 +46,7 @@
 #include <ripple/crypto/csprng.h>
 #include <ripple/crypto/RFC1751.h>
 #include <ripple/json/to_string.h>
+#include <ripple/nodestore/DatabaseShard.h>
 #include <ripple/overlay/Cluster.h>
 #include <ripple/overlay/Overlay.h>
 #include <ripple/overlay/predicates.h>
@@ -1537,7 +1538,8 @@ void NetworkOPsImp::processTrustedProposal (
 
     if (mConsensus->peerProposal (
         app_.timeKeeper().closeTime(), peerPos->proposal()))
-        app_.overlay().relay(*set, peerPos->getSuppressionID());
+        app_.overlay().relay(*set, peerPos->getSuppressionID(),
+            peerPos->getPublicKey());
     else
         JLOG(m_journal.info()) << "Not relaying trusted proposal";
 }
@@ -1605,11 +1607,12 @@ void NetworkOPsImp::pubManifest (Manifest const& mo)
         jvObj [jss::signature]        = strHex (mo.getSignature ());
         jvObj [jss::master_signature] = strHex (mo.getMasterSignature ());
 
+        InfoSub::Message const msg (jvObj);
         for (auto i = mSubManifests.begin (); i != mSubManifests.end (); )
         {
             if (auto p = i->second.lock())
             {
-                p->send (jvObj, true);
+                p->send (msg, true);
                 ++i;
             }
             else
@@ -1703,6 +1706,7 @@ void NetworkOPsImp::pubServer ()
 
         mLastFeeSummary = f;
 
+        InfoSub::Message const msg (jvObj);
         for (auto i = mSubServer.begin (); i != mSubServer.end (); )
         {
             InfoSub::pointer p = i->second.lock ();
@@ -1712,7 +1716,7 @@ void NetworkOPsImp::pubServer ()
             //             sending of JSON data.
             if (p)
             {
-                p->send (jvObj, true);
+                p->send (msg, true);
                 ++i;
             }
             else
@@ -1768,11 +1772,12 @@ void NetworkOPsImp::pubValidation (STValidation::ref val)
         if (auto const reserveInc = (*val)[~sfReserveIncrement])
             jvObj [jss::reserve_inc] = *reserveInc;
 
+        InfoSub::Message const msg (jvObj);
         for (auto i = mSubValidations.begin (); i != mSubValidations.end (); )
         {
             if (auto p = i->second.lock())
             {
-                p->send (jvObj, true);
+                p->send (msg, true);
                 ++i;
             }
             else
@@ -1794,13 +1799,14 @@ void NetworkOPsImp::pubPeerStatus (
 
         jvObj [jss::type]                  = "peerStatusChange";
 
+        InfoSub::Message const msg (jvObj);
         for (auto i = mSubPeerStatus.begin (); i != mSubPeerStatus.end (); )
         {
             InfoSub::pointer p = i->second.lock ();
 
             if (p)
             {
-                p->send (jvObj, true);
+                p->send (msg, true);
                 ++i;
             }
             else
@@ -2153,6 +2159,9 @@ Json::Value NetworkOPsImp::getServerInfo (bool human, bool admin)
     info[jss::complete_ledgers] =
             app_.getLedgerMaster ().getCompleteLedgers ();
 
+    if (auto shardStore = app_.getShardStore ())
+        info[jss::complete_shards] = shardStore->getCompleteShards ();
+
     if (m_amendmentBlocked)
         info[jss::amendment_blocked] = true;
 
@@ -2360,6 +2369,7 @@ void NetworkOPsImp::pubProposedTransaction (
     {
         ScopedLockType sl (mSubLock);
 
+        InfoSub::Message const msg (jvObj);
         auto it = mSubRTTransactions.begin ();
         while (it != mSubRTTransactions.end ())
         {
@@ -2367,7 +2377,7 @@ void NetworkOPsImp::pubProposedTransaction (
 
             if (p)
             {
-                p->send (jvObj, true);
+                p->send (msg, true);
                 ++it;
             }
             else
@@ -2425,13 +2435,14 @@ void NetworkOPsImp::pubLedger (
                         = app_.getLedgerMaster ().getCompleteLedgers ();
             }
 
+            InfoSub::Message const msg (jvObj);
             auto it = mSubLedger.begin ();
             while (it != mSubLedger.end ())
             {
                 InfoSub::pointer p = it->second.lock ();
                 if (p)
                 {
-                    p->send (jvObj, true);
+                    p->send (msg, true);
                     ++it;
                 }
                 else
@@ -2528,6 +2539,7 @@ void NetworkOPsImp::pubValidatedTransaction (
     {
         ScopedLockType sl (mSubLock);
 
+        InfoSub::Message const msg (jvObj);
         auto it = mSubTransactions.begin ();
         while (it != mSubTransactions.end ())
         {
@@ -2535,7 +2547,7 @@ void NetworkOPsImp::pubValidatedTransaction (
 
             if (p)
             {
-                p->send (jvObj, true);
+                p->send (msg, true);
                 ++it;
             }
             else
@@ -2550,7 +2562,7 @@ void NetworkOPsImp::pubValidatedTransaction (
 
             if (p)
             {
-                p->send (jvObj, true);
+                p->send (msg, true);
                 ++it;
             }
             else
@@ -2637,8 +2649,9 @@ void NetworkOPsImp::pubAccountTransaction (
         if (alTx.isApplied ())
             jvObj[jss::meta] = alTx.getMeta ()->getJson (0);
 
+        InfoSub::Message const msg (jvObj);
         for (InfoSub::ref isrListener : notify)
-            isrListener->send (jvObj, true);
+            isrListener->send (msg, true);
     }
 }
 
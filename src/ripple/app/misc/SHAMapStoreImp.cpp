@@ -529,7 +529,9 @@ SHAMapStoreImp::makeDatabaseRotating (std::string const& name,
 {
     return NodeStore::Manager::instance().make_DatabaseRotating (
         name, scheduler_, readThreads, parent,
-        writableBackend, archiveBackend, nodeStoreJournal_);
+        writableBackend, archiveBackend,
+        get<std::size_t> (setup_.nodeDatabase, "filter_size"),
+        nodeStoreJournal_);
 }
 
 bool
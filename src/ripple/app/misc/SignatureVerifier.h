@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#ifndef RIPPLE_APP_MISC_SIGNATUREVERIFIER_H_INCLUDED
+#define RIPPLE_APP_MISC_SIGNATUREVERIFIER_H_INCLUDED
+
+#include <ripple/basics/Blob.h>
+#include <ripple/basics/base_uint.h>
+#include <ripple/core/Job.h>
+#include <ripple/protocol/PublicKey.h>
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace ripple {
+
+class JobQueue;
+
+/** Verifies signatures in batches, on the job queue.
+
+    Signatures received from peers are queued here instead of each
+    being checked in a job of its own. A job takes up to batchSize of
+    them at a time, and another job is started whenever more than
+    batchSize are waiting for each job already running, so bursts are
+    spread across the job threads.
+
+    Each signature is checked on its own, exactly as verify and
+    verifyDigest would. The results are cached and relied on when
+    building ledgers, so every server must reach the same ones, which
+    a randomized ed25519 batch check can not promise.
+
+    Each callback is invoked with the result, from the job that
+    verified its signature.
+*/
+class SignatureVerifier
+{
+public:
+    using Callback = std::function<void (bool valid)>;
+
+    /** The most signatures verified by one job at a time. */
+    static std::size_t constexpr batchSize = 64;
+
+    SignatureVerifier (JobQueue& jobQueue,
+        JobType type, std::string name);
+
+    SignatureVerifier (SignatureVerifier const&) = delete;
+    SignatureVerifier& operator= (SignatureVerifier const&) = delete;
+
+    /** Queue a signature on a message to be verified. */
+    void
+    verify (PublicKey const& publicKey, Blob message,
+        Blob signature, bool mustBeFullyCanonical, Callback callback);
+
+    /** Queue a signature on a digest to be verified. */
+    void
+    verifyDigest (PublicKey const& publicKey, uint256 const& digest,
+        Blob signature, bool mustBeFullyCanonical, Callback callback);
+
+    /** Returns the number of signatures waiting to be verified. */
+    std::size_t
+    size () const;
+
+private:
+    struct Item
+    {
+        PublicKey publicKey;
+        Blob message;
+        boost::optional<uint256> digest;
+        Blob signature;
+        bool mustBeFullyCanonical;
+        Callback callback;
+    };
+
+    void
+    add (Item&& item);
+
+    // Verify waiting signatures until there are none
+    void
+    run ();
+
+    JobQueue& jobQueue_;
+    JobType const type_;
+    std::string const name_;
+
+    std::mutex mutable mutex_;
+    std::deque<Item> pending_;
+    std::size_t jobs_ = 0;
+};
+
+} // ripple
+
+#endif
@@ -25,7 +25,7 @@
 #include <ripple/app/misc/impl/AccountTxPaging.h>
 #include <ripple/protocol/Serializer.h>
 #include <ripple/protocol/types.h>
-#include <boost/format.hpp>
+#include <limits>
 #include <memory>
 
 namespace ripple {
@@ -115,87 +115,57 @@ accountTxPage (
     // we need to clear it in between.
     token = Json::nullValue;
 
+    // Each page is a range scan of AcctTxIndex, which is ordered on
+    // (Account, LedgerSeq, TxnSeq), starting at the marker. Unlike an
+    // OFFSET, this costs the same no matter how deep the page is.
     static std::string const prefix (
         R"(SELECT AccountTransactions.LedgerSeq,AccountTransactions.TxnSeq,
           Status,RawTxn,TxnMeta
           FROM AccountTransactions INNER JOIN Transactions
           ON Transactions.TransID = AccountTransactions.TransID
-          AND AccountTransactions.Account = '%s' WHERE
+          WHERE AccountTransactions.Account = :account AND
           )");
 
-    std::string sql;
+    static std::string const forwardSQL (prefix +
+        R"(AccountTransactions.LedgerSeq BETWEEN :fromLedger AND :maxLedger
+          AND (AccountTransactions.LedgerSeq > :afterLedger OR
+               AccountTransactions.TxnSeq >= :fromSeq)
+          ORDER BY AccountTransactions.LedgerSeq ASC,
+          AccountTransactions.TxnSeq ASC
+          LIMIT :limit;)");
+
+    static std::string const backwardSQL (prefix +
+        R"(AccountTransactions.LedgerSeq BETWEEN :minLedger AND :fromLedger
+          AND (AccountTransactions.LedgerSeq < :beforeLedger OR
+               AccountTransactions.TxnSeq <= :fromSeq)
+          ORDER BY AccountTransactions.LedgerSeq DESC,
+          AccountTransactions.TxnSeq DESC
+          LIMIT :limit;)");
+
+    // Without a marker, start from the appropriate end of the range
+    std::int64_t fromLedger;
+    std::int64_t fromSeq;
 
-    // SQL's BETWEEN uses a closed interval ([a,b])
-
-    if (forward && (findLedger == 0))
-    {
-        sql = boost::str (boost::format(
-            prefix +
-            (R"(AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u'
-             ORDER BY AccountTransactions.LedgerSeq ASC,
-             AccountTransactions.TxnSeq ASC
-             LIMIT %u;)"))
-            % idCache.toBase58(account)
-            % minLedger
-            % maxLedger
-            % queryLimit);
-    }
-    else if (forward && (findLedger != 0))
-    {
-        sql = boost::str (boost::format(
-            prefix +
-            (R"(
-            AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u' OR
-            ( AccountTransactions.LedgerSeq = '%u' AND
-              AccountTransactions.TxnSeq >= '%u' )
-            ORDER BY AccountTransactions.LedgerSeq ASC,
-            AccountTransactions.TxnSeq ASC
-            LIMIT %u;
-            )"))
-        % idCache.toBase58(account)
-        % (findLedger + 1)
-        % maxLedger
-        % findLedger
-        % findSeq
-        % queryLimit);
-    }
-    else if (!forward && (findLedger == 0))
+    if (lookingForMarker)
     {
-        sql = boost::str (boost::format(
-            prefix +
-            (R"(AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u'
-             ORDER BY AccountTransactions.LedgerSeq DESC,
-             AccountTransactions.TxnSeq DESC
-             LIMIT %u;)"))
-            % idCache.toBase58(account)
-            % minLedger
-            % maxLedger
-            % queryLimit);
+        fromLedger = findLedger;
+        fromSeq = findSeq;
     }
-    else if (!forward && (findLedger != 0))
+    else if (forward)
     {
-        sql = boost::str (boost::format(
-            prefix +
-            (R"(AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u' OR
-             (AccountTransactions.LedgerSeq = '%u' AND
-              AccountTransactions.TxnSeq <= '%u')
-             ORDER BY AccountTransactions.LedgerSeq DESC,
-             AccountTransactions.TxnSeq DESC
-             LIMIT %u;)"))
-            % idCache.toBase58(account)
-            % minLedger
-            % (findLedger - 1)
-            % findLedger
-            % findSeq
-            % queryLimit);
+        fromLedger = minLedger;
+        fromSeq = 0;
     }
     else
     {
-        assert (false);
-        // sql is empty
-        return;
+        fromLedger = maxLedger;
+        fromSeq = std::numeric_limits<std::uint32_t>::max ();
     }
 
+    std::string const accountID = idCache.toBase58 (account);
+    std::int64_t const otherEnd = forward ? maxLedger : minLedger;
+    std::int64_t const rows = queryLimit;
+
     {
         auto db (connection.checkoutDb());
 
@@ -209,26 +179,37 @@ accountTxPage (
         soci::blob txnMeta (*db);
         soci::indicator dataPresent, metaPresent;
 
-        soci::statement st = (db->prepare << sql,
-            soci::into (ledgerSeq),
-            soci::into (txnSeq),
-            soci::into (status),
-            soci::into (txnData, dataPresent),
-            soci::into (txnMeta, metaPresent));
+        soci::statement st = forward ?
+            (db->prepare << forwardSQL,
+                soci::use (accountID),
+                soci::use (fromLedger),
+                soci::use (otherEnd),
+                soci::use (fromLedger),
+                soci::use (fromSeq),
+                soci::use (rows),
+                soci::into (ledgerSeq),
+                soci::into (txnSeq),
+                soci::into (status),
+                soci::into (txnData, dataPresent),
+                soci::into (txnMeta, metaPresent)) :
+            (db->prepare << backwardSQL,
+                soci::use (accountID),
+                soci::use (otherEnd),
+                soci::use (fromLedger),
+                soci::use (fromLedger),
+                soci::use (fromSeq),
+                soci::use (rows),
+                soci::into (ledgerSeq),
+                soci::into (txnSeq),
+                soci::into (status),
+                soci::into (txnData, dataPresent),
+                soci::into (txnMeta, metaPresent));
 
         st.execute ();
 
         while (st.fetch ())
         {
-            if (lookingForMarker)
-            {
-                if (findLedger == ledgerSeq.value_or (0) &&
-                    findSeq == txnSeq.value_or (0))
-                {
-                    lookingForMarker = false;
-                }
-            }
-            else if (numberOfResults == 0)
+            if (numberOfResults == 0)
             {
                 token = Json::objectValue;
                 token[jss::ledger] = rangeCheckedCast<std::uint32_t>(ledgerSeq.value_or (0));
@@ -236,26 +217,23 @@ accountTxPage (
                 break;
             }
 
-            if (!lookingForMarker)
-            {
-                if (dataPresent == soci::i_ok)
-                    convert (txnData, rawData);
-                else
-                    rawData.clear ();
-
-                if (metaPresent == soci::i_ok)
-                    convert (txnMeta, rawMeta);
-                else
-                    rawMeta.clear ();
-
-                // Work around a bug that could leave the metadata missing
-                if (rawMeta.size() == 0)
-                    onUnsavedLedger(ledgerSeq.value_or (0));
-
-                onTransaction(rangeCheckedCast<std::uint32_t>(ledgerSeq.value_or (0)),
-                    *status, rawData, rawMeta);
-                --numberOfResults;
-            }
+            if (dataPresent == soci::i_ok)
+                convert (txnData, rawData);
+            else
+                rawData.clear ();
+
+            if (metaPresent == soci::i_ok)
+                convert (txnMeta, rawMeta);
+            else
+                rawMeta.clear ();
+
+            // Work around a bug that could leave the metadata missing
+            if (rawMeta.size() == 0)
+                onUnsavedLedger(ledgerSeq.value_or (0));
+
+            onTransaction(rangeCheckedCast<std::uint32_t>(ledgerSeq.value_or (0)),
+                *status, rawData, rawMeta);
+            --numberOfResults;
         }
     }
 
@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/app/misc/SignatureVerifier.h>
+#include <ripple/core/JobQueue.h>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace ripple {
+
+SignatureVerifier::SignatureVerifier (JobQueue& jobQueue,
+        JobType type, std::string name)
+    : jobQueue_ (jobQueue)
+    , type_ (type)
+    , name_ (std::move (name))
+{
+}
+
+void
+SignatureVerifier::verify (PublicKey const& publicKey, Blob message,
+    Blob signature, bool mustBeFullyCanonical, Callback callback)
+{
+    add ({publicKey, std::move (message), boost::none,
+        std::move (signature), mustBeFullyCanonical,
+            std::move (callback)});
+}
+
+void
+SignatureVerifier::verifyDigest (PublicKey const& publicKey,
+    uint256 const& digest, Blob signature, bool mustBeFullyCanonical,
+        Callback callback)
+{
+    add ({publicKey, Blob (), digest, std::move (signature),
+        mustBeFullyCanonical, std::move (callback)});
+}
+
+std::size_t
+SignatureVerifier::size () const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    return pending_.size ();
+}
+
+void
+SignatureVerifier::add (Item&& item)
+{
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        pending_.push_back (std::move (item));
+        if (jobs_ != 0 && pending_.size () <= jobs_ * batchSize)
+            return;
+        ++jobs_;
+    }
+
+    jobQueue_.addJob (type_, name_, [this](Job&) { run (); });
+}
+
+void
+SignatureVerifier::run ()
+{
+    std::vector<Item> batch;
+    batch.reserve (batchSize);
+
+    for (;;)
+    {
+        batch.clear ();
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            if (pending_.empty ())
+            {
+                --jobs_;
+                return;
+            }
+            auto const n = std::min (batchSize, pending_.size ());
+            std::move (pending_.begin (), pending_.begin () + n,
+                std::back_inserter (batch));
+            pending_.erase (pending_.begin (), pending_.begin () + n);
+        }
+
+        for (auto& item : batch)
+        {
+            bool valid = false;
+            if (! item.digest)
+            {
+                valid = ripple::verify (item.publicKey,
+                    makeSlice (item.message), makeSlice (item.signature),
+                        item.mustBeFullyCanonical);
+            }
+            else if (publicKeyType (item.publicKey) == KeyType::secp256k1)
+            {
+                // Only secp256k1 keys sign digests
+                valid = ripple::verifyDigest (item.publicKey,
+                    *item.digest, makeSlice (item.signature),
+                        item.mustBeFullyCanonical);
+            }
+            item.callback (valid);
+        }
+    }
+}
+
+} // ripple
@@ -26,9 +26,78 @@
 #include <ripple/protocol/JsonFields.h>
 #include <ripple/resource/Fees.h>
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <thread>
 
 namespace ripple {
 
+void
+PathLatencyHistogram::notify (std::chrono::milliseconds ms)
+{
+    std::size_t bucket = 0;
+    for (auto n = ms.count (); n > 0 && bucket + 1 < buckets; n >>= 1)
+        ++bucket;
+    counts_[bucket].fetch_add (1, std::memory_order_relaxed);
+}
+
+Json::Value
+PathLatencyHistogram::getJson () const
+{
+    // Report only the buckets that have been used, keyed by
+    // their upper bound in milliseconds.
+    Json::Value ret (Json::objectValue);
+    for (std::size_t i = 0; i < buckets; ++i)
+    {
+        auto const count = counts_[i].load (std::memory_order_relaxed);
+        if (count == 0)
+            continue;
+        auto const key = (i + 1 < buckets)
+            ? "lt_" + std::to_string (1ull << i) + "ms"
+            : "ge_" + std::to_string (1ull << (i - 1)) + "ms";
+        ret[key] = static_cast<Json::UInt> (count);
+    }
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+
+struct PathRequests::Pass
+{
+    std::vector<PathRequest::wptr> requests;
+    std::shared_ptr<RippleLineCache> cache;
+    bool newRequests;
+    Job::CancelCallback shouldCancel;
+
+    std::atomic<std::size_t> next {0};
+    std::atomic<bool> stop {false};
+    std::atomic<int>& processed;
+    std::atomic<int>& removed;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int busy = 0;
+    std::exception_ptr error;
+
+    Pass (std::atomic<int>& processed_, std::atomic<int>& removed_)
+        : processed (processed_)
+        , removed (removed_)
+    {
+    }
+};
+
+PathRequests::PathRequests (Application& app,
+        beast::Journal journal, beast::insight::Collector::ptr const& collector)
+    : app_ (app)
+    , mJournal (journal)
+    , workers_ (std::max (1u,
+        std::min (8u, std::thread::hardware_concurrency () / 2)))
+    , mLastIdentifier (0)
+{
+    mFast = collector->make_event ("pathfind_fast");
+    mFull = collector->make_event ("pathfind_full");
+}
+
 /** Get the current RippleLineCache, updating it if necessary.
     Get the correct ledger to use.
 */
@@ -70,81 +139,48 @@ void PathRequests::updateAll (std::shared_ptr <ReadView const> const& inLedger,
     }
 
     bool newRequests = app_.getLedgerMaster().isNewPathRequest();
-    bool mustBreak = false;
 
     JLOG (mJournal.trace()) <<
         "updateAll seq=" << cache->getLedger()->seq() <<
         ", " << requests.size() << " requests";
 
-    int processed = 0, removed = 0;
+    std::atomic<int> processed {0}, removed {0};
 
     do
     {
-        for (auto const& wr : requests)
+        // Requests are independent of each other and only read from the
+        // line cache, so each pass shares them out between jobs. This
+        // job works too, so the pass finishes even if no other job runs.
+        // A job that starts after the pass finished finds nothing to do.
+        auto const pass = std::make_shared<Pass> (processed, removed);
+        pass->requests = std::move (requests);
+        pass->cache = cache;
+        pass->newRequests = newRequests;
+        pass->shouldCancel = shouldCancel;
+
+        auto const jobs = std::min<std::size_t> (
+            pass->requests.size (), workers_);
+        for (std::size_t i = 1; i < jobs && ! shouldCancel (); ++i)
         {
-            if (shouldCancel())
-                break;
-
-            auto request = wr.lock ();
-            bool remove = true;
-
-            if (request)
-            {
-                if (!request->needsUpdate (newRequests, cache->getLedger()->seq()))
-                    remove = false;
-                else
+            app_.getJobQueue().addJob (jtUPDATE_PF, "PathRequests::updateAll",
+                [this, pass] (Job&)
                 {
-                    if (auto ipSub = request->getSubscriber ())
-                    {
-                        if (!ipSub->getConsumer ().warn ())
-                        {
-                            Json::Value update = request->doUpdate (cache, false);
-                            request->updateComplete ();
-                            update[jss::type] = "path_find";
-                            ipSub->send (update, false);
-                            remove = false;
-                            ++processed;
-                        }
-                    }
-                    else if (request->hasCompletion ())
-                    {
-                        // One-shot request with completion function
-                        request->doUpdate (cache, false);
-                        request->updateComplete();
-                        ++processed;
-                    }
-                }
-            }
-
-            if (remove)
-            {
-                ScopedLockType sl (mLock);
-
-                // Remove any dangling weak pointers or weak
-                // pointers that refer to this path request.
-                auto ret = std::remove_if (
-                    requests_.begin(), requests_.end(),
-                    [&removed,&request](auto const& wl)
-                    {
-                        auto r = wl.lock();
-
-                        if (r && r != request)
-                            return false;
-                        ++removed;
-                        return true;
-                    });
+                    runPass (*pass);
+                });
+        }
+        runPass (*pass);
 
-                requests_.erase (ret, requests_.end());
-            }
+        bool mustBreak;
+        {
+            std::unique_lock<std::mutex> lock (pass->mutex);
+            pass->cv.wait (lock, [&]{ return pass->busy == 0; });
+            if (pass->error)
+                std::rethrow_exception (pass->error);
 
-            mustBreak = !newRequests &&
-                app_.getLedgerMaster().isNewPathRequest();
-
-            // We weren't handling new requests and then
-            // there was a new request
-            if (mustBreak)
-                break;
+            mustBreak = pass->stop;
 
+            // Jobs that start from now on find the pass stopped
+            pass->stop = true;
         }
 
         if (mustBreak)
@@ -179,6 +215,96 @@ void PathRequests::updateAll (std::shared_ptr <ReadView const> const& inLedger,
         removed << " removed";
 }
 
+void PathRequests::runPass (Pass& pass)
+{
+    {
+        std::lock_guard<std::mutex> lock (pass.mutex);
+        if (pass.stop)
+            return;
+        ++pass.busy;
+    }
+
+    try
+    {
+        for (auto i = pass.next++; i < pass.requests.size (); i = pass.next++)
+        {
+            if (pass.stop || pass.shouldCancel())
+                break;
+
+            auto request = pass.requests[i].lock ();
+            if (! request || ! updateOne (request, pass.cache,
+                    pass.newRequests, pass.processed))
+            {
+                ScopedLockType sl (mLock);
+
+                // Remove any dangling weak pointers or weak
+                // pointers that refer to this path request.
+                auto ret = std::remove_if (
+                    requests_.begin(), requests_.end(),
+                    [&pass,&request](auto const& wl)
+                    {
+                        auto r = wl.lock();
+
+                        if (r && r != request)
+                            return false;
+                        ++pass.removed;
+                        return true;
+                    });
+
+                requests_.erase (ret, requests_.end());
+            }
+
+            // We weren't handling new requests and then
+            // there was a new request
+            if (!pass.newRequests &&
+                    app_.getLedgerMaster().isNewPathRequest())
+                pass.stop = true;
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock (pass.mutex);
+        if (! pass.error)
+            pass.error = std::current_exception ();
+        pass.stop = true;
+    }
+
+    std::lock_guard<std::mutex> lock (pass.mutex);
+    if (--pass.busy == 0)
+        pass.cv.notify_all ();
+}
+
+bool PathRequests::updateOne (
+    PathRequest::pointer const& request,
+    std::shared_ptr<RippleLineCache> const& cache,
+    bool newRequests, std::atomic<int>& processed)
+{
+    if (!request->needsUpdate (newRequests, cache->getLedger()->seq()))
+        return true;
+
+    if (auto ipSub = request->getSubscriber ())
+    {
+        if (ipSub->getConsumer ().warn ())
+            return false;
+
+        Json::Value update = request->doUpdate (cache, false);
+        request->updateComplete ();
+        update[jss::type] = "path_find";
+        ipSub->send (update, false);
+        ++processed;
+        return true;
+    }
+
+    if (request->hasCompletion ())
+    {
+        // One-shot request with completion function
+        request->doUpdate (cache, false);
+        request->updateComplete();
+        ++processed;
+    }
+    return false;
+}
+
 void PathRequests::insertPathRequest (
     PathRequest::pointer const& req)
 {
@@ -24,24 +24,38 @@
 #include <ripple/app/paths/PathRequest.h>
 #include <ripple/app/paths/RippleLineCache.h>
 #include <ripple/core/Job.h>
+#include <ripple/json/json_value.h>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <vector>
 
 namespace ripple {
 
+/** Counts path request reply latencies in power-of-two millisecond buckets.
+
+    Bucket i holds replies that took less than 2^i milliseconds; the last
+    bucket holds everything slower. Safe to update from any thread.
+*/
+class PathLatencyHistogram
+{
+public:
+    static constexpr std::size_t buckets = 16;
+
+    void notify (std::chrono::milliseconds ms);
+
+    Json::Value getJson () const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, buckets> counts_ {};
+};
+
 class PathRequests
 {
 public:
     PathRequests (Application& app,
-            beast::Journal journal, beast::insight::Collector::ptr const& collector)
-        : app_ (app)
-        , mJournal (journal)
-        , mLastIdentifier (0)
-    {
-        mFast = collector->make_event ("pathfind_fast");
-        mFull = collector->make_event ("pathfind_full");
-    }
+            beast::Journal journal, beast::insight::Collector::ptr const& collector);
 
     void updateAll (std::shared_ptr<ReadView const> const& ledger,
                     Job::CancelCallback shouldCancel);
@@ -76,22 +90,53 @@ public:
     void reportFast (std::chrono::milliseconds ms)
     {
         mFast.notify (ms);
+        fastLatency_.notify (ms);
     }
 
     void reportFull (std::chrono::milliseconds ms)
     {
         mFull.notify (ms);
+        fullLatency_.notify (ms);
+    }
+
+    /** Latency of the first (fast) reply to each request. */
+    PathLatencyHistogram const& getFastLatency () const
+    {
+        return fastLatency_;
+    }
+
+    /** Latency of the first full reply to each request. */
+    PathLatencyHistogram const& getFullLatency () const
+    {
+        return fullLatency_;
     }
 
 private:
+    // One pass over the requests, shared by the jobs working on it
+    struct Pass;
+
     void insertPathRequest (PathRequest::pointer const&);
 
+    // Update requests of the pass until none are left or it is stopped
+    void runPass (Pass& pass);
+
+    // Bring one request up to date. Returns false if it should be removed.
+    bool updateOne (PathRequest::pointer const& request,
+        std::shared_ptr<RippleLineCache> const& cache,
+        bool newRequests, std::atomic<int>& processed);
+
     Application& app_;
     beast::Journal                   mJournal;
 
     beast::insight::Event            mFast;
     beast::insight::Event            mFull;
 
+    PathLatencyHistogram             fastLatency_;
+    PathLatencyHistogram             fullLatency_;
+
+    // The most jobs, including the caller's, that work on a pass
+    unsigned const                   workers_;
+
     // Track all requests
     std::vector<PathRequest::wptr> requests_;
 
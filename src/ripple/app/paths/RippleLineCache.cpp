@@ -36,17 +36,23 @@ std::vector<RippleState::pointer> const&
 RippleLineCache::getRippleLines (AccountID const& accountID)
 {
     AccountKey key (accountID, hasher_ (accountID));
-
-    std::lock_guard <std::mutex> sl (mLock);
-
-    auto it = lines_.emplace (key,
-        std::vector<RippleState::pointer>());
-
-    if (it.second)
-        it.first->second = getRippleStateItems (
-            accountID, *mLedger);
-
-    return it.first->second;
+    auto& partition = partitions_[key.get_hash () % partitions_.size ()];
+
+    {
+        std::lock_guard <std::mutex> sl (partition.mutex);
+        auto const it = partition.lines.find (key);
+        if (it != partition.lines.end ())
+            return it->second;
+    }
+
+    // Another thread may load the same lines meanwhile; the first
+    // to finish is kept. Entries are never removed, so references
+    // to them remain valid.
+    auto lines = getRippleStateItems (accountID, *mLedger);
+
+    std::lock_guard <std::mutex> sl (partition.mutex);
+    return partition.lines.emplace (
+        key, std::move (lines)).first->second;
 }
 
 } // ripple
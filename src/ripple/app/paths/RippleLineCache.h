@@ -23,6 +23,7 @@
 #include <ripple/app/ledger/Ledger.h>
 #include <ripple/app/paths/RippleState.h>
 #include <ripple/basics/hardened_hash.h>
+#include <array>
 #include <cstddef>
 #include <memory>
 #include <mutex>
@@ -31,6 +32,12 @@
 namespace ripple {
 
 // Used by Pathfinder
+//
+// The cache is a snapshot of one ledger, which never changes, so any
+// thread loading the lines of an account finds the same ones. Lines
+// are loaded without holding a lock, and accounts are spread across
+// partitions with their own locks, so path requests being updated in
+// parallel do not wait for each other.
 class RippleLineCache
 {
 public:
@@ -48,8 +55,6 @@ public:
     getRippleLines (AccountID const& accountID);
 
 private:
-    std::mutex mLock;
-
     ripple::hardened_hash<> hasher_;
     std::shared_ptr <ReadView const> mLedger;
 
@@ -89,10 +94,17 @@ private:
         };
     };
 
-    hash_map <
-        AccountKey,
-        std::vector <RippleState::pointer>,
-        AccountKey::Hash> lines_;
+    struct Partition
+    {
+        std::mutex mutex;
+
+        hash_map <
+            AccountKey,
+            std::vector <RippleState::pointer>,
+            AccountKey::Hash> lines;
+    };
+
+    std::array <Partition, 16> partitions_;
 };
 
 } // ripple
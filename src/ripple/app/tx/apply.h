@@ -71,7 +71,8 @@ checkValidity(HashRouter& router,
     @warning Use with extreme care.
 
     @note Can only raise the validity to a more valid state,
-          and can not override anything cached bad.
+          and can not override anything cached bad. `SigBad`
+          caches a bad signature found by some other check.
 
     @see checkValidity, Validity
 */
@@ -96,7 +96,7 @@ forceValidity(HashRouter& router, uint256 const& txid,
         flags |= SF_SIGGOOD;
         // fall through
     case Validity::SigBad:
-        // would be silly to call directly
+        flags |= SF_SIGBAD;
         break;
     }
     if (flags)
@@ -20,6 +20,7 @@
 #ifndef RIPPLE_BASICS_KEYCACHE_H_INCLUDED
 #define RIPPLE_BASICS_KEYCACHE_H_INCLUDED
 
+#include <ripple/basics/flat_hash_map.h>
 #include <ripple/basics/hardened_hash.h>
 #include <ripple/basics/UnorderedContainers.h>
 #include <ripple/beast/clock/abstract_clock.h>
@@ -37,7 +38,7 @@ namespace ripple {
 // VFALCO TODO Figure out how to pass through the allocator
 template <
     class Key,
-    class Hash = hardened_hash <>,
+    class Hash = flat_hash <Key>,
     class KeyEqual = std::equal_to <Key>,
     //class Allocator = std::allocator <std::pair <Key const, Entry>>,
     class Mutex = std::mutex
@@ -79,7 +80,7 @@ private:
         clock_type::time_point last_access;
     };
 
-    using map_type = hardened_hash_map <key_type, Entry, Hash, KeyEqual>;
+    using map_type = flat_hash_map <key_type, Entry, Hash, KeyEqual>;
     using iterator = typename map_type::iterator;
     using lock_guard = std::lock_guard <Mutex>;
 
@@ -192,9 +193,7 @@ public:
     {
         lock_guard lock (m_mutex);
         clock_type::time_point const now (m_clock.now ());
-        std::pair <iterator, bool> result (m_map.emplace (
-            std::piecewise_construct, std::forward_as_tuple (key),
-                std::forward_as_tuple (now)));
+        std::pair <iterator, bool> result (m_map.try_emplace (key, now));
         if (! result.second)
         {
             result.first->second.last_access = now;
@@ -20,13 +20,19 @@
 #ifndef RIPPLE_BASICS_TAGGEDCACHE_H_INCLUDED
 #define RIPPLE_BASICS_TAGGEDCACHE_H_INCLUDED
 
+#include <ripple/basics/flat_hash_map.h>
 #include <ripple/basics/hardened_hash.h>
 #include <ripple/basics/Log.h>
 #include <ripple/basics/UnorderedContainers.h>
 #include <ripple/beast/clock/abstract_clock.h>
 #include <ripple/beast/insight/Insight.h>
+#include <array>
+#include <atomic>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <tuple>
 #include <vector>
 
 namespace ripple {
@@ -43,6 +49,11 @@ struct TaggedCacheLog;
     If it stays in memory even after it is ejected from the cache,
     the map will track it.
 
+    The map is split into independent partitions selected by the hash
+    of the key, each with its own lock. Lookups and insertions only
+    lock the partition holding the key, and sweeping visits one
+    partition at a time, so unrelated keys do not contend.
+
     @note Callers must not modify data objects that are stored in the cache
           unless they hold their own lock over all cache operations.
 */
@@ -50,7 +61,7 @@ struct TaggedCacheLog;
 template <
     class Key,
     class T,
-    class Hash = hardened_hash <>,
+    class Hash = flat_hash <Key>,
     class KeyEqual = std::equal_to <Key>,
     //class Allocator = std::allocator <std::pair <Key const, Entry>>,
     class Mutex = std::recursive_mutex
@@ -69,6 +80,9 @@ public:
     using mapped_ptr = std::shared_ptr <mapped_type>;
     using clock_type = beast::abstract_clock <std::chrono::steady_clock>;
 
+    /** The number of independently locked partitions. */
+    static std::size_t constexpr partitions = 16;
+
 public:
     // VFALCO TODO Change expiration_seconds to clock_type::duration
     TaggedCache (std::string const& name, int size,
@@ -81,10 +95,8 @@ public:
                 collector)
         , m_name (name)
         , m_target_size (size)
-        , m_target_age (std::chrono::seconds (expiration_seconds))
-        , m_cache_count (0)
-        , m_hits (0)
-        , m_misses (0)
+        , m_target_age (clock_type::duration (
+            std::chrono::seconds (expiration_seconds)).count())
     {
     }
 
@@ -97,17 +109,23 @@ public:
 
     int getTargetSize () const
     {
-        lock_guard lock (m_mutex);
         return m_target_size;
     }
 
     void setTargetSize (int s)
     {
-        lock_guard lock (m_mutex);
         m_target_size = s;
 
         if (s > 0)
-            m_cache.rehash (static_cast<std::size_t> ((s + (s >> 2)) / m_cache.max_load_factor () + 1));
+        {
+            auto const each = (s + (s >> 2)) / partitions + 1;
+            for (auto& p : m_partitions)
+            {
+                lock_guard lock (p.mutex);
+                p.cache.rehash (static_cast<std::size_t> (
+                    each / p.cache.max_load_factor () + 1));
+            }
+        }
 
         JLOG(m_journal.debug()) <<
             m_name << " target size set to " << s;
@@ -115,49 +133,66 @@ public:
 
     clock_type::rep getTargetAge () const
     {
-        lock_guard lock (m_mutex);
-        return m_target_age.count();
+        return m_target_age;
     }
 
     void setTargetAge (clock_type::rep s)
     {
-        lock_guard lock (m_mutex);
-        m_target_age = std::chrono::seconds (s);
+        m_target_age = clock_type::duration (
+            std::chrono::seconds (s)).count();
         JLOG(m_journal.debug()) <<
-            m_name << " target age set to " << m_target_age.count();
+            m_name << " target age set to " << m_target_age;
     }
 
     int getCacheSize () const
     {
-        lock_guard lock (m_mutex);
-        return m_cache_count;
+        int count = 0;
+        for (auto const& p : m_partitions)
+        {
+            lock_guard lock (p.mutex);
+            count += p.cache_count;
+        }
+        return count;
     }
 
     int getTrackSize () const
     {
-        lock_guard lock (m_mutex);
-        return m_cache.size ();
+        std::size_t size = 0;
+        for (auto const& p : m_partitions)
+        {
+            lock_guard lock (p.mutex);
+            size += p.cache.size ();
+        }
+        return static_cast<int> (size);
     }
 
     float getHitRate ()
     {
-        lock_guard lock (m_mutex);
-        auto const total = static_cast<float> (m_hits + m_misses);
-        return m_hits * (100.0f / std::max (1.0f, total));
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::tie (hits, misses) = getStats ();
+        auto const total = static_cast<float> (hits + misses);
+        return hits * (100.0f / std::max (1.0f, total));
     }
 
     void clearStats ()
     {
-        lock_guard lock (m_mutex);
-        m_hits = 0;
-        m_misses = 0;
+        for (auto& p : m_partitions)
+        {
+            lock_guard lock (p.mutex);
+            p.hits = 0;
+            p.misses = 0;
+        }
     }
 
     void clear ()
     {
-        lock_guard lock (m_mutex);
-        m_cache.clear ();
-        m_cache_count = 0;
+        for (auto& p : m_partitions)
+        {
+            lock_guard lock (p.mutex);
+            p.cache.clear ();
+            p.cache_count = 0;
+        }
     }
 
     void sweep ()
@@ -171,97 +206,105 @@ public:
         //
         std::vector <mapped_ptr> stuffToSweep;
 
-        {
-            clock_type::time_point const now (m_clock.now());
-            clock_type::time_point when_expire;
+        clock_type::time_point const now (m_clock.now());
+        clock_type::time_point when_expire;
 
-            lock_guard lock (m_mutex);
+        int const target_size = m_target_size;
+        clock_type::duration const target_age (m_target_age.load ());
+        int const size = getTrackSize ();
 
-            if (m_target_size == 0 ||
-                (static_cast<int> (m_cache.size ()) <= m_target_size))
-            {
-                when_expire = now - m_target_age;
-            }
-            else
-            {
-                when_expire = now - clock_type::duration (
-                    m_target_age.count() * m_target_size / m_cache.size ());
+        if (target_size == 0 || size <= target_size)
+        {
+            when_expire = now - target_age;
+        }
+        else
+        {
+            when_expire = now - clock_type::duration (
+                target_age.count() * target_size / size);
 
-                clock_type::duration const minimumAge (
-                    std::chrono::seconds (1));
-                if (when_expire > (now - minimumAge))
-                    when_expire = now - minimumAge;
+            clock_type::duration const minimumAge (
+                std::chrono::seconds (1));
+            if (when_expire > (now - minimumAge))
+                when_expire = now - minimumAge;
 
-                JLOG(m_journal.trace()) <<
-                    m_name << " is growing fast " << m_cache.size () << " of " << m_target_size <<
-                        " aging at " << (now - when_expire).count() << " of " << m_target_age.count();
-            }
+            JLOG(m_journal.trace()) <<
+                m_name << " is growing fast " << size << " of " << target_size <<
+                    " aging at " << (now - when_expire).count() << " of " << target_age.count();
+        }
 
-            stuffToSweep.reserve (m_cache.size ());
+        for (auto& p : m_partitions)
+        {
+            {
+                lock_guard lock (p.mutex);
 
-            cache_iterator cit = m_cache.begin ();
+                stuffToSweep.reserve (p.cache.size ());
 
-            while (cit != m_cache.end ())
-            {
-                if (cit->second.isWeak ())
+                cache_iterator cit = p.cache.begin ();
+
+                while (cit != p.cache.end ())
                 {
-                    // weak
-                    if (cit->second.isExpired ())
+                    if (cit->second.isWeak ())
                     {
-                        ++mapRemovals;
-                        cit = m_cache.erase (cit);
+                        // weak
+                        if (cit->second.isExpired ())
+                        {
+                            ++mapRemovals;
+                            cit = p.cache.erase (cit);
+                        }
+                        else
+                        {
+                            ++cit;
+                        }
                     }
-                    else
-                    {
-                        ++cit;
-                    }
-                }
-                else if (cit->second.last_access <= when_expire)
-                {
-                    // strong, expired
-                    --m_cache_count;
-                    ++cacheRemovals;
-                    if (cit->second.ptr.unique ())
+                    else if (cit->second.last_access <= when_expire)
                     {
-                        stuffToSweep.push_back (cit->second.ptr);
-                        ++mapRemovals;
-                        cit = m_cache.erase (cit);
+                        // strong, expired
+                        --p.cache_count;
+                        ++cacheRemovals;
+                        if (cit->second.ptr.unique ())
+                        {
+                            stuffToSweep.push_back (cit->second.ptr);
+                            ++mapRemovals;
+                            cit = p.cache.erase (cit);
+                        }
+                        else
+                        {
+                            // remains weakly cached
+                            cit->second.ptr.reset ();
+                            ++cit;
+                        }
                     }
                     else
                     {
-                        // remains weakly cached
-                        cit->second.ptr.reset ();
+                        // strong, not expired
+                        ++cc;
                         ++cit;
                     }
                 }
-                else
-                {
-                    // strong, not expired
-                    ++cc;
-                    ++cit;
-                }
             }
+
+            // Release what this partition swept before moving on to the
+            // next one, outside the lock.
+            stuffToSweep.clear ();
         }
 
         if (mapRemovals || cacheRemovals)
         {
             JLOG(m_journal.trace()) <<
-                m_name << ": cache = " << m_cache.size () <<
+                m_name << ": cache = " << size <<
                 "-" << cacheRemovals << ", map-=" << mapRemovals;
         }
-
-        // At this point stuffToSweep will go out of scope outside the lock
-        // and decrement the reference count on each strong pointer.
     }
 
     bool del (const key_type& key, bool valid)
     {
         // Remove from cache, if !valid, remove from map too. Returns true if removed from cache
-        lock_guard lock (m_mutex);
+        Partition& p = partition (key);
+        lock_guard lock (p.mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        cache_iterator cit = p.cache.find (key);
 
-        if (cit == m_cache.end ())
+        if (cit == p.cache.end ())
             return false;
 
         Entry& entry = cit->second;
@@ -270,13 +313,13 @@ public:
 
         if (entry.isCached ())
         {
-            --m_cache_count;
+            --p.cache_count;
             entry.ptr.reset ();
             ret = true;
         }
 
         if (!valid || entry.isExpired ())
-            m_cache.erase (cit);
+            p.cache.erase (cit);
 
         return ret;
     }
@@ -298,16 +341,15 @@ public:
     {
         // Return canonical value, store if needed, refresh in cache
         // Return values: true=we had the data already
-        lock_guard lock (m_mutex);
+        Partition& p = partition (key);
+        lock_guard lock (p.mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        cache_iterator cit = p.cache.find (key);
 
-        if (cit == m_cache.end ())
+        if (cit == p.cache.end ())
         {
-            m_cache.emplace (std::piecewise_construct,
-                std::forward_as_tuple(key),
-                std::forward_as_tuple(m_clock.now(), data));
-            ++m_cache_count;
+            p.cache.try_emplace (key, m_clock.now(), data);
+            ++p.cache_count;
             return false;
         }
 
@@ -344,13 +386,13 @@ public:
                 data = cachedData;
             }
 
-            ++m_cache_count;
+            ++p.cache_count;
             return true;
         }
 
         entry.ptr = data;
         entry.weak_ptr = data;
-        ++m_cache_count;
+        ++p.cache_count;
 
         return false;
     }
@@ -358,13 +400,14 @@ public:
     std::shared_ptr<T> fetch (const key_type& key)
     {
         // fetch us a shared pointer to the stored data object
-        lock_guard lock (m_mutex);
+        Partition& p = partition (key);
+        lock_guard lock (p.mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        cache_iterator cit = p.cache.find (key);
 
-        if (cit == m_cache.end ())
+        if (cit == p.cache.end ())
         {
-            ++m_misses;
+            ++p.misses;
             return mapped_ptr ();
         }
 
@@ -373,7 +416,7 @@ public:
 
         if (entry.isCached ())
         {
-            ++m_hits;
+            ++p.hits;
             return entry.ptr;
         }
 
@@ -382,12 +425,12 @@ public:
         if (entry.isCached ())
         {
             // independent of cache size, so not counted as a hit
-            ++m_cache_count;
+            ++p.cache_count;
             return entry.ptr;
         }
 
-        m_cache.erase (cit);
-        ++m_misses;
+        p.cache.erase (cit);
+        ++p.misses;
         return mapped_ptr ();
     }
 
@@ -429,11 +472,12 @@ public:
         bool found = false;
 
         // If present, make current in cache
-        lock_guard lock (m_mutex);
+        Partition& p = partition (key);
+        lock_guard lock (p.mutex);
 
-        cache_iterator cit = m_cache.find (key);
+        cache_iterator cit = p.cache.find (key);
 
-        if (cit != m_cache.end ())
+        if (cit != p.cache.end ())
         {
             Entry& entry = cit->second;
 
@@ -445,7 +489,7 @@ public:
                 if (entry.isCached ())
                 {
                     // We just put the object back in cache
-                    ++m_cache_count;
+                    ++p.cache_count;
                     entry.touch (m_clock.now());
                     found = true;
                 }
@@ -453,7 +497,7 @@ public:
                 {
                     // Couldn't get strong pointer,
                     // object fell out of the cache so remove the entry.
-                    m_cache.erase (cit);
+                    p.cache.erase (cit);
                 }
             }
             else
@@ -471,19 +515,15 @@ public:
         return found;
     }
 
-    mutex_type& peekMutex ()
-    {
-        return m_mutex;
-    }
-
     std::vector <key_type> getKeys ()
     {
         std::vector <key_type> v;
 
+        for (auto& p : m_partitions)
         {
-            lock_guard lock (m_mutex);
-            v.reserve (m_cache.size());
-            for (auto const& _ : m_cache)
+            lock_guard lock (p.mutex);
+            v.reserve (v.size() + p.cache.size());
+            for (auto const& _ : p.cache)
                 v.push_back (_.first);
         }
 
@@ -491,6 +531,20 @@ public:
     }
 
 private:
+    // Returns the total hits and misses across all partitions
+    std::pair <std::uint64_t, std::uint64_t> getStats () const
+    {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        for (auto const& p : m_partitions)
+        {
+            lock_guard lock (p.mutex);
+            hits += p.hits;
+            misses += p.misses;
+        }
+        return { hits, misses };
+    }
+
     void collect_metrics ()
     {
         m_stats.size.set (getCacheSize ());
@@ -498,10 +552,12 @@ private:
         {
             beast::insight::Gauge::value_type hit_rate (0);
             {
-                lock_guard lock (m_mutex);
-                auto const total (m_hits + m_misses);
+                std::uint64_t hits;
+                std::uint64_t misses;
+                std::tie (hits, misses) = getStats ();
+                auto const total (hits + misses);
                 if (total != 0)
-                    hit_rate = (m_hits * 100) / total;
+                    hit_rate = (hits * 100) / total;
             }
             m_stats.hit_rate.set (hit_rate);
         }
@@ -545,29 +601,46 @@ private:
         void touch (clock_type::time_point const& now) { last_access = now; }
     };
 
-    using cache_type = hardened_hash_map <key_type, Entry, Hash, KeyEqual>;
+    using cache_type = flat_hash_map <key_type, Entry, Hash, KeyEqual>;
     using cache_iterator = typename cache_type::iterator;
 
+    // An independently locked slice of the map
+    struct Partition
+    {
+        mutex_type mutable mutex;
+
+        // Number of items cached
+        int cache_count = 0;
+        cache_type cache;  // Hold strong reference to recent objects
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+    };
+
+    // The low bits of the hash place the key within the partition's
+    // map, so the partition is chosen from the high bits.
+    Partition& partition (key_type const& key)
+    {
+        auto constexpr shift =
+            std::numeric_limits <std::size_t>::digits - 8;
+        return m_partitions[(m_hash (key) >> shift) % partitions];
+    }
+
     beast::Journal m_journal;
     clock_type& m_clock;
     Stats m_stats;
 
-    mutex_type mutable m_mutex;
-
     // Used for logging
     std::string m_name;
 
     // Desired number of cache entries (0 = ignore)
-    int m_target_size;
+    std::atomic <int> m_target_size;
 
     // Desired maximum cache age
-    clock_type::duration m_target_age;
+    std::atomic <clock_type::rep> m_target_age;
 
-    // Number of items cached
-    int m_cache_count;
-    cache_type m_cache;  // Hold strong reference to recent objects
-    std::uint64_t m_hits;
-    std::uint64_t m_misses;
+    // Selects the partition for a key
+    Hash m_hash;
+    std::array <Partition, partitions> m_partitions;
 };
 
 }
@@ -0,0 +1,797 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#ifndef RIPPLE_BASICS_FLAT_HASH_MAP_H_INCLUDED
+#define RIPPLE_BASICS_FLAT_HASH_MAP_H_INCLUDED
+
+#include <ripple/basics/base_uint.h>
+#include <ripple/basics/hardened_hash.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ripple {
+
+namespace detail {
+
+// Multiplies two 64-bit values and folds the 128-bit product
+inline
+std::uint64_t
+fold_multiply (std::uint64_t a, std::uint64_t b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    auto const r = static_cast<unsigned __int128> (a) * b;
+    return static_cast<std::uint64_t> (r) ^
+        static_cast<std::uint64_t> (r >> 64);
+#else
+    std::uint64_t const a0 = a & 0xffffffff, a1 = a >> 32;
+    std::uint64_t const b0 = b & 0xffffffff, b1 = b >> 32;
+    std::uint64_t const p00 = a0 * b0, p01 = a0 * b1;
+    std::uint64_t const p10 = a1 * b0, p11 = a1 * b1;
+    std::uint64_t const mid = (p00 >> 32) + (p01 & 0xffffffff) + p10;
+    std::uint64_t const lo = (mid << 32) | (p00 & 0xffffffff);
+    std::uint64_t const hi = p11 + (p01 >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+inline
+seed_pair const&
+flat_hash_seed ()
+{
+    static seed_pair const seed = make_seed_pair<> ();
+    return seed;
+}
+
+} // detail
+
+/** The default hash function for flat_hash_map.
+
+    Keys without a specialization are hashed with hardened_hash.
+*/
+template <class Key>
+struct flat_hash : hardened_hash<>
+{
+};
+
+/** Hashes a base_uint by mixing its bits directly.
+
+    Most of these keys are digests, whose bits are already uniformly
+    distributed, so running them through a general purpose hash as
+    hardened_hash does buys nothing. Instead the key's 64-bit words are
+    combined a pair at a time with a folded 128-bit multiply, keyed by a
+    random per-process seed.
+
+    The seed is what defends against hash flooding, as it does for
+    hardened_hash: without it, an attacker grinding out digests could
+    choose keys that collide.
+*/
+template <std::size_t Bits, class Tag>
+struct flat_hash <base_uint<Bits, Tag>>
+{
+    using result_type = std::size_t;
+
+    result_type
+    operator() (base_uint<Bits, Tag> const& key) const noexcept
+    {
+        // An even number of words, zero padded
+        std::size_t constexpr n = 2 * ((Bits + 127) / 128);
+        std::uint64_t words[n] = {};
+        std::memcpy (words, key.data (), key.size ());
+
+        auto const& seed = detail::flat_hash_seed ();
+        std::uint64_t h = seed.first;
+        for (std::size_t i = 0; i != n; i += 2)
+            h = detail::fold_multiply (
+                words[i] ^ h, words[i + 1] ^ seed.second);
+        return static_cast<result_type> (h);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+/** An unordered map that stores its elements in a flat array.
+
+    The interface follows std::unordered_map, with these differences:
+
+    - Inserting may move elements, invalidating all iterators,
+      pointers and references. Erasing only invalidates those to the
+      erased element.
+    - Elements must be move constructible.
+
+    The layout follows the "Swiss table" design. A byte of metadata for
+    each slot holds seven bits of the element's hash, or marks the slot
+    empty or deleted. Slots are probed in groups of sixteen, comparing
+    all of a group's metadata bytes at once with SSE2 where available.
+    Only metadata matches touch the elements themselves, so a lookup
+    usually reads one cache line of metadata and one element. The table
+    grows when seven eighths of its slots are in use.
+*/
+template <
+    class Key,
+    class T,
+    class Hash = flat_hash <Key>,
+    class KeyEqual = std::equal_to <Key>
+>
+class flat_hash_map
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair <Key const, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using reference = value_type&;
+    using const_reference = value_type const&;
+    using pointer = value_type*;
+    using const_pointer = value_type const*;
+
+private:
+    using ctrl_t = std::int8_t;
+
+    static std::size_t constexpr group_size = 16;
+    static std::size_t constexpr min_capacity = group_size;
+
+    // Metadata for slots without an element. Full slots hold
+    // seven bits of their hash, so they are never negative.
+    static ctrl_t constexpr ctrl_empty = -128;
+    static ctrl_t constexpr ctrl_deleted = -2;
+
+    static std::size_t constexpr npos = std::size_t (-1);
+
+    template <bool IsConst>
+    class basic_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = flat_hash_map::value_type;
+        using difference_type = flat_hash_map::difference_type;
+        using pointer = typename std::conditional <IsConst,
+            value_type const*, value_type*>::type;
+        using reference = typename std::conditional <IsConst,
+            value_type const&, value_type&>::type;
+
+        basic_iterator () = default;
+
+        // Iterators convert to const_iterators
+        template <bool OtherConst,
+            class = typename std::enable_if <
+                IsConst && ! OtherConst>::type>
+        basic_iterator (basic_iterator <OtherConst> const& other)
+            : ctrl_ (other.ctrl_)
+            , end_ (other.end_)
+            , slot_ (other.slot_)
+        {
+        }
+
+        reference operator* () const { return *slot_; }
+        pointer operator-> () const { return slot_; }
+
+        basic_iterator&
+        operator++ ()
+        {
+            ++ctrl_;
+            ++slot_;
+            skip ();
+            return *this;
+        }
+
+        basic_iterator
+        operator++ (int)
+        {
+            auto const prev = *this;
+            ++*this;
+            return prev;
+        }
+
+        friend
+        bool
+        operator== (basic_iterator const& lhs, basic_iterator const& rhs)
+        {
+            return lhs.ctrl_ == rhs.ctrl_;
+        }
+
+        friend
+        bool
+        operator!= (basic_iterator const& lhs, basic_iterator const& rhs)
+        {
+            return lhs.ctrl_ != rhs.ctrl_;
+        }
+
+    private:
+        friend class flat_hash_map;
+        template <bool> friend class basic_iterator;
+
+        ctrl_t const* ctrl_ = nullptr;
+        ctrl_t const* end_ = nullptr;
+        pointer slot_ = nullptr;
+
+        basic_iterator (ctrl_t const* ctrl,
+                ctrl_t const* end, pointer slot)
+            : ctrl_ (ctrl)
+            , end_ (end)
+            , slot_ (slot)
+        {
+        }
+
+        // Advance to the next full slot
+        void
+        skip ()
+        {
+            while (ctrl_ != end_ && *ctrl_ < 0)
+            {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+    };
+
+public:
+    using iterator = basic_iterator <false>;
+    using const_iterator = basic_iterator <true>;
+
+    flat_hash_map () = default;
+
+    explicit
+    flat_hash_map (size_type count,
+            Hash const& hash = Hash (),
+            KeyEqual const& equal = KeyEqual ())
+        : hash_ (hash)
+        , equal_ (equal)
+    {
+        reserve (count);
+    }
+
+    flat_hash_map (flat_hash_map const& other)
+        : hash_ (other.hash_)
+        , equal_ (other.equal_)
+    {
+        reserve (other.size ());
+        for (auto const& v : other)
+            insert (v);
+    }
+
+    flat_hash_map (flat_hash_map&& other) noexcept
+        : hash_ (other.hash_)
+        , equal_ (other.equal_)
+    {
+        swap (other);
+    }
+
+    flat_hash_map&
+    operator= (flat_hash_map other) noexcept
+    {
+        swap (other);
+        return *this;
+    }
+
+    ~flat_hash_map ()
+    {
+        destroy_all ();
+        deallocate ();
+    }
+
+    void
+    swap (flat_hash_map& other) noexcept
+    {
+        using std::swap;
+        swap (ctrl_, other.ctrl_);
+        swap (slots_, other.slots_);
+        swap (capacity_, other.capacity_);
+        swap (size_, other.size_);
+        swap (growth_left_, other.growth_left_);
+        swap (hash_, other.hash_);
+        swap (equal_, other.equal_);
+    }
+
+    friend
+    void
+    swap (flat_hash_map& lhs, flat_hash_map& rhs) noexcept
+    {
+        lhs.swap (rhs);
+    }
+
+    //--------------------------------------------------------------------------
+
+    iterator
+    begin () noexcept
+    {
+        iterator it (ctrl_.get (), ctrl_.get () + capacity_, slots_);
+        it.skip ();
+        return it;
+    }
+
+    const_iterator
+    begin () const noexcept
+    {
+        const_iterator it (ctrl_.get (), ctrl_.get () + capacity_, slots_);
+        it.skip ();
+        return it;
+    }
+
+    const_iterator cbegin () const noexcept { return begin (); }
+
+    iterator
+    end () noexcept
+    {
+        auto const end = ctrl_.get () + capacity_;
+        return iterator (end, end, slots_ + capacity_);
+    }
+
+    const_iterator
+    end () const noexcept
+    {
+        auto const end = ctrl_.get () + capacity_;
+        return const_iterator (end, end, slots_ + capacity_);
+    }
+
+    const_iterator cend () const noexcept { return end (); }
+
+    bool empty () const noexcept { return size_ == 0; }
+    size_type size () const noexcept { return size_; }
+
+    /** The number of slots, full or not. */
+    size_type bucket_count () const noexcept { return capacity_; }
+
+    float
+    load_factor () const noexcept
+    {
+        return capacity_ == 0 ? 0.0f :
+            static_cast<float> (size_) / capacity_;
+    }
+
+    float max_load_factor () const noexcept { return 0.875f; }
+
+    /** The memory held by the table, in bytes. */
+    std::size_t
+    memory () const noexcept
+    {
+        return capacity_ * (sizeof (value_type) + sizeof (ctrl_t));
+    }
+
+    hasher hash_function () const { return hash_; }
+    key_equal key_eq () const { return equal_; }
+
+    //--------------------------------------------------------------------------
+
+    void
+    clear () noexcept
+    {
+        destroy_all ();
+        if (capacity_ != 0)
+            std::fill_n (ctrl_.get (), capacity_, ctrl_empty);
+        size_ = 0;
+        growth_left_ = max_size_for (capacity_);
+    }
+
+    /** Insert a value constructed from the arguments, unless the key is
+        already present.
+    */
+    template <class... Args>
+    std::pair <iterator, bool>
+    try_emplace (key_type const& key, Args&&... args)
+    {
+        auto const h = hash_ (key);
+        auto const found = find_index (key, h);
+        if (found != npos)
+            return { make_iterator (found), false };
+
+        auto const i = prepare_insert (h);
+        ::new (static_cast<void*> (slots_ + i)) value_type (
+            std::piecewise_construct,
+            std::forward_as_tuple (key),
+            std::forward_as_tuple (std::forward <Args> (args)...));
+        commit_insert (i, h);
+        return { make_iterator (i), true };
+    }
+
+    template <class V>
+    std::pair <iterator, bool>
+    emplace (key_type const& key, V&& value)
+    {
+        return try_emplace (key, std::forward <V> (value));
+    }
+
+    std::pair <iterator, bool>
+    insert (value_type const& value)
+    {
+        return try_emplace (value.first, value.second);
+    }
+
+    std::pair <iterator, bool>
+    insert (value_type&& value)
+    {
+        return try_emplace (value.first, std::move (value.second));
+    }
+
+    mapped_type&
+    operator[] (key_type const& key)
+    {
+        return try_emplace (key).first->second;
+    }
+
+    iterator
+    find (key_type const& key)
+    {
+        auto const i = find_index (key, hash_ (key));
+        return i == npos ? end () : make_iterator (i);
+    }
+
+    const_iterator
+    find (key_type const& key) const
+    {
+        auto const i = find_index (key, hash_ (key));
+        if (i == npos)
+            return end ();
+        return const_iterator (ctrl_.get () + i,
+            ctrl_.get () + capacity_, slots_ + i);
+    }
+
+    size_type
+    count (key_type const& key) const
+    {
+        return find_index (key, hash_ (key)) == npos ? 0 : 1;
+    }
+
+    /** Remove an element, returning an iterator to the next one. */
+    iterator
+    erase (const_iterator pos)
+    {
+        auto const i = static_cast<std::size_t> (pos.ctrl_ - ctrl_.get ());
+        erase_index (i);
+        iterator next (ctrl_.get () + i, ctrl_.get () + capacity_, slots_ + i);
+        next.skip ();
+        return next;
+    }
+
+    iterator
+    erase (iterator pos)
+    {
+        return erase (const_iterator (pos));
+    }
+
+    size_type
+    erase (key_type const& key)
+    {
+        auto const i = find_index (key, hash_ (key));
+        if (i == npos)
+            return 0;
+        erase_index (i);
+        return 1;
+    }
+
+    /** Make room for at least `count` elements without growing. */
+    void
+    reserve (size_type count)
+    {
+        if (count > max_size_for (capacity_))
+            resize (capacity_for (count));
+    }
+
+    /** Resize to at least `count` slots, or enough for the elements. */
+    void
+    rehash (size_type count)
+    {
+        auto const capacity = std::max (capacity_for (size_),
+            count == 0 ? 0 : round_up (count));
+        if (capacity != capacity_)
+            resize (capacity);
+    }
+
+private:
+    // The metadata, then the slots they describe
+    std::unique_ptr <ctrl_t[]> ctrl_;
+    value_type* slots_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+
+    // How many more elements fit in empty slots before the table has
+    // to grow. Reusing a deleted slot does not count against this.
+    std::size_t growth_left_ = 0;
+
+    Hash hash_;
+    KeyEqual equal_;
+
+    //--------------------------------------------------------------------------
+
+    static
+    std::size_t
+    max_size_for (std::size_t capacity)
+    {
+        return capacity - capacity / 8;
+    }
+
+    static
+    std::size_t
+    round_up (std::size_t count)
+    {
+        std::size_t capacity = min_capacity;
+        while (capacity < count)
+            capacity *= 2;
+        return capacity;
+    }
+
+    static
+    std::size_t
+    capacity_for (std::size_t count)
+    {
+        if (count == 0)
+            return 0;
+        std::size_t capacity = min_capacity;
+        while (max_size_for (capacity) < count)
+            capacity *= 2;
+        return capacity;
+    }
+
+    static
+    ctrl_t
+    h2 (std::size_t h)
+    {
+        return static_cast<ctrl_t> (h & 0x7f);
+    }
+
+    // Bit i is set if byte i of the group matches
+    static
+    std::uint32_t
+    match (ctrl_t const* group, ctrl_t c)
+    {
+#if defined(__SSE2__)
+        auto const v = _mm_loadu_si128 (
+            reinterpret_cast<__m128i const*> (group));
+        return static_cast<std::uint32_t> (_mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (_mm_set1_epi8 (c), v)));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i != group_size; ++i)
+            if (group[i] == c)
+                mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+    // Bit i is set if slot i of the group is empty or deleted
+    static
+    std::uint32_t
+    match_free (ctrl_t const* group)
+    {
+#if defined(__SSE2__)
+        return static_cast<std::uint32_t> (_mm_movemask_epi8 (
+            _mm_loadu_si128 (reinterpret_cast<__m128i const*> (group))));
+#else
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i != group_size; ++i)
+            if (group[i] < 0)
+                mask |= 1u << i;
+        return mask;
+#endif
+    }
+
+    static
+    std::size_t
+    lowest_bit (std::uint32_t mask)
+    {
+        assert (mask != 0);
+#if defined(__GNUC__)
+        return static_cast<std::size_t> (__builtin_ctz (mask));
+#else
+        std::size_t i = 0;
+        while ((mask & 1) == 0)
+        {
+            mask >>= 1;
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    iterator
+    make_iterator (std::size_t i)
+    {
+        return iterator (ctrl_.get () + i,
+            ctrl_.get () + capacity_, slots_ + i);
+    }
+
+    // Groups are probed quadratically, which visits every group
+    // because their number is a power of two.
+    std::size_t
+    find_index (key_type const& key, std::size_t h) const
+    {
+        if (size_ == 0)
+            return npos;
+
+        auto const groups = capacity_ / group_size;
+        auto const tag = h2 (h);
+        auto g = (h >> 7) & (groups - 1);
+        for (std::size_t step = 1; step <= groups; ++step)
+        {
+            auto const group = ctrl_.get () + g * group_size;
+            for (auto m = match (group, tag); m != 0; m &= m - 1)
+            {
+                auto const i = g * group_size + lowest_bit (m);
+                if (equal_ (slots_[i].first, key))
+                    return i;
+            }
+            if (match (group, ctrl_empty) != 0)
+                return npos;
+            g = (g + step) & (groups - 1);
+        }
+        return npos;
+    }
+
+    // The first empty or deleted slot on the key's probe sequence
+    std::size_t
+    find_free (std::size_t h) const
+    {
+        auto const groups = capacity_ / group_size;
+        auto g = (h >> 7) & (groups - 1);
+        for (std::size_t step = 1; ; ++step)
+        {
+            assert (step <= groups);
+            auto const group = ctrl_.get () + g * group_size;
+            auto const m = match_free (group);
+            if (m != 0)
+                return g * group_size + lowest_bit (m);
+            g = (g + step) & (groups - 1);
+        }
+    }
+
+    // Returns the slot a new element with this hash should go in,
+    // growing or cleaning the table first if needed.
+    std::size_t
+    prepare_insert (std::size_t h)
+    {
+        if (capacity_ == 0)
+            resize (min_capacity);
+
+        auto i = find_free (h);
+        if (growth_left_ == 0 && ctrl_[i] == ctrl_empty)
+        {
+            // Rebuilding at the same size is enough if deleted
+            // slots, rather than elements, are what fill the table.
+            if (size_ < max_size_for (capacity_) / 2)
+                resize (capacity_);
+            else
+                resize (capacity_ * 2);
+            i = find_free (h);
+        }
+        return i;
+    }
+
+    void
+    commit_insert (std::size_t i, std::size_t h)
+    {
+        if (ctrl_[i] == ctrl_empty)
+            --growth_left_;
+        ctrl_[i] = h2 (h);
+        ++size_;
+    }
+
+    void
+    erase_index (std::size_t i)
+    {
+        assert (ctrl_[i] >= 0);
+        slots_[i].~value_type ();
+        --size_;
+
+        // A probe stops at the first group with an empty slot. If this
+        // group already has one, no probe has ever gone past it, so the
+        // slot can be empty too. Otherwise it must stay on the probe
+        // sequences that do.
+        auto const group = ctrl_.get () + (i / group_size) * group_size;
+        if (match (group, ctrl_empty) != 0)
+        {
+            ctrl_[i] = ctrl_empty;
+            ++growth_left_;
+        }
+        else
+        {
+            ctrl_[i] = ctrl_deleted;
+        }
+    }
+
+    void
+    resize (std::size_t capacity)
+    {
+        assert (capacity >= min_capacity || capacity == 0);
+        assert (max_size_for (capacity) >= size_);
+
+        flat_hash_map next;
+        next.hash_ = hash_;
+        next.equal_ = equal_;
+        if (capacity != 0)
+        {
+            next.ctrl_.reset (new ctrl_t[capacity]);
+            std::fill_n (next.ctrl_.get (), capacity, ctrl_empty);
+            next.slots_ = std::allocator <value_type> ().allocate (capacity);
+            next.capacity_ = capacity;
+            next.growth_left_ = max_size_for (capacity);
+        }
+
+        for (std::size_t i = 0; i != capacity_; ++i)
+        {
+            if (ctrl_[i] < 0)
+                continue;
+            auto const h = hash_ (slots_[i].first);
+            auto const j = next.find_free (h);
+            ::new (static_cast<void*> (next.slots_ + j)) value_type (
+                std::move (slots_[i]));
+            next.commit_insert (j, h);
+            slots_[i].~value_type ();
+            ctrl_[i] = ctrl_empty;
+        }
+        size_ = 0;
+
+        swap (next);
+    }
+
+    void
+    destroy_all () noexcept
+    {
+        for (std::size_t i = 0; i != capacity_; ++i)
+            if (ctrl_[i] >= 0)
+                slots_[i].~value_type ();
+    }
+
+    void
+    deallocate () noexcept
+    {
+        if (slots_ != nullptr)
+            std::allocator <value_type> ().deallocate (slots_, capacity_);
+        slots_ = nullptr;
+        ctrl_.reset ();
+        capacity_ = 0;
+    }
+};
+
+template <class Key, class T, class Hash, class KeyEqual>
+std::size_t constexpr
+flat_hash_map<Key, T, Hash, KeyEqual>::group_size;
+
+template <class Key, class T, class Hash, class KeyEqual>
+std::size_t constexpr
+flat_hash_map<Key, T, Hash, KeyEqual>::min_capacity;
+
+template <class Key, class T, class Hash, class KeyEqual>
+std::int8_t constexpr
+flat_hash_map<Key, T, Hash, KeyEqual>::ctrl_empty;
+
+template <class Key, class T, class Hash, class KeyEqual>
+std::int8_t constexpr
+flat_hash_map<Key, T, Hash, KeyEqual>::ctrl_deleted;
+
+template <class Key, class T, class Hash, class KeyEqual>
+std::size_t constexpr
+flat_hash_map<Key, T, Hash, KeyEqual>::npos;
+
+} // ripple
+
+#endif
@@ -29,6 +29,7 @@ struct ConfigSection
 {
     static std::string nodeDatabase ()       { return "node_db"; }
     static std::string importNodeDatabase () { return "import_db"; }
+    static std::string shardDatabase ()      { return "shard_db"; }
 };
 
 // VFALCO TODO Rename and replace these macros with variables.
@@ -29,6 +29,7 @@
 #include <ripple/core/impl/Workers.h>
 #include <ripple/json/json_value.h>
 #include <boost/coroutine/all.hpp>
+#include <atomic>
 
 namespace ripple {
 
@@ -192,13 +193,27 @@ private:
 
     beast::Journal m_journal;
     mutable std::mutex m_mutex;
-    std::uint64_t m_lastJob;
-    std::set <Job> m_jobSet;
+    std::atomic <std::uint64_t> m_lastJob;
     JobDataMap m_jobData;
     JobTypeData m_invalidJobData;
 
+    // Each bit is set while the JobType with that value has a waiting
+    // job and is running below its limit. Threads looking for work use
+    // this to find the highest priority runnable type without taking
+    // the lock of every type.
+    std::atomic <std::uint64_t> m_ready;
+
+    // Threads that find no runnable type wait here, rather than
+    // spinning, until a bit in m_ready is set.
+    std::mutex readyMutex_;
+    std::condition_variable readyCv_;
+    std::atomic <int> readyWaiters_ {0};
+
+    // The number of jobs waiting, of all types
+    std::atomic <int> m_jobCount;
+
     // The number of jobs currently in processTask()
-    int m_processCount;
+    std::atomic <int> m_processCount;
 
     // The number of suspended coroutines
     int nSuspend_ = 0;
@@ -227,44 +242,53 @@ private:
     // Signals the service stopped if the stopped condition is met.
     void checkStopped (std::lock_guard <std::mutex> const& lock);
 
-    // Signals an added Job for processing.
+    // Sets or clears the bit for the JobType in m_ready.
+    //
+    // Invariants:
+    //  The calling thread owns the lock of the JobTypeData
+    void updateReady (JobTypeData& data,
+        std::lock_guard <std::mutex> const& lock);
+
+    // Adds a Job to the waiting jobs of its type.
     //
     // Pre-conditions:
     //  The JobType must be valid.
-    //  The Job must exist in mJobSet.
     //  The Job must not have previously been queued.
     //
     // Post-conditions:
     //  Count of waiting jobs of that type will be incremented.
-    //  If JobQueue exists, and has at least one thread, Job will eventually run.
+    //  Returns true if the caller must signal a task for the Job,
+    //  otherwise the task is deferred until the type is below its limit.
     //
     // Invariants:
-    //  The calling thread owns the JobLock
-    void queueJob (Job const& job, std::lock_guard <std::mutex> const& lock);
+    //  The calling thread owns the lock of the JobTypeData
+    bool queueJob (JobTypeData& data, Job&& job,
+        std::lock_guard <std::mutex> const& lock);
 
     // Returns the next Job we should run now.
     //
     // RunnableJob:
-    //  A Job in the JobSet whose slots count for its type is greater than zero.
+    //  A waiting Job whose slots count for its type is greater than zero.
     //
     // Pre-conditions:
-    //  mJobSet must not be empty.
-    //  mJobSet holds at least one RunnableJob
+    //  A signaled task is held by the calling thread, so that at least
+    //  one RunnableJob exists or will exist once another thread finishes
+    //  updating its JobType.
     //
     // Post-conditions:
-    //  job is a valid Job object.
-    //  job is removed from mJobQueue.
+    //  job is the oldest waiting Job of the highest priority runnable type.
+    //  job is removed from the waiting jobs of its type.
     //  Waiting job count of its type is decremented
     //  Running job count of its type is incremented
     //
     // Invariants:
-    //  The calling thread owns the JobLock
+    //  <none>
     void getNextJob (Job& job);
 
     // Indicates that a running Job has completed its task.
     //
     // Pre-conditions:
-    //  Job must not exist in mJobSet.
+    //  Job must not be waiting.
     //  The JobType must not be invalid.
     //
     // Post-conditions:
@@ -286,7 +310,7 @@ private:
     // Runs the next appropriate waiting Job.
     //
     // Pre-conditions:
-    //  A RunnableJob must exist in the JobSet
+    //  A RunnableJob must exist
     //
     // Post-conditions:
     //  The chosen RunnableJob will have Job::doJob() called.
@@ -21,8 +21,11 @@
 #define RIPPLE_CORE_JOBTYPEDATA_H_INCLUDED
 
 #include <ripple/basics/Log.h>
+#include <ripple/core/Job.h>
 #include <ripple/core/JobTypeInfo.h>
 #include <ripple/beast/insight/Collector.h>
+#include <deque>
+#include <mutex>
 
 namespace ripple
 {
@@ -48,6 +51,12 @@ public:
     /* And the number we deferred executing because of job limits */
     int deferred;
 
+    /* Protects the counts above and the waiting jobs */
+    std::mutex mutable mutex;
+
+    /* The jobs of this type waiting to run, oldest first */
+    std::deque <Job> jobs;
+
     /* Notification callbacks */
     beast::insight::Event dequeue;
     beast::insight::Event execute;
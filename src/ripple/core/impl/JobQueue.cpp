@@ -29,6 +29,8 @@ JobQueue::JobQueue (beast::insight::Collector::ptr const& collector,
     , m_journal (journal)
     , m_lastJob (0)
     , m_invalidJobData (getJobTypes ().getInvalid (), collector, logs)
+    , m_ready (0)
+    , m_jobCount (0)
     , m_processCount (0)
     , m_workers (*this, "JobQueue", 0)
     , m_cancelCallback (std::bind (&Stoppable::isStopping, this))
@@ -37,20 +39,19 @@ JobQueue::JobQueue (beast::insight::Collector::ptr const& collector,
     hook = m_collector->make_hook (std::bind (&JobQueue::collect, this));
     job_count = m_collector->make_gauge ("job_count");
 
+    for (auto const& x : getJobTypes ())
     {
-        std::lock_guard <std::mutex> lock (m_mutex);
+        JobTypeInfo const& jt = x.second;
 
-        for (auto const& x : getJobTypes ())
-        {
-            JobTypeInfo const& jt = x.second;
-
-            // And create dynamic information for all jobs
-            auto const result (m_jobData.emplace (std::piecewise_construct,
-                std::forward_as_tuple (jt.type ()),
-                std::forward_as_tuple (jt, m_collector, logs)));
-            assert (result.second == true);
-            (void) result.second;
-        }
+        // Every job type needs a bit in m_ready
+        assert (jt.type () >= 0 && jt.type () < 64);
+
+        // And create dynamic information for all jobs
+        auto const result (m_jobData.emplace (std::piecewise_construct,
+            std::forward_as_tuple (jt.type ()),
+            std::forward_as_tuple (jt, m_collector, logs)));
+        assert (result.second == true);
+        (void) result.second;
     }
 }
 
@@ -63,8 +64,7 @@ JobQueue::~JobQueue ()
 void
 JobQueue::collect ()
 {
-    std::lock_guard <std::mutex> lock (m_mutex);
-    job_count = m_jobSet.size ();
+    job_count = m_jobCount.load ();
 }
 
 void
@@ -84,6 +84,9 @@ JobQueue::addJob (JobType type, std::string const& name,
     // do not add jobs to a queue with no threads
     assert (type == jtCLIENT || m_workers.getNumberOfThreads () > 0);
 
+    // Build the job before taking the lock, it allocates
+    Job job (type, name, ++m_lastJob, data.load (), func, m_cancelCallback);
+
     {
         std::lock_guard <std::mutex> lock (m_mutex);
 
@@ -99,39 +102,51 @@ JobQueue::addJob (JobType type, std::string const& name,
         //      * Not all children are stopped
         //
         assert (! isStopped() && (
-            m_processCount>0 ||
-            ! m_jobSet.empty () ||
+            m_processCount > 0 ||
+            m_jobCount > 0 ||
             ! areChildrenStopped()));
 
-        std::pair <std::set <Job>::iterator, bool> result (
-            m_jobSet.insert (Job (type, name, ++m_lastJob,
-                data.load (), func, m_cancelCallback)));
-        queueJob (*result.first, lock);
+        // Counted under the lock so that checkStopped can't see an
+        // empty queue while a job is being added, and before the job
+        // can be taken, so the count of waiting jobs never goes
+        // negative.
+        ++m_jobCount;
+    }
+
+    bool signal;
+    {
+        std::lock_guard <std::mutex> lock (data.mutex);
+        signal = queueJob (data, std::move (job), lock);
     }
+
+    if (signal)
+        m_workers.addTask ();
 }
 
 int
 JobQueue::getJobCount (JobType t) const
 {
-    std::lock_guard <std::mutex> lock (m_mutex);
-
     JobDataMap::const_iterator c = m_jobData.find (t);
 
-    return (c == m_jobData.end ())
-        ? 0
-        : c->second.waiting;
+    if (c == m_jobData.end ())
+        return 0;
+
+    JobTypeData const& data = c->second;
+    std::lock_guard <std::mutex> lock (data.mutex);
+    return data.waiting;
 }
 
 int
 JobQueue::getJobCountTotal (JobType t) const
 {
-    std::lock_guard <std::mutex> lock (m_mutex);
-
     JobDataMap::const_iterator c = m_jobData.find (t);
 
-    return (c == m_jobData.end ())
-        ? 0
-        : (c->second.waiting + c->second.running);
+    if (c == m_jobData.end ())
+        return 0;
+
+    JobTypeData const& data = c->second;
+    std::lock_guard <std::mutex> lock (data.mutex);
+    return data.waiting + data.running;
 }
 
 int
@@ -140,12 +155,13 @@ JobQueue::getJobCountGE (JobType t) const
     // return the number of jobs at this priority level or greater
     int ret = 0;
 
-    std::lock_guard <std::mutex> lock (m_mutex);
-
     for (auto const& x : m_jobData)
     {
         if (x.first >= t)
+        {
+            std::lock_guard <std::mutex> lock (x.second.mutex);
             ret += x.second.waiting;
+        }
     }
 
     return ret;
@@ -226,8 +242,6 @@ JobQueue::getJson (int c)
 
     Json::Value priorities = Json::arrayValue;
 
-    std::lock_guard <std::mutex> lock (m_mutex);
-
     for (auto& x : m_jobData)
     {
         assert (x.first != jtINVALID);
@@ -239,8 +253,13 @@ JobQueue::getJson (int c)
 
         LoadMonitor::Stats stats (data.stats ());
 
-        int waiting (data.waiting);
-        int running (data.running);
+        int waiting;
+        int running;
+        {
+            std::lock_guard <std::mutex> lock (data.mutex);
+            waiting = data.waiting;
+            running = data.running;
+        }
 
         if ((stats.count != 0) || (waiting != 0) ||
             (stats.latencyPeak != 0) || (running != 0))
@@ -281,7 +300,7 @@ JobQueue::rendezvous()
     cv_.wait(lock, [&]
     {
         return m_processCount == 0 &&
-            m_jobSet.empty();
+            m_jobCount == 0;
     });
 }
 
@@ -320,7 +339,7 @@ JobQueue::checkStopped (std::lock_guard <std::mutex> const& lock)
     if (isStopping() &&
         areChildrenStopped() &&
         (m_processCount == 0) &&
-        m_jobSet.empty() &&
+        (m_jobCount == 0) &&
         nSuspend_ == 0)
     {
         stopped();
@@ -328,17 +347,43 @@ JobQueue::checkStopped (std::lock_guard <std::mutex> const& lock)
 }
 
 void
-JobQueue::queueJob (Job const& job, std::lock_guard <std::mutex> const& lock)
+JobQueue::updateReady (JobTypeData& data,
+    std::lock_guard <std::mutex> const& lock)
+{
+    std::uint64_t const bit = std::uint64_t (1) << data.type ();
+
+    if (! data.jobs.empty () && data.running < data.info.limit ())
+    {
+        m_ready.fetch_or (bit);
+
+        // Both this and the waiter's increment are sequentially
+        // consistent, so either we see the waiter or it sees the bit.
+        if (readyWaiters_.load () > 0)
+        {
+            std::lock_guard <std::mutex> readyLock (readyMutex_);
+            readyCv_.notify_all ();
+        }
+    }
+    else
+    {
+        m_ready.fetch_and (~bit);
+    }
+}
+
+bool
+JobQueue::queueJob (JobTypeData& data, Job&& job,
+    std::lock_guard <std::mutex> const& lock)
 {
     JobType const type (job.getType ());
     assert (type != jtINVALID);
-    assert (m_jobSet.find (job) != m_jobSet.end ());
+    assert (type == data.type ());
 
-    JobTypeData& data (getJobTypeData (type));
+    data.jobs.push_back (std::move (job));
 
-    if (data.waiting + data.running < getJobLimit (type))
+    bool signal = false;
+    if (data.waiting + data.running < data.info.limit ())
     {
-        m_workers.addTask ();
+        signal = true;
     }
     else
     {
@@ -347,40 +392,61 @@ JobQueue::queueJob (Job const& job, std::lock_guard <std::mutex> const& lock)
         ++data.deferred;
     }
     ++data.waiting;
+
+    updateReady (data, lock);
+    return signal;
 }
 
 void
 JobQueue::getNextJob (Job& job)
 {
-    assert (! m_jobSet.empty ());
-
-    std::set <Job>::const_iterator iter;
-    for (iter = m_jobSet.begin (); iter != m_jobSet.end (); ++iter)
+    for (;;)
     {
-        JobTypeData& data (getJobTypeData (iter->getType ()));
+        std::uint64_t const ready = m_ready.load ();
 
-        assert (data.running <= getJobLimit (data.type ()));
-
-        // Run this job if we're running below the limit.
-        if (data.running < getJobLimit (data.type ()))
+        if (ready == 0)
         {
-            assert (data.waiting > 0);
-            break;
+            // The job we were signaled for is being published by
+            // another thread which still holds the lock for its type.
+            std::unique_lock <std::mutex> readyLock (readyMutex_);
+            ++readyWaiters_;
+            readyCv_.wait (readyLock, [this]
+                {
+                    return m_ready.load () != 0;
+                });
+            --readyWaiters_;
+            continue;
         }
-    }
 
-    assert (iter != m_jobSet.end ());
+        // Higher job types have higher priority
+        int t = 63;
+        while ((ready & (std::uint64_t (1) << t)) == 0)
+            --t;
 
-    JobType const type = iter->getType ();
-    JobTypeData& data (getJobTypeData (type));
+        JobType const type = static_cast <JobType> (t);
+        JobTypeData& data (getJobTypeData (type));
 
-    assert (type != jtINVALID);
+        std::lock_guard <std::mutex> lock (data.mutex);
 
-    job = *iter;
-    m_jobSet.erase (iter);
+        assert (data.running <= data.info.limit ());
 
-    --data.waiting;
-    ++data.running;
+        // Another thread took the last runnable job of
+        // this type after we looked, so look again.
+        if (data.jobs.empty () || data.running >= data.info.limit ())
+            continue;
+
+        assert (data.waiting > 0);
+
+        job = std::move (data.jobs.front ());
+        data.jobs.pop_front ();
+
+        --data.waiting;
+        ++data.running;
+        --m_jobCount;
+
+        updateReady (data, lock);
+        return;
+    }
 }
 
 void
@@ -390,16 +456,26 @@ JobQueue::finishJob (JobType type)
 
     JobTypeData& data = getJobTypeData (type);
 
-    // Queue a deferred task if possible
-    if (data.deferred > 0)
+    bool signal = false;
     {
-        assert (data.running + data.waiting >= getJobLimit (type));
+        std::lock_guard <std::mutex> lock (data.mutex);
 
-        --data.deferred;
-        m_workers.addTask ();
+        // Queue a deferred task if possible
+        if (data.deferred > 0)
+        {
+            assert (data.running + data.waiting >= data.info.limit ());
+
+            --data.deferred;
+            signal = true;
+        }
+
+        --data.running;
+
+        updateReady (data, lock);
     }
 
-    --data.running;
+    if (signal)
+        m_workers.addTask ();
 }
 
 template <class Rep, class Period>
@@ -434,11 +510,10 @@ JobQueue::processTask ()
             Job::clock_type::now());
         {
             Job job;
-            {
-                std::lock_guard <std::mutex> lock (m_mutex);
-                getNextJob (job);
-                ++m_processCount;
-            }
+            // Counted before the job is taken so that we never
+            // appear idle while a job is between the two counts.
+            ++m_processCount;
+            getNextJob (job);
             type = job.getType();
             JobTypeData& data(getJobTypeData(type));
             JLOG(m_journal.trace()) << "Doing " << data.name () << " job";
@@ -448,13 +523,17 @@ JobQueue::processTask ()
         on_execute(type, Job::clock_type::now() - start_time);
     }
 
+    // Job should be destroyed before calling checkStopped
+    // otherwise destructors with side effects can access
+    // parent objects that are already destroyed.
+    finishJob (type);
+
+    // Only the last running task can complete a rendezvous or a stop,
+    // so the others finish without touching the shared mutex.
+    if (--m_processCount == 0)
     {
         std::lock_guard <std::mutex> lock (m_mutex);
-        // Job should be destroyed before calling checkStopped
-        // otherwise destructors with side effects can access
-        // parent objects that are already destroyed.
-        finishJob (type);
-        if(--m_processCount == 0 && m_jobSet.empty())
+        if (m_jobCount == 0)
             cv_.notify_all();
         checkStopped (lock);
     }
@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/basics/contract.h>
+#include <ripple/json/json_arena.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+
+namespace Json {
+
+namespace detail {
+
+struct alignas (std::max_align_t) ArenaBlock
+{
+    // Outstanding allocations, plus a bias held while the block is current
+    std::atomic<std::size_t> refs;
+    std::size_t size;
+
+    char*
+    data ()
+    {
+        return reinterpret_cast<char*> (this + 1);
+    }
+};
+
+// Precedes every allocation and names the block it was carved from, or
+// nullptr if it came from the heap. Small heap requests are rounded up
+// by malloc anyway, so for short strings the tag often costs nothing.
+struct alignas (8) ArenaTag
+{
+    ArenaBlock* block;
+};
+
+static_assert (sizeof (ArenaTag) == 8,
+    "the tag keeps allocations eight byte aligned");
+
+static std::size_t constexpr bias =
+    std::numeric_limits<std::size_t>::max () / 2;
+
+static thread_local ScopedArena* currentArena = nullptr;
+
+static
+void
+release (ArenaBlock* block, std::size_t n) noexcept
+{
+    if (block->refs.fetch_sub (n, std::memory_order_acq_rel) == n)
+        std::free (block);
+}
+
+void*
+allocate (std::size_t size)
+{
+    if (currentArena)
+    {
+        if (auto p = currentArena->allocate (size))
+            return p;
+    }
+
+    auto tag = static_cast<ArenaTag*> (
+        std::malloc (sizeof (ArenaTag) + size));
+    if (! tag)
+        ripple::Throw<std::bad_alloc> ();
+    tag->block = nullptr;
+    return tag + 1;
+}
+
+void
+deallocate (void* p) noexcept
+{
+    if (! p)
+        return;
+
+    auto tag = static_cast<ArenaTag*> (p) - 1;
+    if (tag->block)
+        release (tag->block, 1);
+    else
+        std::free (tag);
+}
+
+} // detail
+
+//------------------------------------------------------------------------------
+
+ScopedArena::ScopedArena (std::size_t blockSize)
+    : previous_ (detail::currentArena)
+    , blockSize_ (std::max<std::size_t> (blockSize, 1024))
+{
+    detail::currentArena = this;
+}
+
+ScopedArena::~ScopedArena ()
+{
+    retire ();
+    detail::currentArena = previous_;
+}
+
+void*
+ScopedArena::allocate (std::size_t size)
+{
+    using namespace detail;
+
+    std::size_t constexpr align = alignof (ArenaTag);
+    auto const needed = sizeof (ArenaTag) + (size + align - 1) / align * align;
+
+    // Large allocations would waste most of a block
+    if (needed > blockSize_ / 4)
+        return nullptr;
+
+    if (! block_ || used_ + needed > block_->size)
+    {
+        retire ();
+
+        auto block = static_cast<ArenaBlock*> (
+            std::malloc (sizeof (ArenaBlock) + blockSize_));
+        if (! block)
+            return nullptr;
+        block->refs.store (bias, std::memory_order_relaxed);
+        block->size = blockSize_;
+        block_ = block;
+    }
+
+    auto tag = reinterpret_cast<ArenaTag*> (block_->data () + used_);
+    tag->block = block_;
+    used_ += needed;
+    ++count_;
+    return tag + 1;
+}
+
+void
+ScopedArena::retire ()
+{
+    if (! block_)
+        return;
+
+    // Trade the bias for the allocations actually made from the block.
+    // Whichever release brings the count to zero frees it.
+    detail::release (block_, detail::bias - count_);
+    block_ = nullptr;
+    used_ = 0;
+    count_ = 0;
+}
+
+} // Json
@@ -23,6 +23,11 @@
 #include <algorithm>
 #include <string>
 #include <cctype>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace Json
 {
@@ -67,6 +72,81 @@ codePointToUTF8 (unsigned int cp)
     return result;
 }
 
+static
+inline
+bool
+isSpace (char c)
+{
+    return c == ' '  ||  c == '\t'  ||  c == '\r'  ||  c == '\n';
+}
+
+// The scanners below look at sixteen characters at a time when SSE2 is
+// available, and finish (or do all the work) one character at a time.
+
+// Returns the first character in [p, end) which is not whitespace
+static
+Reader::Location
+skipWhitespace (Reader::Location p, Reader::Location end)
+{
+    // Compact documents rarely have more than one space in a row
+    if ( p == end  ||  !isSpace (*p) )
+        return p;
+
+#if defined(__SSE2__)
+    __m128i const space = _mm_set1_epi8 (' ');
+    __m128i const tab = _mm_set1_epi8 ('\t');
+    __m128i const cr = _mm_set1_epi8 ('\r');
+    __m128i const lf = _mm_set1_epi8 ('\n');
+
+    for ( ; end - p >= 16; p += 16 )
+    {
+        __m128i const chunk =
+            _mm_loadu_si128 (reinterpret_cast<__m128i const*> (p));
+        __m128i const ws = _mm_or_si128 (
+            _mm_or_si128 (_mm_cmpeq_epi8 (chunk, space),
+                _mm_cmpeq_epi8 (chunk, tab)),
+            _mm_or_si128 (_mm_cmpeq_epi8 (chunk, cr),
+                _mm_cmpeq_epi8 (chunk, lf)));
+        int const mask = _mm_movemask_epi8 (ws) ^ 0xFFFF;
+
+        if ( mask != 0 )
+            return p + __builtin_ctz (mask);
+    }
+#endif
+
+    while ( p != end  &&  isSpace (*p) )
+        ++p;
+
+    return p;
+}
+
+// Returns the first quote or backslash in [p, end), or end if there is none
+static
+Reader::Location
+findQuoteOrEscape (Reader::Location p, Reader::Location end)
+{
+#if defined(__SSE2__)
+    __m128i const quote = _mm_set1_epi8 ('"');
+    __m128i const backslash = _mm_set1_epi8 ('\\');
+
+    for ( ; end - p >= 16; p += 16 )
+    {
+        __m128i const chunk =
+            _mm_loadu_si128 (reinterpret_cast<__m128i const*> (p));
+        int const mask = _mm_movemask_epi8 (_mm_or_si128 (
+            _mm_cmpeq_epi8 (chunk, quote), _mm_cmpeq_epi8 (chunk, backslash)));
+
+        if ( mask != 0 )
+            return p + __builtin_ctz (mask);
+    }
+#endif
+
+    while ( p != end  &&  *p != '"'  &&  *p != '\\' )
+        ++p;
+
+    return p;
+}
+
 
 // Class Reader
 // //////////////////////////////////////////////////////////////////
@@ -302,15 +382,7 @@ Reader::readToken ( Token& token )
 void
 Reader::skipSpaces ()
 {
-    while ( current_ != end_ )
-    {
-        Char c = *current_;
-
-        if ( c == ' '  ||  c == '\t'  ||  c == '\r'  ||  c == '\n' )
-            ++current_;
-        else
-            break;
-    }
+    current_ = skipWhitespace ( current_, end_ );
 }
 
 
@@ -410,19 +482,22 @@ Reader::readNumber ()
 bool
 Reader::readString ()
 {
-    Char c = 0;
-
-    while ( current_ != end_ )
+    while ( true )
     {
-        c = getNextChar ();
+        current_ = findQuoteOrEscape ( current_, end_ );
 
-        if ( c == '\\' )
-            getNextChar ();
-        else if ( c == '"' )
-            break;
-    }
+        if ( current_ == end_ )
+            return false;
+
+        if ( *current_++ == '"' )
+            return true;
 
-    return c == '"';
+        // Skip the escaped character
+        if ( current_ == end_ )
+            return false;
+
+        ++current_;
+    }
 }
 
 
@@ -464,10 +539,13 @@ Reader::readObject ( Token& tokenStart )
         }
 
         // Reject duplicate names
-        if (currentValue ().isMember (name))
+        Value& object = currentValue ();
+        auto const members = object.size ();
+        Value& value = object[ name ];
+
+        if ( object.size () == members )
             return addError ( "Key '" + name + "' appears twice.", tokenName );
 
-        Value& value = currentValue ()[ name ];
         nodes_.push ( &value );
         bool ok = readValue ();
         nodes_.pop ();
@@ -666,6 +744,16 @@ Reader::decodeDouble( Token &token )
 bool
 Reader::decodeString ( Token& token )
 {
+    Location begin = token.start_ + 1;
+    Location end = token.end_ - 1;
+
+    // Most strings have no escapes and can be used as they are
+    if ( !std::memchr ( begin, '\\', end - begin ) )
+    {
+        currentValue () = Value ( begin, end );
+        return true;
+    }
+
     std::string decoded;
 
     if ( !decodeString ( token, decoded ) )
@@ -679,10 +767,17 @@ Reader::decodeString ( Token& token )
 bool
 Reader::decodeString ( Token& token, std::string& decoded )
 {
-    decoded.reserve ( token.end_ - token.start_ - 2 );
     Location current = token.start_ + 1; // skip '"'
     Location end = token.end_ - 1;      // do not include '"'
 
+    if ( !std::memchr ( current, '\\', end - current ) )
+    {
+        decoded.assign ( current, end );
+        return true;
+    }
+
+    decoded.reserve ( end - current );
+
     while ( current != end )
     {
         Char c = *current++;
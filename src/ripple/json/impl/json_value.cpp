@@ -62,7 +62,8 @@ public:
         if ( length == unknown )
             length = (unsigned int)strlen (value);
 
-        char* newString = static_cast<char*> ( malloc ( length + 1 ) );
+        char* newString = static_cast<char*> (
+            detail::allocate ( length + 1 ) );
         memcpy ( newString, value, length );
         newString[length] = 0;
         return newString;
@@ -70,8 +71,7 @@ public:
 
     virtual void releaseStringValue ( char* value )
     {
-        if ( value )
-            free ( value );
+        detail::deallocate ( value );
     }
 };
 
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_JSON_JSON_ARENA_H_INCLUDED
+#define RIPPLE_JSON_JSON_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <new>
+
+namespace Json {
+
+namespace detail {
+struct ArenaBlock;
+}
+
+/** Satisfies Value allocations made on this thread from a shared arena.
+
+    While a ScopedArena is alive, member names, string values and object
+    nodes created by Value on the constructing thread are carved out of
+    large blocks instead of being individually allocated from the heap.
+    This makes building a Value tree, for example while parsing a
+    request, much cheaper.
+
+    Values created inside the scope may safely outlive it and may be
+    destroyed on any thread: each block is released once everything
+    allocated from it has been released. A single long-lived value does
+    keep its whole block alive, so the arena is meant for short-lived,
+    request-scoped values.
+
+    Scopes nest. A scope must be destroyed on the thread which created it,
+    so it must not be held across a coroutine yield.
+*/
+class ScopedArena
+{
+public:
+    static std::size_t constexpr defaultBlockSize = 8 * 1024;
+
+    explicit
+    ScopedArena (std::size_t blockSize = defaultBlockSize);
+
+    ScopedArena (ScopedArena const&) = delete;
+    ScopedArena& operator= (ScopedArena const&) = delete;
+
+    ~ScopedArena ();
+
+    /** Return memory for an allocation of the given size, or nullptr
+        if the request should be satisfied by the heap instead.
+    */
+    void*
+    allocate (std::size_t size);
+
+private:
+    void
+    retire ();
+
+    ScopedArena* previous_;
+    std::size_t const blockSize_;
+    detail::ArenaBlock* block_ = nullptr;
+    std::size_t used_ = 0;
+    std::size_t count_ = 0;
+};
+
+namespace detail {
+
+/** Allocate memory from the current ScopedArena, or the heap. */
+void*
+allocate (std::size_t size);
+
+/** Release memory returned by allocate. */
+void
+deallocate (void* p) noexcept;
+
+/** Standard allocator for the containers used inside Value. */
+template <class T>
+class ArenaAllocator
+{
+    // Allocations from an arena are only aligned to eight bytes
+    static_assert (alignof (T) <= 8, "over-aligned type");
+
+public:
+    using value_type = T;
+
+    ArenaAllocator () = default;
+
+    template <class U>
+    ArenaAllocator (ArenaAllocator<U> const&) noexcept
+    {
+    }
+
+    T*
+    allocate (std::size_t n)
+    {
+        return static_cast<T*> (detail::allocate (n * sizeof (T)));
+    }
+
+    void
+    deallocate (T* p, std::size_t) noexcept
+    {
+        detail::deallocate (p);
+    }
+
+    template <class U>
+    bool
+    operator== (ArenaAllocator<U> const&) const noexcept
+    {
+        return true;
+    }
+
+    template <class U>
+    bool
+    operator!= (ArenaAllocator<U> const&) const noexcept
+    {
+        return false;
+    }
+};
+
+} // detail
+
+} // Json
+
+#endif
@@ -26,7 +26,9 @@
 #include <ripple/resource/Consumer.h>
 #include <ripple/protocol/Book.h>
 #include <ripple/core/Stoppable.h>
+#include <memory>
 #include <mutex>
+#include <string>
 
 namespace ripple {
 
@@ -117,6 +119,34 @@ public:
         virtual pointer addRpcSub (std::string const& strUrl, ref rspEntry) = 0;
     };
 
+    /** A JSON message published to many subscribers.
+
+        Subscribers which transmit the message as text share a single
+        serialization, produced the first time one of them asks for it.
+        The JSON value must outlive the message. A message is meant to
+        be built and sent from one thread; it is not thread safe.
+    */
+    class Message
+    {
+    public:
+        explicit Message (Json::Value const& jv);
+
+        Message (Message const&) = delete;
+        Message& operator= (Message const&) = delete;
+
+        Json::Value const& json () const
+        {
+            return jv_;
+        }
+
+        /** Return the compact serialized text of the message. */
+        std::shared_ptr<std::string const> const& text () const;
+
+    private:
+        Json::Value const& jv_;
+        std::shared_ptr<std::string const> mutable text_;
+    };
+
 public:
     InfoSub (Source& source);
     InfoSub (Source& source, Consumer consumer);
@@ -127,6 +157,12 @@ public:
 
     virtual void send (Json::Value const& jvObj, bool broadcast) = 0;
 
+    /** Send a message shared with other subscribers.
+
+        The default implementation sends the JSON value.
+    */
+    virtual void send (Message const& msg, bool broadcast);
+
     std::uint64_t getSeq ();
 
     void onSendEmpty ();
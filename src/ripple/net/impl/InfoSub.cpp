@@ -43,6 +43,29 @@ InfoSub::Source::Source (char const* name, Stoppable& parent)
 
 //------------------------------------------------------------------------------
 
+InfoSub::Message::Message (Json::Value const& jv)
+    : jv_ (jv)
+{
+}
+
+std::shared_ptr<std::string const> const&
+InfoSub::Message::text () const
+{
+    if (! text_)
+    {
+        std::string s;
+        Json::stream (jv_,
+            [&s](void const* data, std::size_t n)
+            {
+                s.append (static_cast<char const*> (data), n);
+            });
+        text_ = std::make_shared<std::string const> (std::move (s));
+    }
+    return text_;
+}
+
+//------------------------------------------------------------------------------
+
 InfoSub::InfoSub(Source& source)
     : m_source(source)
     , mSeq(assign_id())
@@ -77,6 +100,11 @@ InfoSub::~InfoSub ()
             (mSeq, normalSubscriptions_, false);
 }
 
+void InfoSub::send (Message const& msg, bool broadcast)
+{
+    send (msg.json (), broadcast);
+}
+
 Resource::Consumer& InfoSub::getConsumer()
 {
     return m_consumer;
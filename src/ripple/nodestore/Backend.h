@@ -65,12 +65,21 @@ public:
     */
     virtual Status fetch (void const* key, std::shared_ptr<NodeObject>* pObject) = 0;
 
-    /** Return `true` if batch fetches are optimized. */
+    /** Return `true` if batch fetches are optimized.
+        Otherwise fetchBatch is not called, and the caller fetches
+        each key in turn.
+    */
     virtual
     bool
     canFetchBatch() = 0;
 
-    /** Fetch a batch synchronously. */
+    /** Fetch a batch synchronously.
+        Objects which are not found, or which fail to load, are nullptr.
+        @note This will be called concurrently.
+        @param n The number of keys.
+        @param keys Pointers to the key data.
+        @return The objects, in the order of the keys.
+    */
     virtual
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch (std::size_t n, void const* const* keys) = 0;
@@ -84,11 +93,20 @@ public:
     virtual void store (std::shared_ptr<NodeObject> const& object) = 0;
 
     /** Store a group of objects.
-        @note This function will not be called concurrently with
-              itself or @ref store.
+        @note This will be called concurrently, with itself and with
+              @ref store, when the branches of a SHAMap are flushed
+              in parallel.
     */
     virtual void storeBatch (Batch const& batch) = 0;
 
+    /** Make the objects stored so far durable.
+        Blocks until they are written to disk, so that they
+        survive a crash.
+        @note This will be called concurrently with @ref fetch
+              and @ref store.
+    */
+    virtual void sync () = 0;
+
     /** Visit every object in the database
         This is usually called during import.
         @note This routine will not be called concurrently with itself
@@ -106,6 +124,15 @@ public:
     /** Perform consistency checks on database .*/
     virtual void verify() = 0;
 
+    /** Add a dictionary to compress the objects stored from now on.
+        Objects stored before remain readable.
+        @note This routine will not be called concurrently with itself
+              or other methods.
+        @return `false` if the backend does not compress with dictionaries.
+        @see trainDictionary
+    */
+    virtual bool addDictionary (Blob const& dictionary) = 0;
+
     /** Returns the number of file handles the backend expects to need */
     virtual int fdlimit() const = 0;
 };
@@ -78,6 +78,18 @@ public:
     */
     virtual std::shared_ptr<NodeObject> fetch (uint256 const& hash) = 0;
 
+    /** Fetch several objects.
+        Objects not in the cache are read from the backend together, which
+        is faster than reading them one at a time for some backends.
+
+        @note This can be called concurrently.
+        @param hashes The keys of the objects to retrieve.
+        @return The objects, in the order of the keys. An object is
+                nullptr if it couldn't be retrieved.
+    */
+    virtual std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch (std::vector<uint256> const& hashes) = 0;
+
     /** Fetch an object without waiting.
         If I/O is required to determine whether or not the object is present,
         `false` is returned. Otherwise, `true` is returned and `object` is set
@@ -116,6 +128,15 @@ public:
                         Blob&& data,
                         uint256 const& hash) = 0;
 
+    /** Store several objects.
+
+        The objects are cached as store would, and handed to the
+        backend together, so it can write them in one operation.
+
+        @param batch The objects to store.
+    */
+    virtual void storeBatch (Batch const& batch) = 0;
+
     /** Visit every object in the database
         This is usually called during import.
 
@@ -155,6 +176,13 @@ public:
     virtual std::uint32_t getStoreSize () const = 0;
     virtual std::uint32_t getFetchSize () const = 0;
 
+    /** Gather statistics pertaining to the lookup filter, if any.
+        Return the fetches the filter answered without going to the
+        backend, and the fetches it sent to the backend for nothing.
+     */
+    virtual std::uint32_t getFilterHitCount () const = 0;
+    virtual std::uint32_t getFilterFalsePositiveCount () const = 0;
+
     /** Return the number of files needed by our backend */
     virtual int fdlimit() const = 0;
 };
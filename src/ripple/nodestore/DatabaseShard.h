@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_DATABASESHARD_H_INCLUDED
+#define RIPPLE_NODESTORE_DATABASESHARD_H_INCLUDED
+
+#include <ripple/nodestore/Database.h>
+#include <boost/optional.hpp>
+
+namespace ripple {
+namespace NodeStore {
+
+/* This class splits ledger history into shards, each holding the objects
+ * used by a fixed range of ledgers. A shard is acquired a ledger at a time
+ * and never changes once it holds every ledger in its range, so complete
+ * shards can be verified, copied and served independently of each other.
+ */
+
+class DatabaseShard
+{
+public:
+    virtual ~DatabaseShard() = default;
+
+    /** Returns the number of ledgers in each shard. */
+    virtual std::uint32_t ledgersPerShard () const = 0;
+
+    /** Returns the index of the shard holding a ledger. */
+    std::uint32_t seqToShardIndex (std::uint32_t seq) const
+    {
+        return (seq - 1) / ledgersPerShard ();
+    }
+
+    /** Returns the first ledger in a shard. */
+    std::uint32_t firstSeq (std::uint32_t shardIndex) const
+    {
+        return 1 + shardIndex * ledgersPerShard ();
+    }
+
+    /** Returns the last ledger in a shard. */
+    std::uint32_t lastSeq (std::uint32_t shardIndex) const
+    {
+        return (shardIndex + 1) * ledgersPerShard ();
+    }
+
+    /** Choose the next ledger to acquire.
+
+        If no shard is being acquired, one is chosen at random from those
+        we do not hold whose ledgers are all validated.
+
+        @param validLedgerSeq The sequence of the last validated ledger.
+        @return The sequence of a ledger to acquire, if any.
+    */
+    virtual boost::optional<std::uint32_t>
+    prepare (std::uint32_t validLedgerSeq) = 0;
+
+    /** Store an object used by a ledger.
+
+        @return `false` if the ledger's shard is not being acquired.
+    */
+    virtual bool store (NodeObjectType type,
+                        Blob&& data,
+                        uint256 const& hash,
+                        std::uint32_t seq) = 0;
+
+    /** Record that every object used by a ledger has been stored. */
+    virtual void setStored (std::uint32_t seq) = 0;
+
+    /** Returns `true` if a ledger is stored. */
+    virtual bool contains (std::uint32_t seq) = 0;
+
+    /** Fetch an object used by a ledger.
+        Only the shard holding the ledger is searched.
+
+        @note This can be called concurrently.
+        @return The object, or nullptr if it couldn't be retrieved.
+    */
+    virtual std::shared_ptr<NodeObject>
+    fetch (uint256 const& hash, std::uint32_t seq) = 0;
+
+    /** Returns the indexes of the complete shards, as ranges. */
+    virtual std::string getCompleteShards () = 0;
+};
+
+}
+}
+
+#endif
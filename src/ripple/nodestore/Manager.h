@@ -22,6 +22,7 @@
 
 #include <ripple/nodestore/Factory.h>
 #include <ripple/nodestore/DatabaseRotating.h>
+#include <ripple/nodestore/DatabaseShard.h>
 
 namespace ripple {
 namespace NodeStore {
@@ -66,6 +67,11 @@ public:
         Some choices for 'type' are:
             HyperLevelDB, LevelDBFactory, SQLite, MDB
 
+        If the 'filter_size' key is set, it is the number of objects the
+        database is expected to hold. An in-memory filter of that size is
+        filled from the backend when the database is opened, and used to
+        answer most fetches of missing objects without reading the backend.
+
         If the fastBackendParameter is omitted or empty, no ephemeral database
         is used. If the scheduler parameter is omited or unspecified, a
         synchronous scheduler is used which performs all tasks immediately on
@@ -95,7 +101,24 @@ public:
             Stoppable& parent,
                 std::shared_ptr <Backend> writableBackend,
                     std::shared_ptr <Backend> archiveBackend,
-                        beast::Journal journal) = 0;
+                        std::size_t filterSize,
+                            beast::Journal journal) = 0;
+
+    /** Construct a shard store.
+
+        The 'path' key names the directory holding the shards, one
+        directory each. The other keys are passed to each shard's
+        backend, 'nudb' if no 'type' is given.
+
+        @note If a shard cannot be opened, an exception is thrown.
+    */
+    virtual
+    std::unique_ptr <DatabaseShard>
+    make_DatabaseShard (std::string const& name,
+        Scheduler& scheduler, int readThreads,
+            Stoppable& parent,
+                Section const& config,
+                    beast::Journal journal) = 0;
 };
 
 //------------------------------------------------------------------------------
@@ -105,6 +128,20 @@ std::unique_ptr <Backend>
 make_Backend (Section const& config,
     Scheduler& scheduler, beast::Journal journal);
 
+/** Train a dictionary to compress a backend's objects, and add it.
+
+    A random sample of the objects is read with Backend::for_each, so this
+    takes about as long as reading the whole backend. Objects stored from
+    then on are compressed with the dictionary.
+
+    @param sampleCount The number of objects to train on.
+    @return `false` if no dictionary was added, because the backend does
+            not support them or the samples had nothing in common.
+*/
+bool
+trainDictionary (Backend& backend,
+    std::size_t sampleCount, beast::Journal journal);
+
 }
 }
 
@@ -156,6 +156,11 @@ public:
             store (e);
     }
 
+    void
+    sync () override
+    {
+    }
+
     void
     for_each (std::function <void(std::shared_ptr<NodeObject>)> f) override
     {
@@ -184,6 +189,12 @@ public:
     {
         return 0;
     }
+
+    bool
+    addDictionary (Blob const&) override
+    {
+        return false;
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -32,6 +32,8 @@
 #include <cstdio>
 #include <cstdint>
 #include <exception>
+#include <fstream>
+#include <iterator>
 #include <memory>
 
 namespace ripple {
@@ -56,6 +58,7 @@ public:
     nudb::store db_;
     std::atomic <bool> deletePath_;
     Scheduler& scheduler_;
+    CodecDictionaries dicts_;
 
     NuDBBackend (int keyBytes, Section const& keyValues,
         Scheduler& scheduler, beast::Journal journal)
@@ -88,6 +91,7 @@ public:
                 Throw<nudb::system_error>(ec);
             if (db_.appnum() != currentType)
                 Throw<std::runtime_error> ("nodestore: unknown appnum");
+            loadDictionaries();
         }
         catch (std::exception const& e)
         {
@@ -131,11 +135,11 @@ public:
         pno->reset();
         nudb::error_code ec;
         db_.fetch (key,
-            [key, pno, &status](void const* data, std::size_t size)
+            [this, key, pno, &status](void const* data, std::size_t size)
             {
                 nudb::detail::buffer bf;
                 auto const result =
-                    nodeobject_decompress(data, size, bf);
+                    nodeobject_decompress(data, size, bf, &dicts_);
                 DecodedBlob decoded (key, result.first, result.second);
                 if (! decoded.wasOk ())
                 {
@@ -173,7 +177,7 @@ public:
         nudb::error_code ec;
         nudb::detail::buffer bf;
         auto const result = nodeobject_compress(
-            e.getData(), e.getSize(), bf);
+            e.getData(), e.getSize(), bf, dicts_.current());
         db_.insert (e.getKey(), result.first, result.second, ec);
         if(ec && ec != nudb::error::key_exists)
             Throw<nudb::system_error>(ec);
@@ -209,6 +213,15 @@ public:
         scheduler_.onBatchWrite (report);
     }
 
+    void
+    sync () override
+    {
+        nudb::error_code ec;
+        db_.flush (ec);
+        if(ec)
+            Throw<nudb::system_error>(ec);
+    }
+
     void
     for_each (std::function <void(std::shared_ptr<NodeObject>)> f) override
     {
@@ -228,7 +241,7 @@ public:
             {
                 nudb::detail::buffer bf;
                 auto const result =
-                    nodeobject_decompress(data, size, bf);
+                    nodeobject_decompress(data, size, bf, &dicts_);
                 DecodedBlob decoded (key, result.first, result.second);
                 if (! decoded.wasOk ())
                 {
@@ -282,6 +295,81 @@ public:
     {
         return 3;
     }
+
+    bool
+    addDictionary (Blob const& dictionary) override
+    {
+        auto const current = dicts_.current();
+        dicts_.add (current ? current->id() + 1 : 1, dictionary);
+        saveDictionaries();
+        return true;
+    }
+
+private:
+    // The dictionaries are kept in a file beside the database,
+    // each as its id and size followed by its content.
+    std::string
+    dictionaryPath() const
+    {
+        return (boost::filesystem::path (name_) / "nudb.dict").string();
+    }
+
+    void
+    loadDictionaries()
+    {
+        using namespace nudb::detail;
+        std::ifstream ifs (dictionaryPath(), std::ios::binary);
+        if (! ifs)
+            return;
+        Blob const file {std::istreambuf_iterator<char>(ifs),
+            std::istreambuf_iterator<char>()};
+        std::size_t pos = 0;
+        while (pos < file.size())
+        {
+            if (file.size() - pos < 8)
+                Throw<std::runtime_error> (
+                    "nodestore: short dictionary file");
+            istream is (&file[pos], 8);
+            std::uint32_t id;
+            std::uint32_t size;
+            read<std::uint32_t>(is, id);
+            read<std::uint32_t>(is, size);
+            pos += 8;
+            if (file.size() - pos < size)
+                Throw<std::runtime_error> (
+                    "nodestore: short dictionary file");
+            dicts_.add (id, Blob (file.begin() + pos,
+                file.begin() + pos + size));
+            pos += size;
+        }
+    }
+
+    void
+    saveDictionaries()
+    {
+        using namespace nudb::detail;
+        auto const path = dictionaryPath();
+        auto const temp = path + ".tmp";
+        {
+            std::ofstream ofs (temp, std::ios::binary | std::ios::trunc);
+            for (auto const& dict : dicts_.list())
+            {
+                std::array<std::uint8_t, 8> header;
+                ostream os (header.data(), header.size());
+                write<std::uint32_t>(os, dict->id());
+                write<std::uint32_t>(os,
+                    static_cast<std::uint32_t>(dict->data().size()));
+                ofs.write (reinterpret_cast<char const*>(
+                    header.data()), header.size());
+                ofs.write (reinterpret_cast<char const*>(
+                    dict->data().data()), dict->data().size());
+            }
+            if (! ofs.flush())
+                Throw<std::runtime_error> (
+                    "nodestore: can't write " + temp);
+        }
+        boost::filesystem::rename (temp, path);
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -77,6 +77,11 @@ public:
     {
     }
 
+    void
+    sync () override
+    {
+    }
+
     void
     for_each (std::function <void(std::shared_ptr<NodeObject>)> f) override
     {
@@ -105,6 +110,12 @@ public:
         return 0;
     }
 
+    bool
+    addDictionary (Blob const&) override
+    {
+        return false;
+    }
+
 private:
 };
 
@@ -260,14 +260,48 @@ public:
     bool
     canFetchBatch() override
     {
-        return false;
+        return true;
     }
 
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch (std::size_t n, void const* const* keys) override
     {
-        Throw<std::runtime_error> ("pure virtual called");
-        return {};
+        std::vector<rocksdb::Slice> slices;
+        slices.reserve (n);
+        for (std::size_t i = 0; i < n; ++i)
+            slices.emplace_back (
+                static_cast <char const*> (keys[i]), m_keyBytes);
+
+        rocksdb::ReadOptions const options;
+        std::vector<std::string> values;
+        auto const statuses = m_db->MultiGet (options, slices, &values);
+
+        std::vector<std::shared_ptr<NodeObject>> objects (n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (statuses[i].ok ())
+            {
+                DecodedBlob decoded (keys[i],
+                    values[i].data (), values[i].size ());
+
+                if (decoded.wasOk ())
+                {
+                    objects[i] = decoded.createObject ();
+                }
+                else
+                {
+                    // Decoding failed, probably corrupted!
+                    JLOG(m_journal.fatal()) <<
+                        "Corrupt NodeObject #" << uint256::fromVoid (keys[i]);
+                }
+            }
+            else if (! statuses[i].IsNotFound ())
+            {
+                JLOG(m_journal.error()) << statuses[i].ToString ();
+            }
+        }
+
+        return objects;
     }
 
     void
@@ -302,6 +336,19 @@ public:
             Throw<std::runtime_error> ("storeBatch failed: " + ret.ToString());
     }
 
+    void
+    sync () override
+    {
+        m_batch.waitForWriting ();
+
+        // Writes go to the WAL without syncing it,
+        // so flush the memtables to table files
+        auto ret = m_db->Flush (rocksdb::FlushOptions ());
+
+        if (! ret.ok ())
+            Throw<std::runtime_error> ("sync failed: " + ret.ToString());
+    }
+
     void
     for_each (std::function <void(std::shared_ptr<NodeObject>)> f) override
     {
@@ -370,6 +417,12 @@ public:
     {
         return fdlimit_;
     }
+
+    bool
+    addDictionary (Blob const&) override
+    {
+        return false;
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -65,10 +65,12 @@ public:
     /** Get an estimate of the amount of writing I/O pending. */
     int getWriteLoad ();
 
+    /** Wait until every object stored so far is written. */
+    void waitForWriting ();
+
 private:
     void performScheduledTask ();
     void writeBatch ();
-    void waitForWriting ();
 
 private:
     using LockType = std::recursive_mutex;
@@ -0,0 +1,123 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_BLOOMFILTER_H_INCLUDED
+#define RIPPLE_NODESTORE_BLOOMFILTER_H_INCLUDED
+
+#include <ripple/basics/base_uint.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+/** A set of keys which can say for certain that a key is absent.
+
+    Sized for an expected number of keys at ten bits per key, which
+    gives about one false positive in a hundred lookups of absent keys.
+    Adding more keys than expected raises that rate, it never causes a
+    present key to be reported absent.
+
+    Keys are hashes, so their bits are used directly as the probes.
+
+    Thread safe.
+*/
+class BloomFilter
+{
+private:
+    static std::size_t constexpr bitsPerKey = 10;
+    static int constexpr probes = 7;
+
+    std::vector <std::atomic <std::uint64_t>> words_;
+    std::uint64_t bits_;
+
+    template <class Function>
+    void
+    forEachProbe (uint256 const& key, Function&& f) const
+    {
+        std::uint64_t h1;
+        std::uint64_t h2;
+        std::memcpy (&h1, key.data (), sizeof (h1));
+        std::memcpy (&h2, key.data () + sizeof (h1), sizeof (h2));
+        // An even step could cycle through a fraction of the bits
+        h2 |= 1;
+        for (int i = 0; i < probes; ++i, h1 += h2)
+        {
+            if (! f (h1 % bits_))
+                break;
+        }
+    }
+
+public:
+    explicit
+    BloomFilter (std::size_t expectedKeys)
+        : words_ ((std::max <std::size_t> (expectedKeys, 1) *
+            bitsPerKey + 63) / 64)
+        , bits_ (words_.size () * 64)
+    {
+    }
+
+    BloomFilter (BloomFilter const&) = delete;
+    BloomFilter& operator= (BloomFilter const&) = delete;
+
+    void
+    insert (uint256 const& key)
+    {
+        forEachProbe (key,
+            [this](std::uint64_t bit)
+            {
+                auto& word = words_[bit / 64];
+                auto const mask = std::uint64_t (1) << (bit % 64);
+                if ((word.load (std::memory_order_relaxed) & mask) == 0)
+                    word.fetch_or (mask, std::memory_order_relaxed);
+                return true;
+            });
+    }
+
+    /** Returns `false` if the key was never inserted. */
+    bool
+    mayContain (uint256 const& key) const
+    {
+        bool result = true;
+        forEachProbe (key,
+            [this, &result](std::uint64_t bit)
+            {
+                auto const word =
+                    words_[bit / 64].load (std::memory_order_relaxed);
+                result = (word & (std::uint64_t (1) << (bit % 64))) != 0;
+                return result;
+            });
+        return result;
+    }
+
+    /** Returns the memory used by the filter, in bytes. */
+    std::size_t
+    size () const
+    {
+        return words_.size () * sizeof (std::uint64_t);
+    }
+};
+
+}
+}
+
+#endif
@@ -22,10 +22,13 @@
 
 #include <ripple/nodestore/Database.h>
 #include <ripple/nodestore/Scheduler.h>
+#include <ripple/nodestore/impl/BloomFilter.h>
 #include <ripple/nodestore/impl/Tuning.h>
 #include <ripple/basics/KeyCache.h>
 #include <ripple/basics/chrono.h>
 #include <ripple/beast/core/CurrentThreadName.h>
+#include <algorithm>
+#include <cassert>
 
 namespace ripple {
 namespace NodeStore {
@@ -38,12 +41,19 @@ private:
     Scheduler& m_scheduler;
     // Persistent key/value storage.
     std::unique_ptr <Backend> m_backend;
+    // Keys in m_backend, if filtering lookups
+    std::unique_ptr <BloomFilter> m_filter;
 protected:
+    // Expected number of keys in each backend, zero for no filters
+    std::size_t const m_filterSize;
+
     // Positive cache
     TaggedCache <uint256, NodeObject> m_cache;
 
     // Negative cache
     KeyCache <uint256> m_negCache;
+
+    std::atomic <std::uint32_t> m_fetchTotalCount;
 private:
     std::mutex                m_readLock;
     std::condition_variable   m_readCondVar;
@@ -53,12 +63,14 @@ private:
     std::vector <std::thread> m_readThreads;
     bool                      m_readShut;
     uint64_t                  m_readGen;        // current read generation
+    int                       m_readPending;    // threads reading a batch
     int                       fdlimit_;
     std::atomic <std::uint32_t> m_storeCount;
-    std::atomic <std::uint32_t> m_fetchTotalCount;
     std::atomic <std::uint32_t> m_fetchHitCount;
     std::atomic <std::uint32_t> m_storeSize;
     std::atomic <std::uint32_t> m_fetchSize;
+    std::atomic <std::uint32_t> m_filterHitCount;
+    std::atomic <std::uint32_t> m_filterFalsePositiveCount;
 
 public:
     DatabaseImp (std::string const& name,
@@ -66,24 +78,33 @@ public:
                  int readThreads,
                  Stoppable& parent,
                  std::unique_ptr <Backend> backend,
+                 std::size_t filterSize,
                  beast::Journal journal)
         : Database (name, parent)
         , m_journal (journal)
         , m_scheduler (scheduler)
         , m_backend (std::move (backend))
+        , m_filterSize (filterSize)
         , m_cache ("NodeStore", cacheTargetSize, cacheTargetSeconds,
             stopwatch(), journal)
         , m_negCache ("NodeStore", stopwatch(),
             cacheTargetSize, cacheTargetSeconds)
+        , m_fetchTotalCount (0)
         , m_readShut (false)
         , m_readGen (0)
+        , m_readPending (0)
         , fdlimit_ (0)
         , m_storeCount (0)
-        , m_fetchTotalCount (0)
         , m_fetchHitCount (0)
         , m_storeSize (0)
         , m_fetchSize (0)
+        , m_filterHitCount (0)
+        , m_filterFalsePositiveCount (0)
     {
+        // Fill the filter before anything can read
+        if (m_backend)
+            m_filter = makeFilter (*m_backend);
+
         for (int i = 0; i < readThreads; ++i)
             m_readThreads.emplace_back (&DatabaseImp::threadEntry, this);
 
@@ -135,7 +156,10 @@ public:
             // Wake in two generations
             std::uint64_t const wakeGeneration = m_readGen + 2;
 
-            while (!m_readShut && !m_readSet.empty () && (m_readGen < wakeGeneration))
+            // Keys being read have already left the set
+            while (!m_readShut &&
+                (!m_readSet.empty () || m_readPending != 0) &&
+                    (m_readGen < wakeGeneration))
                 m_readGenCondVar.wait (lock);
         }
 
@@ -227,14 +251,123 @@ public:
 
     virtual std::shared_ptr<NodeObject> fetchFrom (uint256 const& hash)
     {
-        return fetchInternal (*m_backend, hash);
+        return fetchInternal (*m_backend, m_filter.get (), hash);
+    }
+
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatch (std::vector<uint256> const& hashes) override
+    {
+        return doTimedFetchBatch (hashes, false);
+    }
+
+    /** Perform a batch fetch and report the time it took */
+    std::vector<std::shared_ptr<NodeObject>>
+    doTimedFetchBatch (std::vector<uint256> const& hashes, bool isAsync)
+    {
+        FetchReport report;
+        report.isAsync = isAsync;
+        report.wentToDisk = false;
+
+        auto const before = std::chrono::steady_clock::now();
+        std::vector<std::shared_ptr<NodeObject>> objects (hashes.size ());
+
+        // Keys not in either cache, and where their objects go
+        std::vector<uint256> keys;
+        std::vector<std::size_t> where;
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+        {
+            objects[i] = m_cache.fetch (hashes[i]);
+            if (! objects[i] && ! m_negCache.touch_if_exists (hashes[i]))
+            {
+                keys.push_back (hashes[i]);
+                where.push_back (i);
+            }
+        }
+
+        if (! keys.empty ())
+        {
+            report.wentToDisk = true;
+            auto found = fetchBatchFrom (keys);
+            m_fetchTotalCount += keys.size ();
+
+            for (std::size_t i = 0; i < keys.size (); ++i)
+            {
+                auto& obj = found[i];
+                if (obj == nullptr)
+                {
+                    // Just in case a write occurred
+                    obj = m_cache.fetch (keys[i]);
+                    if (obj == nullptr)
+                        m_negCache.insert (keys[i]);
+                }
+                else
+                {
+                    m_cache.canonicalize (keys[i], obj);
+                }
+                objects[where[i]] = std::move (obj);
+            }
+        }
+
+        report.elapsed = std::chrono::duration_cast <std::chrono::milliseconds>
+            (std::chrono::steady_clock::now() - before);
+        report.wasFound = std::all_of (objects.begin (), objects.end (),
+            [](std::shared_ptr<NodeObject> const& obj)
+            {
+                return obj != nullptr;
+            });
+        m_scheduler.onFetch (report);
+
+        return objects;
+    }
+
+    virtual std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom (std::vector<uint256> const& hashes)
+    {
+        return fetchBatchInternal (*m_backend, m_filter.get (), hashes);
+    }
+
+    /** Returns a filter holding every key in the backend.
+
+        The backend must not be written to until this returns.
+        Returns `nullptr` if lookups are not filtered.
+    */
+    std::unique_ptr <BloomFilter> makeFilter (Backend& backend)
+    {
+        if (m_filterSize == 0)
+            return nullptr;
+
+        auto filter = std::make_unique <BloomFilter> (m_filterSize);
+        std::size_t count = 0;
+        backend.for_each (
+            [&](std::shared_ptr<NodeObject> object)
+            {
+                filter->insert (object->getHash ());
+                ++count;
+            });
+
+        JLOG(m_journal.info()) <<
+            "Filter for " << backend.getName () << ": " << count <<
+            " keys, " << filter->size () << " bytes";
+        if (count > m_filterSize)
+        {
+            JLOG(m_journal.warn()) <<
+                "Filter for " << backend.getName () << " holds " << count <<
+                " keys, more than the " << m_filterSize << " configured";
+        }
+        return filter;
     }
 
     std::shared_ptr<NodeObject> fetchInternal (Backend& backend,
-        uint256 const& hash)
+        BloomFilter const* filter, uint256 const& hash)
     {
         std::shared_ptr<NodeObject> object;
 
+        if (filter && ! filter->mayContain (hash))
+        {
+            ++m_filterHitCount;
+            return object;
+        }
+
         Status const status = backend.fetch (hash.begin (), &object);
 
         switch (status)
@@ -243,7 +376,11 @@ public:
             ++m_fetchHitCount;
             if (object)
                 m_fetchSize += object->getData().size();
+            break;
+
         case notFound:
+            if (filter)
+                ++m_filterFalsePositiveCount;
             break;
 
         case dataCorrupt:
@@ -262,19 +399,82 @@ public:
         return object;
     }
 
+    std::vector<std::shared_ptr<NodeObject>> fetchBatchInternal (
+        Backend& backend, BloomFilter const* filter,
+            std::vector<uint256> const& hashes)
+    {
+        std::vector<std::shared_ptr<NodeObject>> objects (hashes.size ());
+
+        // Keys the filter doesn't rule out, and where their objects go
+        std::vector<void const*> keys;
+        std::vector<std::size_t> where;
+        keys.reserve (hashes.size ());
+        where.reserve (hashes.size ());
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+        {
+            if (filter && ! filter->mayContain (hashes[i]))
+            {
+                ++m_filterHitCount;
+                continue;
+            }
+            keys.push_back (hashes[i].begin ());
+            where.push_back (i);
+        }
+
+        if (keys.empty ())
+            return objects;
+
+        if (! backend.canFetchBatch ())
+        {
+            for (std::size_t i = 0; i < keys.size (); ++i)
+            {
+                auto& obj = objects[where[i]];
+                obj = fetchInternal (backend, nullptr, hashes[where[i]]);
+                if (filter && ! obj)
+                    ++m_filterFalsePositiveCount;
+            }
+            return objects;
+        }
+
+        auto found = backend.fetchBatch (keys.size (), keys.data ());
+        assert (found.size () == keys.size ());
+        for (std::size_t i = 0; i < keys.size (); ++i)
+        {
+            auto& obj = found[i];
+            if (obj)
+            {
+                ++m_fetchHitCount;
+                m_fetchSize += obj->getData().size();
+            }
+            else if (filter)
+            {
+                ++m_filterFalsePositiveCount;
+            }
+            objects[where[i]] = std::move (obj);
+        }
+        return objects;
+    }
+
     //------------------------------------------------------------------------------
 
     void store (NodeObjectType type,
                 Blob&& data,
                 uint256 const& hash) override
     {
-        storeInternal (type, std::move(data), hash, *m_backend.get());
+        storeInternal (type, std::move(data), hash,
+            *m_backend.get(), m_filter.get());
+    }
+
+    void storeBatch (Batch const& batch) override
+    {
+        storeBatchInternal (batch, *m_backend.get(), m_filter.get());
     }
 
     void storeInternal (NodeObjectType type,
                         Blob&& data,
                         uint256 const& hash,
-                        Backend& backend)
+                        Backend& backend,
+                        BloomFilter* filter)
     {
         #if RIPPLE_VERIFY_NODEOBJECT_KEYS
         assert (hash == sha512Hash(makeSlice(data)));
@@ -285,6 +485,8 @@ public:
 
         m_cache.canonicalize (hash, object, true);
 
+        if (filter)
+            filter->insert (hash);
         backend.store (object);
         ++m_storeCount;
         if (object)
@@ -293,6 +495,32 @@ public:
         m_negCache.erase (hash);
     }
 
+    void storeBatchInternal (Batch const& batch, Backend& backend,
+        BloomFilter* filter)
+    {
+        if (batch.empty ())
+            return;
+
+        std::uint32_t size = 0;
+        for (auto object : batch)
+        {
+            #if RIPPLE_VERIFY_NODEOBJECT_KEYS
+            assert (object->getHash () ==
+                sha512Hash (makeSlice (object->getData ())));
+            #endif
+
+            m_cache.canonicalize (object->getHash (), object, true);
+            m_negCache.erase (object->getHash ());
+            if (filter)
+                filter->insert (object->getHash ());
+            size += object->getData ().size ();
+        }
+
+        backend.storeBatch (batch);
+        m_storeCount += batch.size ();
+        m_storeSize += size;
+    }
+
     //------------------------------------------------------------------------------
 
     float getCacheHitRate () override
@@ -325,13 +553,19 @@ public:
     void threadEntry ()
     {
         beast::setCurrentThreadName ("prefetch");
+        std::vector<uint256> hashes;
+        hashes.reserve (readBatchSize);
         while (1)
         {
-            uint256 hash;
-
             {
                 std::unique_lock <std::mutex> lock (m_readLock);
 
+                if (! hashes.empty ())
+                {
+                    hashes.clear ();
+                    --m_readPending;
+                }
+
                 while (!m_readShut && m_readSet.empty ())
                 {
                     // all work is done
@@ -353,13 +587,22 @@ public:
                     m_readGenCondVar.notify_all ();
                 }
 
-                hash = *it;
-                m_readSet.erase (it);
-                m_readLast = hash;
+                // Take the keys that follow, up to the end of the set
+                while (it != m_readSet.end () &&
+                    hashes.size () < readBatchSize)
+                {
+                    hashes.push_back (*it);
+                    it = m_readSet.erase (it);
+                }
+                m_readLast = hashes.back ();
+                ++m_readPending;
             }
 
-            // Perform the read
-            doTimedFetch (hash, true);
+            // Perform the reads
+            if (hashes.size () == 1)
+                doTimedFetch (hashes.front (), true);
+            else
+                doTimedFetchBatch (hashes, true);
          }
      }
 
@@ -372,10 +615,11 @@ public:
 
     void import (Database& source) override
     {
-        importInternal (source, *m_backend.get());
+        importInternal (source, *m_backend.get(), m_filter.get());
     }
 
-    void importInternal (Database& source, Backend& dest)
+    void importInternal (Database& source, Backend& dest,
+        BloomFilter* filter)
     {
         Batch b;
         b.reserve (batchWritePreallocationSize);
@@ -389,6 +633,8 @@ public:
                 b.reserve (batchWritePreallocationSize);
             }
 
+            if (filter)
+                filter->insert (object->getHash ());
             b.push_back (object);
             ++m_storeCount;
             if (object)
@@ -424,6 +670,16 @@ public:
         return m_fetchSize;
     }
 
+    std::uint32_t getFilterHitCount () const override
+    {
+        return m_filterHitCount;
+    }
+
+    std::uint32_t getFilterFalsePositiveCount () const override
+    {
+        return m_filterFalsePositiveCount;
+    }
+
     int fdlimit() const override
     {
         return fdlimit_;
@@ -31,25 +31,82 @@ std::shared_ptr <Backend> DatabaseRotatingImp::rotateBackends (
     archiveBackend_ = writableBackend_;
     writableBackend_ = newBackend;
 
+    // The new backend starts out empty
+    archiveFilter_ = std::move (writableFilter_);
+    if (m_filterSize != 0)
+        writableFilter_ = std::make_shared <BloomFilter> (m_filterSize);
+
     return oldBackend;
 }
 
 std::shared_ptr<NodeObject> DatabaseRotatingImp::fetchFrom (uint256 const& hash)
 {
     Backends b = getBackends();
-    std::shared_ptr<NodeObject> object = fetchInternal (*b.writableBackend, hash);
+    std::shared_ptr<NodeObject> object = fetchInternal (
+        *b.writableBackend, b.writableFilter.get(), hash);
     if (!object)
     {
-        object = fetchInternal (*b.archiveBackend, hash);
+        object = fetchInternal (
+            *b.archiveBackend, b.archiveFilter.get(), hash);
         if (object)
         {
-            getWritableBackend()->store (object);
+            Backends w = getBackends();
+            if (w.writableFilter)
+                w.writableFilter->insert (hash);
+            w.writableBackend->store (object);
             m_negCache.erase (hash);
         }
     }
 
     return object;
 }
+
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseRotatingImp::fetchBatchFrom (std::vector<uint256> const& hashes)
+{
+    Backends b = getBackends();
+    auto objects = fetchBatchInternal (
+        *b.writableBackend, b.writableFilter.get(), hashes);
+
+    std::vector<uint256> missing;
+    std::vector<std::size_t> where;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+        if (! objects[i])
+        {
+            missing.push_back (hashes[i]);
+            where.push_back (i);
+        }
+    }
+    if (missing.empty())
+        return objects;
+
+    auto archived = fetchBatchInternal (
+        *b.archiveBackend, b.archiveFilter.get(), missing);
+
+    Batch copy;
+    for (std::size_t i = 0; i < archived.size(); ++i)
+    {
+        if (archived[i])
+        {
+            copy.push_back (archived[i]);
+            objects[where[i]] = std::move (archived[i]);
+        }
+    }
+    if (! copy.empty())
+    {
+        Backends w = getBackends();
+        for (auto const& object : copy)
+        {
+            if (w.writableFilter)
+                w.writableFilter->insert (object->getHash());
+            m_negCache.erase (object->getHash());
+        }
+        w.writableBackend->storeBatch (copy);
+    }
+
+    return objects;
+}
 }
 
 }
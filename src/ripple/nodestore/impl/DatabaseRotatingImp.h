@@ -33,17 +33,24 @@ class DatabaseRotatingImp
 private:
     std::shared_ptr <Backend> writableBackend_;
     std::shared_ptr <Backend> archiveBackend_;
+    // Keys in each backend, if filtering lookups
+    std::shared_ptr <BloomFilter> writableFilter_;
+    std::shared_ptr <BloomFilter> archiveFilter_;
     mutable std::mutex rotateMutex_;
 
     struct Backends {
         std::shared_ptr <Backend> const& writableBackend;
         std::shared_ptr <Backend> const& archiveBackend;
+        // Copied, so a rotation can't free them while in use
+        std::shared_ptr <BloomFilter> writableFilter;
+        std::shared_ptr <BloomFilter> archiveFilter;
     };
 
     Backends getBackends() const
     {
         std::lock_guard <std::mutex> lock (rotateMutex_);
-        return Backends {writableBackend_, archiveBackend_};
+        return Backends {writableBackend_, archiveBackend_,
+            writableFilter_, archiveFilter_};
     }
 
 public:
@@ -53,6 +60,7 @@ public:
                  Stoppable& parent,
                  std::shared_ptr <Backend> writableBackend,
                  std::shared_ptr <Backend> archiveBackend,
+                 std::size_t filterSize,
                  beast::Journal journal)
             : DatabaseImp (
                 name,
@@ -60,9 +68,12 @@ public:
                 readThreads,
                 parent,
                 std::unique_ptr <Backend>(),
+                filterSize,
                 journal)
             , writableBackend_ (writableBackend)
             , archiveBackend_ (archiveBackend)
+            , writableFilter_ (makeFilter (*writableBackend))
+            , archiveFilter_ (makeFilter (*archiveBackend))
     {}
 
     ~DatabaseRotatingImp () override
@@ -109,15 +120,24 @@ public:
 
     void import (Database& source) override
     {
-        importInternal (source, *getWritableBackend());
+        Backends b = getBackends();
+        importInternal (source, *b.writableBackend, b.writableFilter.get());
     }
 
     void store (NodeObjectType type,
                 Blob&& data,
                 uint256 const& hash) override
     {
+        Backends b = getBackends();
         storeInternal (type, std::move(data), hash,
-                *getWritableBackend());
+                *b.writableBackend, b.writableFilter.get());
+    }
+
+    void storeBatch (Batch const& batch) override
+    {
+        Backends b = getBackends();
+        storeBatchInternal (batch, *b.writableBackend,
+            b.writableFilter.get());
     }
 
     std::shared_ptr<NodeObject> fetchNode (uint256 const& hash) override
@@ -126,6 +146,10 @@ public:
     }
 
     std::shared_ptr<NodeObject> fetchFrom (uint256 const& hash) override;
+
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom (std::vector<uint256> const& hashes) override;
+
     TaggedCache <uint256, NodeObject>& getPositiveCache() override
     {
         return m_cache;
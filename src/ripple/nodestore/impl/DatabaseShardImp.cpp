@@ -0,0 +1,331 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/DatabaseShardImp.h>
+#include <ripple/basics/contract.h>
+#include <ripple/basics/random.h>
+#include <boost/lexical_cast.hpp>
+
+namespace ripple {
+namespace NodeStore {
+
+DatabaseShardImp::DatabaseShardImp (std::string const& name,
+        Scheduler& scheduler,
+        int readThreads,
+        Stoppable& parent,
+        Section const& config,
+        beast::Journal journal)
+    : DatabaseImp (
+        name,
+        scheduler,
+        readThreads,
+        parent,
+        std::unique_ptr <Backend>(),
+        0,
+        journal)
+    , config_ (config)
+    , scheduler_ (scheduler)
+    , j_ (journal)
+    , dir_ (get<std::string> (config, "path"))
+    , ledgersPerShard_ (get<std::uint32_t> (
+        config, "ledgers_per_shard", 16384))
+    , earliestSeq_ (get<std::uint32_t> (config, "earliest_seq", 1))
+{
+    using namespace boost::filesystem;
+
+    if (dir_.empty ())
+        Throw<std::runtime_error> ("Missing path in [shard_db] section");
+    if (ledgersPerShard_ == 0)
+        Throw<std::runtime_error> ("Invalid ledgers_per_shard in [shard_db]");
+    create_directories (dir_);
+
+    for (auto const& entry : directory_iterator (dir_))
+    {
+        if (! is_directory (entry.path ()))
+            continue;
+
+        std::uint32_t index;
+        try
+        {
+            index = boost::lexical_cast <std::uint32_t> (
+                entry.path ().filename ().string ());
+        }
+        catch (boost::bad_lexical_cast const&)
+        {
+            continue;
+        }
+
+        auto shard = std::make_shared <Shard> (index, firstSeq (index),
+            lastSeq (index), entry.path (), j_);
+        shard->open (config_, scheduler_);
+        if (shard->complete ())
+        {
+            complete_.emplace (index, std::move (shard));
+        }
+        else if (! incomplete_)
+        {
+            incomplete_ = std::move (shard);
+        }
+        else
+        {
+            JLOG(j_.warn()) <<
+                "Ignoring shard " << index << ", shard " <<
+                incomplete_->index () << " is being acquired";
+        }
+    }
+
+    JLOG(j_.info()) <<
+        "Shards: " << getCompleteShards () << (incomplete_ ?
+            ", acquiring " + std::to_string (incomplete_->index ()) : "");
+}
+
+std::vector <std::shared_ptr <Shard>>
+DatabaseShardImp::getShards () const
+{
+    std::vector <std::shared_ptr <Shard>> shards;
+    std::lock_guard <std::mutex> lock (mutex_);
+    shards.reserve (complete_.size () + 1);
+    if (incomplete_)
+        shards.push_back (incomplete_);
+    for (auto iter = complete_.rbegin (); iter != complete_.rend (); ++iter)
+        shards.push_back (iter->second);
+    return shards;
+}
+
+std::shared_ptr <Shard>
+DatabaseShardImp::findShard (std::uint32_t seq) const
+{
+    auto const index = seqToShardIndex (seq);
+    std::lock_guard <std::mutex> lock (mutex_);
+    if (incomplete_ && incomplete_->index () == index)
+        return incomplete_;
+    auto const iter = complete_.find (index);
+    if (iter != complete_.end ())
+        return iter->second;
+    return nullptr;
+}
+
+boost::optional<std::uint32_t>
+DatabaseShardImp::prepare (std::uint32_t validLedgerSeq)
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    if (incomplete_)
+        return incomplete_->prepare ();
+
+    // Every ledger in a candidate has been validated
+    if (validLedgerSeq <= ledgersPerShard_)
+        return boost::none;
+    auto const end = seqToShardIndex (validLedgerSeq);
+    std::vector <std::uint32_t> candidates;
+    for (auto index = seqToShardIndex (earliestSeq_); index < end; ++index)
+    {
+        if (firstSeq (index) >= earliestSeq_ && ! complete_.count (index))
+            candidates.push_back (index);
+    }
+    if (candidates.empty ())
+        return boost::none;
+
+    // Nodes choosing at random hold different parts of history
+    auto const index = candidates.size () == 1 ? candidates.front () :
+        candidates[rand_int (candidates.size () - 1)];
+    auto shard = std::make_shared <Shard> (index, firstSeq (index),
+        lastSeq (index), dir_ / std::to_string (index), j_);
+    shard->open (config_, scheduler_);
+    incomplete_ = std::move (shard);
+
+    JLOG(j_.info()) <<
+        "Acquiring shard " << index << ", ledgers " <<
+        firstSeq (index) << " through " << lastSeq (index);
+    return incomplete_->prepare ();
+}
+
+bool
+DatabaseShardImp::store (NodeObjectType type,
+    Blob&& data, uint256 const& hash, std::uint32_t seq)
+{
+    auto const shard = getIncomplete ();
+    if (! shard || ! shard->inRange (seq))
+    {
+        JLOG(j_.debug()) <<
+            "Not acquiring the shard for ledger " << seq;
+        return false;
+    }
+    storeInternal (type, std::move (data), hash, shard->backend (), nullptr);
+    return true;
+}
+
+void
+DatabaseShardImp::setStored (std::uint32_t seq)
+{
+    auto const shard = getIncomplete ();
+    if (! shard || ! shard->inRange (seq))
+    {
+        JLOG(j_.warn()) <<
+            "Not acquiring the shard for ledger " << seq;
+        return;
+    }
+
+    // The ledger's objects must be on disk before the control
+    // file says they are. Syncing can take a while, so it is
+    // done without holding the lock that fetches need.
+    shard->backend ().sync ();
+
+    std::lock_guard <std::mutex> lock (mutex_);
+    if (incomplete_ != shard)
+        return;
+    if (incomplete_->setStored (seq))
+    {
+        auto const index = incomplete_->index ();
+        complete_.emplace (index, std::move (incomplete_));
+        incomplete_.reset ();
+    }
+}
+
+bool
+DatabaseShardImp::contains (std::uint32_t seq)
+{
+    auto const index = seqToShardIndex (seq);
+    std::lock_guard <std::mutex> lock (mutex_);
+    if (complete_.count (index))
+        return true;
+    return incomplete_ && incomplete_->contains (seq);
+}
+
+std::shared_ptr<NodeObject>
+DatabaseShardImp::fetch (uint256 const& hash, std::uint32_t seq)
+{
+    std::shared_ptr<NodeObject> obj = m_cache.fetch (hash);
+    if (obj)
+        return obj;
+
+    // A miss in one shard says nothing of the others,
+    // so the negative cache is left alone
+    auto const shard = findShard (seq);
+    if (! shard)
+        return nullptr;
+
+    obj = fetchInternal (shard->backend (), nullptr, hash);
+    ++m_fetchTotalCount;
+    if (obj)
+        m_cache.canonicalize (hash, obj);
+    return obj;
+}
+
+std::string
+DatabaseShardImp::getCompleteShards ()
+{
+    RangeSet indexes;
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        for (auto const& e : complete_)
+            indexes.setValue (e.first);
+    }
+    return indexes.toString ();
+}
+
+int
+DatabaseShardImp::fdlimit () const
+{
+    int n = 0;
+    for (auto const& shard : getShards ())
+        n += shard->backend ().fdlimit ();
+    return n;
+}
+
+void
+DatabaseShardImp::import (Database&)
+{
+    Throw<std::runtime_error> ("Import into a shard store is not supported");
+}
+
+void
+DatabaseShardImp::store (NodeObjectType type,
+    Blob&& data, uint256 const& hash)
+{
+    auto const shard = getIncomplete ();
+    if (! shard)
+    {
+        JLOG(j_.debug()) << "No shard to store " << hash;
+        return;
+    }
+    storeInternal (type, std::move (data), hash, shard->backend (), nullptr);
+}
+
+void
+DatabaseShardImp::storeBatch (Batch const& batch)
+{
+    auto const shard = getIncomplete ();
+    if (! shard)
+    {
+        JLOG(j_.debug()) << "No shard to store " << batch.size () << " objects";
+        return;
+    }
+    storeBatchInternal (batch, shard->backend (), nullptr);
+}
+
+std::shared_ptr<NodeObject>
+DatabaseShardImp::fetchFrom (uint256 const& hash)
+{
+    for (auto const& shard : getShards ())
+    {
+        if (auto obj = fetchInternal (shard->backend (), nullptr, hash))
+            return obj;
+    }
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<NodeObject>>
+DatabaseShardImp::fetchBatchFrom (std::vector<uint256> const& hashes)
+{
+    std::vector<std::shared_ptr<NodeObject>> objects (hashes.size ());
+    std::vector<uint256> missing = hashes;
+    std::vector<std::size_t> where (hashes.size ());
+    for (std::size_t i = 0; i < where.size (); ++i)
+        where[i] = i;
+
+    for (auto const& shard : getShards ())
+    {
+        if (missing.empty ())
+            break;
+
+        auto found = fetchBatchInternal (
+            shard->backend (), nullptr, missing);
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < found.size (); ++i)
+        {
+            if (found[i])
+            {
+                objects[where[i]] = std::move (found[i]);
+            }
+            else
+            {
+                missing[n] = missing[i];
+                where[n] = where[i];
+                ++n;
+            }
+        }
+        missing.resize (n);
+        where.resize (n);
+    }
+    return objects;
+}
+
+}
+}
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_DATABASESHARDIMP_H_INCLUDED
+#define RIPPLE_NODESTORE_DATABASESHARDIMP_H_INCLUDED
+
+#include <ripple/nodestore/impl/DatabaseImp.h>
+#include <ripple/nodestore/impl/Shard.h>
+#include <ripple/nodestore/DatabaseShard.h>
+#include <map>
+
+namespace ripple {
+namespace NodeStore {
+
+class DatabaseShardImp
+    : public DatabaseImp
+    , public DatabaseShard
+{
+private:
+    Section const config_;
+    Scheduler& scheduler_;
+    beast::Journal j_;
+    boost::filesystem::path const dir_;
+    std::uint32_t const ledgersPerShard_;
+    // Shards before the one holding this ledger are never acquired
+    std::uint32_t const earliestSeq_;
+
+    mutable std::mutex mutex_;
+    std::map <std::uint32_t, std::shared_ptr <Shard>> complete_;
+    // The shard being acquired, if any
+    std::shared_ptr <Shard> incomplete_;
+
+    // Returns the shards, the one being acquired first
+    std::vector <std::shared_ptr <Shard>> getShards () const;
+
+    // Returns the shard holding a ledger, if we have it
+    std::shared_ptr <Shard> findShard (std::uint32_t seq) const;
+
+    std::shared_ptr <Shard> getIncomplete () const
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        return incomplete_;
+    }
+
+public:
+    DatabaseShardImp (std::string const& name,
+                 Scheduler& scheduler,
+                 int readThreads,
+                 Stoppable& parent,
+                 Section const& config,
+                 beast::Journal journal);
+
+    ~DatabaseShardImp () override
+    {
+        // Stop threads before data members are destroyed.
+        DatabaseImp::stopThreads ();
+    }
+
+    std::uint32_t ledgersPerShard () const override
+    {
+        return ledgersPerShard_;
+    }
+
+    boost::optional<std::uint32_t>
+    prepare (std::uint32_t validLedgerSeq) override;
+
+    bool store (NodeObjectType type,
+                Blob&& data,
+                uint256 const& hash,
+                std::uint32_t seq) override;
+
+    void setStored (std::uint32_t seq) override;
+
+    bool contains (std::uint32_t seq) override;
+
+    std::shared_ptr<NodeObject>
+    fetch (uint256 const& hash, std::uint32_t seq) override;
+
+    std::shared_ptr<NodeObject> fetch (uint256 const& hash) override
+    {
+        return DatabaseImp::fetch (hash);
+    }
+
+    std::string getCompleteShards () override;
+
+    std::string getName() const override
+    {
+        return dir_.string();
+    }
+
+    std::int32_t getWriteLoad() const override
+    {
+        if (auto const shard = getIncomplete ())
+            return shard->backend().getWriteLoad();
+        return 0;
+    }
+
+    int fdlimit() const override;
+
+    void for_each (std::function <void(std::shared_ptr<NodeObject>)> f) override
+    {
+        for (auto const& shard : getShards ())
+            shard->backend().for_each (f);
+    }
+
+    void import (Database& source) override;
+
+    // Objects without a ledger go to the shard being acquired
+    void store (NodeObjectType type,
+                Blob&& data,
+                uint256 const& hash) override;
+
+    void storeBatch (Batch const& batch) override;
+
+    std::shared_ptr<NodeObject> fetchFrom (uint256 const& hash) override;
+
+    std::vector<std::shared_ptr<NodeObject>>
+    fetchBatchFrom (std::vector<uint256> const& hashes) override;
+};
+
+}
+}
+
+#endif
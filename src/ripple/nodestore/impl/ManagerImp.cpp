@@ -20,6 +20,11 @@
 #include <BeastConfig.h>
 #include <ripple/nodestore/impl/ManagerImp.h>
 #include <ripple/nodestore/impl/DatabaseRotatingImp.h>
+#include <ripple/nodestore/impl/DatabaseShardImp.h>
+#include <ripple/nodestore/impl/EncodedBlob.h>
+#include <ripple/nodestore/impl/codec.h>
+#include <ripple/basics/random.h>
+#include <nudb/detail/buffer.hpp>
 
 namespace ripple {
 namespace NodeStore {
@@ -98,6 +103,7 @@ ManagerImp::make_Database (
             backendParameters,
             scheduler,
             journal),
+        get<std::size_t> (backendParameters, "filter_size"),
         journal);
 }
 
@@ -109,6 +115,7 @@ ManagerImp::make_DatabaseRotating (
         Stoppable& parent,
         std::shared_ptr <Backend> writableBackend,
         std::shared_ptr <Backend> archiveBackend,
+        std::size_t filterSize,
         beast::Journal journal)
 {
     return std::make_unique <DatabaseRotatingImp> (
@@ -118,6 +125,29 @@ ManagerImp::make_DatabaseRotating (
         parent,
         writableBackend,
         archiveBackend,
+        filterSize,
+        journal);
+}
+
+std::unique_ptr <DatabaseShard>
+ManagerImp::make_DatabaseShard (
+        std::string const& name,
+        Scheduler& scheduler,
+        int readThreads,
+        Stoppable& parent,
+        Section const& config,
+        beast::Journal journal)
+{
+    Section backendParameters (config);
+    if (! backendParameters.exists ("type"))
+        backendParameters.set ("type", "nudb");
+
+    return std::make_unique <DatabaseShardImp> (
+        name,
+        scheduler,
+        readThreads,
+        parent,
+        backendParameters,
         journal);
 }
 
@@ -171,5 +201,82 @@ make_Backend (Section const& config,
         config, scheduler, journal);
 }
 
+bool
+trainDictionary (Backend& backend,
+    std::size_t sampleCount, beast::Journal journal)
+{
+    if (sampleCount == 0)
+        return false;
+
+    // Inner nodes are compressed without the dictionary
+    auto const isInner = [](NodeObject const& object)
+    {
+        auto const& data = object.getData ();
+        if (data.size () < 4)
+            return false;
+        std::uint32_t const prefix =
+            (std::uint32_t (data[0]) << 24) |
+            (std::uint32_t (data[1]) << 16) |
+            (std::uint32_t (data[2]) << 8) |
+            std::uint32_t (data[3]);
+        return prefix == HashPrefix::innerNode ||
+            prefix == HashPrefix::innerNodeV2;
+    };
+
+    // Every object is equally likely to be sampled
+    std::vector <Blob> samples;
+    std::size_t seen = 0;
+    EncodedBlob encoded;
+    backend.for_each (
+        [&](std::shared_ptr <NodeObject> object)
+        {
+            if (isInner (*object))
+                return;
+            auto slot = samples.size ();
+            if (++seen > sampleCount)
+            {
+                slot = rand_int (seen - 1);
+                if (slot >= sampleCount)
+                    return;
+            }
+            encoded.prepare (object);
+            auto const p = static_cast <std::uint8_t const*> (
+                encoded.getData ());
+            Blob sample (p, p + encoded.getSize ());
+            if (slot == samples.size ())
+                samples.push_back (std::move (sample));
+            else
+                samples[slot] = std::move (sample);
+        });
+
+    auto dictionary = train_dictionary (samples);
+    if (dictionary.empty ())
+    {
+        JLOG (journal.warn()) <<
+            "No dictionary trained from " << samples.size () << " objects";
+        return false;
+    }
+
+    {
+        std::size_t before = 0;
+        std::size_t after = 0;
+        CodecDictionary const dict (0, dictionary);
+        nudb::detail::buffer bf;
+        for (auto const& sample : samples)
+        {
+            before += nodeobject_compress (
+                sample.data (), sample.size (), bf).second;
+            after += nodeobject_compress (
+                sample.data (), sample.size (), bf, &dict).second;
+        }
+        JLOG (journal.info()) <<
+            "Trained a " << dictionary.size () << " byte dictionary on " <<
+            samples.size () << " of " << seen << " objects, which it " <<
+            "compresses to " << after << " bytes instead of " << before;
+    }
+
+    return backend.addDictionary (dictionary);
+}
+
 }
 }
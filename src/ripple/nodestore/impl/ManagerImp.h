@@ -76,6 +76,16 @@ public:
         Stoppable& parent,
         std::shared_ptr <Backend> writableBackend,
         std::shared_ptr <Backend> archiveBackend,
+        std::size_t filterSize,
+        beast::Journal journal) override;
+
+    std::unique_ptr <DatabaseShard>
+    make_DatabaseShard (
+        std::string const& name,
+        Scheduler& scheduler,
+        int readThreads,
+        Stoppable& parent,
+        Section const& config,
         beast::Journal journal) override;
 };
 
@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/Shard.h>
+#include <ripple/nodestore/Manager.h>
+#include <ripple/basics/contract.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <fstream>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+Shard::Shard (std::uint32_t index, std::uint32_t firstSeq,
+        std::uint32_t lastSeq, boost::filesystem::path dir,
+            beast::Journal journal)
+    : index_ (index)
+    , firstSeq_ (firstSeq)
+    , lastSeq_ (lastSeq)
+    , dir_ (std::move (dir))
+    , control_ (dir_ / "control.txt")
+    , j_ (journal)
+{
+}
+
+void
+Shard::open (Section config, Scheduler& scheduler)
+{
+    using namespace boost::filesystem;
+
+    bool const exists = is_directory (dir_);
+    if (! exists)
+    {
+        // The control file goes first, so an interrupted
+        // creation is never mistaken for a complete shard
+        create_directories (dir_);
+        saveControl ();
+    }
+
+    config.set ("path", dir_.string ());
+    backend_ = Manager::instance ().make_Backend (config, scheduler, j_);
+
+    if (! is_regular_file (control_))
+    {
+        complete_ = true;
+        stored_.setRange (firstSeq_, lastSeq_);
+        return;
+    }
+
+    std::ifstream in (control_.string ());
+    std::string line;
+    std::getline (in, line);
+    boost::trim (line);
+    if (line != "empty" && ! line.empty ())
+    {
+        std::vector<std::string> ranges;
+        boost::split (ranges, line, boost::algorithm::is_any_of (","));
+        for (auto const& range : ranges)
+        {
+            std::vector<std::string> bounds;
+            boost::split (bounds, range, boost::algorithm::is_any_of ("-"));
+            std::uint32_t first = 0;
+            std::uint32_t last = 0;
+            try
+            {
+                first = boost::lexical_cast<std::uint32_t> (bounds.front ());
+                last = boost::lexical_cast<std::uint32_t> (bounds.back ());
+            }
+            catch (boost::bad_lexical_cast const&)
+            {
+                Throw<std::runtime_error> (
+                    "Shard " + std::to_string (index_) +
+                    " has a malformed control file");
+            }
+            if (bounds.size () > 2 || first > last ||
+                ! inRange (first) || ! inRange (last))
+            {
+                Throw<std::runtime_error> (
+                    "Shard " + std::to_string (index_) +
+                    " has a malformed control file");
+            }
+            stored_.setRange (first, last);
+        }
+    }
+
+    JLOG(j_.debug()) <<
+        "Shard " << index_ << " holds ledgers " << stored_.toString ();
+}
+
+boost::optional<std::uint32_t>
+Shard::prepare () const
+{
+    if (complete_)
+        return boost::none;
+
+    // Acquire from the top down, so each ledger
+    // gives the hash of the one before it
+    auto const seq = stored_.prevMissing (lastSeq_ + 1);
+    if (seq == RangeSet::absent || seq < firstSeq_)
+        return boost::none;
+    return seq;
+}
+
+bool
+Shard::setStored (std::uint32_t seq)
+{
+    assert (inRange (seq));
+    if (complete_ || stored_.hasValue (seq))
+        return complete_;
+
+    stored_.setValue (seq);
+    if (stored_.lebesgue_sum () == lastSeq_ - firstSeq_ + 1)
+    {
+        boost::filesystem::remove (control_);
+        complete_ = true;
+        JLOG(j_.info()) << "Shard " << index_ << " complete";
+    }
+    else
+    {
+        saveControl ();
+    }
+    return complete_;
+}
+
+bool
+Shard::contains (std::uint32_t seq) const
+{
+    return inRange (seq) && stored_.hasValue (seq);
+}
+
+void
+Shard::saveControl ()
+{
+    auto const temp = dir_ / "control.tmp";
+    {
+        std::ofstream out (temp.string (), std::ios::trunc);
+        out << stored_.toString () << '\n';
+        if (! out)
+            Throw<std::runtime_error> (
+                "Unable to write " + temp.string ());
+    }
+    boost::filesystem::rename (temp, control_);
+}
+
+}
+}
@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_SHARD_H_INCLUDED
+#define RIPPLE_NODESTORE_SHARD_H_INCLUDED
+
+#include <ripple/nodestore/Backend.h>
+#include <ripple/nodestore/Scheduler.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/basics/RangeSet.h>
+#include <ripple/beast/utility/Journal.h>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <memory>
+
+namespace ripple {
+namespace NodeStore {
+
+/** The ledgers in a range, and a backend holding the objects they use.
+
+    Until every ledger in the range is stored, the ledgers the shard holds
+    are recorded in a control file in the shard's directory. The control
+    file is removed when the last ledger is stored, and the shard is not
+    written to again.
+
+    The caller must synchronize access, except to the backend.
+*/
+class Shard
+{
+public:
+    Shard (std::uint32_t index, std::uint32_t firstSeq,
+        std::uint32_t lastSeq, boost::filesystem::path dir,
+            beast::Journal journal);
+
+    /** Open the backend, creating the shard if it does not exist.
+
+        @param config The backend parameters, less the path.
+        @note If the shard cannot be opened, an exception is thrown.
+    */
+    void
+    open (Section config, Scheduler& scheduler);
+
+    /** Returns the highest ledger the shard does not hold, if any. */
+    boost::optional<std::uint32_t>
+    prepare () const;
+
+    /** Record that a ledger is stored.
+
+        The backend must have been synced since the ledger's
+        objects were stored, since the control file is updated.
+
+        @return `true` if the shard is now complete.
+    */
+    bool
+    setStored (std::uint32_t seq);
+
+    /** Returns `true` if the ledger is in the shard's range. */
+    bool
+    inRange (std::uint32_t seq) const
+    {
+        return seq >= firstSeq_ && seq <= lastSeq_;
+    }
+
+    /** Returns `true` if the ledger is stored. */
+    bool
+    contains (std::uint32_t seq) const;
+
+    bool
+    complete () const
+    {
+        return complete_;
+    }
+
+    std::uint32_t
+    index () const
+    {
+        return index_;
+    }
+
+    Backend&
+    backend ()
+    {
+        return *backend_;
+    }
+
+private:
+    // Write the stored ledgers to the control file
+    void
+    saveControl ();
+
+    std::uint32_t const index_;
+    std::uint32_t const firstSeq_;
+    std::uint32_t const lastSeq_;
+    boost::filesystem::path const dir_;
+    boost::filesystem::path const control_;
+    beast::Journal j_;
+    std::unique_ptr<Backend> backend_;
+    RangeSet stored_;
+    bool complete_ = false;
+};
+
+}
+}
+
+#endif
@@ -33,6 +33,9 @@ enum
 
     // Fraction of the cache one query source can take
     ,asyncDivider = 8
+
+    // Most keys an async read thread fetches from the backend at once
+    ,readBatchSize = 64
 };
 
 }
@@ -20,6 +20,7 @@
 #ifndef RIPPLE_NODESTORE_CODEC_H_INCLUDED
 #define RIPPLE_NODESTORE_CODEC_H_INCLUDED
 
+#include <ripple/basics/Blob.h>
 #include <ripple/basics/contract.h>
 #include <nudb/detail/field.hpp>
 #include <ripple/nodestore/impl/varint.h>
@@ -27,9 +28,15 @@
 #include <ripple/protocol/HashPrefix.h>
 #include <lz4/lib/lz4.h>
 #include <snappy.h>
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstring>
+#include <memory>
+#include <queue>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace ripple {
 namespace NodeStore {
@@ -129,6 +136,314 @@ lz4_compress (void const* in,
 
 //------------------------------------------------------------------------------
 
+/** A dictionary for compressing node objects with LZ4.
+
+    Ledger entries and transactions are small and share most of their
+    content: field headers, flags, currencies and issuers. Compressed one
+    at a time there is little in an object to match against, so each is
+    compressed as if it followed a dictionary of that shared content.
+*/
+class CodecDictionary
+{
+public:
+    /** The largest dictionary LZ4 can use. */
+    static std::size_t constexpr maxSize = 64 * 1024;
+
+    CodecDictionary (std::uint32_t id, Blob data)
+        : id_ (id)
+        , data_ (std::move (data))
+    {
+        if (data_.empty () || data_.size () > maxSize)
+            Throw<std::runtime_error> (
+                "nodeobject codec: bad dictionary size");
+        LZ4_resetStream (&stream_);
+        LZ4_loadDict (&stream_,
+            reinterpret_cast<char const*>(data_.data ()),
+                static_cast<int>(data_.size ()));
+    }
+
+    CodecDictionary (CodecDictionary const&) = delete;
+    CodecDictionary& operator= (CodecDictionary const&) = delete;
+
+    /** Returns the number that compressed objects refer to it by. */
+    std::uint32_t
+    id () const
+    {
+        return id_;
+    }
+
+    Blob const&
+    data () const
+    {
+        return data_;
+    }
+
+    /** Prepare a stream to compress an object against the dictionary.
+
+        Copying the stream loaded when the dictionary was created is much
+        cheaper than loading the dictionary again.
+    */
+    void
+    prime (LZ4_stream_t& stream) const
+    {
+        stream = stream_;
+    }
+
+private:
+    std::uint32_t const id_;
+    Blob const data_;
+    LZ4_stream_t stream_;
+};
+
+/** The dictionaries that a store's objects are compressed with.
+
+    Stored objects refer to their dictionary by id, so dictionaries are
+    only ever added. New objects are compressed with the newest one.
+*/
+class CodecDictionaries
+{
+public:
+    /** Returns the dictionary for new objects, or nullptr if none. */
+    CodecDictionary const*
+    current () const
+    {
+        if (dicts_.empty ())
+            return nullptr;
+        return dicts_.back ().get ();
+    }
+
+    /** Returns the dictionary with an id, or nullptr if none. */
+    CodecDictionary const*
+    find (std::size_t id) const
+    {
+        for (auto const& dict : dicts_)
+            if (dict->id () == id)
+                return dict.get ();
+        return nullptr;
+    }
+
+    /** Add a dictionary, which becomes the current one.
+
+        @param id Must be greater than the id of the current dictionary.
+    */
+    CodecDictionary const&
+    add (std::uint32_t id, Blob data)
+    {
+        if (! dicts_.empty () && id <= dicts_.back ()->id ())
+            Throw<std::runtime_error> (
+                "nodeobject codec: dictionary id out of order");
+        dicts_.push_back (std::make_unique<CodecDictionary> (
+            id, std::move (data)));
+        return *dicts_.back ();
+    }
+
+    std::vector<std::unique_ptr<CodecDictionary>> const&
+    list () const
+    {
+        return dicts_;
+    }
+
+private:
+    std::vector<std::unique_ptr<CodecDictionary>> dicts_;
+};
+
+template <class BufferFactory>
+std::pair<void const*, std::size_t>
+lz4_decompress (void const* in, std::size_t in_size,
+    CodecDictionary const& dict, BufferFactory&& bf)
+{
+    using namespace nudb::detail;
+    std::pair<void const*, std::size_t> result;
+    std::uint8_t const* p = reinterpret_cast<
+        std::uint8_t const*>(in);
+    auto const n = read_varint(
+        p, in_size, result.second);
+    if (n == 0)
+        Throw<std::runtime_error> (
+            "lz4 decompress");
+    void* const out = bf(result.second);
+    result.first = out;
+    if (LZ4_decompress_safe_usingDict(
+        reinterpret_cast<char const*>(in) + n,
+            reinterpret_cast<char*>(out),
+                static_cast<int>(in_size - n),
+                    static_cast<int>(result.second),
+                        reinterpret_cast<char const*>(
+                            dict.data().data()),
+                                static_cast<int>(dict.data().size())) !=
+                                    static_cast<int>(result.second))
+        Throw<std::runtime_error> (
+            "lz4 decompress");
+    return result;
+}
+
+template <class BufferFactory>
+std::pair<void const*, std::size_t>
+lz4_compress (void const* in, std::size_t in_size,
+    CodecDictionary const& dict, BufferFactory&& bf)
+{
+    using namespace nudb::detail;
+    std::pair<void const*, std::size_t> result;
+    std::array<std::uint8_t, varint_traits<
+        std::size_t>::max> vi;
+    auto const n = write_varint(
+        vi.data(), in_size);
+    auto const out_max =
+        LZ4_compressBound(in_size);
+    std::uint8_t* out = reinterpret_cast<
+        std::uint8_t*>(bf(n + out_max));
+    result.first = out;
+    std::memcpy(out, vi.data(), n);
+    LZ4_stream_t stream;
+    dict.prime(stream);
+    auto const out_size = LZ4_compress_fast_continue(&stream,
+        reinterpret_cast<char const*>(in),
+            reinterpret_cast<char*>(out + n),
+                static_cast<int>(in_size), out_max, 1);
+    if (out_size == 0)
+        Throw<std::runtime_error> (
+            "lz4 compress");
+    result.second = n + out_size;
+    return result;
+}
+
+/** Build a dictionary from a sample of the objects it will compress.
+
+    The samples are cut into segments, and the segments whose content
+    appears in the most samples are chosen until the dictionary is full.
+    Content already chosen does not count towards later segments, so the
+    dictionary holds little that is repeated. The best segments come
+    last, where LZ4 prefers matches when content appears more than once.
+
+    @param samples Uncompressed objects, as the codec receives them.
+    @return The dictionary, empty if the samples share nothing.
+*/
+template <class = void>
+Blob
+train_dictionary (std::vector<Blob> const& samples,
+    std::size_t max_size = CodecDictionary::maxSize)
+{
+    // Content is compared in runs of this many bytes, and
+    // chosen in segments of up to segment_size bytes.
+    std::size_t constexpr run_size = 8;
+    std::size_t constexpr segment_size = 64;
+
+    auto const run = [](std::uint8_t const* p)
+    {
+        std::uint64_t v;
+        std::memcpy(&v, p, run_size);
+        return v;
+    };
+
+    // The number of samples each run appears in
+    std::unordered_map<std::uint64_t, std::uint32_t> counts;
+    {
+        std::vector<std::uint64_t> runs;
+        for (auto const& s : samples)
+        {
+            if (s.size() < run_size)
+                continue;
+            runs.clear();
+            for (std::size_t i = 0; i + run_size <= s.size(); ++i)
+                runs.push_back(run(&s[i]));
+            std::sort(runs.begin(), runs.end());
+            runs.erase(std::unique(
+                runs.begin(), runs.end()), runs.end());
+            for (auto const r : runs)
+                ++counts[r];
+        }
+    }
+
+    struct Segment
+    {
+        std::uint64_t score;
+        std::uint32_t sample;
+        std::uint32_t offset;
+        std::uint32_t size;
+
+        bool
+        operator< (Segment const& other) const
+        {
+            return score < other.score;
+        }
+    };
+
+    // The samples sharing each distinct run of a segment, not counting
+    // runs found in only one sample or already chosen.
+    std::vector<std::uint64_t> runs;
+    auto const score = [&](Segment const& seg)
+    {
+        auto const* p = samples[seg.sample].data() + seg.offset;
+        runs.clear();
+        for (std::size_t i = 0; i + run_size <= seg.size; ++i)
+            runs.push_back(run(p + i));
+        std::sort(runs.begin(), runs.end());
+        runs.erase(std::unique(
+            runs.begin(), runs.end()), runs.end());
+        std::uint64_t total = 0;
+        for (auto const r : runs)
+        {
+            auto const iter = counts.find(r);
+            if (iter != counts.end() && iter->second > 1)
+                total += iter->second;
+        }
+        return total;
+    };
+
+    std::priority_queue<Segment> queue;
+    for (std::uint32_t i = 0; i < samples.size(); ++i)
+    {
+        auto const size = samples[i].size();
+        for (std::size_t offset = 0;
+            offset + run_size <= size; offset += segment_size)
+        {
+            Segment seg {0, i, static_cast<std::uint32_t>(offset),
+                static_cast<std::uint32_t>(
+                    std::min(segment_size, size - offset))};
+            seg.score = score(seg);
+            if (seg.score > 0)
+                queue.push(seg);
+        }
+    }
+
+    // Choosing a segment lowers the score of others sharing its
+    // content, so a segment is only chosen if its score, brought up
+    // to date, is still the best.
+    std::vector<Segment> chosen;
+    std::size_t total = 0;
+    while (! queue.empty() && total < max_size)
+    {
+        auto seg = queue.top();
+        queue.pop();
+        seg.score = score(seg);
+        if (seg.score == 0)
+            continue;
+        if (! queue.empty() && seg.score < queue.top().score)
+        {
+            queue.push(seg);
+            continue;
+        }
+        seg.size = static_cast<std::uint32_t>(
+            std::min<std::size_t>(seg.size, max_size - total));
+        auto const* p = samples[seg.sample].data() + seg.offset;
+        for (std::size_t i = 0; i + run_size <= seg.size; ++i)
+            counts.erase(run(p + i));
+        chosen.push_back(seg);
+        total += seg.size;
+    }
+
+    Blob dict;
+    dict.reserve(total);
+    for (auto iter = chosen.rbegin(); iter != chosen.rend(); ++iter)
+    {
+        auto const* p = samples[iter->sample].data() + iter->offset;
+        dict.insert(dict.end(), p, p + iter->size);
+    }
+    return dict;
+}
+
+//------------------------------------------------------------------------------
+
 /*
     object types:
 
@@ -136,12 +451,19 @@ lz4_compress (void const* in,
     1 = lz4 compressed
     2 = inner node compressed
     3 = full inner node
+    5 = v2 inner node compressed
+    6 = full v2 inner node
+    7 = lz4 compressed with a dictionary, followed by the dictionary id
+
+    Objects compressed with a dictionary can only be decompressed with the
+    dictionaries passed to nodeobject_decompress.
 */
 
 template <class BufferFactory>
 std::pair<void const*, std::size_t>
 nodeobject_decompress (void const* in,
-    std::size_t in_size, BufferFactory&& bf)
+    std::size_t in_size, BufferFactory&& bf,
+        CodecDictionaries const* dicts = nullptr)
 {
     using namespace nudb::detail;
 
@@ -309,6 +631,23 @@ nodeobject_decompress (void const* in,
         write(os, is((depth+1)/2), (depth+1)/2);
         break;
     }
+    case 7: // lz4 with a dictionary
+    {
+        std::size_t id;
+        auto const n = read_varint(
+            p, in_size, id);
+        if (n == 0)
+            Throw<std::runtime_error> (
+                "nodeobject decompress");
+        auto const dict = dicts ? dicts->find(id) : nullptr;
+        if (! dict)
+            Throw<std::runtime_error> (
+                "nodeobject codec: unknown dictionary=" +
+                    std::to_string(id));
+        result = lz4_decompress(
+            p + n, in_size - n, *dict, bf);
+        break;
+    }
     default:
         Throw<std::runtime_error> (
             "nodeobject codec: bad type=" +
@@ -334,7 +673,8 @@ zero32()
 template <class BufferFactory>
 std::pair<void const*, std::size_t>
 nodeobject_compress (void const* in,
-    std::size_t in_size, BufferFactory&& bf)
+    std::size_t in_size, BufferFactory&& bf,
+        CodecDictionary const* dict = nullptr)
 {
     using std::runtime_error;
     using namespace nudb::detail;
@@ -487,9 +827,12 @@ nodeobject_compress (void const* in,
         }
     }
 
-    std::array<std::uint8_t, varint_traits<
+    if (dict)
+        type = 7;
+
+    std::array<std::uint8_t, 2 * varint_traits<
         std::size_t>::max> vi;
-    auto const vn = write_varint(
+    auto vn = write_varint(
         vi.data(), type);
     std::pair<void const*, std::size_t> result;
     switch(type)
@@ -512,6 +855,25 @@ nodeobject_compress (void const* in,
         result.second = vn + lzr.second;
         break;
     }
+    case 7: // lz4 with a dictionary
+    {
+        vn += write_varint(
+            vi.data() + vn, dict->id());
+        std::uint8_t* p;
+        auto const lzr = lz4_compress(
+                in, in_size, *dict, [&p, &vn, &bf]
+            (std::size_t n)
+            {
+                p = reinterpret_cast<
+                    std::uint8_t*>(
+                        bf(vn + n));
+                return p + vn;
+            });
+        std::memcpy(p, vi.data(), vn);
+        result.first = p;
+        result.second = vn + lzr.second;
+        break;
+    }
     default:
         Throw<std::logic_error> (
             "nodeobject codec: unknown=" +
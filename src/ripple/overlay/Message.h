@@ -27,6 +27,7 @@
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 
 namespace ripple {
@@ -43,6 +44,11 @@ namespace ripple {
 // a string prepended by a header specifying the message length.
 // MessageType should be a Message class generated by the protobuf compiler.
 //
+// When both peers agree to it, large messages may instead be sent with
+// their payload compressed using LZ4. The high bit of the length in the
+// header marks a compressed payload, which starts with the size of the
+// uncompressed payload as a 4 byte big-endian integer.
+//
 
 class Message : public std::enable_shared_from_this <Message>
 {
@@ -54,8 +60,19 @@ public:
     */
     static size_t const kHeaderBytes = 6;
 
+    /** Number of bytes before the compressed data in a compressed payload.
+    */
+    static size_t const kCompressedHeaderBytes = 4;
+
+    /** Payloads smaller than this are never compressed.
+    */
+    static size_t const kCompressionThreshold = 1024;
+
     Message (::google::protobuf::Message const& message, int type);
 
+    Message (Message const&) = delete;
+    Message& operator= (Message const&) = delete;
+
     /** Retrieve the packed message data. */
     std::vector <uint8_t> const&
     getBuffer () const
@@ -63,6 +80,17 @@ public:
         return mBuffer;
     }
 
+    /** Retrieve the packed message data to send to a peer.
+
+        If `compressed` is true and the payload is large enough, the
+        compressed form is returned. The payload is compressed at most
+        once no matter how many peers the message is sent to, and the
+        uncompressed form is returned if compressing does not make the
+        message smaller.
+    */
+    std::vector <uint8_t> const&
+    getBuffer (bool compressed) const;
+
     /** Get the traffic category */
     int
     getCategory () const
@@ -87,7 +115,7 @@ public:
                 Message::kHeaderBytes)
             return 0;
         std::size_t n;
-        n  = std::size_t{*first++} << 24;
+        n  = std::size_t{*first++ & 0x7Fu} << 24;
         n += std::size_t{*first++} << 16;
         n += std::size_t{*first++} <<  8;
         n += std::size_t{*first};
@@ -104,6 +132,30 @@ public:
     }
     /** @} */
 
+    /** Determine if the payload of a packed message is compressed. */
+    /** @{ */
+    template <class FwdIter>
+    static
+    std::enable_if_t<std::is_same<typename
+        FwdIter::value_type, std::uint8_t>::value, bool>
+    compressed (FwdIter first, FwdIter last)
+    {
+        if (std::distance(first, last) <
+                Message::kHeaderBytes)
+            return false;
+        return (*first & 0x80) != 0;
+    }
+
+    template <class BufferSequence>
+    static
+    bool
+    compressed (BufferSequence const& buffers)
+    {
+        return compressed(buffers_begin(buffers),
+            buffers_end(buffers));
+    }
+    /** @} */
+
     /** Determine the type of a packed message. */
     /** @{ */
     static int getType (std::vector <uint8_t> const& buf);
@@ -150,12 +202,19 @@ private:
             BufferSequence, Value>::end (buffers);
     }
 
-        // Encodes the size and type into a header at the beginning of buf
+    // Encodes the size and type into a header at the beginning of buf
     //
-    void encodeHeader (unsigned size, int type);
+    static void encodeHeader (std::vector <uint8_t>& buf,
+        unsigned size, int type);
+
+    void compress () const;
 
     std::vector <uint8_t> mBuffer;
 
+    // Filled in the first time the compressed form is requested
+    std::vector <uint8_t> mutable mBufferCompressed;
+    std::once_flag mutable mCompressOnce;
+
     int mCategory;
 };
 
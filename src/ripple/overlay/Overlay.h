@@ -68,6 +68,8 @@ public:
         bool expire = false;
         beast::IP::Address public_ip;
         int ipLimit = 0;
+        bool compression = false;
+        bool squelch = false;
     };
 
     using PeerSequence = std::vector <std::shared_ptr<Peer>>;
@@ -149,17 +151,23 @@ public:
     void
     send (protocol::TMValidation& m) = 0;
 
-    /** Relay a proposal. */
+    /** Relay a proposal.
+
+        Peers that squelched the validator are skipped.
+    */
     virtual
     void
     relay (protocol::TMProposeSet& m,
-        uint256 const& uid) = 0;
+        uint256 const& uid, PublicKey const& validator) = 0;
 
-    /** Relay a validation. */
+    /** Relay a validation.
+
+        Peers that squelched the validator are skipped.
+    */
     virtual
     void
     relay (protocol::TMValidation& m,
-        uint256 const& uid) = 0;
+        uint256 const& uid, PublicKey const& validator) = 0;
 
     /** Visit every active peer and return a value
         The functor must:
@@ -214,7 +214,7 @@ ConnectAttempt::onHandshake (error_code ec)
         return close(); // makeSharedValue logs
 
     req_ = makeRequest(! overlay_.peerFinder().config().peerPrivate,
-        remote_endpoint_.address());
+        overlay_.setup().compression, remote_endpoint_.address());
     auto const hello = buildHello (
         *sharedValue,
         overlay_.setup().public_ip,
@@ -284,7 +284,7 @@ ConnectAttempt::onShutdown (error_code ec)
 //--------------------------------------------------------------------------
 
 auto
-ConnectAttempt::makeRequest (bool crawl,
+ConnectAttempt::makeRequest (bool crawl, bool compression,
     boost::asio::ip::address const& remote_address) ->
         request_type
 {
@@ -298,6 +298,8 @@ ConnectAttempt::makeRequest (bool crawl,
     m.insert ("Connection", "Upgrade");
     m.insert ("Connect-As", "Peer");
     m.insert ("Crawl", crawl ? "public" : "private");
+    if (compression)
+        appendCompression (m);
     return m;
 }
 
@@ -107,7 +107,7 @@ private:
 
     static
     request_type
-    makeRequest (bool crawl,
+    makeRequest (bool crawl, bool compression,
         boost::asio::ip::address const& remote_address);
 
     void processResponse();
@@ -20,6 +20,7 @@
 #include <BeastConfig.h>
 #include <ripple/overlay/Message.h>
 #include <ripple/overlay/impl/TrafficCount.h>
+#include <lz4/lib/lz4.h>
 #include <cstdint>
 
 namespace ripple {
@@ -32,7 +33,7 @@ Message::Message (::google::protobuf::Message const& message, int type)
 
     mBuffer.resize (kHeaderBytes + messageBytes);
 
-    encodeHeader (messageBytes, type);
+    encodeHeader (mBuffer, messageBytes, type);
 
     if (messageBytes != 0)
     {
@@ -43,6 +44,53 @@ Message::Message (::google::protobuf::Message const& message, int type)
         (message, type, false));
 }
 
+std::vector <uint8_t> const&
+Message::getBuffer (bool compressed) const
+{
+    if (! compressed ||
+            mBuffer.size () < kHeaderBytes + kCompressionThreshold)
+        return mBuffer;
+
+    std::call_once (mCompressOnce, [this]{ compress (); });
+
+    if (mBufferCompressed.empty ())
+        return mBuffer;
+
+    return mBufferCompressed;
+}
+
+void Message::compress () const
+{
+    auto const messageBytes = mBuffer.size () - kHeaderBytes;
+    auto const bound = LZ4_compressBound (static_cast<int> (messageBytes));
+
+    std::vector <uint8_t> buf (
+        kHeaderBytes + kCompressedHeaderBytes + bound);
+
+    auto const compressedBytes = LZ4_compress_default (
+        reinterpret_cast<char const*> (&mBuffer [kHeaderBytes]),
+        reinterpret_cast<char*> (
+            &buf [kHeaderBytes + kCompressedHeaderBytes]),
+        static_cast<int> (messageBytes), bound);
+
+    // Leave mBufferCompressed empty unless it saves something
+    if (compressedBytes <= 0 ||
+            kCompressedHeaderBytes + compressedBytes >= messageBytes)
+        return;
+
+    auto const payloadBytes = static_cast<unsigned> (
+        kCompressedHeaderBytes + compressedBytes);
+    buf.resize (kHeaderBytes + payloadBytes);
+
+    encodeHeader (buf, payloadBytes | 0x80000000u, getType (mBuffer));
+    buf[kHeaderBytes + 0] = static_cast<std::uint8_t> ((messageBytes >> 24) & 0xFF);
+    buf[kHeaderBytes + 1] = static_cast<std::uint8_t> ((messageBytes >> 16) & 0xFF);
+    buf[kHeaderBytes + 2] = static_cast<std::uint8_t> ((messageBytes >> 8) & 0xFF);
+    buf[kHeaderBytes + 3] = static_cast<std::uint8_t> (messageBytes & 0xFF);
+
+    mBufferCompressed = std::move (buf);
+}
+
 bool Message::operator== (Message const& other) const
 {
     return mBuffer == other.mBuffer;
@@ -54,7 +102,7 @@ unsigned Message::getLength (std::vector <uint8_t> const& buf)
 
     if (buf.size () >= Message::kHeaderBytes)
     {
-        result = buf [0];
+        result = buf [0] & 0x7F;
         result <<= 8;
         result |= buf [1];
         result <<= 8;
@@ -81,15 +129,16 @@ int Message::getType (std::vector<uint8_t> const& buf)
     return ret;
 }
 
-void Message::encodeHeader (unsigned size, int type)
+void Message::encodeHeader (std::vector <uint8_t>& buf,
+    unsigned size, int type)
 {
-    assert (mBuffer.size () >= Message::kHeaderBytes);
-    mBuffer[0] = static_cast<std::uint8_t> ((size >> 24) & 0xFF);
-    mBuffer[1] = static_cast<std::uint8_t> ((size >> 16) & 0xFF);
-    mBuffer[2] = static_cast<std::uint8_t> ((size >> 8) & 0xFF);
-    mBuffer[3] = static_cast<std::uint8_t> (size & 0xFF);
-    mBuffer[4] = static_cast<std::uint8_t> ((type >> 8) & 0xFF);
-    mBuffer[5] = static_cast<std::uint8_t> (type & 0xFF);
+    assert (buf.size () >= Message::kHeaderBytes);
+    buf[0] = static_cast<std::uint8_t> ((size >> 24) & 0xFF);
+    buf[1] = static_cast<std::uint8_t> ((size >> 16) & 0xFF);
+    buf[2] = static_cast<std::uint8_t> ((size >> 8) & 0xFF);
+    buf[3] = static_cast<std::uint8_t> (size & 0xFF);
+    buf[4] = static_cast<std::uint8_t> ((type >> 8) & 0xFF);
+    buf[5] = static_cast<std::uint8_t> (type & 0xFF);
 }
 
 }
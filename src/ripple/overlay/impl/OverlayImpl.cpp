@@ -120,6 +120,7 @@ OverlayImpl::Timer::on_timer (error_code ec)
     overlay_.m_peerFinder->once_per_second();
     overlay_.sendEndpoints();
     overlay_.autoConnect();
+    overlay_.squelch_.onTimer();
 
     if ((++overlay_.timer_count_ % Tuning::checkSeconds) == 0)
         overlay_.check();
@@ -155,6 +156,17 @@ OverlayImpl::OverlayImpl (
     , m_resolver (resolver)
     , next_id_(1)
     , timer_count_(0)
+    , txVerifier_ (app_.getJobQueue (), jtTRANSACTION,
+        "recvTransaction->verify")
+    , trustedProposalVerifier_ (app_.getJobQueue (), jtPROPOSAL_t,
+        "recvPropose->verify")
+    , untrustedProposalVerifier_ (app_.getJobQueue (), jtPROPOSAL_ut,
+        "recvPropose->verify")
+    , trustedValidationVerifier_ (app_.getJobQueue (), jtVALIDATION_t,
+        "recvValidation->verify")
+    , untrustedValidationVerifier_ (app_.getJobQueue (), jtVALIDATION_ut,
+        "recvValidation->verify")
+    , squelch_ (*this, stopwatch ())
 {
     beast::PropertyStream::Source::add (m_peerFinder.get());
 }
@@ -592,7 +604,25 @@ OverlayImpl::onWrite (beast::PropertyStream::Map& stream)
         item["messages_out"] =
             beast::lexicalCast<std::string>
                 (i.second.messagesOut.load());
+        item["bytes_in_uncompressed"] =
+            beast::lexicalCast<std::string>
+                (i.second.bytesInUncompressed.load());
+        item["bytes_out_uncompressed"] =
+            beast::lexicalCast<std::string>
+                (i.second.bytesOutUncompressed.load());
     }
+
+    auto const& writes = m_traffic.getWriteStats();
+    beast::PropertyStream::Map item ("writes", stream);
+    item["writes"] =
+        beast::lexicalCast<std::string>
+            (writes.writes.load());
+    item["messages"] =
+        beast::lexicalCast<std::string>
+            (writes.messages.load());
+    item["microseconds"] =
+        beast::lexicalCast<std::string>
+            (writes.microseconds.load());
 }
 
 //------------------------------------------------------------------------------
@@ -629,8 +659,13 @@ OverlayImpl::activate (std::shared_ptr<PeerImp> const& peer)
 void
 OverlayImpl::onPeerDeactivate (Peer::id_t id)
 {
-    std::lock_guard <decltype(mutex_)> lock (mutex_);
-    ids_.erase(id);
+    {
+        std::lock_guard <decltype(mutex_)> lock (mutex_);
+        ids_.erase(id);
+    }
+
+    // Squelching may message other peers, which takes the lock
+    squelch_.onPeerDeactivate (id);
 }
 
 void
@@ -710,9 +745,38 @@ void
 OverlayImpl::reportTraffic (
     TrafficCount::category cat,
     bool isInbound,
-    int number)
+    int number,
+    int uncompressed)
+{
+    m_traffic.addCount (cat, isInbound, number, uncompressed);
+}
+
+void
+OverlayImpl::reportWrite (std::size_t messages,
+    std::chrono::microseconds elapsed)
 {
-    m_traffic.addCount (cat, isInbound, number);
+    m_traffic.addWrite (messages, elapsed);
+}
+
+SignatureVerifier&
+OverlayImpl::verifier (JobType type)
+{
+    switch (type)
+    {
+    case jtTRANSACTION:
+        return txVerifier_;
+    case jtPROPOSAL_t:
+        return trustedProposalVerifier_;
+    case jtPROPOSAL_ut:
+        return untrustedProposalVerifier_;
+    case jtVALIDATION_t:
+        return trustedValidationVerifier_;
+    case jtVALIDATION_ut:
+        return untrustedValidationVerifier_;
+    default:
+        break;
+    }
+    LogicError ("OverlayImpl::verifier: unexpected job type");
 }
 
 std::size_t
@@ -904,7 +968,7 @@ OverlayImpl::send (protocol::TMValidation& m)
 
 void
 OverlayImpl::relay (protocol::TMProposeSet& m,
-    uint256 const& uid)
+    uint256 const& uid, PublicKey const& validator)
 {
     if (m.has_hops() && m.hops() >= maxTTL)
         return;
@@ -917,14 +981,22 @@ OverlayImpl::relay (protocol::TMProposeSet& m,
     {
         if (toSkip->find(p->id()) != toSkip->end())
             return;
-        if (! m.has_hops() || p->hopsAware())
-            p->send(sm);
+        if (m.has_hops() && ! p->hopsAware())
+            return;
+        if (p->squelched(validator))
+        {
+            auto const size = static_cast<int>(sm->getBuffer().size());
+            reportTraffic (TrafficCount::category::CT_squelch_suppressed,
+                false, size, size);
+            return;
+        }
+        p->send(sm);
     });
 }
 
 void
 OverlayImpl::relay (protocol::TMValidation& m,
-    uint256 const& uid)
+    uint256 const& uid, PublicKey const& validator)
 {
     if (m.has_hops() && m.hops() >= maxTTL)
         return;
@@ -937,11 +1009,54 @@ OverlayImpl::relay (protocol::TMValidation& m,
     {
         if (toSkip->find(p->id()) != toSkip->end())
             return;
-        if (! m.has_hops() || p->hopsAware())
-            p->send(sm);
+        if (m.has_hops() && ! p->hopsAware())
+            return;
+        if (p->squelched(validator))
+        {
+            auto const size = static_cast<int>(sm->getBuffer().size());
+            reportTraffic (TrafficCount::category::CT_squelch_suppressed,
+                false, size, size);
+            return;
+        }
+        p->send(sm);
     });
 }
 
+void
+OverlayImpl::onValidatorMessage (
+    PublicKey const& validator, Peer::id_t peer)
+{
+    if (setup_.squelch)
+        squelch_.onMessage (validator, peer);
+}
+
+void
+OverlayImpl::squelch (PublicKey const& validator, Peer::id_t peer,
+    std::chrono::seconds duration)
+{
+    if (auto p = findPeerByShortID (peer))
+    {
+        protocol::TMSquelch m;
+        m.set_squelch (true);
+        m.set_validatorpubkey (validator.data (), validator.size ());
+        m.set_squelchduration (static_cast<std::uint32_t> (
+            duration.count ()));
+        p->send (std::make_shared<Message> (m, protocol::mtSQUELCH));
+    }
+}
+
+void
+OverlayImpl::unsquelch (PublicKey const& validator, Peer::id_t peer)
+{
+    if (auto p = findPeerByShortID (peer))
+    {
+        protocol::TMSquelch m;
+        m.set_squelch (false);
+        m.set_validatorpubkey (validator.data (), validator.size ());
+        p->send (std::make_shared<Message> (m, protocol::mtSQUELCH));
+    }
+}
+
 //------------------------------------------------------------------------------
 
 void
@@ -1034,6 +1149,8 @@ setup_Overlay (BasicConfig const& config)
     auto const& section = config.section("overlay");
     setup.context = make_SSLContext("");
     setup.expire = get<bool>(section, "expire", false);
+    setup.compression = get<bool>(section, "compression", false);
+    setup.squelch = get<bool>(section, "squelch", false);
 
     set (setup.ipLimit, "ip_limit", section);
     if (setup.ipLimit < 0)
@@ -21,8 +21,10 @@
 #define RIPPLE_OVERLAY_OVERLAYIMPL_H_INCLUDED
 
 #include <ripple/app/main/Application.h>
+#include <ripple/app/misc/SignatureVerifier.h>
 #include <ripple/core/Job.h>
 #include <ripple/overlay/Overlay.h>
+#include <ripple/overlay/impl/Squelch.h>
 #include <ripple/overlay/impl/TrafficCount.h>
 #include <ripple/server/Handoff.h>
 #include <ripple/rpc/ServerHandler.h>
@@ -54,7 +56,9 @@ enum
     maxTTL = 2
 };
 
-class OverlayImpl : public Overlay
+class OverlayImpl
+    : public Overlay
+    , private Squelch::Handler
 {
 public:
     class Child
@@ -119,6 +123,16 @@ private:
     std::atomic <Peer::id_t> next_id_;
     int timer_count_;
 
+    // Signatures from peers, by the type of job that checks them
+    SignatureVerifier txVerifier_;
+    SignatureVerifier trustedProposalVerifier_;
+    SignatureVerifier untrustedProposalVerifier_;
+    SignatureVerifier trustedValidationVerifier_;
+    SignatureVerifier untrustedValidationVerifier_;
+
+    // Chooses the peers relaying each validator's messages to us
+    Squelch squelch_;
+
     //--------------------------------------------------------------------------
 
 public:
@@ -181,11 +195,11 @@ public:
 
     void
     relay (protocol::TMProposeSet& m,
-        uint256 const& uid) override;
+        uint256 const& uid, PublicKey const& validator) override;
 
     void
     relay (protocol::TMValidation& m,
-        uint256 const& uid) override;
+        uint256 const& uid, PublicKey const& validator) override;
 
     //--------------------------------------------------------------------------
     //
@@ -298,7 +312,25 @@ public:
     reportTraffic (
         TrafficCount::category cat,
         bool isInbound,
-        int bytes);
+        int bytes,
+        int uncompressedBytes);
+
+    void
+    reportWrite (std::size_t messages, std::chrono::microseconds elapsed);
+
+    /** Returns the verifier for signatures checked by a type of job.
+
+        @param type jtTRANSACTION, or a proposal or validation job type.
+    */
+    SignatureVerifier&
+    verifier (JobType type);
+
+    /** Record that a peer delivered a trusted validator's message.
+
+        Does nothing unless squelching is enabled.
+    */
+    void
+    onValidatorMessage (PublicKey const& validator, Peer::id_t peer);
 
 private:
     std::shared_ptr<Writer>
@@ -374,6 +406,13 @@ private:
 
     void
     sendEndpoints();
+
+    void
+    squelch (PublicKey const& validator, Peer::id_t peer,
+        std::chrono::seconds duration) override;
+
+    void
+    unsquelch (PublicKey const& validator, Peer::id_t peer) override;
 };
 
 } // ripple
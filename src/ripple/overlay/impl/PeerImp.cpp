@@ -39,12 +39,14 @@
 #include <ripple/core/JobQueue.h>
 #include <ripple/core/TimeKeeper.h>
 #include <ripple/json/json_reader.h>
+#include <ripple/nodestore/DatabaseShard.h>
 #include <ripple/resource/Fees.h>
 #include <ripple/rpc/ServerHandler.h>
 #include <ripple/overlay/Cluster.h>
 #include <ripple/overlay/ClusterNode.h>
 #include <ripple/protocol/BuildInfo.h>
 #include <ripple/protocol/JsonFields.h>
+#include <ripple/protocol/TxFlags.h>
 #include <ripple/beast/core/SemanticVersion.h>
 #include <ripple/beast/utility/weak_fn.h>
 #include <beast/core/ostream.hpp>
@@ -55,6 +57,7 @@
 #include <functional>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -128,6 +131,10 @@ PeerImp::run()
             }
         }
     }
+    // An inbound peer offers compression in its request and we accept
+    // it in our response, an outbound peer's response accepts our offer.
+    compressionEnabled_ = overlay_.setup().compression &&
+        peerSupportsCompression(headers_);
     if (m_inbound)
     {
         doAccept();
@@ -200,7 +207,8 @@ PeerImp::send (Message::pointer const& m)
 
     overlay_.reportTraffic (
         static_cast<TrafficCount::category>(m->getCategory()),
-        false, static_cast<int>(m->getBuffer().size()));
+        false, static_cast<int>(m->getBuffer(compressionEnabled_).size()),
+            static_cast<int>(m->getBuffer().size()));
 
     auto sendq_size = send_queue_.size();
 
@@ -218,16 +226,12 @@ PeerImp::send (Message::pointer const& m)
                 " sendq: " << sendq_size;
     }
 
-    send_queue_.push(m);
+    send_queue_.push_back(m);
 
     if(sendq_size != 0)
         return;
 
-    boost::asio::async_write (stream_, boost::asio::buffer(
-        send_queue_.front()->getBuffer()), strand_.wrap(std::bind(
-            &PeerImp::onWriteMessage, shared_from_this(),
-                std::placeholders::_1,
-                    std::placeholders::_2)));
+    doWrite();
 }
 
 void
@@ -252,6 +256,19 @@ PeerImp::crawl() const
     return beast::detail::ci_equal(iter->value(), "public");
 }
 
+bool
+PeerImp::squelched (PublicKey const& validator)
+{
+    std::lock_guard<std::mutex> sl(squelchLock_);
+    auto const iter = squelches_.find (validator);
+    if (iter == squelches_.end ())
+        return false;
+    if (iter->second > clock_type::now ())
+        return true;
+    squelches_.erase (iter);
+    return false;
+}
+
 std::string
 PeerImp::getVersion() const
 {
@@ -308,6 +325,16 @@ PeerImp::json()
     ret[jss::uptime] = static_cast<Json::UInt>(
         std::chrono::duration_cast<std::chrono::seconds>(uptime()).count());
 
+    if (auto const writes = writes_.load())
+    {
+        // Averages over every write to this peer, latency in microseconds
+        ret[jss::writes] = static_cast<Json::UInt> (writes);
+        ret[jss::messages_per_write] =
+            static_cast<double> (messagesWritten_.load()) / writes;
+        ret[jss::write_latency] =
+            static_cast<Json::UInt> (writeMicroseconds_.load() / writes);
+    }
+
     std::uint32_t minSeq, maxSeq;
     ledgerRange(minSeq, maxSeq);
 
@@ -665,6 +692,8 @@ PeerImp::makeResponse (bool crawl,
     resp.insert("Connect-As", "Peer");
     resp.insert("Server", BuildInfo::getFullVersionString());
     resp.insert("Crawl", crawl ? "public" : "private");
+    if (compressionEnabled_)
+        appendCompression(resp);
     protocol::TMHello hello = buildHello(sharedValue,
         overlay_.setup().public_ip, remote, app_);
     appendHello(resp, hello);
@@ -757,7 +786,7 @@ PeerImp::onReadMessage (error_code ec, std::size_t bytes_transferred)
     {
         std::size_t bytes_consumed;
         std::tie(bytes_consumed, ec) = invokeProtocolMessage(
-            read_buffer_.data(), *this);
+            read_buffer_.data(), compressionEnabled_, *this);
         if (ec)
             return fail("onReadMessage", ec);
         if (! stream_.next_layer().is_open())
@@ -793,17 +822,19 @@ PeerImp::onWriteMessage (error_code ec, std::size_t bytes_transferred)
             stream << "onWriteMessage";
     }
 
-    assert(! send_queue_.empty());
-    send_queue_.pop();
+    auto const elapsed = std::chrono::duration_cast<
+        std::chrono::microseconds>(clock_type::now() - writeStart_);
+    ++writes_;
+    messagesWritten_ += writeCount_;
+    writeMicroseconds_ += elapsed.count();
+    overlay_.reportWrite (writeCount_, elapsed);
+
+    assert(send_queue_.size() >= writeCount_);
+    send_queue_.erase (send_queue_.begin(),
+        send_queue_.begin() + writeCount_);
+    writeCount_ = 0;
     if (! send_queue_.empty())
-    {
-        // Timeout on writes only
-        return boost::asio::async_write (stream_, boost::asio::buffer(
-            send_queue_.front()->getBuffer()), strand_.wrap(std::bind(
-                &PeerImp::onWriteMessage, shared_from_this(),
-                    std::placeholders::_1,
-                        std::placeholders::_2)));
-    }
+        return doWrite();
 
     if (gracefulClose_)
     {
@@ -813,6 +844,26 @@ PeerImp::onWriteMessage (error_code ec, std::size_t bytes_transferred)
     }
 }
 
+void
+PeerImp::doWrite ()
+{
+    assert(writeCount_ == 0);
+    assert(! send_queue_.empty());
+
+    // Everything queued since the last write goes out together, so a
+    // burst of small messages costs one system call instead of many.
+    std::vector<boost::asio::const_buffer> buffers;
+    writeCount_ = gatherMessages (send_queue_, compressionEnabled_, buffers);
+    writeStart_ = clock_type::now();
+
+    // Timeout on writes only
+    boost::asio::async_write (stream_, buffers,
+        strand_.wrap(std::bind(
+            &PeerImp::onWriteMessage, shared_from_this(),
+                std::placeholders::_1,
+                    std::placeholders::_2)));
+}
+
 //------------------------------------------------------------------------------
 //
 // ProtocolHandler
@@ -830,13 +881,13 @@ PeerImp::onMessageUnknown (std::uint16_t type)
 PeerImp::error_code
 PeerImp::onMessageBegin (std::uint16_t type,
     std::shared_ptr <::google::protobuf::Message> const& m,
-    std::size_t size)
+    std::size_t size, std::size_t uncompressedSize)
 {
     load_event_ = app_.getJobQueue ().makeLoadEvent (
         jtPEER, protocolMessageName(type));
     fee_ = Resource::feeLightPeer;
     overlay_.reportTraffic (TrafficCount::categorize (*m, type, true),
-        true, static_cast<int>(size));
+        true, static_cast<int>(size), static_cast<int>(uncompressedSize));
     return error_code{};
 }
 
@@ -1102,7 +1153,10 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMTransaction> const& m)
             }
         }
 
-        if (app_.getJobQueue().getJobCount(jtTRANSACTION) > 100)
+        auto& verifier = overlay_.verifier (jtTRANSACTION);
+
+        if (app_.getJobQueue().getJobCount(jtTRANSACTION) +
+            verifier.size() > 100)
         {
             JLOG(p_journal_.info()) << "Transaction queue is full";
         }
@@ -1110,6 +1164,37 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMTransaction> const& m)
         {
             JLOG(p_journal_.trace()) << "No new transactions until synchronized";
         }
+        else if (checkSignature && ! stx->isFieldPresent (sfSigners) &&
+            publicKeyType (makeSlice (stx->getSigningPubKey ())))
+        {
+            // Single signed: verify it along with others, then
+            // record the result before deciding whether to relay
+            verifier.verify (PublicKey (makeSlice (stx->getSigningPubKey ())),
+                stx->getSigningData (), stx->getFieldVL (sfTxnSignature),
+                stx->getFlags () & tfFullyCanonicalSig,
+                [weak = std::weak_ptr<PeerImp>(shared_from_this()),
+                &router = app_.getHashRouter (), flags, stx] (bool valid) {
+                    auto const txID = stx->getTransactionID ();
+                    forceValidity (router, txID,
+                        valid ? Validity::SigGoodOnly : Validity::SigBad);
+                    if (! valid)
+                        router.setFlags (txID, SF_BAD);
+
+                    if (auto peer = weak.lock())
+                    {
+                        if (valid)
+                        {
+                            peer->checkTransaction (flags, true, stx);
+                        }
+                        else
+                        {
+                            JLOG(peer->p_journal_.trace()) <<
+                                "Transaction has bad signature: " << txID;
+                            peer->charge (Resource::feeInvalidSignature);
+                        }
+                    }
+                });
+        }
         else
         {
             app_.getJobQueue ().addJob (
@@ -1250,9 +1335,14 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMProposeSet> const& m)
         proposeHash, prevLedger, set.proposeseq(),
         closeTime, publicKey.slice(), signature);
 
-    if (! app_.getHashRouter ().addSuppressionPeer (suppression, id_))
+    int flags;
+    if (! app_.getHashRouter ().addSuppressionPeer (suppression, id_, flags))
     {
         JLOG(p_journal_.trace()) << "Proposal: duplicate";
+        if (flags & SF_BAD)
+            fee_ = Resource::feeInvalidSignature;
+        else
+            onDuplicate (publicKey, set);
         return;
     }
 
@@ -1289,11 +1379,40 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMProposeSet> const& m)
             app_.timeKeeper().closeTime(),calcNodeID(publicKey)});
 
     std::weak_ptr<PeerImp> weak = shared_from_this();
-    app_.getJobQueue ().addJob (
-        isTrusted ? jtPROPOSAL_t : jtPROPOSAL_ut, "recvPropose->checkPropose",
-        [weak, m, proposal] (Job& job) {
+    auto const jobType = isTrusted ? jtPROPOSAL_t : jtPROPOSAL_ut;
+
+    if (cluster())
+    {
+        app_.getJobQueue ().addJob (
+            jobType, "recvPropose->checkPropose",
+            [weak, isTrusted, m, proposal] (Job&) {
+                if (auto peer = weak.lock())
+                    peer->checkPropose(isTrusted, m, proposal);
+            });
+        return;
+    }
+
+    overlay_.verifier (jobType).verifyDigest (publicKey,
+        proposal->getSigningHash (), Blob (signature.data (),
+            signature.data () + signature.size ()), false,
+        [weak, &router = app_.getHashRouter (), isTrusted, m, proposal]
+        (bool valid) {
+            if (! valid)
+                router.setFlags (proposal->getSuppressionID (), SF_BAD);
+
             if (auto peer = weak.lock())
-                peer->checkPropose(job, m, proposal);
+            {
+                if (valid)
+                {
+                    peer->checkPropose(isTrusted, m, proposal);
+                }
+                else
+                {
+                    JLOG(peer->p_journal_.warn()) <<
+                        "Proposal fails sig check";
+                    peer->charge (Resource::feeInvalidSignature);
+                }
+            }
         });
 }
 
@@ -1583,10 +1702,16 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMValidation> const& m)
             return;
         }
 
+        auto const suppression = sha512Half(makeSlice(m->validation()));
+        int flags;
         if (! app_.getHashRouter ().addSuppressionPeer(
-            sha512Half(makeSlice(m->validation())), id_))
+            suppression, id_, flags))
         {
             JLOG(p_journal_.trace()) << "Validation: duplicate";
+            if (flags & SF_BAD)
+                fee_ = Resource::feeInvalidRequest;
+            else
+                onDuplicate (val->getSignerPublic (), *m);
             return;
         }
 
@@ -1601,17 +1726,47 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMValidation> const& m)
         if (isTrusted || !app_.getFeeTrack ().isLoadedLocal ())
         {
             std::weak_ptr<PeerImp> weak = shared_from_this();
-            app_.getJobQueue ().addJob (
-                isTrusted ? jtVALIDATION_t : jtVALIDATION_ut,
-                "recvValidation->checkValidation",
-                [weak, val, isTrusted, m] (Job&)
-                {
-                    if (auto peer = weak.lock())
-                        peer->checkValidation(
-                            val,
-                            isTrusted,
-                            m);
-                });
+            auto const type = isTrusted ? jtVALIDATION_t : jtVALIDATION_ut;
+            if (cluster())
+            {
+                app_.getJobQueue ().addJob (
+                    type, "recvValidation->checkValidation",
+                    [weak, val, isTrusted, m] (Job&)
+                    {
+                        if (auto peer = weak.lock())
+                            peer->checkValidation(
+                                val,
+                                isTrusted,
+                                m);
+                    });
+            }
+            else
+            {
+                overlay_.verifier (type).verifyDigest (
+                    val->getSignerPublic (), val->getSigningHash (),
+                    val->getSignature (),
+                    val->getFlags () & vfFullyCanonicalSig,
+                    [weak, &router = app_.getHashRouter (),
+                    suppression, val, isTrusted, m] (bool valid)
+                    {
+                        if (! valid)
+                            router.setFlags (suppression, SF_BAD);
+
+                        if (auto peer = weak.lock())
+                        {
+                            if (valid)
+                            {
+                                peer->checkValidation(val, isTrusted, m);
+                            }
+                            else
+                            {
+                                JLOG(peer->p_journal_.warn()) <<
+                                    "Validation is invalid";
+                                peer->charge (Resource::feeInvalidRequest);
+                            }
+                        }
+                    });
+            }
         }
         else
         {
@@ -1676,6 +1831,13 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMGetObjectByHash> const& m)
                 std::shared_ptr<NodeObject> hObj =
                     app_.getNodeStore ().fetch (hash);
 
+                // Historical ledgers may only be held in a shard
+                if (! hObj && obj.has_ledgerseq ())
+                {
+                    if (auto shardStore = app_.getShardStore ())
+                        hObj = shardStore->fetch (hash, obj.ledgerseq ());
+                }
+
                 if (hObj)
                 {
                     protocol::TMIndexedObject& newObj = *reply.add_objects ();
@@ -1755,6 +1917,51 @@ PeerImp::onMessage (std::shared_ptr <protocol::TMGetObjectByHash> const& m)
     }
 }
 
+void
+PeerImp::onMessage (std::shared_ptr <protocol::TMSquelch> const& m)
+{
+    auto const slice = makeSlice (m->validatorpubkey ());
+    if (! publicKeyType (slice))
+    {
+        JLOG(p_journal_.debug()) << "Squelch: Invalid validator key";
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+
+    PublicKey const validator (slice);
+
+    // Only validators we know of are relayed selectively. Keeping
+    // squelches for other keys would let a peer grow the map at will.
+    if (! app_.validators().listed (validator) &&
+        ! app_.validators().trusted (validator))
+    {
+        JLOG(p_journal_.debug()) << "Squelch: Unknown validator";
+        fee_ = Resource::feeUnwantedData;
+        return;
+    }
+
+    std::lock_guard<std::mutex> sl(squelchLock_);
+
+    if (! m->squelch ())
+    {
+        squelches_.erase (validator);
+        return;
+    }
+
+    auto const duration = m->has_squelchduration () ?
+        m->squelchduration () : 0;
+    if (duration == 0 || duration > Tuning::squelchMaxSeconds)
+    {
+        JLOG(p_journal_.debug()) <<
+            "Squelch: Invalid duration " << duration;
+        fee_ = Resource::feeInvalidRequest;
+        return;
+    }
+
+    squelches_[validator] =
+        clock_type::now () + std::chrono::seconds (duration);
+}
+
 //--------------------------------------------------------------------------
 
 void
@@ -1884,28 +2091,19 @@ PeerImp::checkTransaction (int flags,
 
 // Called from our JobQueue
 void
-PeerImp::checkPropose (Job& job,
+PeerImp::checkPropose (bool isTrusted,
     std::shared_ptr <protocol::TMProposeSet> const& packet,
         RCLCxPeerPos::pointer peerPos)
 {
-    bool isTrusted = (job.getType () == jtPROPOSAL_t);
-
     JLOG(p_journal_.trace()) <<
         "Checking " << (isTrusted ? "trusted" : "UNTRUSTED") << " proposal";
 
     assert (packet);
     protocol::TMProposeSet& set = *packet;
 
-    if (! cluster() && !peerPos->checkSign ())
-    {
-        JLOG(p_journal_.warn()) <<
-            "Proposal fails sig check";
-        charge (Resource::feeInvalidSignature);
-        return;
-    }
-
     if (isTrusted)
     {
+        overlay_.onValidatorMessage (peerPos->getPublicKey (), id_);
         app_.getOPs ().processTrustedProposal (
             peerPos, packet, calcNodeID (publicKey_));
     }
@@ -1916,7 +2114,8 @@ PeerImp::checkPropose (Job& job,
             // relay untrusted proposal
             JLOG(p_journal_.trace()) <<
                 "relaying UNTRUSTED proposal";
-            overlay_.relay(set, peerPos->getSuppressionID());
+            overlay_.relay(set, peerPos->getSuppressionID(),
+                peerPos->getPublicKey());
         }
         else
         {
@@ -1934,17 +2133,13 @@ PeerImp::checkValidation (STValidation::pointer val,
     {
         // VFALCO Which functions throw?
         uint256 signingHash = val->getSigningHash();
-        if (! cluster() && !val->isValid (signingHash))
-        {
-            JLOG(p_journal_.warn()) <<
-                "Validation is invalid";
-            charge (Resource::feeInvalidRequest);
-            return;
-        }
 
         if (app_.getOPs ().recvValidation(
                 val, std::to_string(id())))
-            overlay_.relay(*packet, signingHash);
+            overlay_.relay(*packet, signingHash, val->getSignerPublic());
+
+        if (isTrusted)
+            overlay_.onValidatorMessage (val->getSignerPublic(), id_);
     }
     catch (std::exception const&)
     {
@@ -1954,6 +2149,19 @@ PeerImp::checkValidation (STValidation::pointer val,
     }
 }
 
+void
+PeerImp::onDuplicate (PublicKey const& validator,
+    ::google::protobuf::Message const& m)
+{
+    auto const size = static_cast<int> (
+        Message::kHeaderBytes + m.ByteSize ());
+    overlay_.reportTraffic (TrafficCount::category::CT_duplicate,
+        true, size, size);
+
+    if (overlay_.setup ().squelch && app_.validators ().trusted (validator))
+        overlay_.onValidatorMessage (validator, id_);
+}
+
 // Returns the set of peers that can help us get
 // the TX tree with the specified root hash.
 //
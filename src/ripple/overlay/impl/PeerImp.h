@@ -40,6 +40,7 @@
 #include <beast/http/message.hpp>
 #include <beast/http/parser.hpp>
 #include <ripple/beast/utility/WrappedSink.h>
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <queue>
@@ -155,13 +156,30 @@ private:
     http_response_type response_;
     beast::http::fields const& headers_;
     beast::multi_buffer write_buffer_;
-    std::queue<Message::pointer> send_queue_;
+    std::deque<Message::pointer> send_queue_;
     bool gracefulClose_ = false;
     int large_sendq_ = 0;
     int no_ping_ = 0;
     std::unique_ptr <LoadEvent> load_event_;
     bool hopsAware_ = false;
 
+    // True if both sides agreed to compress large messages
+    bool compressionEnabled_ = false;
+
+    // The queued messages being written, and when the write started
+    std::size_t writeCount_ = 0;
+    clock_type::time_point writeStart_;
+
+    // Totals over completed writes, reported by json()
+    std::atomic<std::uint64_t> writes_ {0};
+    std::atomic<std::uint64_t> messagesWritten_ {0};
+    std::atomic<std::uint64_t> writeMicroseconds_ {0};
+
+    // Validators whose messages this peer asked us not to relay,
+    // and until when
+    std::mutex mutable squelchLock_;
+    hash_map<PublicKey, clock_type::time_point> squelches_;
+
     friend class OverlayImpl;
 
 public:
@@ -257,6 +275,12 @@ public:
         return hopsAware_;
     }
 
+    /** Returns `true` if the peer asked us not to relay
+        this validator's messages.
+    */
+    bool
+    squelched (PublicKey const& validator);
+
     void
     check();
 
@@ -382,6 +406,10 @@ private:
     void
     onWriteMessage (error_code ec, std::size_t bytes_transferred);
 
+    // Gathers queued messages into a single write
+    void
+    doWrite ();
+
 public:
     //--------------------------------------------------------------------------
     //
@@ -403,7 +431,7 @@ public:
     error_code
     onMessageBegin (std::uint16_t type,
         std::shared_ptr <::google::protobuf::Message> const& m,
-        std::size_t size);
+        std::size_t size, std::size_t uncompressedSize);
 
     void
     onMessageEnd (std::uint16_t type,
@@ -424,6 +452,7 @@ public:
     void onMessage (std::shared_ptr <protocol::TMHaveTransactionSet> const& m);
     void onMessage (std::shared_ptr <protocol::TMValidation> const& m);
     void onMessage (std::shared_ptr <protocol::TMGetObjectByHash> const& m);
+    void onMessage (std::shared_ptr <protocol::TMSquelch> const& m);
 
 private:
     State state() const
@@ -448,15 +477,22 @@ private:
     checkTransaction (int flags, bool checkSignature,
         std::shared_ptr<STTx const> const& stx);
 
+    // The proposal's signature, if any, has been verified
     void
-    checkPropose (Job& job,
+    checkPropose (bool isTrusted,
         std::shared_ptr<protocol::TMProposeSet> const& packet,
             RCLCxPeerPos::pointer peerPos);
 
+    // The validation's signature, if any, has been verified
     void
     checkValidation (STValidation::pointer val,
         bool isTrusted, std::shared_ptr<protocol::TMValidation> const& packet);
 
+    // A proposal or validation we already had arrived again
+    void
+    onDuplicate (PublicKey const& validator,
+        ::google::protobuf::Message const& m);
+
     void
     getLedger (std::shared_ptr<protocol::TMGetLedger> const&packet);
 
@@ -22,12 +22,17 @@
 
 #include "ripple.pb.h"
 #include <ripple/overlay/Message.h>
+#include <ripple/overlay/impl/Tuning.h>
 #include <ripple/overlay/impl/ZeroCopyStream.h>
+#include <lz4/lib/lz4.h>
+#include <beast/core/buffer_prefix.hpp>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/buffers_iterator.hpp>
 #include <boost/system/error_code.hpp>
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <iterator>
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -57,6 +62,7 @@ protocolMessageName (int type)
     case protocol::mtHAVE_SET:          return "have_set";
     case protocol::mtVALIDATION:        return "validation";
     case protocol::mtGET_OBJECTS:       return "get_objects";
+    case protocol::mtSQUELCH:           return "squelch";
     default:
         break;
     };
@@ -65,21 +71,73 @@ protocolMessageName (int type)
 
 namespace detail {
 
+/** Decompress the payload of a compressed protocol message.
+
+    @return `false` if the payload is malformed or too large.
+*/
+template <class Buffers>
+bool
+decompress (Buffers const& buffers, std::vector<std::uint8_t>& out)
+{
+    auto const size = Message::size (buffers);
+    if (size <= Message::kCompressedHeaderBytes)
+        return false;
+
+    std::vector<std::uint8_t> in (size);
+    auto first = boost::asio::buffers_iterator<
+        Buffers, std::uint8_t>::begin (buffers);
+    std::advance (first, Message::kHeaderBytes);
+    std::copy_n (first, size, in.begin ());
+
+    std::size_t n;
+    n  = std::size_t{in[0]} << 24;
+    n += std::size_t{in[1]} << 16;
+    n += std::size_t{in[2]} <<  8;
+    n += std::size_t{in[3]};
+    if (n == 0 || n > Tuning::maxUncompressedBytes)
+        return false;
+
+    out.resize (n);
+    auto const result = LZ4_decompress_safe (
+        reinterpret_cast<char const*> (
+            in.data () + Message::kCompressedHeaderBytes),
+        reinterpret_cast<char*> (out.data ()),
+        static_cast<int> (size - Message::kCompressedHeaderBytes),
+        static_cast<int> (n));
+    return result >= 0 && static_cast<std::size_t> (result) == n;
+}
+
 template <class T, class Buffers, class Handler>
 std::enable_if_t<std::is_base_of<
     ::google::protobuf::Message, T>::value,
         boost::system::error_code>
 invoke (int type, Buffers const& buffers,
-    Handler& handler)
+    bool compressionEnabled, Handler& handler)
 {
-    ZeroCopyInputStream<Buffers> stream(buffers);
-    stream.Skip(Message::kHeaderBytes);
     auto const m (std::make_shared<T>());
-    if (! m->ParseFromZeroCopyStream(&stream))
-        return boost::system::errc::make_error_code(
-            boost::system::errc::invalid_argument);
+    auto const size = Message::size (buffers);
+    auto uncompressedSize = size;
+    if (Message::compressed (buffers))
+    {
+        std::vector<std::uint8_t> payload;
+        if (! compressionEnabled || ! decompress (buffers, payload) ||
+                ! m->ParseFromArray (payload.data (),
+                    static_cast<int> (payload.size ())))
+            return boost::system::errc::make_error_code(
+                boost::system::errc::invalid_argument);
+        uncompressedSize = payload.size ();
+    }
+    else
+    {
+        ZeroCopyInputStream<Buffers> stream(buffers);
+        stream.Skip(Message::kHeaderBytes);
+        if (! m->ParseFromZeroCopyStream(&stream))
+            return boost::system::errc::make_error_code(
+                boost::system::errc::invalid_argument);
+    }
     auto ec = handler.onMessageBegin (type, m,
-       Message::kHeaderBytes + Message::size (buffers));
+       Message::kHeaderBytes + size,
+       Message::kHeaderBytes + uncompressedSize);
     if (! ec)
     {
         handler.onMessage (m);
@@ -95,11 +153,16 @@ invoke (int type, Buffers const& buffers,
     If there is insufficient data to produce a complete protocol
     message, zero is returned for the number of bytes consumed.
 
+    @param compressionEnabled `true` if compression was negotiated with
+                              the peer. Compressed frames are rejected
+                              otherwise.
+
     @return The number of bytes consumed, or the error code if any.
 */
 template <class Buffers, class Handler>
 std::pair <std::size_t, boost::system::error_code>
-invokeProtocolMessage (Buffers const& buffers, Handler& handler)
+invokeProtocolMessage (Buffers const& buffers,
+    bool compressionEnabled, Handler& handler)
 {
     std::pair<std::size_t,boost::system::error_code> result = { 0, {} };
     boost::system::error_code& ec = result.second;
@@ -111,23 +174,28 @@ invokeProtocolMessage (Buffers const& buffers, Handler& handler)
     if (boost::asio::buffer_size(buffers) < size)
         return result;
 
+    // The buffers may hold the start of the next message as well,
+    // which must not be parsed as part of this one.
+    auto const message = beast::buffer_prefix (size, buffers);
+
     switch (type)
     {
-    case protocol::mtHELLO:         ec = detail::invoke<protocol::TMHello> (type, buffers, handler); break;
-    case protocol::mtMANIFESTS:     ec = detail::invoke<protocol::TMManifests> (type, buffers, handler); break;
-    case protocol::mtPING:          ec = detail::invoke<protocol::TMPing> (type, buffers, handler); break;
-    case protocol::mtCLUSTER:       ec = detail::invoke<protocol::TMCluster> (type, buffers, handler); break;
-    case protocol::mtGET_PEERS:     ec = detail::invoke<protocol::TMGetPeers> (type, buffers, handler); break;
-    case protocol::mtPEERS:         ec = detail::invoke<protocol::TMPeers> (type, buffers, handler); break;
-    case protocol::mtENDPOINTS:     ec = detail::invoke<protocol::TMEndpoints> (type, buffers, handler); break;
-    case protocol::mtTRANSACTION:   ec = detail::invoke<protocol::TMTransaction> (type, buffers, handler); break;
-    case protocol::mtGET_LEDGER:    ec = detail::invoke<protocol::TMGetLedger> (type, buffers, handler); break;
-    case protocol::mtLEDGER_DATA:   ec = detail::invoke<protocol::TMLedgerData> (type, buffers, handler); break;
-    case protocol::mtPROPOSE_LEDGER:ec = detail::invoke<protocol::TMProposeSet> (type, buffers, handler); break;
-    case protocol::mtSTATUS_CHANGE: ec = detail::invoke<protocol::TMStatusChange> (type, buffers, handler); break;
-    case protocol::mtHAVE_SET:      ec = detail::invoke<protocol::TMHaveTransactionSet> (type, buffers, handler); break;
-    case protocol::mtVALIDATION:    ec = detail::invoke<protocol::TMValidation> (type, buffers, handler); break;
-    case protocol::mtGET_OBJECTS:   ec = detail::invoke<protocol::TMGetObjectByHash> (type, buffers, handler); break;
+    case protocol::mtHELLO:         ec = detail::invoke<protocol::TMHello> (type, message, compressionEnabled, handler); break;
+    case protocol::mtMANIFESTS:     ec = detail::invoke<protocol::TMManifests> (type, message, compressionEnabled, handler); break;
+    case protocol::mtPING:          ec = detail::invoke<protocol::TMPing> (type, message, compressionEnabled, handler); break;
+    case protocol::mtCLUSTER:       ec = detail::invoke<protocol::TMCluster> (type, message, compressionEnabled, handler); break;
+    case protocol::mtGET_PEERS:     ec = detail::invoke<protocol::TMGetPeers> (type, message, compressionEnabled, handler); break;
+    case protocol::mtPEERS:         ec = detail::invoke<protocol::TMPeers> (type, message, compressionEnabled, handler); break;
+    case protocol::mtENDPOINTS:     ec = detail::invoke<protocol::TMEndpoints> (type, message, compressionEnabled, handler); break;
+    case protocol::mtTRANSACTION:   ec = detail::invoke<protocol::TMTransaction> (type, message, compressionEnabled, handler); break;
+    case protocol::mtGET_LEDGER:    ec = detail::invoke<protocol::TMGetLedger> (type, message, compressionEnabled, handler); break;
+    case protocol::mtLEDGER_DATA:   ec = detail::invoke<protocol::TMLedgerData> (type, message, compressionEnabled, handler); break;
+    case protocol::mtPROPOSE_LEDGER:ec = detail::invoke<protocol::TMProposeSet> (type, message, compressionEnabled, handler); break;
+    case protocol::mtSTATUS_CHANGE: ec = detail::invoke<protocol::TMStatusChange> (type, message, compressionEnabled, handler); break;
+    case protocol::mtHAVE_SET:      ec = detail::invoke<protocol::TMHaveTransactionSet> (type, message, compressionEnabled, handler); break;
+    case protocol::mtVALIDATION:    ec = detail::invoke<protocol::TMValidation> (type, message, compressionEnabled, handler); break;
+    case protocol::mtGET_OBJECTS:   ec = detail::invoke<protocol::TMGetObjectByHash> (type, message, compressionEnabled, handler); break;
+    case protocol::mtSQUELCH:       ec = detail::invoke<protocol::TMSquelch> (type, message, compressionEnabled, handler); break;
     default:
         ec = handler.onMessageUnknown (type);
         break;
@@ -138,6 +206,34 @@ invokeProtocolMessage (Buffers const& buffers, Handler& handler)
     return result;
 }
 
+/** Gather queued messages into the buffers for a single write.
+
+    Messages are taken from the front of the queue, in order, until
+    Tuning::maxWriteMessages are gathered or the buffers hold at least
+    Tuning::maxWriteBytes. At least one message is always gathered
+    from a non-empty queue.
+
+    @return The number of messages gathered.
+*/
+template <class Queue>
+std::size_t
+gatherMessages (Queue const& queue, bool compressed,
+    std::vector<boost::asio::const_buffer>& buffers)
+{
+    buffers.clear();
+    std::size_t bytes = 0;
+    for (auto const& m : queue)
+    {
+        if (buffers.size() >= Tuning::maxWriteMessages ||
+                bytes >= Tuning::maxWriteBytes)
+            break;
+        auto const& buffer = m->getBuffer(compressed);
+        buffers.emplace_back (boost::asio::buffer (buffer));
+        bytes += buffer.size();
+    }
+    return buffers.size();
+}
+
 /** Write a protocol message to a streambuf. */
 template <class Streambuf>
 void
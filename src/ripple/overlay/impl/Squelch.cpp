@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/overlay/impl/Squelch.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/basics/random.h>
+#include <algorithm>
+
+namespace ripple {
+
+Squelch::Squelch (Handler& handler, clock_type& clock)
+    : handler_ (handler)
+    , clock_ (clock)
+{
+}
+
+void
+Squelch::onMessage (PublicKey const& validator, Peer::id_t peer)
+{
+    std::vector <Action> actions;
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        auto const now = clock_.now ();
+
+        auto& slot = slots_[validator];
+        slot.last = now;
+        auto& state = slot.peers[peer];
+        state.last = now;
+
+        if (slot.active)
+        {
+            // A peer that started relaying since the selection
+            if (! state.selected && ! state.squelched)
+            {
+                using namespace std::chrono;
+                state.squelched = true;
+                actions.push_back ({validator, peer, std::max (
+                    duration_cast <seconds> (slot.expires - now),
+                        seconds (1)), true});
+            }
+        }
+        else
+        {
+            if (++state.count == Tuning::squelchMessageThreshold)
+                slot.reached.push_back (peer);
+
+            if (slot.reached.size () >= Tuning::squelchSelectedPeers &&
+                    slot.peers.size () > Tuning::squelchSelectedPeers)
+                select (validator, slot, actions);
+        }
+    }
+    dispatch (actions);
+}
+
+void
+Squelch::onPeerDeactivate (Peer::id_t peer)
+{
+    std::vector <Action> actions;
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        for (auto& v : slots_)
+        {
+            auto& slot = v.second;
+            auto const iter = slot.peers.find (peer);
+            if (iter == slot.peers.end ())
+                continue;
+
+            bool const selected = iter->second.selected;
+            slot.peers.erase (iter);
+            slot.reached.erase (std::remove (slot.reached.begin (),
+                slot.reached.end (), peer), slot.reached.end ());
+            if (selected)
+                reset (v.first, slot, actions);
+        }
+    }
+    dispatch (actions);
+}
+
+void
+Squelch::onTimer ()
+{
+    using namespace std::chrono;
+
+    std::vector <Action> actions;
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        auto const now = clock_.now ();
+
+        for (auto iter = slots_.begin (); iter != slots_.end ();)
+        {
+            auto& slot = iter->second;
+            if (now - slot.last > seconds (Tuning::squelchForgetSeconds))
+            {
+                reset (iter->first, slot, actions);
+                iter = slots_.erase (iter);
+                continue;
+            }
+
+            if (slot.active)
+            {
+                if (now >= slot.expires)
+                {
+                    // The squelched peers resume on their own, so only
+                    // our side needs to start over
+                    for (auto& p : slot.peers)
+                        p.second.squelched = false;
+                    reset (iter->first, slot, actions);
+                }
+                else
+                {
+                    auto const idle = std::any_of (slot.peers.begin (),
+                        slot.peers.end (),
+                        [&](auto const& p)
+                        {
+                            return p.second.selected && now - p.second.last >
+                                seconds (Tuning::squelchIdleSeconds);
+                        });
+                    if (idle)
+                        reset (iter->first, slot, actions);
+                }
+            }
+            ++iter;
+        }
+    }
+    dispatch (actions);
+}
+
+std::size_t
+Squelch::squelched () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    std::size_t n = 0;
+    for (auto const& v : slots_)
+        for (auto const& p : v.second.peers)
+            if (p.second.squelched)
+                ++n;
+    return n;
+}
+
+void
+Squelch::reset (PublicKey const& validator, Slot& slot,
+    std::vector <Action>& actions)
+{
+    for (auto& p : slot.peers)
+    {
+        auto& state = p.second;
+        if (state.squelched)
+            actions.push_back ({validator, p.first,
+                std::chrono::seconds (0), false});
+        state = PeerState {0, state.last, false, false};
+    }
+    slot.reached.clear ();
+    slot.active = false;
+}
+
+void
+Squelch::select (PublicKey const& validator, Slot& slot,
+    std::vector <Action>& actions)
+{
+    std::chrono::seconds const duration (rand_int (
+        static_cast<int> (Tuning::squelchMinSeconds),
+        static_cast<int> (Tuning::squelchMaxSeconds)));
+
+    slot.active = true;
+    slot.expires = clock_.now () + duration;
+
+    for (std::size_t i = 0; i < Tuning::squelchSelectedPeers; ++i)
+        slot.peers[slot.reached[i]].selected = true;
+    slot.reached.clear ();
+
+    for (auto& p : slot.peers)
+    {
+        if (p.second.selected)
+            continue;
+        p.second.squelched = true;
+        actions.push_back ({validator, p.first, duration, true});
+    }
+}
+
+void
+Squelch::dispatch (std::vector <Action> const& actions)
+{
+    for (auto const& a : actions)
+    {
+        if (a.squelch)
+            handler_.squelch (a.validator, a.peer, a.duration);
+        else
+            handler_.unsquelch (a.validator, a.peer);
+    }
+}
+
+} // ripple
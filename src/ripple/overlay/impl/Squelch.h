@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#ifndef RIPPLE_OVERLAY_SQUELCH_H_INCLUDED
+#define RIPPLE_OVERLAY_SQUELCH_H_INCLUDED
+
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/beast/clock/abstract_clock.h>
+#include <ripple/overlay/Peer.h>
+#include <ripple/protocol/PublicKey.h>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+/** Chooses which peers relay each validator's messages to us.
+
+    In a meshed network every proposal and validation arrives once from
+    each peer that relays it. When squelching is enabled, a validator's
+    messages are counted by the peer delivering them. Once more than
+    enough peers deliver them, the first few to deliver a threshold
+    number are kept and every other peer is asked to stop relaying
+    that validator's messages to us for a while.
+
+    Selection starts over when the squelch period ends, so the chosen
+    peers follow changes in the network. It also starts over, lifting
+    the squelches early, when a chosen peer goes quiet or disconnects.
+*/
+class Squelch
+{
+public:
+    using clock_type = beast::abstract_clock <std::chrono::steady_clock>;
+
+    /** Sends squelch messages to peers. */
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+
+        /** Ask a peer to stop relaying a validator's messages. */
+        virtual
+        void
+        squelch (PublicKey const& validator, Peer::id_t peer,
+            std::chrono::seconds duration) = 0;
+
+        /** Ask a peer to resume relaying a validator's messages. */
+        virtual
+        void
+        unsquelch (PublicKey const& validator, Peer::id_t peer) = 0;
+    };
+
+    Squelch (Handler& handler, clock_type& clock);
+
+    /** Record that a peer delivered a message from a validator. */
+    void
+    onMessage (PublicKey const& validator, Peer::id_t peer);
+
+    /** Forget a peer that has disconnected. */
+    void
+    onPeerDeactivate (Peer::id_t peer);
+
+    /** Start over where it is time to, and forget idle validators.
+
+        Called periodically.
+    */
+    void
+    onTimer ();
+
+    /** Returns the number of squelched validator and peer pairs. */
+    std::size_t
+    squelched () const;
+
+private:
+    struct PeerState
+    {
+        // Messages delivered since selection started
+        std::size_t count = 0;
+        clock_type::time_point last;
+        bool selected = false;
+        bool squelched = false;
+    };
+
+    struct Slot
+    {
+        hash_map <Peer::id_t, PeerState> peers;
+
+        // Peers which reached the threshold, in the order they did
+        std::vector <Peer::id_t> reached;
+
+        // Whether squelches are in effect, and until when
+        bool active = false;
+        clock_type::time_point expires;
+
+        clock_type::time_point last;
+    };
+
+    struct Action
+    {
+        PublicKey validator;
+        Peer::id_t peer;
+        std::chrono::seconds duration;
+        bool squelch;
+    };
+
+    // Lift any squelches and start counting again
+    static
+    void
+    reset (PublicKey const& validator, Slot& slot,
+        std::vector <Action>& actions);
+
+    void
+    select (PublicKey const& validator, Slot& slot,
+        std::vector <Action>& actions);
+
+    // Called without the lock held
+    void
+    dispatch (std::vector <Action> const& actions);
+
+    Handler& handler_;
+    clock_type& clock_;
+
+    std::mutex mutable mutex_;
+    hash_map <PublicKey, Slot> slots_;
+};
+
+} // ripple
+
+#endif
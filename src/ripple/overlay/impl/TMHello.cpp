@@ -221,6 +221,18 @@ parse_ProtocolVersions(boost::string_ref const& value)
     return result;
 }
 
+void
+appendCompression (beast::http::fields& h)
+{
+    h.insert ("Compression", "lz4");
+}
+
+bool
+peerSupportsCompression (beast::http::fields const& h)
+{
+    return beast::rfc2616::token_in_list (h["Compression"], "lz4");
+}
+
 boost::optional<protocol::TMHello>
 parseHello (bool request, beast::http::fields const& h, beast::Journal journal)
 {
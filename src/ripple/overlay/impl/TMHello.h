@@ -86,6 +86,16 @@ verifyHello (protocol::TMHello const& h, uint256 const& sharedValue,
 std::vector<ProtocolVersion>
 parse_ProtocolVersions(boost::string_ref const& s);
 
+/** Insert the HTTP header offering or accepting compressed messages. */
+void
+appendCompression (beast::http::fields& h);
+
+/** Returns `true` if the HTTP headers offer, in a request, or accept,
+    in a response, LZ4 compressed protocol messages.
+*/
+bool
+peerSupportsCompression (beast::http::fields const& h);
+
 }
 
 #endif
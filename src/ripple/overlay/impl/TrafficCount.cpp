@@ -44,6 +44,12 @@ const char* TrafficCount::getName (category c)
             return "transaction_set_get";
         case category::CT_share_trans:
             return "transaction_set_share";
+        case category::CT_squelch:
+            return "squelch";
+        case category::CT_squelch_suppressed:
+            return "squelch_suppressed";
+        case category::CT_duplicate:
+            return "duplicate_proposal_validation";
         case category::CT_unknown:
             assert (false);
             return "unknown";
@@ -78,6 +84,9 @@ TrafficCount::category TrafficCount::categorize (
     if (type == protocol::mtPROPOSE_LEDGER)
         return TrafficCount::category::CT_proposal;
 
+    if (type == protocol::mtSQUELCH)
+        return TrafficCount::category::CT_squelch;
+
     if (type == protocol::mtHAVE_SET)
         return inbound ? TrafficCount::category::CT_get_trans :
             TrafficCount::category::CT_share_trans;
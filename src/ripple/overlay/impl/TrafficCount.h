@@ -23,6 +23,7 @@
 #include "ripple.pb.h"
 
 #include <atomic>
+#include <chrono>
 #include <map>
 
 namespace ripple {
@@ -43,8 +44,14 @@ public:
         count_t messagesIn;
         count_t messagesOut;
 
+        // Bytes before compression, equal to the bytes
+        // above when no messages were compressed.
+        count_t bytesInUncompressed;
+        count_t bytesOutUncompressed;
+
         TrafficStats() : bytesIn(0), bytesOut(0),
-            messagesIn(0), messagesOut(0)
+            messagesIn(0), messagesOut(0),
+            bytesInUncompressed(0), bytesOutUncompressed(0)
         { ; }
 
         TrafficStats(const TrafficStats& ts)
@@ -52,6 +59,8 @@ public:
             , bytesOut (ts.bytesOut.load())
             , messagesIn (ts.messagesIn.load())
             , messagesOut (ts.messagesOut.load())
+            , bytesInUncompressed (ts.bytesInUncompressed.load())
+            , bytesOutUncompressed (ts.bytesOutUncompressed.load())
         { ; }
 
         operator bool () const
@@ -61,6 +70,19 @@ public:
     };
 
 
+    /** Gathered writes of queued messages to peers. */
+    class WriteStats
+    {
+        public:
+
+        count_t writes;
+        count_t messages;
+        count_t microseconds;
+
+        WriteStats() : writes(0), messages(0), microseconds(0)
+        { ; }
+    };
+
     enum class category
     {
         CT_base,           // basic peer overhead, must be first
@@ -72,6 +94,9 @@ public:
         CT_share_ledger,   // ledgers we share
         CT_get_trans,      // transaction sets we try to get
         CT_share_trans,    // transaction sets we get
+        CT_squelch,        // requests to stop or resume relaying
+        CT_squelch_suppressed, // messages not relayed to squelching peers
+        CT_duplicate,      // proposals and validations already received
         CT_unknown         // must be last
     };
 
@@ -81,20 +106,47 @@ public:
         ::google::protobuf::Message const& message,
         int type, bool inbound);
 
-    void addCount (category cat, bool inbound, int number)
+    /** Account for a message sent or received.
+
+        @param number The bytes on the wire.
+        @param uncompressed The bytes the message would have taken
+                            without compression.
+    */
+    void addCount (category cat, bool inbound,
+        int number, int uncompressed)
     {
         if (inbound)
         {
             counts_[cat].bytesIn += number;
+            counts_[cat].bytesInUncompressed += uncompressed;
             ++counts_[cat].messagesIn;
         }
         else
         {
             counts_[cat].bytesOut += number;
+            counts_[cat].bytesOutUncompressed += uncompressed;
             ++counts_[cat].messagesOut;
         }
     }
 
+    /** Account for a write of one or more messages to a peer.
+
+        @param messages The number of messages in the write.
+        @param elapsed The time from starting the write to its completion.
+    */
+    void addWrite (std::size_t messages, std::chrono::microseconds elapsed)
+    {
+        ++writes_.writes;
+        writes_.messages += messages;
+        writes_.microseconds += elapsed.count();
+    }
+
+    WriteStats const&
+    getWriteStats () const
+    {
+        return writes_;
+    }
+
     TrafficCount()
     {
         for (category i = category::CT_base;
@@ -124,6 +176,7 @@ public:
     protected:
 
     std::map <category, TrafficStats> counts_;
+    WriteStats writes_;
 };
 
 }
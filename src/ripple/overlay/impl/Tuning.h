@@ -74,6 +74,37 @@ enum
 
     /** How often to log send queue size */
     sendQueueLogFreq    =    64,
+
+    /** The most queued messages gathered into a single write */
+    maxWriteMessages    =    64,
+
+    /** Stop gathering queued messages into a write once it
+        holds at least this many bytes */
+    maxWriteBytes       = 64 * 1024,
+
+    /** The largest message payload we will decompress */
+    maxUncompressedBytes = 64 * 1024 * 1024,
+
+    /** How many peers keep relaying each validator's
+        messages to us when squelching */
+    squelchSelectedPeers =    5,
+
+    /** How many of a validator's messages a peer delivers
+        before it can be selected */
+    squelchMessageThreshold = 20,
+
+    /** The range of squelch durations we ask for, in seconds.
+        We honor requests up to the maximum. */
+    squelchMinSeconds   =  300,
+    squelchMaxSeconds   =  600,
+
+    /** How long a selected peer can go without delivering a
+        validator's messages before selection starts over */
+    squelchIdleSeconds  =   16,
+
+    /** How long before we forget a validator we stopped
+        hearing from */
+    squelchForgetSeconds =  300,
 };
 
 } // Tuning
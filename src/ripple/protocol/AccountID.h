@@ -25,9 +25,14 @@
 //#include <ripple/protocol/PublicKey.h>
 #include <ripple/basics/base_uint.h>
 #include <ripple/basics/UnorderedContainers.h>
+#include <ripple/basics/hardened_hash.h>
 #include <ripple/json/json_value.h>
 #include <boost/optional.hpp>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -142,21 +147,56 @@ inline std::ostream& operator<< (std::ostream& os, AccountID const& x)
     justify having a cache. In the future, rippled should
     require clients to receive "binary" results, where
     AccountIDs are hex-encoded.
+
+    The cache is a fixed table of entries, each holding one
+    AccountID and its string. An AccountID can only live in
+    the entry its hash selects, which it takes over from
+    whatever was there before. Every entry is guarded by its
+    own sequence counter instead of a lock: readers retry
+    nothing and writers skip an entry that is busy, so a
+    lookup never waits on another thread.
 */
 class AccountIDCache
 {
 private:
-    std::mutex mutable mutex_;
-    std::size_t capacity_;
-    hash_map<AccountID,
-        std::string> mutable m0_;
-    hash_map<AccountID,
-        std::string> mutable m1_;
+    // Enough for the base58 of a 25 byte token
+    static std::size_t constexpr maxText = 35;
+
+    // An entry fills one cache line: the sequence counter, then
+    // the AccountID, the length of its string and the string,
+    // packed into words so that they can be copied atomically.
+    struct alignas(64) Entry
+    {
+        std::atomic<std::uint32_t> seq {0};
+        std::array<std::atomic<std::uint64_t>, 7> words;
+
+        Entry();
+    };
+
+    static_assert (sizeof (Entry) == 64, "");
+    static_assert (20 + 1 + maxText <= 7 * 8, "");
+
+    std::unique_ptr<Entry[]> entries_;
+    std::size_t mask_;
+    hardened_hash<> hash_;
+
+    bool
+    lookup (Entry const& e, AccountID const& id,
+        std::string& result) const;
+
+    void
+    store (Entry& e, AccountID const& id,
+        std::string const& text) const;
 
 public:
     AccountIDCache(AccountIDCache const&) = delete;
     AccountIDCache& operator= (AccountIDCache const&) = delete;
 
+    /** Create a cache.
+
+        @param capacity The number of entries, which is
+                        rounded up to a power of two.
+    */
     explicit
     AccountIDCache (std::size_t capacity);
 
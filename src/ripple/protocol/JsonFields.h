@@ -121,6 +121,7 @@ JSS ( code );                       // out: errors
 JSS ( command );                    // in: RPCHandler
 JSS ( complete );                   // out: NetworkOPs, InboundLedger
 JSS ( complete_ledgers );           // out: NetworkOPs, PeerImp
+JSS ( complete_shards );            // out: NetworkOPs
 JSS ( consensus );                  // out: NetworkOPs, LedgerConsensus
 JSS ( converge_time );              // out: NetworkOPs
 JSS ( converge_time_s );            // out: NetworkOPs
@@ -206,6 +207,9 @@ JSS ( index );                      // in: LedgerEntry; out: PathState,
                                     //     TxHistory, LedgerData;
                                     // field
 JSS ( info );                       // out: ServerInfo, ConsensusInfo, FetchInfo
+JSS ( inner_node_bytes );           // out: GetCounts
+JSS ( inner_node_full_bytes );      // out: GetCounts
+JSS ( inner_nodes );                // out: GetCounts
 JSS ( internal_command );           // in: Internal
 JSS ( io_latency_ms );              // out: NetworkOPs
 JSS ( ip );                         // in: Connect, out: OverlayImpl
@@ -272,6 +276,7 @@ JSS ( max_spend_drops_total );      // out: AccountInfo
 JSS ( median_fee );                 // out: TxQ
 JSS ( median_level );               // out: TxQ
 JSS ( message );                    // error.
+JSS ( messages_per_write );         // out: PeerImp
 JSS ( meta );                       // out: NetworkOPs, AccountTx*, Tx
 JSS ( metaData );
 JSS ( metadata );                   // out: TransactionEntry
@@ -290,6 +295,8 @@ JSS ( no_ripple_peer );             // out: AccountLines
 JSS ( node );                       // out: LedgerEntry
 JSS ( node_binary );                // out: LedgerEntry
 JSS ( node_hit_rate );              // out: GetCounts
+JSS ( node_filter_false_positives ); // out: GetCounts
+JSS ( node_filter_hits );           // out: GetCounts
 JSS ( node_read_bytes );            // out: GetCounts
 JSS ( node_reads_hit );             // out: GetCounts
 JSS ( node_reads_total );           // out: GetCounts
@@ -312,6 +319,8 @@ JSS ( parent_hash );                // out: LedgerToJson
 JSS ( partition );                  // in: LogLevel
 JSS ( passphrase );                 // in: WalletPropose
 JSS ( password );                   // in: Subscribe
+JSS ( path_find_fast );             // out: GetCounts
+JSS ( path_find_full );             // out: GetCounts
 JSS ( paths );                      // in: RipplePathFind
 JSS ( paths_canonical );            // out: RipplePathFind
 JSS ( paths_computed );             // out: PathRequest, RipplePathFind
@@ -454,7 +463,9 @@ JSS ( version );                    // out: RPCVersion
 JSS ( vetoed );                     // out: AmendmentTableImpl
 JSS ( vote );                       // in: Feature
 JSS ( warning );                    // rpc:
+JSS ( write_latency );              // out: PeerImp
 JSS ( write_load );                 // out: GetCounts
+JSS ( writes );                     // out: PeerImp
 
 #undef JSS
 
@@ -123,6 +123,9 @@ public:
     Json::Value getJson (int options) const override;
     Json::Value getJson (int options, bool binary) const;
 
+    /** Returns the data covered by a single signature. */
+    Blob getSigningData () const;
+
     void sign (
         PublicKey const& publicKey,
         SecretKey const& secretKey);
@@ -21,6 +21,7 @@
 #define RIPPLE_PROTOCOL_DIGEST_H_INCLUDED
 
 #include <ripple/basics/base_uint.h>
+#include <ripple/basics/Slice.h>
 #include <ripple/beast/crypto/ripemd.h>
 #include <ripple/beast/crypto/sha2.h>
 #include <ripple/beast/hash/endian.h>
@@ -291,6 +292,46 @@ sha512Half_s (Args const&... args)
         sha512_half_hasher_s::result_type>(h);
 }
 
+//------------------------------------------------------------------------------
+
+/** Computes the SHA512-Half of many independent messages.
+
+    digests[i] receives the SHA512-Half of messages[i]. On CPUs with
+    AVX2 or AVX-512 several messages are hashed at once, one per vector
+    lane; otherwise each message is hashed in turn. The results are the
+    same either way.
+
+    This pays off when there are many short messages to hash, such as
+    the nodes of a SHAMap.
+*/
+void
+sha512HalfBatch (Slice const* messages,
+    uint256* digests, std::size_t count);
+
+namespace detail {
+
+/** The ways sha512HalfBatch can hash its messages. */
+enum class sha512_batch_kernel
+{
+    scalar,     // one message at a time
+    avx2,       // four messages at a time
+    avx512      // eight messages at a time
+};
+
+/** Returns true if the kernel can be used on this CPU. */
+bool
+sha512HalfBatchSupported (sha512_batch_kernel kernel);
+
+/** sha512HalfBatch, using a particular kernel.
+
+    The kernel must be supported by this CPU.
+*/
+void
+sha512HalfBatch (sha512_batch_kernel kernel,
+    Slice const* messages, uint256* digests, std::size_t count);
+
+} // detail
+
 } // ripple
 
 #endif
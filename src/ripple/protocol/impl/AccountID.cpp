@@ -184,54 +184,93 @@ to_issuer (AccountID& issuer, std::string const& s)
 
 //------------------------------------------------------------------------------
 
-/*  VFALCO NOTE
-    An alternate implementation could use a pair of insert-only
-    hash maps that each use a single large memory allocation
-    to store a fixed size hash table and all of the AccountID/string
-    pairs laid out in memory (wouldn't use std::string here just a
-    length prefixed or zero terminated array). Possibly using
-    boost::intrusive as the basis for the unordered container.
-    This would cut down to one allocate/free cycle per swap of
-    the map.
-*/
+AccountIDCache::Entry::Entry()
+{
+    for (auto& w : words)
+        w.store (0, std::memory_order_relaxed);
+}
 
 AccountIDCache::AccountIDCache(
         std::size_t capacity)
-    : capacity_(capacity)
 {
-    m1_.reserve(capacity_);
+    std::size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    entries_.reset (new Entry[size]);
+    mask_ = size - 1;
+}
+
+// The entries follow the usual sequence lock protocol. A writer makes
+// the counter odd, stores the words and makes it even again. A reader
+// trusts what it copied only if the counter was even and unchanged
+// throughout the copy.
+
+bool
+AccountIDCache::lookup (Entry const& e,
+    AccountID const& id, std::string& result) const
+{
+    auto const seq = e.seq.load (std::memory_order_acquire);
+    if (seq == 0 || (seq & 1) != 0)
+        return false;
+
+    std::array<std::uint64_t, 7> words;
+    for (std::size_t i = 0; i != words.size (); ++i)
+        words[i] = e.words[i].load (std::memory_order_relaxed);
+
+    std::atomic_thread_fence (std::memory_order_acquire);
+    if (e.seq.load (std::memory_order_relaxed) != seq)
+        return false;
+
+    auto const bytes = reinterpret_cast<char const*>(words.data ());
+    if (std::memcmp (bytes, id.data (), id.size ()) != 0)
+        return false;
+
+    auto const size = static_cast<unsigned char>(bytes[20]);
+    if (size > maxText)
+        return false;
+
+    result.assign (bytes + 21, size);
+    return true;
+}
+
+void
+AccountIDCache::store (Entry& e,
+    AccountID const& id, std::string const& text) const
+{
+    if (text.size () > maxText)
+        return;
+
+    // Leave the entry alone if another thread is writing it
+    auto seq = e.seq.load (std::memory_order_relaxed);
+    if ((seq & 1) != 0 || ! e.seq.compare_exchange_strong (
+            seq, seq + 1, std::memory_order_relaxed))
+        return;
+    std::atomic_thread_fence (std::memory_order_release);
+
+    std::array<std::uint64_t, 7> words {};
+    auto const bytes = reinterpret_cast<char*>(words.data ());
+    std::memcpy (bytes, id.data (), id.size ());
+    bytes[20] = static_cast<char>(text.size ());
+    std::memcpy (bytes + 21, text.data (), text.size ());
+
+    for (std::size_t i = 0; i != words.size (); ++i)
+        e.words[i].store (words[i], std::memory_order_relaxed);
+
+    e.seq.store (seq + 2, std::memory_order_release);
 }
 
 std::string
 AccountIDCache::toBase58(
     AccountID const& id) const
 {
-    std::lock_guard<
-        std::mutex> lock(mutex_);
-    auto iter = m1_.find(id);
-    if (iter != m1_.end())
-        return iter->second;
-    iter = m0_.find(id);
+    auto& e = entries_[hash_ (id) & mask_];
+
     std::string result;
-    if (iter != m0_.end())
-    {
-        result = iter->second;
-        // Can use insert-only hash maps if
-        // we didn't erase from here.
-        m0_.erase(iter);
-    }
-    else
-    {
-        result =
-            ripple::toBase58(id);
-    }
-    if (m1_.size() >= capacity_)
-    {
-        m0_ = std::move(m1_);
-        m1_.clear();
-        m1_.reserve(capacity_);
-    }
-    m1_.emplace(id, result);
+    if (lookup (e, id, result))
+        return result;
+
+    result = ripple::toBase58 (id);
+    store (e, id, result);
     return result;
 }
 
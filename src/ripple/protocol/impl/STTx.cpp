@@ -139,11 +139,12 @@ STTx::getMentionedAccounts () const
     return list;
 }
 
-static Blob getSigningData (STTx const& that)
+Blob
+STTx::getSigningData () const
 {
     Serializer s;
     s.add32 (HashPrefix::txSign);
-    that.addWithoutSigningFields (s);
+    addWithoutSigningFields (s);
     return s.getData();
 }
 
@@ -169,7 +170,7 @@ void STTx::sign (
     PublicKey const& publicKey,
     SecretKey const& secretKey)
 {
-    auto const data = getSigningData (*this);
+    auto const data = getSigningData ();
 
     auto const sig = ripple::sign (
         publicKey,
@@ -278,7 +279,7 @@ std::pair<bool, std::string> STTx::checkSingleSign () const
         if (publicKeyType (makeSlice(spk)))
         {
             Blob const signature = getFieldVL (sfTxnSignature);
-            Blob const data = getSigningData (*this);
+            Blob const data = getSigningData ();
 
             validSig = verify (
                 PublicKey (makeSlice(spk)),
@@ -0,0 +1,408 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/protocol/digest.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+// The multi-buffer kernels use the GCC/Clang vector extensions and
+// per-function target attributes, so the rest of the program can still
+// be built for (and run on) CPUs without AVX2.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RIPPLE_SHA512_MULTI_BUFFER 1
+#else
+#define RIPPLE_SHA512_MULTI_BUFFER 0
+#endif
+
+namespace ripple {
+namespace detail {
+
+namespace {
+
+/*  A message, as the sequence of 128-byte blocks that SHA-512 compresses.
+
+    Whole blocks are read in place. Only the last one or two blocks,
+    which carry the padding and the message length, are copied.
+*/
+class sha512_padded_message
+{
+private:
+    std::uint8_t const* data_;
+    std::size_t whole_;
+    std::size_t blocks_;
+    std::uint8_t tail_[256];
+
+public:
+    static
+    std::size_t
+    blockCount (std::size_t size)
+    {
+        // 0x80 and the 128-bit length follow the message
+        return (size + 17 + 127) / 128;
+    }
+
+    void
+    reset (Slice const& message)
+    {
+        auto const size = message.size ();
+
+        data_ = message.data ();
+        whole_ = size / 128;
+        blocks_ = blockCount (size);
+
+        auto const rest = size % 128;
+        auto const tail = (blocks_ - whole_) * 128;
+
+        std::memset (tail_, 0, tail);
+        if (rest != 0)
+            std::memcpy (tail_, data_ + whole_ * 128, rest);
+        tail_[rest] = 0x80;
+
+        // The length in bits, big-endian. Messages are far shorter
+        // than 2^61 bytes, so the upper 64 bits are always zero.
+        std::uint64_t const bits = size * 8;
+        for (int i = 0; i != 8; ++i)
+            tail_[tail - 1 - i] = static_cast<std::uint8_t> (bits >> (8 * i));
+    }
+
+    std::size_t
+    blocks () const
+    {
+        return blocks_;
+    }
+
+    std::uint8_t const*
+    block (std::size_t i) const
+    {
+        if (i < whole_)
+            return data_ + i * 128;
+        return tail_ + (i - whole_) * 128;
+    }
+};
+
+#if RIPPLE_SHA512_MULTI_BUFFER
+
+std::uint64_t const sha512K[80] =
+{
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+    0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+    0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+    0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+    0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+    0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+    0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+    0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+    0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+    0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+    0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+    0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+    0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+    0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+std::uint64_t const sha512H[8] =
+{
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+using u64x4 = std::uint64_t __attribute__ ((vector_size (32)));
+using u64x8 = std::uint64_t __attribute__ ((vector_size (64)));
+
+#define RIPPLE_SHA512_INLINE inline __attribute__ ((always_inline))
+
+// A macro rather than a function: passing a vector by value to a
+// function compiled without AVX changes its ABI, which GCC warns about.
+#define RIPPLE_SHA512_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+inline
+std::uint64_t
+loadBigEndian (std::uint8_t const* p)
+{
+    std::uint64_t x;
+    std::memcpy (&x, p, sizeof (x));
+    return __builtin_bswap64 (x);
+}
+
+/*  Runs SHA-512 over N messages at once, one per vector lane.
+
+    The lanes may need different numbers of blocks. A lane that has run
+    out of blocks keeps compressing its last block, but the result is
+    masked off so its state does not change.
+*/
+template <class V, std::size_t N>
+RIPPLE_SHA512_INLINE
+void
+sha512Lanes (
+    sha512_padded_message const* const* lanes,
+    uint256* const* digests)
+{
+    V state[8];
+    for (int i = 0; i != 8; ++i)
+        state[i] = V{} + sha512H[i];
+
+    std::size_t blocks[N];
+    std::size_t maxBlocks = 0;
+    for (std::size_t j = 0; j != N; ++j)
+    {
+        blocks[j] = lanes[j]->blocks ();
+        maxBlocks = std::max (maxBlocks, blocks[j]);
+    }
+
+    for (std::size_t b = 0; b != maxBlocks; ++b)
+    {
+        V w[16];
+        V active;
+        for (std::size_t j = 0; j != N; ++j)
+        {
+            auto const last = b >= blocks[j];
+            auto const p = lanes[j]->block (last ? blocks[j] - 1 : b);
+            for (int t = 0; t != 16; ++t)
+                w[t][j] = loadBigEndian (p + 8 * t);
+            active[j] = last ? 0 : ~std::uint64_t (0);
+        }
+
+        V a = state[0], b_ = state[1], c = state[2], d = state[3];
+        V e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t != 80; ++t)
+        {
+            if (t >= 16)
+            {
+                V const w15 = w[(t - 15) & 15];
+                V const w2 = w[(t - 2) & 15];
+                w[t & 15] +=
+                    (RIPPLE_SHA512_ROTR (w15, 1) ^
+                        RIPPLE_SHA512_ROTR (w15, 8) ^ (w15 >> 7)) +
+                    w[(t - 7) & 15] +
+                    (RIPPLE_SHA512_ROTR (w2, 19) ^
+                        RIPPLE_SHA512_ROTR (w2, 61) ^ (w2 >> 6));
+            }
+
+            V const t1 = h +
+                (RIPPLE_SHA512_ROTR (e, 14) ^ RIPPLE_SHA512_ROTR (e, 18) ^
+                    RIPPLE_SHA512_ROTR (e, 41)) +
+                ((e & f) ^ (~e & g)) + sha512K[t] + w[t & 15];
+            V const t2 =
+                (RIPPLE_SHA512_ROTR (a, 28) ^ RIPPLE_SHA512_ROTR (a, 34) ^
+                    RIPPLE_SHA512_ROTR (a, 39)) +
+                ((a & b_) ^ (a & c) ^ (b_ & c));
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b_;
+            b_ = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a & active;
+        state[1] += b_ & active;
+        state[2] += c & active;
+        state[3] += d & active;
+        state[4] += e & active;
+        state[5] += f & active;
+        state[6] += g & active;
+        state[7] += h & active;
+    }
+
+    // The half digest is the first four state words, big-endian
+    for (std::size_t j = 0; j != N; ++j)
+    {
+        auto out = digests[j]->data ();
+        for (int i = 0; i != 4; ++i)
+        {
+            auto const x = __builtin_bswap64 (state[i][j]);
+            std::memcpy (out + 8 * i, &x, sizeof (x));
+        }
+    }
+}
+
+#undef RIPPLE_SHA512_ROTR
+#undef RIPPLE_SHA512_INLINE
+
+__attribute__ ((target ("avx2")))
+void
+sha512x4 (
+    sha512_padded_message const* const* lanes,
+    uint256* const* digests)
+{
+    sha512Lanes<u64x4, 4> (lanes, digests);
+}
+
+__attribute__ ((target ("avx512f")))
+void
+sha512x8 (
+    sha512_padded_message const* const* lanes,
+    uint256* const* digests)
+{
+    sha512Lanes<u64x8, 8> (lanes, digests);
+}
+
+#endif
+
+void
+sha512HalfScalar (
+    Slice const* messages, uint256* digests, std::size_t count)
+{
+    for (std::size_t i = 0; i != count; ++i)
+        digests[i] = sha512Half (messages[i]);
+}
+
+template <std::size_t N, class Kernel>
+void
+sha512HalfLanes (Kernel kernel,
+    Slice const* messages, uint256* digests, std::size_t count)
+{
+    // Messages needing the same number of blocks go through the kernel
+    // together, so that lanes are not left idle.
+    std::vector<std::size_t> order (count);
+    std::iota (order.begin (), order.end (), std::size_t (0));
+    std::stable_sort (order.begin (), order.end (),
+        [messages](std::size_t lhs, std::size_t rhs)
+        {
+            return sha512_padded_message::blockCount (messages[lhs].size ()) <
+                sha512_padded_message::blockCount (messages[rhs].size ());
+        });
+
+    sha512_padded_message padded[N];
+    sha512_padded_message const* lanes[N];
+    uint256* out[N];
+    uint256 unused;
+
+    for (std::size_t i = 0; i < count; i += N)
+    {
+        auto const n = std::min (N, count - i);
+
+        if (n == 1)
+        {
+            sha512HalfScalar (&messages[order[i]], &digests[order[i]], 1);
+            break;
+        }
+
+        // Spare lanes repeat the first message and their results are
+        // thrown away.
+        for (std::size_t j = 0; j != N; ++j)
+        {
+            if (j < n)
+            {
+                padded[j].reset (messages[order[i + j]]);
+                lanes[j] = &padded[j];
+                out[j] = &digests[order[i + j]];
+            }
+            else
+            {
+                lanes[j] = &padded[0];
+                out[j] = &unused;
+            }
+        }
+
+        kernel (lanes, out);
+    }
+}
+
+sha512_batch_kernel
+bestKernel ()
+{
+#if RIPPLE_SHA512_MULTI_BUFFER
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx512f"))
+        return sha512_batch_kernel::avx512;
+    if (__builtin_cpu_supports ("avx2"))
+        return sha512_batch_kernel::avx2;
+#endif
+    return sha512_batch_kernel::scalar;
+}
+
+} // (anon)
+
+bool
+sha512HalfBatchSupported (sha512_batch_kernel kernel)
+{
+    switch (kernel)
+    {
+    case sha512_batch_kernel::scalar:
+        return true;
+#if RIPPLE_SHA512_MULTI_BUFFER
+    case sha512_batch_kernel::avx2:
+        __builtin_cpu_init ();
+        return __builtin_cpu_supports ("avx2");
+    case sha512_batch_kernel::avx512:
+        __builtin_cpu_init ();
+        return __builtin_cpu_supports ("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+void
+sha512HalfBatch (sha512_batch_kernel kernel,
+    Slice const* messages, uint256* digests, std::size_t count)
+{
+    assert (sha512HalfBatchSupported (kernel));
+
+    switch (kernel)
+    {
+#if RIPPLE_SHA512_MULTI_BUFFER
+    case sha512_batch_kernel::avx2:
+        sha512HalfLanes<4> (&sha512x4, messages, digests, count);
+        break;
+    case sha512_batch_kernel::avx512:
+        sha512HalfLanes<8> (&sha512x8, messages, digests, count);
+        break;
+#endif
+    default:
+        sha512HalfScalar (messages, digests, count);
+        break;
+    }
+}
+
+} // detail
+
+void
+sha512HalfBatch (Slice const* messages,
+    uint256* digests, std::size_t count)
+{
+    static auto const kernel = detail::bestKernel ();
+    detail::sha512HalfBatch (kernel, messages, digests, count);
+}
+
+} // ripple
@@ -100,7 +100,7 @@ checksum (void* out,
 //         calculates the size of buffer needed.
 static
 std::string
-encodeBase58(
+encodeBase58Reference(
     void const* message, std::size_t size,
         void *temp, char const* const alphabet)
 {
@@ -146,6 +146,115 @@ encodeBase58(
     return str;
 }
 
+#if defined(__SIZEOF_INT128__)
+
+// The fast codec works on 64-bit limbs, with 128-bit intermediates, and
+// converts ten base58 digits at a time: 58^10 is the largest power of
+// 58 that fits in 64 bits. Numbers are held as little-endian arrays of
+// limbs. Anything too long for these arrays, far longer than any
+// token, takes the byte-at-a-time path.
+#define RIPPLE_BASE58_FAST 1
+
+static std::uint64_t constexpr base58Chunk = 430804206899405824ULL;
+static std::size_t constexpr base58ChunkDigits = 10;
+static std::size_t constexpr base58MaxLimbs = 17;
+static std::size_t constexpr base58MaxBytes = 8 * base58MaxLimbs;
+// No more than 16 limbs: 170 * log2(58) < 1024
+static std::size_t constexpr base58MaxDigits = 170;
+
+static
+bool
+encodeBase58Fast (std::string& result,
+    void const* message, std::size_t size,
+        char const* const alphabet)
+{
+    auto pbegin = reinterpret_cast<
+        unsigned char const*>(message);
+    auto const pend = pbegin + size;
+    // Skip & count leading zeroes.
+    std::size_t zeroes = 0;
+    while (pbegin != pend && *pbegin == 0)
+    {
+        pbegin++;
+        zeroes++;
+    }
+    auto const bytes = static_cast<std::size_t>(pend - pbegin);
+    if (bytes > base58MaxBytes)
+        return false;
+
+    // Gather the big-endian bytes into limbs
+    std::uint64_t limbs[base58MaxLimbs];
+    auto count = (bytes + 7) / 8;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        auto const last = bytes - 8 * i;
+        auto const first = last > 8 ? last - 8 : 0;
+        std::uint64_t limb = 0;
+        for (auto j = first; j != last; ++j)
+            limb = (limb << 8) | pbegin[j];
+        limbs[i] = limb;
+    }
+
+    // Divide by 58^10 until nothing is left. The remainders are
+    // the chunks of ten digits, least significant first.
+    std::uint64_t chunks[base58MaxLimbs + 3];
+    std::size_t chunkCount = 0;
+    while (count != 0)
+    {
+        std::uint64_t rem = 0;
+        for (auto i = count; i-- != 0;)
+        {
+            auto const cur = (static_cast<unsigned __int128>(rem) << 64) | limbs[i];
+            auto const quot = static_cast<std::uint64_t>(cur / base58Chunk);
+            rem = limbs[i] - quot * base58Chunk;
+            limbs[i] = quot;
+        }
+        chunks[chunkCount++] = rem;
+        while (count != 0 && limbs[count - 1] == 0)
+            --count;
+    }
+
+    // Split the chunks into digits, least significant first
+    unsigned char digits[base58ChunkDigits * (base58MaxLimbs + 3)];
+    std::size_t digitCount = 0;
+    for (std::size_t i = 0; i != chunkCount; ++i)
+    {
+        auto chunk = chunks[i];
+        for (std::size_t j = 0; j != base58ChunkDigits; ++j)
+        {
+            digits[digitCount++] = chunk % 58;
+            chunk /= 58;
+        }
+    }
+    // Skip leading zeroes in base58 result.
+    while (digitCount != 0 && digits[digitCount - 1] == 0)
+        --digitCount;
+
+    result.reserve(zeroes + digitCount);
+    result.assign(zeroes, alphabet[0]);
+    while (digitCount != 0)
+        result += alphabet[digits[--digitCount]];
+    return true;
+}
+
+#else
+#define RIPPLE_BASE58_FAST 0
+#endif
+
+static
+std::string
+encodeBase58(
+    void const* message, std::size_t size,
+        void *temp, char const* const alphabet)
+{
+#if RIPPLE_BASE58_FAST
+    std::string result;
+    if (encodeBase58Fast(result, message, size, alphabet))
+        return result;
+#endif
+    return encodeBase58Reference(message, size, temp, alphabet);
+}
+
 static
 std::string
 encodeToken (std::uint8_t type,
@@ -203,7 +312,7 @@ base58EncodeTokenBitcoin (std::uint8_t type,
 template <class InverseArray>
 static
 std::string
-decodeBase58 (std::string const& s,
+decodeBase58Reference (std::string const& s,
     InverseArray const& inv)
 {
     auto psz = s.c_str();
@@ -249,6 +358,101 @@ decodeBase58 (std::string const& s,
     return result;
 }
 
+#if RIPPLE_BASE58_FAST
+
+template <class InverseArray>
+static
+bool
+decodeBase58Fast (std::string& result,
+    std::string const& s, InverseArray const& inv)
+{
+    auto psz = s.c_str();
+    auto remain = s.size();
+    // Skip and count leading zeroes
+    std::size_t zeroes = 0;
+    while (remain > 0 && inv[*psz] == 0)
+    {
+        ++zeroes;
+        ++psz;
+        --remain;
+    }
+    if (remain > base58MaxDigits)
+        return false;
+
+    // Apply "limbs = limbs * 58^n + chunk" for each chunk of up to ten
+    // digits, most significant first. The first chunk takes whatever
+    // does not divide evenly.
+    std::uint64_t limbs[base58MaxLimbs];
+    std::size_t count = 0;
+    auto n = remain % base58ChunkDigits;
+    if (n == 0)
+        n = base58ChunkDigits;
+    while (remain > 0)
+    {
+        std::uint64_t chunk = 0;
+        std::uint64_t scale = 1;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            auto const digit = inv[*psz++];
+            if (digit == -1)
+            {
+                result.clear();
+                return true;
+            }
+            chunk = chunk * 58 + digit;
+            scale *= 58;
+        }
+        remain -= n;
+        n = base58ChunkDigits;
+
+        auto carry = chunk;
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            auto const cur = static_cast<unsigned __int128>(limbs[i]) * scale + carry;
+            limbs[i] = static_cast<std::uint64_t>(cur);
+            carry = static_cast<std::uint64_t>(cur >> 64);
+        }
+        if (carry != 0)
+        {
+            assert(count < base58MaxLimbs);
+            limbs[count++] = carry;
+        }
+    }
+
+    // Lay the limbs out big-endian, skipping leading zeroes.
+    result.reserve(zeroes + 8 * count);
+    result.assign(zeroes, 0x00);
+    bool leading = true;
+    for (auto i = count; i-- != 0;)
+    {
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+            auto const c = static_cast<char>(limbs[i] >> shift);
+            if (leading && c == 0)
+                continue;
+            leading = false;
+            result.push_back(c);
+        }
+    }
+    return true;
+}
+
+#endif
+
+template <class InverseArray>
+static
+std::string
+decodeBase58 (std::string const& s,
+    InverseArray const& inv)
+{
+#if RIPPLE_BASE58_FAST
+    std::string result;
+    if (decodeBase58Fast(result, s, inv))
+        return result;
+#endif
+    return decodeBase58Reference(s, inv);
+}
+
 /*  Base58 decode a Ripple token
 
     The type and checksum are are checked
@@ -329,4 +533,31 @@ decodeBase58TokenBitcoin(
         s, type, bitcoinInverse);
 }
 
+//------------------------------------------------------------------------------
+
+namespace detail {
+
+std::string
+encodeBase58 (void const* message,
+    std::size_t size, bool reference)
+{
+    // log(256) / log(58), rounded up.
+    std::vector<char> temp (size * (138 / 100 + 1));
+    if (reference)
+        return encodeBase58Reference(
+            message, size, temp.data(), rippleAlphabet);
+    return ripple::encodeBase58(
+        message, size, temp.data(), rippleAlphabet);
+}
+
+std::string
+decodeBase58 (std::string const& s, bool reference)
+{
+    if (reference)
+        return decodeBase58Reference(s, rippleInverse);
+    return ripple::decodeBase58(s, rippleInverse);
+}
+
+} // detail
+
 } // ripple
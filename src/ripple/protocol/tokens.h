@@ -113,6 +113,25 @@ std::string
 decodeBase58TokenBitcoin(
     std::string const& s, int type);
 
+namespace detail {
+
+/*  Base-58 encode or decode, in the Ripple alphabet,
+    without a type or checksum.
+
+    When `reference` is set the simple byte-at-a-time
+    conversion is used, rather than the faster one used
+    for tokens. This is exposed for testing.
+*/
+std::string
+encodeBase58 (void const* message,
+    std::size_t size, bool reference = false);
+
+std::string
+decodeBase58 (std::string const& s,
+    bool reference = false);
+
+} // detail
+
 } // ripple
 
 #endif
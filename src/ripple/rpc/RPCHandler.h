@@ -25,6 +25,10 @@
 #include <ripple/rpc/Context.h>
 #include <ripple/rpc/Status.h>
 
+namespace Json {
+class Object;
+}
+
 namespace ripple {
 namespace RPC {
 
@@ -33,6 +37,17 @@ struct Context;
 /** Execute an RPC command and store the results in a Json::Value. */
 Status doCommand (RPC::Context&, Json::Value&);
 
+/** Execute an RPC command and write the results to a Json::Object.
+
+    Only commands for which canStream() is true can be executed this way.
+    Any error is reported through the returned Status as well as being
+    written to the object.
+*/
+Status doCommand (RPC::Context&, Json::Object&);
+
+/** Returns `true` if the method can write its result as it goes. */
+bool canStream (std::string const& method);
+
 Role roleRequired (std::string const& method );
 
 } // RPC
@@ -39,14 +39,15 @@ struct VisitData
     AccountID const& raPeerAccount;
 };
 
-void addLine (Json::Value& jsonLines, RippleState const& line)
+void addLine (Json::Value& jsonLines, RippleState const& line,
+    AccountIDCache const& accountIDCache)
 {
     STAmount const& saBalance (line.getBalance ());
     STAmount const& saLimit (line.getLimit ());
     STAmount const& saLimitPeer (line.getLimitPeer ());
     Json::Value& jPeer (jsonLines.append (Json::objectValue));
 
-    jPeer[jss::account] = to_string (line.getAccountIDPeer ());
+    jPeer[jss::account] = accountIDCache.toBase58 (line.getAccountIDPeer ());
     // Amount reported is positive if current account holds other
     // account's IOUs.
     //
@@ -156,7 +157,7 @@ Json::Value doAccountLines (RPC::Context& context)
         if (line == nullptr)
             return rpcError (rpcINVALID_PARAMS);
 
-        addLine (jsonLines, *line);
+        addLine (jsonLines, *line, context.app.accountIDCache());
         visitData.items.reserve (reserve);
     }
     else
@@ -200,7 +201,7 @@ Json::Value doAccountLines (RPC::Context& context)
     result[jss::account] = context.app.accountIDCache().toBase58 (accountID);
 
     for (auto const& item : visitData.items)
-        addLine (jsonLines, *item.get ());
+        addLine (jsonLines, *item.get (), context.app.accountIDCache());
 
     context.loadType = Resource::feeMediumBurdenRPC;
     return result;
@@ -23,6 +23,7 @@
 #include <ripple/app/ledger/LedgerMaster.h>
 #include <ripple/app/main/Application.h>
 #include <ripple/app/misc/NetworkOPs.h>
+#include <ripple/app/paths/PathRequests.h>
 #include <ripple/basics/UptimeTimer.h>
 #include <ripple/core/DatabaseCon.h>
 #include <ripple/json/json_value.h>
@@ -32,6 +33,7 @@
 #include <ripple/protocol/ErrorCodes.h>
 #include <ripple/protocol/JsonFields.h>
 #include <ripple/rpc/Context.h>
+#include <ripple/shamap/SHAMapTreeNode.h>
 
 namespace ripple {
 
@@ -110,6 +112,26 @@ Json::Value doGetCounts (RPC::Context& context)
     ret[jss::treenode_cache_size] = context.app.family().treecache().getCacheSize();
     ret[jss::treenode_track_size] = context.app.family().treecache().getTrackSize();
 
+    {
+        // Inner nodes only store the branches they have, so report the
+        // average size alongside the size of a node with every branch.
+        auto const usage = SHAMapInnerNode::getMemoryUsage ();
+        ret[jss::inner_nodes] = static_cast<Json::UInt> (usage.nodes);
+        if (usage.nodes > 0)
+            ret[jss::inner_node_bytes] =
+                static_cast<Json::UInt> (usage.bytes / usage.nodes);
+        ret[jss::inner_node_full_bytes] =
+            static_cast<Json::UInt> (SHAMapInnerNode::fullSize ());
+    }
+
+    {
+        // Time from each path request's creation to its first fast
+        // and first full reply.
+        auto const& paths = context.app.getPathRequests ();
+        ret[jss::path_find_fast] = paths.getFastLatency ().getJson ();
+        ret[jss::path_find_full] = paths.getFullLatency ().getJson ();
+    }
+
     std::string uptime;
     int s = UptimeTimer::getInstance ().getElapsedSeconds ();
     textTime (uptime, s, "year", 365 * 24 * 60 * 60);
@@ -124,6 +146,10 @@ Json::Value doGetCounts (RPC::Context& context)
     ret[jss::node_reads_hit] = context.app.getNodeStore().getFetchHitCount();
     ret[jss::node_written_bytes] = context.app.getNodeStore().getStoreSize();
     ret[jss::node_read_bytes] = context.app.getNodeStore().getFetchSize();
+    ret[jss::node_filter_hits] =
+        context.app.getNodeStore().getFilterHitCount();
+    ret[jss::node_filter_false_positives] =
+        context.app.getNodeStore().getFilterFalsePositiveCount();
 
     return ret;
 }
@@ -20,6 +20,7 @@
 #ifndef RIPPLE_RPC_HANDLERS_HANDLERS_H_INCLUDED
 #define RIPPLE_RPC_HANDLERS_HANDLERS_H_INCLUDED
 
+#include <ripple/rpc/handlers/LedgerDataHandler.h>
 #include <ripple/rpc/handlers/LedgerHandler.h>
 
 namespace ripple {
@@ -49,7 +50,6 @@ Json::Value doLedgerAccept          (RPC::Context&);
 Json::Value doLedgerCleaner         (RPC::Context&);
 Json::Value doLedgerClosed          (RPC::Context&);
 Json::Value doLedgerCurrent         (RPC::Context&);
-Json::Value doLedgerData            (RPC::Context&);
 Json::Value doLedgerEntry           (RPC::Context&);
 Json::Value doLedgerHeader          (RPC::Context&);
 Json::Value doLedgerRequest         (RPC::Context&);
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_RPC_HANDLERS_LEDGERDATA_H_INCLUDED
+#define RIPPLE_RPC_HANDLERS_LEDGERDATA_H_INCLUDED
+
+#include <ripple/app/ledger/LedgerToJson.h>
+#include <ripple/ledger/ReadView.h>
+#include <ripple/json/Object.h>
+#include <ripple/protocol/JsonFields.h>
+#include <ripple/rpc/Context.h>
+#include <ripple/rpc/Status.h>
+#include <ripple/rpc/impl/Handler.h>
+#include <ripple/rpc/Role.h>
+
+namespace ripple {
+namespace RPC {
+
+struct Context;
+
+// Get state nodes from a ledger
+//   Inputs:
+//     limit:        integer, maximum number of entries
+//     marker:       opaque, resume point
+//     binary:       boolean, format
+//     type:         string // optional, defaults to all ledger node types
+//   Outputs:
+//     ledger_hash:  chosen ledger's hash
+//     ledger_index: chosen ledger's index
+//     state:        array of state nodes
+//     marker:       resume point, if any
+//
+// Admins may ask for any number of entries, so the state nodes are
+// written one at a time to allow the response to be streamed.
+
+class LedgerDataHandler {
+public:
+    explicit LedgerDataHandler (Context&);
+
+    Status check ();
+
+    template <class Object>
+    void writeResult (Object&);
+
+    static const char* const name()
+    {
+        return "ledger_data";
+    }
+
+    static Role role()
+    {
+        return Role::USER;
+    }
+
+    static Condition condition()
+    {
+        return NO_CONDITION;
+    }
+
+private:
+    Context& context_;
+    std::shared_ptr<ReadView const> ledger_;
+    Json::Value result_;
+    ReadView::key_type key_;
+    bool isMarker_ = false;
+    bool isBinary_ = false;
+    int limit_ = -1;
+    LedgerEntryType type_ = ltINVALID;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Implementation.
+
+template <class Object>
+void LedgerDataHandler::writeResult (Object& value)
+{
+    Json::copyFrom (value, result_);
+
+    if (! isMarker_)
+    {
+        // Return base ledger data on first query
+        value[jss::ledger] = getJson (
+            LedgerFill (*ledger_, isBinary_ ?
+                LedgerFill::Options::binary : 0));
+    }
+
+    std::string marker;
+    {
+        auto&& nodes = Json::setArray (value, jss::state);
+        auto limit = limit_;
+
+        auto e = ledger_->sles.end();
+        for (auto i = ledger_->sles.upper_bound(key_); i != e; ++i)
+        {
+            auto sle = ledger_->read(keylet::unchecked((*i)->key()));
+            if (limit-- <= 0)
+            {
+                // Stop processing before the current key.
+                auto k = sle->key();
+                marker = to_string(--k);
+                break;
+            }
+
+            if (type_ == ltINVALID || sle->getType () == type_)
+            {
+                if (isBinary_)
+                {
+                    auto&& entry = Json::appendObject (nodes);
+                    entry[jss::data] = serializeHex(*sle);
+                    entry[jss::index] = to_string(sle->key());
+                }
+                else
+                {
+                    auto entry = sle->getJson (0);
+                    entry[jss::index] = to_string(sle->key());
+                    nodes.append (entry);
+                }
+            }
+        }
+    }
+
+    if (! marker.empty ())
+        value[jss::marker] = marker;
+}
+
+} // RPC
+} // ripple
+
+#endif
@@ -71,6 +71,7 @@ class HandlerTable {
 
         // This is where the new-style handlers are added.
         addHandler<LedgerHandler>();
+        addHandler<LedgerDataHandler>();
         addHandler<VersionHandler>();
     }
 
@@ -90,6 +91,7 @@ class HandlerTable {
         Handler h;
         h.name_ = HandlerImpl::name();
         h.valueMethod_ = &handle<Json::Value, HandlerImpl>;
+        h.objectMethod_ = &handle<Json::Object, HandlerImpl>;
         h.role_ = HandlerImpl::role();
         h.condition_ = HandlerImpl::condition();
 
@@ -123,7 +125,6 @@ Handler handlerArray[] {
     {   "ledger_cleaner",       byRef (&doLedgerCleaner),       Role::ADMIN,   NEEDS_NETWORK_CONNECTION  },
     {   "ledger_closed",        byRef (&doLedgerClosed),        Role::USER,  NO_CONDITION   },
     {   "ledger_current",       byRef (&doLedgerCurrent),       Role::USER,  NEEDS_CURRENT_LEDGER  },
-    {   "ledger_data",          byRef (&doLedgerData),          Role::USER,  NO_CONDITION  },
     {   "ledger_entry",         byRef (&doLedgerEntry),         Role::USER,  NO_CONDITION  },
     {   "ledger_header",        byRef (&doLedgerHeader),        Role::USER,  NO_CONDITION  },
     {   "ledger_request",       byRef (&doLedgerRequest),       Role::ADMIN,   NO_CONDITION     },
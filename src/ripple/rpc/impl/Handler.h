@@ -48,6 +48,9 @@ struct Handler
     Method<Json::Value> valueMethod_;
     Role role_;
     RPC::Condition condition_;
+
+    // Only set for handlers which can write their result as they go
+    Method<Json::Object> objectMethod_;
 };
 
 const Handler* getHandler (std::string const&);
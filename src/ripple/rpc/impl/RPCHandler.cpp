@@ -226,10 +226,9 @@ void getResult (
     }
 }
 
-} // namespace
-
-Status doCommand (
-    RPC::Context& context, Json::Value& result)
+template <class Object, class Method>
+Status runCommand (RPC::Context& context, Object& result,
+    Method Handler::* member)
 {
     Handler const * handler = nullptr;
     if (auto error = fillHandler (context, handler))
@@ -238,7 +237,7 @@ Status doCommand (
         return error;
     }
 
-    if (auto method = handler->valueMethod_)
+    if (auto method = handler->*member)
     {
         if (! context.headers.user.empty() ||
             ! context.headers.forwardedFor.empty())
@@ -261,9 +260,30 @@ Status doCommand (
         }
     }
 
+    inject_error (rpcUNKNOWN_COMMAND, result);
     return rpcUNKNOWN_COMMAND;
 }
 
+} // namespace
+
+Status doCommand (
+    RPC::Context& context, Json::Value& result)
+{
+    return runCommand (context, result, &Handler::valueMethod_);
+}
+
+Status doCommand (
+    RPC::Context& context, Json::Object& result)
+{
+    return runCommand (context, result, &Handler::objectMethod_);
+}
+
+bool canStream (std::string const& method)
+{
+    auto handler = RPC::getHandler(method);
+    return handler && handler->objectMethod_;
+}
+
 Role roleRequired (std::string const& method)
 {
     auto handler = RPC::getHandler(method);
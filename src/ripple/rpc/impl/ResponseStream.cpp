@@ -0,0 +1,293 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/rpc/impl/ResponseStream.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace ripple {
+namespace RPC {
+
+class ResponseStream::HTTPWriter : public Writer
+{
+    std::shared_ptr<ResponseStream> stream_;
+    buffers_type data_;
+
+public:
+    explicit
+    HTTPWriter (std::shared_ptr<ResponseStream> stream)
+        : stream_ (std::move (stream))
+    {
+    }
+
+    ~HTTPWriter () override
+    {
+        stream_->abort ();
+    }
+
+    bool
+    complete () override
+    {
+        std::lock_guard<std::mutex> lock (stream_->mutex_);
+        return stream_->finished_ && stream_->queued_ == 0;
+    }
+
+    void
+    consume (std::size_t bytes) override
+    {
+        stream_->consume (bytes);
+    }
+
+    bool
+    prepare (std::size_t bytes,
+        std::function<void(void)> resume) override
+    {
+        auto result = stream_->prepare (bytes, std::move (resume));
+        if (boost::indeterminate (result.first))
+            return false;
+        data_ = std::move (result.second);
+        return true;
+    }
+
+    std::vector<boost::asio::const_buffer>
+    data () override
+    {
+        return data_;
+    }
+};
+
+class ResponseStream::StreamWSMsg : public WSMsg
+{
+    std::shared_ptr<ResponseStream> stream_;
+    std::size_t n_ = 0;
+
+public:
+    explicit
+    StreamWSMsg (std::shared_ptr<ResponseStream> stream)
+        : stream_ (std::move (stream))
+    {
+    }
+
+    ~StreamWSMsg () override
+    {
+        stream_->abort ();
+    }
+
+    std::pair<boost::tribool,
+        std::vector<boost::asio::const_buffer>>
+    prepare (std::size_t bytes,
+        std::function<void(void)> resume) override
+    {
+        // Each call means the previous frame has been written
+        stream_->consume (n_);
+        auto result = stream_->prepare (bytes, std::move (resume));
+        n_ = boost::asio::buffer_size (result.second);
+        return result;
+    }
+};
+
+//------------------------------------------------------------------------------
+
+ResponseStream::ResponseStream (std::shared_ptr<JobQueue::Coro> coro,
+        std::string header, std::size_t blockSize, std::size_t limit)
+    : coro_ (std::move (coro))
+    , blockSize_ (blockSize)
+    , limit_ (limit)
+    , header_ (std::move (header))
+    , chunked_ (! header_.empty ())
+{
+    pending_.reserve (blockSize_);
+}
+
+Json::Output
+ResponseStream::output ()
+{
+    return [this](boost::string_ref const& s)
+    {
+        write (s);
+    };
+}
+
+void
+ResponseStream::write (boost::string_ref const& s)
+{
+    pending_.append (s.data (), s.size ());
+    if (pending_.size () >= blockSize_)
+        commit (false);
+}
+
+bool
+ResponseStream::discard ()
+{
+    if (size_ != 0)
+        return false;
+    pending_.clear ();
+    header_.clear ();
+    chunked_ = false;
+    return true;
+}
+
+void
+ResponseStream::finish ()
+{
+    commit (true);
+}
+
+std::shared_ptr<Writer>
+ResponseStream::makeWriter ()
+{
+    return std::make_shared<HTTPWriter> (shared_from_this ());
+}
+
+std::shared_ptr<WSMsg>
+ResponseStream::makeWSMsg ()
+{
+    return std::make_shared<StreamWSMsg> (shared_from_this ());
+}
+
+void
+ResponseStream::commit (bool last)
+{
+    std::string block = std::move (header_);
+    header_.clear ();
+
+    if (chunked_)
+    {
+        if (! pending_.empty ())
+        {
+            char size[20];
+            auto const n = std::snprintf (size, sizeof (size),
+                "%zx\r\n", pending_.size ());
+            block.append (size, n);
+            block.append (pending_);
+            block.append ("\r\n");
+        }
+        if (last)
+            block.append ("0\r\n\r\n");
+    }
+    else
+    {
+        block.append (pending_);
+    }
+    pending_.clear ();
+    size_ += block.size ();
+
+    std::function<void(void)> resume;
+    bool wait = false;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        if (last)
+            finished_ = true;
+        if (aborted_)
+            return;
+        if (! block.empty ())
+        {
+            queued_ += block.size ();
+            blocks_.push_back (std::move (block));
+        }
+        resume.swap (resume_);
+        wait = ! last && queued_ > limit_;
+        waiting_ = wait;
+    }
+
+    if (resume)
+        resume ();
+
+    // Resumed by consume() once the session has caught up
+    if (wait)
+        coro_->yield ();
+}
+
+std::pair<boost::tribool, ResponseStream::buffers_type>
+ResponseStream::prepare (std::size_t bytes, std::function<void(void)> resume)
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    if (queued_ == 0)
+    {
+        if (finished_ || aborted_)
+            return {true, {}};
+        resume_ = std::move (resume);
+        return {boost::indeterminate, {}};
+    }
+
+    buffers_type buffers;
+    std::size_t n = 0;
+    auto offset = offset_;
+    for (auto const& b : blocks_)
+    {
+        if (n >= bytes)
+            break;
+        auto const len = std::min (b.size () - offset, bytes - n);
+        buffers.emplace_back (b.data () + offset, len);
+        n += len;
+        offset = 0;
+    }
+    return {finished_ && n == queued_, std::move (buffers)};
+}
+
+void
+ResponseStream::consume (std::size_t bytes)
+{
+    bool post = false;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        queued_ -= std::min (bytes, queued_);
+        while (bytes > 0 && ! blocks_.empty ())
+        {
+            auto const left = blocks_.front ().size () - offset_;
+            if (bytes < left)
+            {
+                offset_ += bytes;
+                break;
+            }
+            bytes -= left;
+            blocks_.pop_front ();
+            offset_ = 0;
+        }
+        if (waiting_ && queued_ <= limit_ / 2)
+        {
+            waiting_ = false;
+            post = true;
+        }
+    }
+    if (post)
+        coro_->post ();
+}
+
+void
+ResponseStream::abort ()
+{
+    std::function<void(void)> resume;
+    bool post = false;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        aborted_ = true;
+        blocks_.clear ();
+        offset_ = 0;
+        queued_ = 0;
+        resume.swap (resume_);
+        std::swap (post, waiting_);
+    }
+    if (post)
+        coro_->post ();
+}
+
+} // RPC
+} // ripple
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_RPC_RESPONSESTREAM_H_INCLUDED
+#define RIPPLE_RPC_RESPONSESTREAM_H_INCLUDED
+
+#include <ripple/core/JobQueue.h>
+#include <ripple/json/Output.h>
+#include <ripple/server/Writer.h>
+#include <ripple/server/WSSession.h>
+#include <boost/asio/buffer.hpp>
+#include <boost/logic/tribool.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ripple {
+namespace RPC {
+
+/** Carries a response from the coroutine producing it to the session
+    sending it.
+
+    The coroutine writes the response through output() as it is generated.
+    Output is gathered into blocks which the session drains through the
+    Writer or WSMsg returned by makeWriter() or makeWSMsg(). When more than
+    `limit` bytes are waiting to be sent, the coroutine yields until the
+    session has caught up, so a response holds a bounded amount of memory
+    however large it is.
+
+    If a header is given, the body is sent with HTTP chunked transfer
+    encoding and the header goes out ahead of the first chunk.
+
+    Nothing is sent until the first block fills. Until then the response
+    can be discarded and replaced, which lets short error replies keep their
+    usual form.
+
+    If the session goes away, further output is dropped.
+*/
+class ResponseStream
+    : public std::enable_shared_from_this<ResponseStream>
+{
+public:
+    ResponseStream (std::shared_ptr<JobQueue::Coro> coro,
+        std::string header, std::size_t blockSize, std::size_t limit);
+
+    ResponseStream (ResponseStream const&) = delete;
+    ResponseStream& operator= (ResponseStream const&) = delete;
+
+    /** Returns an Output which appends to the response. */
+    Json::Output
+    output ();
+
+    /** Append to the response. May yield the coroutine. */
+    void
+    write (boost::string_ref const& s);
+
+    /** Drop everything written so far.
+
+        After a successful discard the header and chunked encoding are
+        dropped too; whatever is written next is sent as is.
+
+        @return `false` if some of the response was already sent.
+    */
+    bool
+    discard ();
+
+    /** Send whatever remains of the response. */
+    void
+    finish ();
+
+    /** Returns the number of bytes handed to the session so far. */
+    std::size_t
+    size () const
+    {
+        return size_;
+    }
+
+    /** Returns a Writer which sends the response over HTTP. */
+    std::shared_ptr<Writer>
+    makeWriter ();
+
+    /** Returns a message which sends the response over a WebSocket. */
+    std::shared_ptr<WSMsg>
+    makeWSMsg ();
+
+private:
+    class HTTPWriter;
+    class StreamWSMsg;
+
+    using buffers_type = std::vector<boost::asio::const_buffer>;
+
+    void
+    commit (bool last);
+
+    std::pair<boost::tribool, buffers_type>
+    prepare (std::size_t bytes, std::function<void(void)> resume);
+
+    void
+    consume (std::size_t bytes);
+
+    void
+    abort ();
+
+    std::shared_ptr<JobQueue::Coro> const coro_;
+    std::size_t const blockSize_;
+    std::size_t const limit_;
+
+    // Only touched by the producer
+    std::string header_;
+    std::string pending_;
+    bool chunked_;
+    std::size_t size_ = 0;
+
+    std::mutex mutex_;
+    std::deque<std::string> blocks_;
+    std::size_t offset_ = 0;    // consumed bytes of the front block
+    std::size_t queued_ = 0;    // bytes not yet consumed
+    std::function<void(void)> resume_;
+    bool waiting_ = false;      // the producer is yielding
+    bool finished_ = false;
+    bool aborted_ = false;
+};
+
+} // RPC
+} // ripple
+
+#endif
@@ -23,6 +23,7 @@
 #include <ripple/beast/rfc2616.h>
 #include <ripple/beast/net/IPAddressConversion.h>
 #include <ripple/json/json_reader.h>
+#include <ripple/json/Object.h>
 #include <ripple/rpc/json_body.h>
 #include <ripple/rpc/ServerHandler.h>
 #include <ripple/server/Server.h>
@@ -37,6 +38,7 @@
 #include <ripple/overlay/Overlay.h>
 #include <ripple/resource/ResourceManager.h>
 #include <ripple/resource/Fees.h>
+#include <ripple/rpc/impl/ResponseStream.h>
 #include <ripple/rpc/impl/Tuning.h>
 #include <ripple/rpc/RPCHandler.h>
 #include <ripple/server/SimpleWriter.h>
@@ -323,8 +325,13 @@ ServerHandlerImp::onWSMessage(
 {
     Json::Value jv;
     auto const size = boost::asio::buffer_size(buffers);
-    if (size > RPC::Tuning::maxRequestSize ||
-        ! Json::Reader{}.parse(jv, buffers) ||
+    bool parsed = false;
+    if (size <= RPC::Tuning::maxRequestSize)
+    {
+        Json::ScopedArena arena;
+        parsed = Json::Reader{}.parse(jv, buffers);
+    }
+    if (! parsed ||
         ! jv ||
         ! jv.isObject())
     {
@@ -354,6 +361,8 @@ ServerHandlerImp::onWSMessage(
         [this, session = std::move(session),
             jv = std::move(jv)](auto const& c)
         {
+            if (this->streamSession(session, c, jv))
+                return;
             auto const jr =
                 this->processSession(session, c, jv);
             auto const s = to_string(jr);
@@ -488,12 +497,120 @@ ServerHandlerImp::processSession(
     return jr;
 }
 
+// Run as a coroutine.
+//
+// Commands which write their result as they go are sent as a fragmented
+// message while they run. Returns `false`, having done nothing, for any
+// other request.
+bool
+ServerHandlerImp::streamSession(
+    std::shared_ptr<WSSession> const& session,
+        std::shared_ptr<JobQueue::Coro> const& coro,
+            Json::Value const& jv)
+{
+    // Unusual requests are left to processSession
+    if (! coro || ! jv.isMember(jss::command) || jv.isMember(jss::method))
+        return false;
+
+    auto const command = jv[jss::command].asString();
+    if (! RPC::canStream(command))
+        return false;
+
+    auto is = std::static_pointer_cast<WSInfoSub> (session->appDefined);
+    if (is->getConsumer().disconnect())
+        return false;
+
+    auto role = requestRole(
+        RPC::roleRequired(command),
+        session->port(),
+        jv,
+        beast::IP::from_asio(session->remote_endpoint().address()),
+        is->user());
+    if (Role::FORBID == role)
+        return false;
+
+    Resource::Charge loadType = Resource::feeReferenceRPC;
+    RPC::Context context{
+        app_.journal("RPCHandler"),
+        jv,
+        app_,
+        loadType,
+        app_.getOPs(),
+        app_.getLedgerMaster(),
+        is->getConsumer(),
+        role,
+        coro,
+        is,
+        {is->user(), is->forwarded_for()}
+        };
+
+    auto stream = std::make_shared<RPC::ResponseStream>(coro,
+        std::string{}, RPC::Tuning::streamBlockSize,
+            RPC::Tuning::streamQueueLimit);
+    session->send(stream->makeWSMsg());
+
+    RPC::Status status;
+    {
+        Json::Writer writer(stream->output());
+        Json::Object::Root jr(writer);
+        {
+            auto result = Json::addObject(jr, jss::result);
+            status = RPC::doCommand(context, result);
+        }
+
+        is->getConsumer().charge(loadType);
+        if (is->getConsumer().warn())
+            jr[jss::warning] = jss::load;
+
+        if (status)
+        {
+            jr[jss::status] = jss::error;
+            jr[jss::request] = jv;
+        }
+        else
+        {
+            jr[jss::status] = jss::success;
+        }
+
+        if (jv.isMember(jss::id))
+            jr[jss::id] = jv[jss::id];
+        if (jv.isMember(jss::jsonrpc))
+            jr[jss::jsonrpc] = jv[jss::jsonrpc];
+        if (jv.isMember(jss::ripplerpc))
+            jr[jss::ripplerpc] = jv[jss::ripplerpc];
+        jr[jss::type] = jss::response;
+    }
+
+    // Errors are found before the result is written, so unless the
+    // handler threw part way through, the reply can still be replaced
+    // with the unwrapped form processSession uses.
+    if (status && stream->discard())
+    {
+        Json::Value jr(Json::objectValue);
+        status.inject(jr);
+        jr[jss::status] = jss::error;
+        jr[jss::request] = jv;
+        if (jv.isMember(jss::id))
+            jr[jss::id] = jv[jss::id];
+        if (jv.isMember(jss::jsonrpc))
+            jr[jss::jsonrpc] = jv[jss::jsonrpc];
+        if (jv.isMember(jss::ripplerpc))
+            jr[jss::ripplerpc] = jv[jss::ripplerpc];
+        jr[jss::type] = jss::response;
+        Json::outputJson(jr, stream->output());
+    }
+
+    stream->finish();
+    session->complete();
+    return true;
+}
+
 // Run as a coroutine.
 void
 ServerHandlerImp::processSession (std::shared_ptr<Session> const& session,
     std::shared_ptr<JobQueue::Coro> coro)
 {
-    processRequest (
+    if (processRequest (
         session->port(), buffers_to_string(
             session->request().body.data()),
                 session->remoteAddress().at_port (0),
@@ -515,7 +632,11 @@ ServerHandlerImp::processSession (std::shared_ptr<Session> const& session,
             if(iter != session->request().end())
                 return iter->value().to_string();
             return std::string{};
-        }());
+        }(),
+        session))
+    {
+        return;
+    }
 
     if(beast::rfc2616::is_keep_alive(session->request()))
         session->complete();
@@ -523,16 +644,18 @@ ServerHandlerImp::processSession (std::shared_ptr<Session> const& session,
         session->close (true);
 }
 
-void
+bool
 ServerHandlerImp::processRequest (Port const& port,
     std::string const& request, beast::IP::Endpoint const& remoteIPAddress,
         Output&& output, std::shared_ptr<JobQueue::Coro> coro,
-        std::string forwardedFor, std::string user)
+        std::string forwardedFor, std::string user,
+        std::shared_ptr<Session> const& session)
 {
     auto rpcJ = app_.journal ("RPC");
 
     Json::Value jsonRPC;
     {
+        Json::ScopedArena arena;
         Json::Reader reader;
         if ((request.size () > RPC::Tuning::maxRequestSize) ||
             ! reader.parse (request, jsonRPC) ||
@@ -540,7 +663,7 @@ ServerHandlerImp::processRequest (Port const& port,
             ! jsonRPC.isObject ())
         {
             HTTPReply (400, "Unable to parse request", output, rpcJ);
-            return;
+            return false;
         }
     }
 
@@ -576,7 +699,7 @@ ServerHandlerImp::processRequest (Port const& port,
         if (usage.disconnect())
         {
             HTTPReply(503, "Server is overloaded", output, rpcJ);
-            return;
+            return false;
         }
     }
 
@@ -584,21 +707,21 @@ ServerHandlerImp::processRequest (Port const& port,
     {
         usage.charge(Resource::feeInvalidRPC);
         HTTPReply (403, "Forbidden", output, rpcJ);
-        return;
+        return false;
     }
 
     if (! method)
     {
         usage.charge(Resource::feeInvalidRPC);
         HTTPReply (400, "Null method", output, rpcJ);
-        return;
+        return false;
     }
 
     if (! method.isString ())
     {
         usage.charge(Resource::feeInvalidRPC);
         HTTPReply (400, "method is not string", output, rpcJ);
-        return;
+        return false;
     }
 
     std::string strMethod = method.asString ();
@@ -606,7 +729,7 @@ ServerHandlerImp::processRequest (Port const& port,
     {
         usage.charge(Resource::feeInvalidRPC);
         HTTPReply (400, "method is empty", output, rpcJ);
-        return;
+        return false;
     }
 
     // Extract request parameters from the request Json as `params`.
@@ -624,7 +747,7 @@ ServerHandlerImp::processRequest (Port const& port,
     {
         usage.charge(Resource::feeInvalidRPC);
         HTTPReply (400, "params unparseable", output, rpcJ);
-        return;
+        return false;
     }
     else
     {
@@ -633,7 +756,7 @@ ServerHandlerImp::processRequest (Port const& port,
         {
             usage.charge(Resource::feeInvalidRPC);
             HTTPReply (400, "params unparseable", output, rpcJ);
-            return;
+            return false;
         }
     }
 
@@ -660,6 +783,60 @@ ServerHandlerImp::processRequest (Port const& port,
     RPC::Context context {m_journal, params, app_, loadType, m_networkOPs,
         app_.getLedgerMaster(), usage, role, coro, InfoSub::pointer(),
         {user, forwardedFor}};
+
+    // Chunked encoding needs HTTP/1.1
+    if (session && coro && RPC::canStream (strMethod) &&
+        session->request().version >= 11)
+    {
+        auto stream = std::make_shared<RPC::ResponseStream> (coro,
+            HTTPChunkedHeader (), RPC::Tuning::streamBlockSize,
+                RPC::Tuning::streamQueueLimit);
+        session->write (stream->makeWriter (),
+            beast::rfc2616::is_keep_alive (session->request()));
+
+        {
+            Json::Writer writer (stream->output ());
+            Json::Object::Root reply (writer);
+            {
+                auto result = Json::addObject (reply, jss::result);
+                if (auto status = RPC::doCommand (context, result))
+                {
+                    result[jss::status] = jss::error;
+                    result[jss::request] = params;
+                    JLOG (m_journal.debug())  <<
+                        "rpcError: " << status.toString ();
+                }
+                else
+                {
+                    result[jss::status] = jss::success;
+                }
+
+                usage.charge (loadType);
+                if (usage.warn())
+                    result[jss::warning] = jss::load;
+            }
+            if (jsonRPC.isMember(jss::jsonrpc))
+                reply[jss::jsonrpc] = jsonRPC[jss::jsonrpc];
+            if (jsonRPC.isMember(jss::ripplerpc))
+                reply[jss::ripplerpc] = jsonRPC[jss::ripplerpc];
+            if (jsonRPC.isMember(jss::id))
+                reply[jss::id] = jsonRPC[jss::id];
+        }
+        stream->write ("\n");
+        stream->finish ();
+
+        rpc_time_.notify (static_cast <beast::insight::Event::value_type> (
+            std::chrono::duration_cast <std::chrono::milliseconds> (
+                std::chrono::high_resolution_clock::now () - start)));
+        ++rpc_requests_;
+        rpc_size_.notify (static_cast <beast::insight::Event::value_type> (
+            stream->size ()));
+
+        JLOG (m_journal.debug()) <<
+            "Reply: streamed " << stream->size () << " bytes";
+        return true;
+    }
+
     Json::Value result;
     RPC::doCommand (context, result);
 
@@ -710,6 +887,7 @@ ServerHandlerImp::processRequest (Port const& port,
     }
 
     HTTPReply (200, response, output, rpcJ);
+    return false;
 }
 
 //------------------------------------------------------------------------------
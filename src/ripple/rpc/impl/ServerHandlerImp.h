@@ -155,15 +155,24 @@ private:
             std::shared_ptr<JobQueue::Coro> const& coro,
                 Json::Value const& jv);
 
+    bool
+    streamSession(
+        std::shared_ptr<WSSession> const& session,
+            std::shared_ptr<JobQueue::Coro> const& coro,
+                Json::Value const& jv);
+
     void
     processSession (std::shared_ptr<Session> const&,
         std::shared_ptr<JobQueue::Coro> coro);
 
-    void
+    // Returns `true` if the reply is being streamed. The
+    // session is then completed by the streaming writer.
+    bool
     processRequest (Port const& port, std::string const& request,
         beast::IP::Endpoint const& remoteIPAddress, Output&&,
         std::shared_ptr<JobQueue::Coro> coro,
-        std::string forwardedFor, std::string user);
+        std::string forwardedFor, std::string user,
+        std::shared_ptr<Session> const& session);
 
     Handoff
     statusResponse(http_request_type const& request) const;
@@ -59,6 +59,13 @@ using namespace std::chrono_literals;
 auto constexpr maxValidatedLedgerAge = 2min;
 static int const maxRequestSize = 1000000;
 
+/** Bytes of a streamed response gathered before any are sent. */
+static std::size_t const streamBlockSize = 16 * 1024;
+
+/** Bytes of a streamed response that may wait to be sent before
+    the handler producing it is paused. */
+static std::size_t const streamQueueLimit = 1024 * 1024;
+
 /** Maximum number of pages in one response from a binary LedgerData request. */
 static int const binaryPageLength = 2048;
 
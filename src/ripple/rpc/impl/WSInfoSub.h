@@ -69,22 +69,20 @@ public:
     }
 
     void
-    send(Json::Value const& jv, bool)
+    send(Json::Value const& jv, bool broadcast) override
+    {
+        send(Message(jv), broadcast);
+    }
+
+    void
+    send(Message const& msg, bool) override
     {
         auto sp = ws_.lock();
         if(! sp)
             return;
-        beast::multi_buffer sb;
-        stream(jv,
-            [&](void const* data, std::size_t n)
-            {
-                sb.commit(boost::asio::buffer_copy(
-                    sb.prepare(n), boost::asio::buffer(data, n)));
-            });
-        auto m = std::make_shared<
-            StreambufWSMsg<decltype(sb)>>(
-                std::move(sb));
-        sp->send(m);
+        // The text is serialized once and shared by every subscriber
+        // the message is sent to.
+        sp->send(std::make_shared<StringWSMsg>(msg.text()));
     }
 };
 
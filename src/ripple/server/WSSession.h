@@ -30,6 +30,7 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -106,6 +107,49 @@ public:
     }
 };
 
+/** A message whose payload is shared with other messages.
+
+    The payload is immutable, so the same serialized text can be
+    queued on any number of sessions at once. Each session gets its
+    own StringWSMsg to track how much of the payload it has written.
+*/
+class StringWSMsg : public WSMsg
+{
+    std::shared_ptr<std::string const> s_;
+    std::size_t pos_ = 0;
+    std::size_t n_ = 0;
+
+public:
+    explicit
+    StringWSMsg(std::shared_ptr<std::string const> s)
+        : s_(std::move(s))
+    {
+    }
+
+    std::pair<boost::tribool,
+        std::vector<boost::asio::const_buffer>>
+    prepare(std::size_t bytes,
+        std::function<void(void)>) override
+    {
+        pos_ += n_;
+        auto const remain = s_->size() - pos_;
+        if (remain == 0)
+            return{true, {}};
+        boost::tribool done;
+        if (bytes < remain)
+        {
+            n_ = bytes;
+            done = false;
+        }
+        else
+        {
+            n_ = remain;
+            done = true;
+        }
+        return{done, {boost::asio::const_buffer(s_->data() + pos_, n_)}};
+    }
+};
+
 struct WSSession
 {
     std::shared_ptr<void> appDefined;
@@ -118,4 +118,16 @@ void HTTPReply (
     output ("\r\n");
 }
 
+std::string HTTPChunkedHeader ()
+{
+    return "HTTP/1.1 200 OK\r\n" +
+        getHTTPHeaderTimestamp () +
+        "Connection: Keep-Alive\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Content-Type: application/json; charset=UTF-8\r\n"
+        "Server: " + systemName () + "-json-rpc/" +
+        BuildInfo::getFullVersionString () + "\r\n"
+        "\r\n";
+}
+
 } // ripple
@@ -28,6 +28,9 @@ namespace ripple {
 void HTTPReply (
     int nStatus, std::string const& strMsg, Json::Output const&, beast::Journal j);
 
+/** Returns the header of a successful reply sent with chunked encoding. */
+std::string HTTPChunkedHeader ();
+
 } // ripple
 
 #endif
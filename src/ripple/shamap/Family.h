@@ -21,6 +21,7 @@
 #define RIPPLE_SHAMAP_FAMILY_H_INCLUDED
 
 #include <ripple/basics/Log.h>
+#include <ripple/shamap/FlushPool.h>
 #include <ripple/shamap/FullBelowCache.h>
 #include <ripple/shamap/TreeNodeCache.h>
 #include <ripple/nodestore/Database.h>
@@ -62,6 +63,15 @@ public:
     NodeStore::Database const&
     db() const = 0;
 
+    /** The threads used to hash and flush a map's modified nodes.
+
+        The branches of the root are independent, so up to 16
+        threads can work on them at once.
+    */
+    virtual
+    FlushPool&
+    flushPool() = 0;
+
     virtual
     void
     missing_node (std::uint32_t refNum) = 0;
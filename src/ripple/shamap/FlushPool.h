@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#ifndef RIPPLE_SHAMAP_FLUSHPOOL_H_INCLUDED
+#define RIPPLE_SHAMAP_FLUSHPOOL_H_INCLUDED
+
+#include <ripple/core/impl/Workers.h>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace ripple {
+
+/** Threads that hash and flush the branches of SHAMaps.
+
+    The threads are started once and shared by every map of a
+    Family. A flush hands its independent pieces of work to run(),
+    and the calling thread works on them too.
+*/
+class FlushPool
+    : private Workers::Callback
+{
+public:
+    /** Create the pool.
+
+        @param threads The most threads that work on one flush,
+                       including the calling thread.
+    */
+    explicit
+    FlushPool (int threads);
+
+    FlushPool (FlushPool const&) = delete;
+    FlushPool& operator= (FlushPool const&) = delete;
+
+    /** Returns the most threads that work on one flush. */
+    int
+    threads () const
+    {
+        return workers_.getNumberOfThreads () + 1;
+    }
+
+    /** Change the most threads that work on one flush.
+
+        @note This function is not thread-safe.
+    */
+    void
+    setThreads (int threads);
+
+    /** Call `work(i)` for each `i` in [0, n).
+
+        The calls may be made concurrently, on the calling thread and
+        on the pool's threads. Returns when every call has returned.
+        If any call throws, the first exception is rethrown here.
+
+        The calling thread takes part, so run() never waits on a call
+        that has not started, and may be used from any thread,
+        including the pool's own.
+    */
+    void
+    run (std::size_t n, std::function<void(std::size_t)> const& work);
+
+private:
+    struct Batch;
+
+    void
+    processTask () override;
+
+    std::mutex mutex_;
+
+    // One entry for every task added to workers_
+    std::deque<std::shared_ptr<Batch>> pending_;
+
+    Workers workers_;
+};
+
+} // ripple
+
+#endif
@@ -88,6 +88,13 @@ private:
     SHAMapType                      type_;
     bool                            backed_ = true; // Map is backed by the database
 
+    // Nodes written to the database at once while flushing
+    static std::size_t constexpr    flushBatchSize = 1024;
+
+    // Modified nodes two levels below the root before a flush is
+    // shared with other threads
+    static std::size_t constexpr    parallelFlushNodes = 64;
+
 public:
     class version
     {
@@ -209,6 +216,16 @@ public:
     SHAMapAddNode addKnownNode (SHAMapNodeID const& nodeID, Slice const& rawNode,
                                 SHAMapSyncFilter * filter);
 
+    /** Add several non-root nodes, as if by addKnownNode on each in turn.
+
+        The nodes' hashes are computed together, which is faster than
+        hashing them one at a time. Adding stops after the first invalid
+        node. Returns the combined result of the nodes added.
+    */
+    SHAMapAddNode addKnownNodes (
+        std::vector<std::pair<SHAMapNodeID, Slice>> const& nodes,
+        SHAMapSyncFilter* filter);
+
 
     // status functions
     void setImmutable ();
@@ -231,6 +248,19 @@ public:
     void getFetchPack (SHAMap const* have, bool includeLeaves, int max,
         std::function<void (SHAMapHash const&, const Blob&)>) const;
 
+    // Inner nodes still to be visited by a getFetchPack that stopped
+    // at its limit. It points into the maps, which must outlive it.
+    using FetchPackStack =
+        std::vector<std::pair<SHAMapInnerNode*, SHAMapNodeID>>;
+
+    // Like getFetchPack, but continues from where the last call with
+    // the same stack stopped. An empty stack starts a new walk. The
+    // limit is checked between inner nodes, so it can be exceeded by
+    // a node's children. Returns true once every node was visited.
+    bool getFetchPack (SHAMap const* have, bool includeLeaves, int max,
+        FetchPackStack& stack,
+        std::function<void (SHAMapHash const&, const Blob&)>) const;
+
     void setUnbacked ();
     bool is_v2() const;
     version get_version() const;
@@ -285,10 +315,22 @@ private:
         std::shared_ptr<Node>
         preFlushNode(std::shared_ptr<Node> node) const;
 
-    /** write and canonicalize modified node */
+    /** write and canonicalize modified node
+
+        The node is added to the batch, which is stored once it
+        holds flushBatchSize nodes.
+    */
     std::shared_ptr<SHAMapAbstractNode>
         writeNode(NodeObjectType t, std::uint32_t seq,
-                  std::shared_ptr<SHAMapAbstractNode> node) const;
+                  std::shared_ptr<SHAMapAbstractNode> node,
+                  NodeStore::Batch& batch) const;
+
+    /** store the nodes in a batch, and empty it */
+    void storeBatch (NodeStore::Batch& batch) const;
+
+    // Hook a node received from a peer into the map
+    SHAMapAddNode addKnownNode (SHAMapNodeID const& nodeID,
+        std::shared_ptr<SHAMapAbstractNode> newNode, SHAMapSyncFilter* filter);
 
     SHAMapTreeNode* firstBelow (std::shared_ptr<SHAMapAbstractNode>,
                                 SharedPtrNodeStack& stack, int branch = 0) const;
@@ -325,6 +367,19 @@ private:
                      std::shared_ptr<SHAMapItem const> const& otherMapItem,
                      bool isFirstMap, Delta & differences, int & maxCount) const;
     int walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq);
+
+    // Counts the modified children of the branches of the root
+    static std::size_t countDirtyBelow (
+        std::vector<std::pair<int, std::shared_ptr<SHAMapInnerNode>>> const& branches);
+
+    // Flush inner nodes below the root, in parallel
+    int walkBranches (
+        std::vector<std::pair<int, std::shared_ptr<SHAMapInnerNode>>>& branches,
+        bool doWrite, NodeObjectType t, std::uint32_t seq) const;
+
+    // Flush an inner node and everything modified below it
+    int walkInner (std::shared_ptr<SHAMapInnerNode>& node, bool doWrite,
+        NodeObjectType t, std::uint32_t seq, NodeStore::Batch& batch) const;
     bool isInconsistentNode(std::shared_ptr<SHAMapAbstractNode> const& node) const;
 
     // Structure to track information about call to
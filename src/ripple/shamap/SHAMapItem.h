@@ -27,52 +27,82 @@
 #include <ripple/beast/utility/Journal.h>
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 
 namespace ripple {
 
+namespace detail {
+template <std::size_t Capacity>
+struct InlineSHAMapItem;
+}
+
 // an item stored in a SHAMap
+//
+// Items created with make_shamapitem keep their data in the same
+// allocation as the item itself; other items own a separate buffer.
 class SHAMapItem
 {
 private:
-    uint256    tag_;
-    Blob       data_;
+    uint256                         tag_;
+    std::uint8_t const*             data_;
+    std::size_t                     size_;
+    std::unique_ptr<std::uint8_t[]> buffer_;
+
+    template <std::size_t>
+    friend struct detail::InlineSHAMapItem;
+
+    // Copy the data to storage the caller provides
+    SHAMapItem (uint256 const& tag, Slice data, std::uint8_t* storage);
 
 public:
+    SHAMapItem (uint256 const& tag, Slice data);
     SHAMapItem (uint256 const& tag, Blob const & data);
     SHAMapItem (uint256 const& tag, Serializer const& s);
-    SHAMapItem (uint256 const& tag, Serializer&& s);
+
+    SHAMapItem (SHAMapItem const& other);
+    SHAMapItem (SHAMapItem&& other);
+    SHAMapItem& operator= (SHAMapItem const& other);
+    SHAMapItem& operator= (SHAMapItem&& other);
 
     Slice slice() const;
 
     uint256 const& key() const;
 
-    Blob const& peekData() const;
-
     std::size_t size() const;
     void const* data() const;
 };
 
+/** Create an item for a SHAMap with a single allocation.
+
+    The reference count, the item and a copy of its data share one
+    block of memory. Blocks for items of common sizes come from pools,
+    which each thread reaches through a small cache of its own.
+*/
+std::shared_ptr<SHAMapItem const>
+make_shamapitem (uint256 const& tag, Slice data);
+
 //------------------------------------------------------------------------------
 
 inline
 Slice
 SHAMapItem::slice() const
 {
-    return {data_.data(), data_.size()};
+    return {data_, size_};
 }
 
 inline
 std::size_t
 SHAMapItem::size() const
 {
-    return data_.size();
+    return size_;
 }
 
 inline
 void const*
 SHAMapItem::data() const
 {
-    return data_.data();
+    return data_;
 }
 
 inline
@@ -82,13 +112,6 @@ SHAMapItem::key() const
     return tag_;
 }
 
-inline
-Blob const&
-SHAMapItem::peekData() const
-{
-    return data_;
-}
-
 } // ripple
 
 #endif
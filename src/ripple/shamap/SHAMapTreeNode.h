@@ -25,10 +25,13 @@
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/beast/utility/Journal.h>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace ripple {
 
@@ -131,6 +134,15 @@ public:
     virtual uint256 const& key() const = 0;
     virtual void invariants(bool is_v2, bool is_root = false) const = 0;
 
+    /** Update the hashes of many nodes at once.
+
+        This has the effect of calling updateHash on each node, but the
+        nodes are hashed together, several at a time where the CPU
+        allows. An inner node's hash depends on its children's, so no
+        node may be an ancestor of another. Null pointers are skipped.
+    */
+    static void updateHashes (std::vector<SHAMapAbstractNode*> const& nodes);
+
     static std::shared_ptr<SHAMapAbstractNode>
         make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat format,
              SHAMapHash const& hash, bool hashValid, beast::Journal j,
@@ -147,16 +159,74 @@ class SHAMapInnerNodeV2;
 class SHAMapInnerNode
     : public SHAMapAbstractNode
 {
-    std::array<SHAMapHash, 16>          mHashes;
-    std::shared_ptr<SHAMapAbstractNode> mChildren[16];
-    int                             mIsBranch = 0;
+    struct Branch
+    {
+        SHAMapHash                          hash;
+        std::shared_ptr<SHAMapAbstractNode> child;
+    };
+
+    // Most inner nodes have only a few children, so only the branches
+    // present are stored: packed in branch order, in an array with room
+    // for mCapacity of them, and found by counting the bits of mIsBranch
+    // below their own. The array only changes size while the node is
+    // being modified, before it can be shared.
+    std::unique_ptr<Branch[]>       mBranches;
+    std::uint16_t                   mIsBranch = 0;
+    std::uint8_t                    mCapacity = 0;
     std::uint32_t                   mFullBelowGen = 0;
 
-    static std::mutex               childLock;
+    // The inner nodes in existence, and the memory they use. Nodes are
+    // made and destroyed on every thread, so the counts are kept in
+    // shards, each on its own cache line and shared by few threads,
+    // and summed when read.
+    struct alignas(64) NodeCounter
+    {
+        std::atomic<std::int64_t> nodes {0};
+        std::atomic<std::int64_t> bytes {0};
+    };
+    static std::array<NodeCounter, 16> sNodeCounters;
+
+    // Returns the shard the calling thread updates
+    static NodeCounter& nodeCounter ();
+
+    // Returns the position in mBranches of a branch
+    int index (int m) const;
+
+    // Make a branch present, returning its position in mBranches
+    int addBranch (int m);
+    void removeBranch (int m);
+
+    // Replace the branches with those whose hashes are non-zero
+    void setBranchHashes (std::array<SHAMapHash, 16> const& hashes);
+    void resize (int capacity);
+
+    // Child pointers are guarded by a lock taken from a fixed pool,
+    // chosen by the address of the node. Unrelated nodes rarely share
+    // a lock, so concurrent descents through different parts of any
+    // SHAMap do not serialize on a single mutex.
+    struct alignas(64) ChildLock
+    {
+        std::mutex mutex;
+    };
+    static std::array<ChildLock, 64> childLocks;
+
+    std::mutex& childLock () const;
 public:
     SHAMapInnerNode(std::uint32_t seq);
+    ~SHAMapInnerNode();
     std::shared_ptr<SHAMapAbstractNode> clone(std::uint32_t seq) const override;
 
+    /** The memory used by the inner nodes in existence. */
+    struct MemoryUsage
+    {
+        std::int64_t nodes;
+        std::int64_t bytes;
+    };
+    static MemoryUsage getMemoryUsage ();
+
+    /** The memory an inner node uses when all of its branches are stored. */
+    static std::size_t constexpr fullSize ();
+
     bool isEmpty () const;
     bool isEmptyBranch (int m) const;
     int getBranchCount () const;
@@ -175,6 +245,9 @@ public:
 
     bool updateHash () override;
     void updateHashDeep();
+
+    // Copy the hashes of the children present into their branches
+    void updateChildHashes ();
     void addRaw (Serializer&, SHANodeFormat format) const override;
     std::string getString (SHAMapNodeID const&) const override;
     uint256 const& key() const override;
@@ -340,6 +413,78 @@ inline
 SHAMapInnerNode::SHAMapInnerNode(std::uint32_t seq)
     : SHAMapAbstractNode(tnINNER, seq)
 {
+    auto& counter = nodeCounter ();
+    counter.nodes.fetch_add (1, std::memory_order_relaxed);
+    counter.bytes.fetch_add (sizeof (SHAMapInnerNode),
+        std::memory_order_relaxed);
+}
+
+inline
+SHAMapInnerNode::~SHAMapInnerNode()
+{
+    auto& counter = nodeCounter ();
+    counter.nodes.fetch_sub (1, std::memory_order_relaxed);
+    counter.bytes.fetch_sub (
+        sizeof (SHAMapInnerNode) + mCapacity * sizeof (Branch),
+            std::memory_order_relaxed);
+}
+
+inline
+SHAMapInnerNode::NodeCounter&
+SHAMapInnerNode::nodeCounter ()
+{
+    // Threads take the shards in turn
+    static std::atomic<unsigned> next {0};
+    static thread_local NodeCounter& counter =
+        sNodeCounters[next++ % sNodeCounters.size()];
+    return counter;
+}
+
+inline
+SHAMapInnerNode::MemoryUsage
+SHAMapInnerNode::getMemoryUsage ()
+{
+    // A node may be destroyed on another thread than the one that
+    // made it, so only the sum over the shards is meaningful.
+    MemoryUsage usage {0, 0};
+    for (auto const& counter : sNodeCounters)
+    {
+        usage.nodes += counter.nodes.load (std::memory_order_relaxed);
+        usage.bytes += counter.bytes.load (std::memory_order_relaxed);
+    }
+    return usage;
+}
+
+inline
+std::size_t constexpr
+SHAMapInnerNode::fullSize ()
+{
+    return sizeof (SHAMapInnerNode) + 16 * sizeof (Branch);
+}
+
+inline
+int
+SHAMapInnerNode::index (int m) const
+{
+    // Count the branches present below m
+    std::uint32_t v = mIsBranch & ((1u << m) - 1);
+    v = v - ((v >> 1) & 0x5555);
+    v = (v & 0x3333) + ((v >> 2) & 0x3333);
+    v = (v + (v >> 4)) & 0x0F0F;
+    return (v + (v >> 8)) & 0x1F;
+}
+
+inline
+std::mutex&
+SHAMapInnerNode::childLock () const
+{
+    // With branches stored apart, an inner node is only 64 bytes on
+    // 64-bit platforms, and the heap and reference count add to that.
+    // So nodes are at least 64 bytes apart, and neighbours still differ
+    // once the low six bits are dropped. The higher bits are folded in
+    // so that distant nodes spread over the locks too.
+    auto const p = reinterpret_cast<std::uintptr_t>(this) >> 6;
+    return childLocks[(p ^ (p >> 6) ^ (p >> 12)) % childLocks.size()].mutex;
 }
 
 inline
@@ -354,7 +499,10 @@ SHAMapHash const&
 SHAMapInnerNode::getChildHash (int m) const
 {
     assert ((m >= 0) && (m < 16) && (getType() == tnINNER));
-    return mHashes[m];
+    static SHAMapHash const zero;
+    if (isEmptyBranch (m))
+        return zero;
+    return mBranches[index (m)].hash;
 }
 
 inline
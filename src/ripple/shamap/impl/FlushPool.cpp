@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/shamap/FlushPool.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <exception>
+
+namespace ripple {
+
+struct FlushPool::Batch
+{
+    std::function<void(std::size_t)> const& work;
+    std::size_t const n;
+
+    std::atomic<std::size_t> next {0};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t done = 0;
+    std::exception_ptr error;
+
+    Batch (std::function<void(std::size_t)> const& work_, std::size_t n_)
+        : work (work_)
+        , n (n_)
+    {
+    }
+
+    // Runs pieces until none are left. A thread that arrives after
+    // the batch finished finds nothing to do, and never touches `work`.
+    void
+    drain ()
+    {
+        for (auto i = next++; i < n; i = next++)
+        {
+            std::exception_ptr e;
+            try
+            {
+                work (i);
+            }
+            catch (...)
+            {
+                e = std::current_exception ();
+            }
+
+            std::lock_guard<std::mutex> lock (mutex);
+            if (e && ! error)
+                error = e;
+            if (++done == n)
+                cv.notify_all ();
+        }
+    }
+};
+
+FlushPool::FlushPool (int threads)
+    : workers_ (*this, "SHAMapFlush", std::max (0, threads - 1))
+{
+}
+
+void
+FlushPool::setThreads (int threads)
+{
+    workers_.setNumberOfThreads (std::max (0, threads - 1));
+}
+
+void
+FlushPool::run (std::size_t n,
+    std::function<void(std::size_t)> const& work)
+{
+    if (n == 0)
+        return;
+
+    auto const batch = std::make_shared<Batch> (work, n);
+
+    auto const helpers = std::min (n - 1,
+        static_cast<std::size_t> (workers_.getNumberOfThreads ()));
+    if (helpers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            pending_.insert (pending_.end (), helpers, batch);
+        }
+        for (std::size_t i = 0; i < helpers; ++i)
+            workers_.addTask ();
+    }
+
+    batch->drain ();
+
+    std::unique_lock<std::mutex> lock (batch->mutex);
+    batch->cv.wait (lock, [&]{ return batch->done == n; });
+    if (batch->error)
+        std::rethrow_exception (batch->error);
+}
+
+void
+FlushPool::processTask ()
+{
+    std::shared_ptr<Batch> batch;
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        assert (! pending_.empty ());
+        batch = std::move (pending_.front ());
+        pending_.pop_front ();
+    }
+    batch->drain ();
+}
+
+} // ripple
@@ -20,6 +20,8 @@
 #include <BeastConfig.h>
 #include <ripple/basics/contract.h>
 #include <ripple/shamap/SHAMap.h>
+#include <algorithm>
+#include <atomic>
 
 namespace ripple {
 
@@ -1004,8 +1006,8 @@ SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
 bool
 SHAMap::addItem(SHAMapItem&& i, bool isTransaction, bool hasMetaData)
 {
-    return addGiveItem(std::make_shared<SHAMapItem const>(std::move(i)),
-                                                          isTransaction, hasMetaData);
+    return addGiveItem(make_shamapitem(i.key(), i.slice()),
+                       isTransaction, hasMetaData);
 }
 
 SHAMapHash
@@ -1105,8 +1107,8 @@ bool SHAMap::fetchRoot (SHAMapHash const& hash, SHAMapSyncFilter* filter)
 // 2) An unshareable node is shared. This happens when you make
 // a mutable snapshot of a mutable SHAMap.
 std::shared_ptr<SHAMapAbstractNode>
-SHAMap::writeNode (
-    NodeObjectType t, std::uint32_t seq, std::shared_ptr<SHAMapAbstractNode> node) const
+SHAMap::writeNode (NodeObjectType t, std::uint32_t seq,
+    std::shared_ptr<SHAMapAbstractNode> node, NodeStore::Batch& batch) const
 {
     // Node is ours, so we can just make it shareable
     assert (node->getSeq() == seq_);
@@ -1117,11 +1119,23 @@ SHAMap::writeNode (
 
     Serializer s;
     node->addRaw (s, snfPREFIX);
-    f_.db().store (t,
-        std::move (s.modData ()), node->getNodeHash ().as_uint256());
+    batch.push_back (NodeObject::createObject (t,
+        std::move (s.modData ()), node->getNodeHash ().as_uint256()));
+    if (batch.size () >= flushBatchSize)
+        storeBatch (batch);
     return node;
 }
 
+void
+SHAMap::storeBatch (NodeStore::Batch& batch) const
+{
+    if (! batch.empty ())
+    {
+        f_.db().storeBatch (batch);
+        batch.clear ();
+    }
+}
+
 // We can't modify an inner node someone else might have a
 // pointer to because flushing modifies inner nodes -- it
 // makes them point to canonical/shared nodes.
@@ -1159,7 +1173,7 @@ int
 SHAMap::walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq)
 {
     int flushed = 0;
-    Serializer s;
+    NodeStore::Batch batch;
 
     if (!root_ || (root_->getSeq() == 0))
         return flushed;
@@ -1169,7 +1183,10 @@ SHAMap::walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq)
         root_ = preFlushNode (std::move(root_));
         root_->updateHash();
         if (doWrite && backed_)
-            root_ = writeNode(t, seq, std::move(root_));
+        {
+            root_ = writeNode(t, seq, std::move(root_), batch);
+            storeBatch (batch);
+        }
         else
             root_->setSeq (0);
         return 1;
@@ -1186,97 +1203,244 @@ SHAMap::walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq)
         return 1;
     }
 
-    // Stack of {parent,index,child} pointers representing
-    // inner nodes we are in the process of flushing
-    using StackEntry = std::pair <std::shared_ptr<SHAMapInnerNode>, int>;
-    std::stack <StackEntry, std::vector<StackEntry>> stack;
-
     node = preFlushNode(std::move(node));
 
-    int pos = 0;
-
-    // We can't flush an inner node until we flush its children
-    while (1)
+    // Flush the leaves hanging from the root, and gather the inner
+    // nodes. Nothing below one branch refers to another branch, so
+    // the inner nodes can be flushed on separate threads.
+    std::vector<std::pair<int, std::shared_ptr<SHAMapInnerNode>>> branches;
+    for (int branch = 0; branch < 16; ++branch)
     {
-        while (pos < 16)
+        if (node->isEmptyBranch (branch))
+            continue;
+
+        // No need to do I/O. If the node isn't linked,
+        // it can't need to be flushed
+        auto child = node->getChild (branch);
+        if (! child || (child->getSeq() == 0))
+            continue;
+
+        child = preFlushNode(std::move(child));
+        if (child->isInner ())
         {
-            if (node->isEmptyBranch (pos))
-            {
-                ++pos;
-            }
+            branches.emplace_back (branch,
+                std::static_pointer_cast<SHAMapInnerNode>(std::move(child)));
+        }
+        else
+        {
+            ++flushed;
+            child->updateHash();
+            if (doWrite && backed_)
+                child = writeNode(t, seq, std::move(child), batch);
             else
-            {
-                // No need to do I/O. If the node isn't linked,
-                // it can't need to be flushed
-                int branch = pos;
-                auto child = node->getChild(pos++);
+                child->setSeq (0);
+            node->shareChild (branch, child);
+        }
+    }
 
-                if (child && (child->getSeq() != 0))
-                {
-                    // This is a node that needs to be flushed
+    flushed += walkBranches (branches, doWrite, t, seq);
 
-                    child = preFlushNode(std::move(child));
+    // Hook the flushed inner nodes to the root
+    for (auto const& b : branches)
+        node->shareChild (b.first, b.second);
 
-                    if (child->isInner ())
-                    {
-                        // save our place and work on this node
+    // update the hash of the root
+    node->updateHashDeep();
 
-                        stack.emplace (std::move (node), branch);
+    // The root can now be shared
+    if (doWrite && backed_)
+    {
+        node = std::static_pointer_cast<SHAMapInnerNode>(writeNode(t, seq,
+                                                             std::move(node), batch));
+        storeBatch (batch);
+    }
+    else
+        node->setSeq (0);
 
-                        node = std::static_pointer_cast<SHAMapInnerNode>(std::move(child));
-                        pos = 0;
-                    }
-                    else
-                    {
-                        // flush this leaf
-                        ++flushed;
+    ++flushed;
 
-                        assert (node->getSeq() == seq_);
-                        child->updateHash();
+    root_ = std::move (node);
 
-                        if (doWrite && backed_)
-                            child = writeNode(t, seq, std::move(child));
-                        else
-                            child->setSeq (0);
+    return flushed;
+}
 
-                        node->shareChild (branch, child);
-                    }
-                }
-            }
+std::size_t
+SHAMap::countDirtyBelow (
+    std::vector<std::pair<int, std::shared_ptr<SHAMapInnerNode>>> const& branches)
+{
+    std::size_t n = 0;
+    for (auto const& b : branches)
+    {
+        for (int branch = 0; branch < 16; ++branch)
+        {
+            if (b.second->isEmptyBranch (branch))
+                continue;
+            auto const child = b.second->getChildPointer (branch);
+            if (child && child->getSeq () != 0)
+                ++n;
         }
+    }
+    return n;
+}
 
-        // update the hash of this inner node
-        node->updateHashDeep();
+int
+SHAMap::walkBranches (
+    std::vector<std::pair<int, std::shared_ptr<SHAMapInnerNode>>>& branches,
+    bool doWrite, NodeObjectType t, std::uint32_t seq) const
+{
+    std::atomic<int> flushed {0};
 
-        // This inner node can now be shared
-        if (doWrite && backed_)
-            node = std::static_pointer_cast<SHAMapInnerNode>(writeNode(t, seq,
-                                                                       std::move(node)));
-        else
-            node->setSeq (0);
+    // Each subtree's nodes are stored together
+    auto const work = [&](std::size_t i)
+    {
+        NodeStore::Batch batch;
+        flushed += walkInner (branches[i].second, doWrite, t, seq, batch);
+        storeBatch (batch);
+    };
+
+    // Handing work to other threads costs more than it saves when
+    // few nodes changed. Unbacked maps hold transaction sets, which
+    // are small, so they stay on this thread as well.
+    if (! backed_ || branches.size () < 2 ||
+        countDirtyBelow (branches) < parallelFlushNodes)
+    {
+        for (std::size_t i = 0; i < branches.size (); ++i)
+            work (i);
+    }
+    else
+    {
+        f_.flushPool().run (branches.size (), work);
+    }
 
-        ++flushed;
+    return flushed;
+}
 
-        if (stack.empty ())
-           break;
+int
+SHAMap::walkInner (std::shared_ptr<SHAMapInnerNode>& node, bool doWrite,
+    NodeObjectType t, std::uint32_t seq, NodeStore::Batch& batch) const
+{
+    // A node that needs to be flushed, and where it hangs
+    struct Dirty
+    {
+        std::shared_ptr<SHAMapAbstractNode> node;
+        SHAMapInnerNode* parent;    // nullptr for the top node
+        int branch;
+        std::size_t depth;
+    };
+
+    // The dirty nodes, each after all of its children
+    std::vector<Dirty> dirty;
+
+    // Unshare the dirty nodes and link them together, depth first.
+    // Nothing is hashed yet: the hashes are computed afterwards, many
+    // nodes at a time.
+    {
+        struct Frame
+        {
+            std::shared_ptr<SHAMapInnerNode> node;
+            SHAMapInnerNode* parent;
+            int branch;
+            int pos;
+        };
+        std::vector<Frame> stack;
+        stack.push_back ({node, nullptr, 0, 0});
 
-        auto parent = std::move (stack.top().first);
-        pos = stack.top().second;
-        stack.pop();
+        while (! stack.empty ())
+        {
+            auto& top = stack.back ();
+            auto const depth = stack.size () - 1;
 
-        // Hook this inner node to its parent
-        assert (parent->getSeq() == seq_);
-        parent->shareChild (pos, node);
+            if (top.pos == 16)
+            {
+                // All of this inner node's children are done
+                dirty.push_back ({std::move (top.node),
+                    top.parent, top.branch, depth});
+                stack.pop_back ();
+                continue;
+            }
 
-        // Continue with parent's next child, if any
-        node = std::move (parent);
-        ++pos;
+            int const branch = top.pos++;
+            if (top.node->isEmptyBranch (branch))
+                continue;
+
+            // No need to do I/O. If the node isn't linked,
+            // it can't need to be flushed
+            auto child = top.node->getChild (branch);
+            if (! child || (child->getSeq() == 0))
+                continue;
+
+            assert (top.node->getSeq() == seq_);
+            child = preFlushNode (std::move (child));
+            top.node->shareChild (branch, child);
+
+            SHAMapInnerNode* const parent = top.node.get ();
+            if (child->isInner ())
+            {
+                stack.push_back ({
+                    std::static_pointer_cast<SHAMapInnerNode>(std::move (child)),
+                    parent, branch, 0});
+            }
+            else
+            {
+                dirty.push_back ({std::move (child),
+                    parent, branch, depth + 1});
+            }
+        }
     }
 
-    // Last inner node is the new root_
-    root_ = std::move (node);
+    // Hash the leaves, then the inner nodes a level at a time from the
+    // bottom up, since an inner node's hash covers its children's.
+    {
+        std::vector<SHAMapAbstractNode*> leaves;
+        std::vector<std::vector<SHAMapAbstractNode*>> levels;
+        for (auto const& d : dirty)
+        {
+            if (d.node->isLeaf ())
+            {
+                leaves.push_back (d.node.get ());
+            }
+            else
+            {
+                if (levels.size () <= d.depth)
+                    levels.resize (d.depth + 1);
+                levels[d.depth].push_back (d.node.get ());
+            }
+        }
 
-    return flushed;
+        SHAMapAbstractNode::updateHashes (leaves);
+
+        for (auto level = levels.rbegin (); level != levels.rend (); ++level)
+        {
+            for (auto n : *level)
+                static_cast<SHAMapInnerNode*>(n)->updateChildHashes ();
+            SHAMapAbstractNode::updateHashes (*level);
+        }
+    }
+
+    // These nodes can now be shared. Children are written before their
+    // parents, so each parent is still ours when it is re-linked to the
+    // canonical copy of its child.
+    for (auto& d : dirty)
+    {
+        auto n = std::move (d.node);
+
+        if (doWrite && backed_)
+            n = writeNode (t, seq, std::move (n), batch);
+        else
+            n->setSeq (0);
+
+        if (d.parent)
+        {
+            assert (d.parent->getSeq() == seq_);
+            d.parent->shareChild (d.branch, n);
+        }
+        else
+        {
+            node = std::static_pointer_cast<SHAMapInnerNode>(std::move (n));
+        }
+    }
+
+    return static_cast<int> (dirty.size ());
 }
 
 void SHAMap::dump (bool hash) const
@@ -72,7 +72,7 @@ bool SHAMap::walkBranch (SHAMapAbstractNode* node,
                 if (--maxCount <= 0)
                     return false;
             }
-            else if (item->peekData () != otherMapItem->peekData ())
+            else if (item->slice () != otherMapItem->slice ())
             {
                 // non-matching items with same tag
                 if (isFirstMap)
@@ -150,7 +150,7 @@ SHAMap::compare (SHAMap const& otherMap,
             auto other = static_cast<SHAMapTreeNode*>(otherNode);
             if (ours->peekItem()->key() == other->peekItem()->key())
             {
-                if (ours->peekItem()->peekData () != other->peekItem()->peekData ())
+                if (ours->peekItem()->slice () != other->peekItem()->slice ())
                 {
                     differences.insert (std::make_pair (ours->peekItem()->key(),
                                                  DeltaRef (ours->peekItem (),
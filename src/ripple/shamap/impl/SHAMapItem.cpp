@@ -17,30 +17,443 @@
 */
 //==============================================================================
 
+
 #include <BeastConfig.h>
 #include <ripple/protocol/Serializer.h>
 #include <ripple/shamap/SHAMapItem.h>
+#include <ripple/basics/contract.h>
+#include <boost/align/aligned_alloc.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
 
 namespace ripple {
 
 class SHAMap;
 
-SHAMapItem::SHAMapItem (uint256 const& tag, Blob const& data)
-    : tag_(tag)
-    , data_(data)
+SHAMapItem::SHAMapItem (uint256 const& tag, Slice data,
+        std::uint8_t* storage)
+    : tag_ (tag)
+    , data_ (storage)
+    , size_ (data.size())
 {
+    if (size_ != 0)
+        std::memcpy (storage, data.data(), size_);
 }
 
-SHAMapItem::SHAMapItem (uint256 const& tag, const Serializer& data)
+SHAMapItem::SHAMapItem (uint256 const& tag, Slice data)
     : tag_ (tag)
-    , data_(data.peekData())
+    , size_ (data.size())
+    , buffer_ (size_ ? new std::uint8_t[size_] : nullptr)
 {
+    data_ = buffer_.get();
+    if (size_ != 0)
+        std::memcpy (buffer_.get(), data.data(), size_);
 }
 
-SHAMapItem::SHAMapItem (uint256 const& tag, Serializer&& data)
-    : tag_ (tag)
-    , data_(std::move(data.modData()))
+SHAMapItem::SHAMapItem (uint256 const& tag, Blob const& data)
+    : SHAMapItem (tag, makeSlice (data))
+{
+}
+
+SHAMapItem::SHAMapItem (uint256 const& tag, Serializer const& data)
+    : SHAMapItem (tag, data.slice())
+{
+}
+
+SHAMapItem::SHAMapItem (SHAMapItem const& other)
+    : SHAMapItem (other.tag_, other.slice())
+{
+}
+
+SHAMapItem::SHAMapItem (SHAMapItem&& other)
+    : tag_ (other.tag_)
+    , data_ (other.data_)
+    , size_ (other.size_)
+    , buffer_ (std::move (other.buffer_))
+{
+    if (buffer_ || size_ == 0)
+    {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    else
+    {
+        // The data lives in the allocation of other, so copy it
+        buffer_.reset (new std::uint8_t[size_]);
+        std::memcpy (buffer_.get(), data_, size_);
+        data_ = buffer_.get();
+    }
+}
+
+SHAMapItem&
+SHAMapItem::operator= (SHAMapItem const& other)
+{
+    if (this != &other)
+        *this = SHAMapItem (other);
+    return *this;
+}
+
+SHAMapItem&
+SHAMapItem::operator= (SHAMapItem&& other)
+{
+    if (this != &other)
+    {
+        SHAMapItem temp (std::move (other));
+        tag_ = temp.tag_;
+        data_ = temp.data_;
+        size_ = temp.size_;
+        buffer_ = std::move (temp.buffer_);
+    }
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+// Blocks a thread holds on to for one pool. It is trivially
+// destructible, so it stays usable while the thread's other
+// objects are destroyed.
+struct SlabCache
+{
+    void* head;
+    std::size_t count;
+    bool armed;             // a SlabCacheReaper was made
+    bool closed;            // the reaper ran
+};
+
+// Blocks of one size, carved from slabs. Threads take blocks from the
+// pool and give them back in batches, through a SlabCache of their own,
+// so the lock is taken once per batch rather than once per item. A slab
+// is returned to the heap once all of its blocks come back, unless it
+// is the only empty one, which is kept for the next allocations.
+class SlabPool
+{
+private:
+    // Slabs are aligned to their size, so a block
+    // finds its slab by masking its address.
+    static std::size_t constexpr slabBytes = 64 * 1024;
+
+    struct Slab
+    {
+        Slab* prev;             // in the list of slabs with free blocks
+        Slab* next;
+        bool listed;
+        void* free;             // blocks given back
+        char* unused;           // blocks never handed out start here
+        char* end;
+        std::size_t used;       // blocks handed out
+    };
+
+    std::size_t const size_;
+    std::size_t const offset_;  // of the first block in a slab
+    std::size_t const batch_;
+    std::mutex mutex_;
+    Slab* head_ = nullptr;      // slabs with free blocks
+    std::size_t empty_ = 0;     // slabs with no blocks handed out
+
+    static
+    void*&
+    link (void* p)
+    {
+        return *static_cast<void**>(p);
+    }
+
+    // Slabs that get blocks back go first, so recycled
+    // blocks are handed out before untouched ones
+    void
+    insert (Slab* slab)
+    {
+        slab->prev = nullptr;
+        slab->next = head_;
+        slab->listed = true;
+        if (head_)
+            head_->prev = slab;
+        head_ = slab;
+    }
+
+    void
+    remove (Slab* slab)
+    {
+        (slab->prev ? slab->prev->next : head_) = slab->next;
+        if (slab->next)
+            slab->next->prev = slab->prev;
+        slab->listed = false;
+    }
+
+    // Takes n blocks, linked through their first word
+    void*
+    take (std::size_t n)
+    {
+        void* head = nullptr;
+        std::lock_guard<std::mutex> lock (mutex_);
+        while (n--)
+        {
+            if (! head_)
+            {
+                auto const slab = static_cast<Slab*>(
+                    boost::alignment::aligned_alloc (slabBytes, slabBytes));
+                if (! slab)
+                    Throw<std::bad_alloc> ();
+                slab->free = nullptr;
+                slab->unused = reinterpret_cast<char*>(slab) + offset_;
+                slab->end = slab->unused +
+                    ((slabBytes - offset_) / size_) * size_;
+                slab->used = 0;
+                insert (slab);
+                ++empty_;
+            }
+
+            auto const slab = head_;
+            void* p;
+            if (slab->free)
+            {
+                p = slab->free;
+                slab->free = link (p);
+            }
+            else
+            {
+                p = slab->unused;
+                slab->unused += size_;
+            }
+            if (slab->used++ == 0)
+                --empty_;
+            if (! slab->free && slab->unused == slab->end)
+                remove (slab);
+
+            link (p) = head;
+            head = p;
+        }
+        return head;
+    }
+
+    // Gives back blocks linked through their first word
+    void
+    give (void* head)
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        while (head)
+        {
+            auto const p = head;
+            head = link (p);
+
+            auto const slab = reinterpret_cast<Slab*>(
+                reinterpret_cast<std::uintptr_t>(p) & ~(slabBytes - 1));
+            link (p) = slab->free;
+            slab->free = p;
+            if (! slab->listed)
+                insert (slab);
+            if (--slab->used == 0)
+            {
+                if (empty_ == 0)
+                {
+                    ++empty_;
+                }
+                else
+                {
+                    remove (slab);
+                    boost::alignment::aligned_free (slab);
+                }
+            }
+        }
+    }
+
+public:
+    SlabPool (std::size_t size, std::size_t align)
+        : size_ (((std::max (size, sizeof (void*)) + align - 1) / align) * align)
+        , offset_ (((sizeof (Slab) + align - 1) / align) * align)
+        , batch_ (std::max<std::size_t> (4, (8 * 1024) / size_))
+    {
+        assert (offset_ + size_ <= slabBytes);
+    }
+
+    void*
+    allocate (SlabCache& cache)
+    {
+        if (cache.closed)
+            return take (1);
+        if (! cache.head)
+        {
+            cache.head = take (batch_);
+            cache.count = batch_;
+        }
+        auto const p = cache.head;
+        cache.head = link (p);
+        --cache.count;
+        return p;
+    }
+
+    void
+    deallocate (SlabCache& cache, void* p)
+    {
+        if (cache.closed)
+        {
+            link (p) = nullptr;
+            give (p);
+            return;
+        }
+        link (p) = cache.head;
+        cache.head = p;
+        if (++cache.count < 2 * batch_)
+            return;
+
+        // Keep one batch and give back the other
+        auto last = cache.head;
+        for (std::size_t i = 1; i < batch_; ++i)
+            last = link (last);
+        auto const rest = link (last);
+        link (last) = nullptr;
+        give (cache.head);
+        cache.head = rest;
+        cache.count -= batch_;
+    }
+
+    // Gives back the blocks a thread holds when it exits
+    void
+    close (SlabCache& cache)
+    {
+        give (cache.head);
+        cache.head = nullptr;
+        cache.count = 0;
+        cache.closed = true;
+    }
+};
+
+struct SlabCacheReaper
+{
+    SlabPool& pool;
+    SlabCache& cache;
+
+    ~SlabCacheReaper ()
+    {
+        pool.close (cache);
+    }
+};
+
+// Allocates single objects from a pool holding blocks of their size
+template <class T>
+struct SlabAllocator
+{
+    using value_type = T;
+
+    SlabAllocator () = default;
+
+    template <class U>
+    SlabAllocator (SlabAllocator<U> const&)
+    {
+    }
+
+    static
+    SlabPool&
+    pool ()
+    {
+        // Never destroyed: items may outlive static destruction
+        static SlabPool& p = *new SlabPool (sizeof (T), alignof (T));
+        return p;
+    }
+
+    static
+    SlabCache&
+    cache ()
+    {
+        static thread_local SlabCache c {};
+        if (! c.armed)
+        {
+            static thread_local SlabCacheReaper reaper {pool (), c};
+            c.armed = true;
+        }
+        return c;
+    }
+
+    T*
+    allocate (std::size_t n)
+    {
+        if (n != 1)
+            return static_cast<T*>(::operator new (n * sizeof (T)));
+        return static_cast<T*>(pool().allocate (cache ()));
+    }
+
+    void
+    deallocate (T* p, std::size_t n)
+    {
+        if (n != 1)
+            ::operator delete (p);
+        else
+            pool().deallocate (cache (), p);
+    }
+};
+
+template <class T, class U>
+bool
+operator== (SlabAllocator<T> const&, SlabAllocator<U> const&)
 {
+    return true;
+}
+
+template <class T, class U>
+bool
+operator!= (SlabAllocator<T> const&, SlabAllocator<U> const&)
+{
+    return false;
+}
+
+} // (anonymous)
+
+namespace detail {
+
+// An item followed by room for its data
+template <std::size_t Capacity>
+struct InlineSHAMapItem
+{
+    SHAMapItem item;
+    std::uint8_t storage[Capacity];
+
+    InlineSHAMapItem (uint256 const& tag, Slice data)
+        : item (tag, data, storage)
+    {
+    }
+};
+
+} // detail
+
+namespace {
+
+template <std::size_t Capacity>
+std::shared_ptr<SHAMapItem const>
+makeInline (uint256 const& tag, Slice data)
+{
+    using type = detail::InlineSHAMapItem<Capacity>;
+    auto const p = std::allocate_shared<type> (
+        SlabAllocator<type>{}, tag, data);
+    return {p, &p->item};
+}
+
+} // (anonymous)
+
+std::shared_ptr<SHAMapItem const>
+make_shamapitem (uint256 const& tag, Slice data)
+{
+    // Account state entries are mostly under 256 bytes and transactions
+    // with metadata under 1KB. Rounding up to a multiple of 64 bytes
+    // wastes about as much as a separate heap block would cost.
+    using maker = std::shared_ptr<SHAMapItem const>(*)(uint256 const&, Slice);
+    static maker const makers[] =
+    {
+        &makeInline<64>,  &makeInline<128>, &makeInline<192>, &makeInline<256>,
+        &makeInline<320>, &makeInline<384>, &makeInline<448>, &makeInline<512>,
+        &makeInline<576>, &makeInline<640>, &makeInline<704>, &makeInline<768>,
+        &makeInline<832>, &makeInline<896>, &makeInline<960>, &makeInline<1024>
+    };
+
+    auto const index = data.empty() ? 0 : (data.size() - 1) / 64;
+    if (index < std::extent<decltype(makers)>::value)
+        return makers[index] (tag, data);
+    return std::make_shared<SHAMapItem const> (tag, data);
 }
 
 } // ripple
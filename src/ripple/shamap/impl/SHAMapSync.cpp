@@ -21,6 +21,7 @@
 #include <ripple/basics/random.h>
 #include <ripple/shamap/SHAMap.h>
 #include <ripple/nodestore/Database.h>
+#include <exception>
 
 namespace ripple {
 
@@ -517,9 +518,74 @@ SHAMap::addKnownNode (const SHAMapNodeID& node, Slice const& rawNode,
         return SHAMapAddNode::duplicate ();
     }
 
+    return addKnownNode (node, SHAMapAbstractNode::make(rawNode, 0, snfWIRE,
+        SHAMapHash{}, false, f_.journal(), node), filter);
+}
+
+SHAMapAddNode
+SHAMap::addKnownNodes (
+    std::vector<std::pair<SHAMapNodeID, Slice>> const& nodes,
+    SHAMapSyncFilter* filter)
+{
+    if (!isSynching ())
+    {
+        JLOG(journal_.trace()) << "AddKnownNodes while not synching";
+        return SHAMapAddNode::duplicate ();
+    }
+
+    // Parse all of the nodes, then hash them together. A node that
+    // fails to parse throws when its turn comes, as addKnownNode would.
+    std::vector<std::shared_ptr<SHAMapAbstractNode>> newNodes (nodes.size ());
+    std::vector<std::exception_ptr> errors (nodes.size ());
+    std::vector<SHAMapAbstractNode*> hashing;
+    hashing.reserve (nodes.size ());
+
+    for (std::size_t i = 0; i < nodes.size (); ++i)
+    {
+        try
+        {
+            newNodes[i] = SHAMapAbstractNode::make (nodes[i].second, 0,
+                snfWIRE, SHAMapHash{}, true, f_.journal(), nodes[i].first);
+            if (newNodes[i] && newNodes[i]->isValid ())
+                hashing.push_back (newNodes[i].get ());
+        }
+        catch (std::exception const&)
+        {
+            errors[i] = std::current_exception ();
+        }
+    }
+
+    SHAMapAbstractNode::updateHashes (hashing);
+
+    SHAMapAddNode result;
+    for (std::size_t i = 0; i < nodes.size (); ++i)
+    {
+        assert (!nodes[i].first.isRoot ());
+
+        if (!isSynching ())
+        {
+            JLOG(journal_.trace()) << "AddKnownNodes while not synching";
+            result += SHAMapAddNode::duplicate ();
+            continue;
+        }
+
+        if (errors[i])
+            std::rethrow_exception (errors[i]);
+
+        auto const added = addKnownNode (
+            nodes[i].first, std::move (newNodes[i]), filter);
+        result += added;
+        if (added.isInvalid ())
+            break;
+    }
+    return result;
+}
+
+SHAMapAddNode
+SHAMap::addKnownNode (SHAMapNodeID const& node,
+    std::shared_ptr<SHAMapAbstractNode> newNode, SHAMapSyncFilter* filter)
+{
     std::uint32_t generation = f_.fullbelow().getGeneration();
-    auto newNode = SHAMapAbstractNode::make(rawNode, 0, snfWIRE,
-                      SHAMapHash{}, false, f_.journal(), node);
     SHAMapNodeID iNodeID;
     auto iNode = root_.get();
 
@@ -630,7 +696,7 @@ bool SHAMap::deepCompare (SHAMap& other) const
             auto& otherNodePeek = static_cast<SHAMapTreeNode*>(otherNode)->peekItem();
             if (nodePeek->key() != otherNodePeek->key())
                 return false;
-            if (nodePeek->peekData() != otherNodePeek->peekData())
+            if (nodePeek->slice() != otherNodePeek->slice())
                 return false;
         }
         else if (node->isInner ())
@@ -752,6 +818,83 @@ void SHAMap::getFetchPack (SHAMap const* have, bool includeLeaves, int max,
         });
 }
 
+bool
+SHAMap::getFetchPack (SHAMap const* have, bool includeLeaves, int max,
+    FetchPackStack& stack,
+    std::function<void (SHAMapHash const&, const Blob&)> func) const
+{
+    if (have != nullptr && have->is_v2() != is_v2())
+    {
+        JLOG(journal_.info()) << "Can not get fetch pack when versions are different.";
+        return true;
+    }
+
+    auto add = [includeLeaves, &max, &func] (SHAMapAbstractNode& smn)
+    {
+        if (includeLeaves || smn.isInner ())
+        {
+            Serializer s;
+            smn.addRaw (s, snfPREFIX);
+            func (smn.getNodeHash(), s.peekData());
+            --max;
+        }
+    };
+
+    if (stack.empty ())
+    {
+        if (root_->getNodeHash ().isZero ())
+            return true;
+
+        if (have && (root_->getNodeHash () == have->root_->getNodeHash ()))
+            return true;
+
+        if (root_->isLeaf ())
+        {
+            auto leaf = std::static_pointer_cast<SHAMapTreeNode>(root_);
+            if (!have || !have->hasLeafNode(leaf->peekItem()->key(), leaf->getNodeHash()))
+                add (*root_);
+            return true;
+        }
+
+        stack.push_back ({static_cast<SHAMapInnerNode*>(root_.get()), SHAMapNodeID{}});
+    }
+
+    // Unlike visitDifferences, a node's children are always queued
+    // before stopping, so that the walk can be continued
+    while (!stack.empty() && max > 0)
+    {
+        SHAMapInnerNode* node;
+        SHAMapNodeID nodeID;
+        std::tie (node, nodeID) = stack.back ();
+        stack.pop_back ();
+
+        add (*node);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            if (!node->isEmptyBranch (i))
+            {
+                auto const& childHash = node->getChildHash (i);
+                SHAMapNodeID childID = nodeID.getChildNodeID (i);
+                auto next = descendThrow(node, i);
+
+                if (next->isInner ())
+                {
+                    if (!have || !have->hasInnerNode(childID, childHash))
+                        stack.push_back ({static_cast<SHAMapInnerNode*>(next), childID});
+                }
+                else if (!have || !have->hasLeafNode(
+                         static_cast<SHAMapTreeNode*>(next)->peekItem()->key(),
+                         childHash))
+                {
+                    add (*next);
+                }
+            }
+        }
+    }
+    return stack.empty ();
+}
+
 void
 SHAMap::visitDifferences(SHAMap const* have,
                          std::function<bool (SHAMapAbstractNode&)> func) const
@@ -26,13 +26,15 @@
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/protocol/HashPrefix.h>
 #include <ripple/beast/core/LexicalCast.h>
+#include <algorithm>
 #include <mutex>
 
 #include <openssl/sha.h>
 
 namespace ripple {
 
-std::mutex SHAMapInnerNode::childLock;
+std::array<SHAMapInnerNode::ChildLock, 64> SHAMapInnerNode::childLocks;
+std::array<SHAMapInnerNode::NodeCounter, 16> SHAMapInnerNode::sNodeCounters;
 
 SHAMapAbstractNode::~SHAMapAbstractNode() = default;
 
@@ -41,14 +43,15 @@ SHAMapInnerNode::clone(std::uint32_t seq) const
 {
     auto p = std::make_shared<SHAMapInnerNode>(seq);
     p->mHash = mHash;
-    p->mIsBranch = mIsBranch;
     p->mFullBelowGen = mFullBelowGen;
-    p->mHashes = mHashes;
-    std::lock_guard <std::mutex> lock(childLock);
-    for (int i = 0; i < 16; ++i)
+    auto const n = getBranchCount();
+    p->resize(n);
+    p->mIsBranch = mIsBranch;
+    std::lock_guard <std::mutex> lock(childLock());
+    for (int i = 0; i < n; ++i)
     {
-        p->mChildren[i] = mChildren[i];
-        assert(std::dynamic_pointer_cast<SHAMapInnerNodeV2>(p->mChildren[i]) == nullptr);
+        p->mBranches[i] = mBranches[i];
+        assert(std::dynamic_pointer_cast<SHAMapInnerNodeV2>(p->mBranches[i].child) == nullptr);
     }
     return std::move(p);
 }
@@ -58,18 +61,19 @@ SHAMapInnerNodeV2::clone(std::uint32_t seq) const
 {
     auto p = std::make_shared<SHAMapInnerNodeV2>(seq);
     p->mHash = mHash;
-    p->mIsBranch = mIsBranch;
     p->mFullBelowGen = mFullBelowGen;
-    p->mHashes = mHashes;
     p->common_ = common_;
     p->depth_ = depth_;
-    std::lock_guard <std::mutex> lock(childLock);
-    for (int i = 0; i < 16; ++i)
+    auto const n = getBranchCount();
+    p->resize(n);
+    p->mIsBranch = mIsBranch;
+    std::lock_guard <std::mutex> lock(childLock());
+    for (int i = 0; i < n; ++i)
     {
-        p->mChildren[i] = mChildren[i];
-        if (p->mChildren[i] != nullptr)
-            assert(std::dynamic_pointer_cast<SHAMapInnerNodeV2>(p->mChildren[i]) != nullptr ||
-                   std::dynamic_pointer_cast<SHAMapTreeNode>(p->mChildren[i]) != nullptr);
+        p->mBranches[i] = mBranches[i];
+        if (p->mBranches[i].child != nullptr)
+            assert(std::dynamic_pointer_cast<SHAMapInnerNodeV2>(p->mBranches[i].child) != nullptr ||
+                   std::dynamic_pointer_cast<SHAMapTreeNode>(p->mBranches[i].child) != nullptr);
     }
     return std::move(p);
 }
@@ -85,7 +89,7 @@ SHAMapTreeNode::SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
     : SHAMapAbstractNode(type, seq)
     , mItem (item)
 {
-    assert (item->peekData ().size () >= 12);
+    assert (item->size () >= 12);
     updateHash();
 }
 
@@ -94,7 +98,7 @@ SHAMapTreeNode::SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
     : SHAMapAbstractNode(type, seq, hash)
     , mItem (item)
 {
-    assert (item->peekData ().size () >= 12);
+    assert (item->size () >= 12);
 }
 
 std::shared_ptr<SHAMapAbstractNode>
@@ -107,19 +111,19 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         if (rawNode.empty ())
             return {};
 
-        Serializer s (rawNode.data(), rawNode.size() - 1);
+        // Leaves are built straight from the raw data; only
+        // inner nodes need a Serializer to parse.
+        Slice const data (rawNode.data(), rawNode.size() - 1);
         int type = rawNode[rawNode.size() - 1];
-        int len = s.getLength ();
+        int len = data.size ();
 
         if ((type < 0) || (type > 6))
             return {};
         if (type == 0)
         {
             // transaction
-            auto item = std::make_shared<SHAMapItem const>(
-                sha512Half(HashPrefix::transactionID,
-                    Slice(s.data(), s.size())),
-                        s.peekData());
+            auto item = make_shamapitem(
+                sha512Half(HashPrefix::transactionID, data), data);
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
@@ -130,13 +134,12 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (len < (256 / 8))
                 Throw<std::runtime_error> ("short AS node");
 
-            uint256 u;
-            s.get256 (u, len - (256 / 8));
-            s.chop (256 / 8);
+            auto const u = uint256::fromVoid (data.data() + len - (256 / 8));
 
             if (u.isZero ()) Throw<std::runtime_error> ("invalid AS node");
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = make_shamapitem (
+                u, Slice (data.data(), len - (256 / 8)));
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
@@ -147,14 +150,12 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (len != 512)
                 Throw<std::runtime_error> ("invalid FI node");
 
+            Serializer s (data.data(), data.size());
             auto ret = std::make_shared<SHAMapInnerNode>(seq);
+            std::array<SHAMapHash, 16> hashes;
             for (int i = 0; i < 16; ++i)
-            {
-                s.get256 (ret->mHashes[i].as_uint256(), i * 32);
-
-                if (ret->mHashes[i].isNonZero ())
-                    ret->mIsBranch |= (1 << i);
-            }
+                s.get256 (hashes[i].as_uint256(), i * 32);
+            ret->setBranchHashes (hashes);
             if (hashValid)
                 ret->mHash = hash;
             else
@@ -163,8 +164,10 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         }
         else if (type == 3)
         {
+            Serializer s (data.data(), data.size());
             auto ret = std::make_shared<SHAMapInnerNode>(seq);
             // compressed inner
+            std::array<SHAMapHash, 16> hashes;
             for (int i = 0; i < (len / 33); ++i)
             {
                 int pos;
@@ -172,10 +175,9 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
                     Throw<std::runtime_error> ("short CI node");
                 if ((pos < 0) || (pos >= 16))
                     Throw<std::runtime_error> ("invalid CI node");
-                s.get256 (ret->mHashes[pos].as_uint256(), i * 33);
-                if (ret->mHashes[pos].isNonZero ())
-                    ret->mIsBranch |= (1 << pos);
+                s.get256 (hashes[pos].as_uint256(), i * 33);
             }
+            ret->setBranchHashes (hashes);
             if (hashValid)
                 ret->mHash = hash;
             else
@@ -188,14 +190,13 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (len < (256 / 8))
                 Throw<std::runtime_error> ("short TM node");
 
-            uint256 u;
-            s.get256 (u, len - (256 / 8));
-            s.chop (256 / 8);
+            auto const u = uint256::fromVoid (data.data() + len - (256 / 8));
 
             if (u.isZero ())
                 Throw<std::runtime_error> ("invalid TM node");
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = make_shamapitem (
+                u, Slice (data.data(), len - (256 / 8)));
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
@@ -206,14 +207,12 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (len != 512)
                 Throw<std::runtime_error> ("invalid FI node");
 
+            Serializer s (data.data(), data.size());
             auto ret = std::make_shared<SHAMapInnerNodeV2>(seq);
+            std::array<SHAMapHash, 16> hashes;
             for (int i = 0; i < 16; ++i)
-            {
-                s.get256 (ret->mHashes[i].as_uint256(), i * 32);
-
-                if (ret->mHashes[i].isNonZero ())
-                    ret->mIsBranch |= (1 << i);
-            }
+                s.get256 (hashes[i].as_uint256(), i * 32);
+            ret->setBranchHashes (hashes);
             ret->set_common(id.getDepth(), id.getNodeID());
             if (hashValid)
                 ret->mHash = hash;
@@ -223,8 +222,10 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         }
         else if (type == 6)
         {
+            Serializer s (data.data(), data.size());
             auto ret = std::make_shared<SHAMapInnerNodeV2>(seq);
             // compressed v2 inner
+            std::array<SHAMapHash, 16> hashes;
             for (int i = 0; i < (len / 33); ++i)
             {
                 int pos;
@@ -232,10 +233,9 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
                     Throw<std::runtime_error> ("short CI node");
                 if ((pos < 0) || (pos >= 16))
                     Throw<std::runtime_error> ("invalid CI node");
-                s.get256 (ret->mHashes[pos].as_uint256(), i * 33);
-                if (ret->mHashes[pos].isNonZero ())
-                    ret->mIsBranch |= (1 << pos);
+                s.get256 (hashes[pos].as_uint256(), i * 33);
             }
+            ret->setBranchHashes (hashes);
             ret->set_common(id.getDepth(), id.getNodeID());
             if (hashValid)
                 ret->mHash = hash;
@@ -260,25 +260,21 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         prefix |= rawNode[2];
         prefix <<= 8;
         prefix |= rawNode[3];
-        Serializer s (rawNode.data() + 4, rawNode.size() - 4);
+        Slice const data (rawNode.data() + 4, rawNode.size() - 4);
 
         if (prefix == HashPrefix::transactionID)
         {
-            auto item = std::make_shared<SHAMapItem const>(
-                sha512Half(rawNode),
-                    s.peekData ());
+            auto item = make_shamapitem(sha512Half(rawNode), data);
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
         }
         else if (prefix == HashPrefix::leafNode)
         {
-            if (s.getLength () < 32)
+            if (data.size () < 32)
                 Throw<std::runtime_error> ("short PLN node");
 
-            uint256 u;
-            s.get256 (u, s.getLength () - 32);
-            s.chop (32);
+            auto const u = uint256::fromVoid (data.data() + data.size() - 32);
 
             if (u.isZero ())
             {
@@ -286,13 +282,15 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
                 Throw<std::runtime_error> ("invalid PLN node");
             }
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = make_shamapitem (
+                u, Slice (data.data(), data.size() - 32));
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
         }
         else if ((prefix == HashPrefix::innerNode) || (prefix == HashPrefix::innerNodeV2))
         {
+            Serializer s (data.data(), data.size());
             auto len = s.getLength();
             bool isV2 = (prefix == HashPrefix::innerNodeV2);
 
@@ -305,13 +303,10 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             else
                 ret = std::make_shared<SHAMapInnerNode>(seq);
 
+            std::array<SHAMapHash, 16> hashes;
             for (int i = 0; i < 16; ++i)
-            {
-                s.get256 (ret->mHashes[i].as_uint256(), i * 32);
-
-                if (ret->mHashes[i].isNonZero ())
-                    ret->mIsBranch |= (1 << i);
-            }
+                s.get256 (hashes[i].as_uint256(), i * 32);
+            ret->setBranchHashes (hashes);
 
             if (isV2)
             {
@@ -337,13 +332,13 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         else if (prefix == HashPrefix::txNode)
         {
             // transaction with metadata
-            if (s.getLength () < 32)
+            if (data.size () < 32)
                 Throw<std::runtime_error> ("short TXN node");
 
-            uint256 txID;
-            s.get256 (txID, s.getLength () - 32);
-            s.chop (32);
-            auto item = std::make_shared<SHAMapItem const> (txID, s.peekData ());
+            auto const txID =
+                uint256::fromVoid (data.data() + data.size() - 32);
+            auto item = make_shamapitem (
+                txID, Slice (data.data(), data.size() - 32));
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
@@ -368,8 +363,8 @@ SHAMapInnerNode::updateHash()
         sha512_half_hasher h;
         using beast::hash_append;
         hash_append(h, HashPrefix::innerNode);
-        for(auto const& hh : mHashes)
-            hash_append(h, hh);
+        for (int i = 0; i < 16; ++i)
+            hash_append(h, getChildHash(i));
         nh = static_cast<typename
             sha512_half_hasher::result_type>(h);
     }
@@ -382,12 +377,65 @@ SHAMapInnerNode::updateHash()
 void
 SHAMapInnerNode::updateHashDeep()
 {
-    for (auto pos = 0; pos < 16; ++pos)
+    updateChildHashes();
+    updateHash();
+}
+
+void
+SHAMapInnerNode::updateChildHashes()
+{
+    for (int i = 0, n = getBranchCount(); i < n; ++i)
     {
-        if (mChildren[pos] != nullptr)
-            mHashes[pos] = mChildren[pos]->getNodeHash();
+        if (mBranches[i].child != nullptr)
+            mBranches[i].hash = mBranches[i].child->getNodeHash();
+    }
+}
+
+void
+SHAMapAbstractNode::updateHashes (std::vector<SHAMapAbstractNode*> const& nodes)
+{
+    // The nodes are serialized a chunk at a time, to bound the memory
+    // held by their serializations
+    std::size_t const chunk = 256;
+
+    std::vector<Serializer> raw (std::min (chunk, nodes.size ()));
+    std::vector<SHAMapAbstractNode*> hashing;
+    std::vector<Slice> messages;
+    std::vector<uint256> digests;
+
+    for (std::size_t i = 0; i < nodes.size (); i += chunk)
+    {
+        hashing.clear ();
+        messages.clear ();
+
+        auto const end = std::min (nodes.size (), i + chunk);
+        for (auto j = i; j != end; ++j)
+        {
+            auto const node = nodes[j];
+            if (node == nullptr)
+                continue;
+
+            // An inner node with no children has a zero hash
+            if (node->isInner () &&
+                static_cast<SHAMapInnerNode*>(node)->isEmpty ())
+            {
+                node->mHash = SHAMapHash{};
+                continue;
+            }
+
+            auto& s = raw[hashing.size ()];
+            s.erase ();
+            node->addRaw (s, snfPREFIX);
+            hashing.push_back (node);
+            messages.push_back (s.slice ());
+        }
+
+        digests.resize (hashing.size ());
+        sha512HalfBatch (messages.data (), digests.data (), messages.size ());
+
+        for (std::size_t j = 0; j != hashing.size (); ++j)
+            hashing[j]->mHash = SHAMapHash{digests[j]};
     }
-    updateHash();
 }
 
 bool
@@ -397,18 +445,18 @@ SHAMapTreeNode::updateHash()
     if (mType == tnTRANSACTION_NM)
     {
         nh = sha512Half(HashPrefix::transactionID,
-            makeSlice(mItem->peekData()));
+            mItem->slice());
     }
     else if (mType == tnACCOUNT_STATE)
     {
         nh = sha512Half(HashPrefix::leafNode,
-            makeSlice(mItem->peekData()),
+            mItem->slice(),
                 mItem->key());
     }
     else if (mType == tnTRANSACTION_MD)
     {
         nh = sha512Half(HashPrefix::txNode,
-            makeSlice(mItem->peekData()),
+            mItem->slice(),
                 mItem->key());
     }
     else
@@ -441,18 +489,18 @@ SHAMapInnerNode::addRaw(Serializer& s, SHANodeFormat format) const
         {
             s.add32 (HashPrefix::innerNode);
 
-            for (auto const& hh : mHashes)
-                s.add256 (hh.as_uint256());
+            for (int i = 0; i < 16; ++i)
+                s.add256 (getChildHash(i).as_uint256());
         }
         else  // format == snfWIRE
         {
             if (getBranchCount () < 12)
             {
                 // compressed node
-                for (int i = 0; i < mHashes.size(); ++i)
+                for (int i = 0; i < 16; ++i)
                     if (!isEmptyBranch (i))
                     {
-                        s.add256 (mHashes[i].as_uint256());
+                        s.add256 (getChildHash(i).as_uint256());
                         s.add8 (i);
                     }
 
@@ -460,8 +508,8 @@ SHAMapInnerNode::addRaw(Serializer& s, SHANodeFormat format) const
             }
             else
             {
-                for (auto const& hh : mHashes)
-                    s.add256 (hh.as_uint256());
+                for (int i = 0; i < 16; ++i)
+                    s.add256 (getChildHash(i).as_uint256());
 
                 s.add8 (2);
             }
@@ -479,7 +527,7 @@ SHAMapInnerNodeV2::addRaw(Serializer& s, SHANodeFormat format) const
         s.add32 (HashPrefix::innerNodeV2);
 
         for (int i = 0 ; i < 16; ++i)
-            s.add256 (mHashes[i].as_uint256());
+            s.add256 (getChildHash(i).as_uint256());
 
         s.add8(depth_);
 
@@ -533,12 +581,12 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::leafNode);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
             s.add8 (1);
         }
@@ -548,11 +596,11 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::transactionID);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add8 (0);
         }
     }
@@ -561,12 +609,12 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::txNode);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->data (), mItem->size ());
             s.add256 (mItem->key());
             s.add8 (4);
         }
@@ -592,13 +640,75 @@ bool SHAMapInnerNode::isEmpty () const
 int SHAMapInnerNode::getBranchCount () const
 {
     assert (isInner ());
-    int count = 0;
+    return index (16);
+}
 
-    for (int i = 0; i < 16; ++i)
-        if (!isEmptyBranch (i))
-            ++count;
+void
+SHAMapInnerNode::resize (int capacity)
+{
+    assert (capacity >= getBranchCount ());
+    std::unique_ptr<Branch[]> branches;
+    if (capacity > 0)
+        branches.reset (new Branch[capacity]);
+    for (int i = 0, n = getBranchCount (); i < n; ++i)
+        branches[i] = std::move (mBranches[i]);
+    nodeCounter ().bytes.fetch_add (
+        (capacity - mCapacity) * sizeof (Branch), std::memory_order_relaxed);
+    mBranches = std::move (branches);
+    mCapacity = capacity;
+}
 
-    return count;
+int
+SHAMapInnerNode::addBranch (int m)
+{
+    auto const pos = index (m);
+    if (! isEmptyBranch (m))
+        return pos;
+    auto const n = getBranchCount ();
+    if (n == mCapacity)
+    {
+        // Leave room for another branch, so a node gaining
+        // children one at a time is not resized for each
+        resize (std::min (n + 2, 16));
+    }
+    for (int i = n; i > pos; --i)
+        mBranches[i] = std::move (mBranches[i - 1]);
+    mBranches[pos] = Branch {};
+    mIsBranch |= (1 << m);
+    return pos;
+}
+
+void
+SHAMapInnerNode::removeBranch (int m)
+{
+    if (isEmptyBranch (m))
+        return;
+    auto const n = getBranchCount ();
+    for (int i = index (m); i + 1 < n; ++i)
+        mBranches[i] = std::move (mBranches[i + 1]);
+    mBranches[n - 1] = Branch {};
+    mIsBranch &= ~(1 << m);
+}
+
+void
+SHAMapInnerNode::setBranchHashes (std::array<SHAMapHash, 16> const& hashes)
+{
+    std::uint16_t isBranch = 0;
+    int n = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (hashes[i].isNonZero ())
+        {
+            isBranch |= (1 << i);
+            ++n;
+        }
+    }
+    mIsBranch = 0;
+    resize (n);
+    mIsBranch = isBranch;
+    for (int i = 0, pos = 0; i < 16; ++i)
+        if (hashes[i].isNonZero ())
+            mBranches[pos++].hash = hashes[i];
 }
 
 #ifdef BEAST_DEBUG
@@ -627,14 +737,14 @@ std::string
 SHAMapInnerNode::getString(const SHAMapNodeID & id) const
 {
     std::string ret = SHAMapAbstractNode::getString(id);
-    for (int i = 0; i < mHashes.size(); ++i)
+    for (int i = 0; i < 16; ++i)
     {
         if (!isEmptyBranch (i))
         {
             ret += "\nb";
             ret += beast::lexicalCastThrow <std::string> (i);
             ret += " = ";
-            ret += to_string (mHashes[i]);
+            ret += to_string (getChildHash(i));
         }
     }
     return ret;
@@ -670,13 +780,17 @@ SHAMapInnerNode::setChild(int m, std::shared_ptr<SHAMapAbstractNode> const& chil
     assert (mType == tnINNER);
     assert (mSeq != 0);
     assert (child.get() != this);
-    mHashes[m].zero();
     mHash.zero();
     if (child)
-        mIsBranch |= (1 << m);
+    {
+        auto& branch = mBranches[addBranch (m)];
+        branch.hash.zero();
+        branch.child = child;
+    }
     else
-        mIsBranch &= ~ (1 << m);
-    mChildren[m] = child;
+    {
+        removeBranch (m);
+    }
 }
 
 // finished modifying, now make shareable
@@ -687,8 +801,9 @@ void SHAMapInnerNode::shareChild (int m, std::shared_ptr<SHAMapAbstractNode> con
     assert (mSeq != 0);
     assert (child);
     assert (child.get() != this);
+    assert (!isEmptyBranch (m));
 
-    mChildren[m] = child;
+    mBranches[index (m)].child = child;
 }
 
 SHAMapAbstractNode*
@@ -697,8 +812,10 @@ SHAMapInnerNode::getChildPointer (int branch)
     assert (branch >= 0 && branch < 16);
     assert (isInner());
 
-    std::lock_guard <std::mutex> lock (childLock);
-    return mChildren[branch].get ();
+    if (isEmptyBranch (branch))
+        return nullptr;
+    std::lock_guard <std::mutex> lock (childLock());
+    return mBranches[index (branch)].child.get ();
 }
 
 std::shared_ptr<SHAMapAbstractNode>
@@ -707,8 +824,10 @@ SHAMapInnerNode::getChild (int branch)
     assert (branch >= 0 && branch < 16);
     assert (isInner());
 
-    std::lock_guard <std::mutex> lock (childLock);
-    return mChildren[branch];
+    if (isEmptyBranch (branch))
+        return {};
+    std::lock_guard <std::mutex> lock (childLock());
+    return mBranches[index (branch)].child;
 }
 
 std::shared_ptr<SHAMapAbstractNode>
@@ -717,20 +836,22 @@ SHAMapInnerNode::canonicalizeChild(int branch, std::shared_ptr<SHAMapAbstractNod
     assert (branch >= 0 && branch < 16);
     assert (isInner());
     assert (node);
-    assert (node->getNodeHash() == mHashes[branch]);
+    assert (node->getNodeHash() == getChildHash(branch));
+    assert (!isEmptyBranch (branch));
 
-    std::lock_guard <std::mutex> lock (childLock);
-    if (mChildren[branch])
+    auto& child = mBranches[index (branch)].child;
+    std::lock_guard <std::mutex> lock (childLock());
+    if (child)
     {
         // There is already a node hooked up, return it
-        node = mChildren[branch];
+        node = child;
     }
     else
     {
         // Hook this node up
         // node must not be a v2 inner node
         assert(std::dynamic_pointer_cast<SHAMapInnerNodeV2>(node) == nullptr);
-        mChildren[branch] = node;
+        child = node;
     }
     return node;
 }
@@ -741,13 +862,15 @@ SHAMapInnerNodeV2::canonicalizeChild(int branch, std::shared_ptr<SHAMapAbstractN
     assert (branch >= 0 && branch < 16);
     assert (isInner());
     assert (node);
-    assert (node->getNodeHash() == mHashes[branch]);
+    assert (node->getNodeHash() == getChildHash(branch));
+    assert (!isEmptyBranch (branch));
 
-    std::lock_guard <std::mutex> lock (childLock);
-    if (mChildren[branch])
+    auto& child = mBranches[index (branch)].child;
+    std::lock_guard <std::mutex> lock (childLock());
+    if (child)
     {
         // There is already a node hooked up, return it
-        node = mChildren[branch];
+        node = child;
     }
     else
     {
@@ -755,7 +878,7 @@ SHAMapInnerNodeV2::canonicalizeChild(int branch, std::shared_ptr<SHAMapAbstractN
         // node must not be a v1 inner node
         assert(std::dynamic_pointer_cast<SHAMapInnerNodeV2>(node) != nullptr ||
                std::dynamic_pointer_cast<SHAMapTreeNode>(node)    != nullptr);
-        mChildren[branch] = node;
+        child = node;
     }
     return node;
 }
@@ -827,10 +950,8 @@ SHAMapInnerNodeV2::setChildren(std::shared_ptr<SHAMapTreeNode> const& child1,
         b2 = *k2 >> 4;
         depth_ = 2*depth_;
     }
-    mChildren[b1] = child1;
-    mIsBranch |= 1 << b1;
-    mChildren[b2] = child2;
-    mIsBranch |= 1 << b2;
+    mBranches[addBranch (b1)].child = child1;
+    mBranches[addBranch (b2)].child = child2;
 }
 
 void
@@ -868,11 +989,12 @@ SHAMapInnerNode::invariants(bool is_v2, bool is_root) const
     unsigned count = 0;
     for (int i = 0; i < 16; ++i)
     {
-        if (mHashes[i].isNonZero())
+        if (getChildHash(i).isNonZero())
         {
             assert((mIsBranch & (1 << i)) != 0);
-            if (mChildren[i] != nullptr)
-                mChildren[i]->invariants(is_v2);
+            auto const& child = mBranches[index(i)].child;
+            if (child != nullptr)
+                child->invariants(is_v2);
             ++count;
         }
         else
@@ -896,21 +1018,22 @@ SHAMapInnerNodeV2::invariants(bool is_v2, bool is_root) const
     unsigned count = 0;
     for (int i = 0; i < 16; ++i)
     {
-        if (mHashes[i].isNonZero())
+        if (getChildHash(i).isNonZero())
         {
             assert((mIsBranch & (1 << i)) != 0);
-            if (mChildren[i] != nullptr)
+            auto const& child = mBranches[index(i)].child;
+            if (child != nullptr)
             {
-                assert(mHashes[i] == mChildren[i]->getNodeHash());
+                assert(getChildHash(i) == child->getNodeHash());
 #ifndef NDEBUG
-                auto const& childID = mChildren[i]->key();
+                auto const& childID = child->key();
 
                 // Make sure this child it attached to the correct branch
                 SHAMapNodeID nodeID {depth(), common()};
                 assert (i == nodeID.selectBranch(childID));
 #endif
                 assert(has_common_prefix(childID));
-                mChildren[i]->invariants(is_v2);
+                child->invariants(is_v2);
             }
             ++count;
         }
@@ -30,6 +30,7 @@
 #include <ripple/app/misc/impl/AmendmentTable.cpp>
 #include <ripple/app/misc/impl/LoadFeeTrack.cpp>
 #include <ripple/app/misc/impl/Manifest.cpp>
+#include <ripple/app/misc/impl/SignatureVerifier.cpp>
 #include <ripple/app/misc/impl/Transaction.cpp>
 #include <ripple/app/misc/impl/TxQ.cpp>
 #include <ripple/app/misc/impl/ValidatorList.cpp>
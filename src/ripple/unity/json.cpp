@@ -25,6 +25,7 @@
 #include <sstream>
 #include <string>
 
+#include <ripple/json/impl/json_arena.cpp>
 #include <ripple/json/impl/json_reader.cpp>
 #include <ripple/json/impl/json_value.cpp>
 #include <ripple/json/impl/json_valueiterator.cpp>
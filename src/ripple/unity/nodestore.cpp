@@ -28,9 +28,11 @@
 #include <ripple/nodestore/impl/BatchWriter.cpp>
 #include <ripple/nodestore/impl/DatabaseImp.h>
 #include <ripple/nodestore/impl/DatabaseRotatingImp.cpp>
+#include <ripple/nodestore/impl/DatabaseShardImp.cpp>
 #include <ripple/nodestore/impl/DummyScheduler.cpp>
 #include <ripple/nodestore/impl/DecodedBlob.cpp>
 #include <ripple/nodestore/impl/EncodedBlob.cpp>
 #include <ripple/nodestore/impl/ManagerImp.cpp>
 #include <ripple/nodestore/impl/NodeObject.cpp>
+#include <ripple/nodestore/impl/Shard.cpp>
 
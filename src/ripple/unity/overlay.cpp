@@ -25,6 +25,7 @@
 #include <ripple/overlay/impl/OverlayImpl.cpp>
 #include <ripple/overlay/impl/PeerImp.cpp>
 #include <ripple/overlay/impl/PeerSet.cpp>
+#include <ripple/overlay/impl/Squelch.cpp>
 #include <ripple/overlay/impl/TMHello.cpp>
 #include <ripple/overlay/impl/TrafficCount.cpp>
 
@@ -89,6 +89,7 @@
 
 #include <ripple/rpc/impl/Handler.cpp>
 #include <ripple/rpc/impl/LegacyPathFind.cpp>
+#include <ripple/rpc/impl/ResponseStream.cpp>
 #include <ripple/rpc/impl/Role.cpp>
 #include <ripple/rpc/impl/RPCHelpers.cpp>
 #include <ripple/rpc/impl/ServerHandlerImp.cpp>
@@ -18,6 +18,7 @@
 //==============================================================================
 
 #include <BeastConfig.h>
+#include <ripple/shamap/impl/FlushPool.cpp>
 #include <ripple/shamap/impl/SHAMap.cpp>
 #include <ripple/shamap/impl/SHAMapDelta.cpp>
 #include <ripple/shamap/impl/SHAMapItem.cpp>
@@ -17,10 +17,18 @@
 */
 //==============================================================================
 #include <test/jtx.h>
+#include <ripple/app/main/DBInit.h>
+#include <ripple/app/misc/impl/AccountTxPaging.h>
 #include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/temp_dir.h>
+#include <ripple/core/DatabaseCon.h>
 #include <ripple/protocol/SField.h>
 #include <ripple/protocol/JsonFields.h>
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <numeric>
+#include <vector>
 
 namespace ripple {
 
@@ -268,5 +276,144 @@ public:
 
 BEAST_DEFINE_TESTSUITE(AccountTxPaging,app,ripple);
 
+//------------------------------------------------------------------------------
+
+// Pages through every transaction of an account with a very long history
+class AccountTxPagingBench_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    static std::size_t constexpr transactions = 1000000;
+    static std::size_t constexpr txnsPerLedger = 20;
+    static std::uint32_t constexpr pageLength = 200;
+    static std::int32_t constexpr firstLedger = 1000;
+    static std::int32_t constexpr lastLedger =
+        firstLedger + transactions / txnsPerLedger - 1;
+
+    static
+    DatabaseCon::Setup
+    setup (beast::temp_dir const& dir)
+    {
+        DatabaseCon::Setup s;
+        s.dataDir = dir.path ();
+        return s;
+    }
+
+    static
+    void
+    populate (DatabaseCon& connection, std::string const& account)
+    {
+        auto db = connection.checkoutDb ();
+        soci::transaction tr (*db);
+
+        std::string id;
+        std::int64_t ledgerSeq;
+        std::int64_t txnSeq;
+        std::string const raw (200, 'r');
+        std::string const meta (400, 'm');
+
+        soci::statement accountTxn = (db->prepare <<
+            "INSERT INTO AccountTransactions "
+            "(TransID, Account, LedgerSeq, TxnSeq) "
+            "VALUES (:id, :account, :ledgerSeq, :txnSeq);",
+            soci::use (id), soci::use (account),
+            soci::use (ledgerSeq), soci::use (txnSeq));
+
+        soci::statement txn = (db->prepare <<
+            "INSERT INTO Transactions "
+            "(TransID, LedgerSeq, Status, RawTxn, TxnMeta) "
+            "VALUES (:id, :ledgerSeq, 'V', :raw, :meta);",
+            soci::use (id), soci::use (ledgerSeq),
+            soci::use (raw), soci::use (meta));
+
+        for (std::size_t i = 0; i < transactions; ++i)
+        {
+            id = to_string (uint256 (i));
+            ledgerSeq = firstLedger + i / txnsPerLedger;
+            txnSeq = i % txnsPerLedger;
+            accountTxn.execute (true);
+            txn.execute (true);
+        }
+
+        tr.commit ();
+    }
+
+    void
+    walk (DatabaseCon& connection, AccountIDCache const& idCache,
+        AccountID const& account, bool forward)
+    {
+        using namespace std::chrono;
+
+        std::size_t count = 0;
+        std::uint32_t previous = forward ? 0 : lastLedger + 1;
+        bool ordered = true;
+        std::vector<clock_type::duration> pages;
+        Json::Value marker;
+
+        do
+        {
+            auto const start = clock_type::now ();
+            accountTxPage (connection, idCache,
+                [](std::uint32_t) {},
+                [&](std::uint32_t ledgerSeq, std::string const&,
+                    Blob const&, Blob const&)
+                {
+                    ordered = ordered && (forward ?
+                        ledgerSeq >= previous : ledgerSeq <= previous);
+                    previous = ledgerSeq;
+                    ++count;
+                },
+                account, firstLedger, lastLedger, forward, marker,
+                pageLength, false, pageLength);
+            pages.push_back (clock_type::now () - start);
+        }
+        while (marker);
+
+        BEAST_EXPECT(count == transactions);
+        BEAST_EXPECT(ordered);
+
+        auto const micros = [](clock_type::duration d)
+        {
+            return duration_cast<microseconds> (d).count ();
+        };
+        auto const sample = std::min<std::size_t> (pages.size (), 10);
+        auto const total = std::accumulate (
+            pages.begin (), pages.end (), clock_type::duration {});
+        auto const first = std::accumulate (
+            pages.begin (), pages.begin () + sample, clock_type::duration {});
+        auto const last = std::accumulate (
+            pages.end () - sample, pages.end (), clock_type::duration {});
+
+        log <<
+            "    " << (forward ? "forward" : "backward") << ": " <<
+            pages.size () << " pages in " <<
+            duration_cast<milliseconds> (total).count () << " ms, " <<
+            micros (first) / sample << " us/page at the start, " <<
+            micros (last) / sample << " us/page at the end" << std::endl;
+    }
+
+public:
+    void
+    run () override
+    {
+        testcase ("page through " + std::to_string (transactions) +
+            " transactions");
+
+        beast::temp_dir dir;
+        DatabaseCon txnDB (setup (dir),
+            "transaction.db", TxnDBInit, TxnDBCount);
+        AccountIDCache idCache (128);
+
+        auto const account = *parseBase58<AccountID> (
+            "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh");
+        populate (txnDB, idCache.toBase58 (account));
+
+        walk (txnDB, idCache, account, true);
+        walk (txnDB, idCache, account, false);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(AccountTxPagingBench,app,ripple);
+
 }
 
@@ -21,6 +21,13 @@
 #include <ripple/app/misc/HashRouter.h>
 #include <ripple/basics/chrono.h>
 #include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 
 namespace ripple {
 namespace test {
@@ -229,6 +236,100 @@ class HashRouter_test : public beast::unit_test::suite
         BEAST_EXPECT(peers && peers->size() == 0);
     }
 
+    void
+    testPeerSet()
+    {
+        HashRouter::PeerSet peers;
+        BEAST_EXPECT(peers.empty());
+
+        // Spill past the inline storage
+        for (HashRouter::PeerShortID i = 1; i <= 100; ++i)
+        {
+            BEAST_EXPECT(peers.insert(i * 7));
+            BEAST_EXPECT(!peers.insert(i * 7));
+            BEAST_EXPECT(peers.size() == i);
+        }
+        BEAST_EXPECT(peers.contains(700));
+        BEAST_EXPECT(!peers.contains(701));
+
+        auto moved = std::move(peers);
+        BEAST_EXPECT(peers.empty());
+        BEAST_EXPECT(moved.size() == 100);
+        BEAST_EXPECT(std::count(moved.begin(), moved.end(), 14) == 1);
+
+        HashRouter::PeerSet small;
+        small.insert(1);
+        small.insert(2);
+        moved = std::move(small);
+        BEAST_EXPECT(moved.size() == 2);
+        BEAST_EXPECT(moved.contains(2));
+
+        // Peers are reported no matter how many there are
+        using namespace std::chrono_literals;
+        TestStopwatch stopwatch;
+        HashRouter router(stopwatch, 2s);
+        uint256 const key1(1);
+        for (HashRouter::PeerShortID i = 1; i <= 50; ++i)
+            router.addSuppressionPeer(key1, i);
+        router.addSuppressionPeer(key1, 25);
+        auto const relay = router.shouldRelay(key1);
+        BEAST_EXPECT(relay && relay->size() == 50);
+        BEAST_EXPECT(relay && relay->count(25) == 1);
+    }
+
+    void
+    testWheel()
+    {
+        using namespace std::chrono_literals;
+        TestStopwatch stopwatch;
+        HashRouter router(stopwatch, 3s);
+
+        beast::xor_shift_engine g(42);
+        auto randomKeys = [&g](std::size_t n)
+        {
+            std::vector<uint256> keys(n);
+            for (auto& key : keys)
+                beast::rngfill(key.data(), key.size(), g);
+            return keys;
+        };
+
+        // Keys spread over every partition, with even ones kept alive
+        auto const keys = randomKeys(1000);
+        for (auto const& key : keys)
+            router.setFlags(key, SF_SAVED);
+        BEAST_EXPECT(router.size() == keys.size());
+        for (int i = 0; i < 3; ++i)
+        {
+            ++stopwatch;
+            for (std::size_t j = 0; j < keys.size(); j += 2)
+                BEAST_EXPECT(router.getFlags(keys[j]) == SF_SAVED);
+        }
+
+        // Nothing expires until a new entry is added to each partition
+        BEAST_EXPECT(router.size() == keys.size());
+        auto const more = randomKeys(1000);
+        for (auto const& key : more)
+            router.addSuppression(key);
+        BEAST_EXPECT(router.size() == keys.size() / 2 + more.size());
+        for (std::size_t j = 0; j < keys.size(); j += 2)
+            BEAST_EXPECT(router.getFlags(keys[j]) == SF_SAVED);
+
+        // Entries in a partition that has not caught up are still
+        // treated as expired
+        for (int i = 0; i < 100; ++i)
+            ++stopwatch;
+        router.addSuppression(uint256(1));
+        for (std::size_t j = 0; j < keys.size(); j += 2)
+            BEAST_EXPECT(router.getFlags(keys[j]) == 0);
+
+        // After a jump of many turns, one insertion per partition
+        // reclaims all the old entries. What remains are the entries
+        // added since the jump.
+        for (auto const& key : randomKeys(1000))
+            router.addSuppression(key);
+        BEAST_EXPECT(router.size() == 1 + keys.size() / 2 + 1000);
+    }
+
 public:
 
     void
@@ -239,10 +340,95 @@ public:
         testSuppression();
         testSetFlags();
         testRelay();
+        testPeerSet();
+        testWheel();
     }
 };
 
 BEAST_DEFINE_TESTSUITE(HashRouter, app, ripple);
 
+//------------------------------------------------------------------------------
+
+// Measures HashRouter throughput when many threads report messages
+// at once, the way the overlay does for every message from every peer.
+class HashRouterContention_test : public beast::unit_test::suite
+{
+    std::vector <uint256> keys_;
+
+    // Each thread reports `ops` messages, each heard from a few peers,
+    // relaying one in eight. Returns the elapsed wall time.
+    std::chrono::nanoseconds
+    hammer (HashRouter& router, unsigned threads, std::size_t ops)
+    {
+        using namespace std::chrono;
+
+        std::vector <std::thread> workers;
+        workers.reserve (threads);
+
+        auto const start = steady_clock::now ();
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            workers.emplace_back (
+                [&, t]()
+                {
+                    beast::xor_shift_engine g (t + 1);
+                    for (std::size_t i = 0; i < ops; ++i)
+                    {
+                        auto const& key = keys_[g() % keys_.size()];
+                        router.addSuppressionPeer (key,
+                            static_cast<HashRouter::PeerShortID> (
+                                1 + g() % 20));
+                        if ((i & 7) == 0)
+                            router.shouldRelay (key);
+                    }
+                });
+        }
+        for (auto& w : workers)
+            w.join ();
+        return duration_cast <nanoseconds> (steady_clock::now () - start);
+    }
+
+public:
+    HashRouterContention_test ()
+    {
+        beast::xor_shift_engine g (19207813);
+        keys_.resize (100000);
+        for (auto& key : keys_)
+            beast::rngfill (key.data(), key.size(), g);
+    }
+
+    void
+    run () override
+    {
+        using namespace std::chrono;
+
+        testcase ("contention");
+
+        std::size_t const ops = 500000;
+
+        std::vector <unsigned> counts;
+        auto const cores = std::max (1u, std::thread::hardware_concurrency ());
+        for (unsigned t = 1; t < cores; t *= 2)
+            counts.push_back (t);
+        counts.push_back (cores);
+
+        for (auto const threads : counts)
+        {
+            HashRouter router (stopwatch (), HashRouter::getDefaultHoldTime ());
+            auto const d = hammer (router, threads, ops);
+            auto const total = ops * threads;
+            log <<
+                "    " << threads << " thread(s): " <<
+                duration_cast <milliseconds> (d).count() << " ms, " <<
+                static_cast <std::uint64_t> (total * 1e9 /
+                    std::max <nanoseconds::rep> (d.count(), 1)) <<
+                " ops/sec, " << router.size () << " entries" << std::endl;
+        }
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(HashRouterContention, app, ripple);
+
 }
 }
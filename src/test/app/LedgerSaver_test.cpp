@@ -0,0 +1,364 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/LedgerSaver.h>
+#include <ripple/app/main/DBInit.h>
+#include <ripple/basics/StringUtilities.h>
+#include <ripple/core/DatabaseCon.h>
+#include <ripple/core/SociDB.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/utility/temp_dir.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ripple {
+namespace test {
+
+namespace detail {
+
+// The transaction and ledger databases, in a temporary directory
+class SavedLedgerDBs
+{
+    beast::temp_dir dir_;
+
+    static
+    DatabaseCon::Setup
+    setup (beast::temp_dir const& dir)
+    {
+        DatabaseCon::Setup s;
+        s.dataDir = dir.path ();
+        return s;
+    }
+
+public:
+    DatabaseCon txnDB;
+    DatabaseCon ledgerDB;
+
+    SavedLedgerDBs ()
+        : txnDB (setup (dir_), "transaction.db", TxnDBInit, TxnDBCount)
+        , ledgerDB (setup (dir_), "ledger.db", LedgerDBInit, LedgerDBCount)
+    {
+    }
+};
+
+// A ledger of `count` transactions, each affecting `accounts` accounts
+inline
+SavedLedger
+makeSavedLedger (LedgerIndex seq, std::size_t count,
+    std::size_t accounts, beast::xor_shift_engine& g)
+{
+    auto random = [&g](std::size_t bytes)
+    {
+        Blob b (bytes);
+        beast::rngfill (b.data (), b.size (), g);
+        return b;
+    };
+    auto randomID = [&]()
+    {
+        uint256 id;
+        beast::rngfill (id.data (), id.size (), g);
+        return id;
+    };
+    auto randomAccount = [&]()
+    {
+        AccountID id;
+        beast::rngfill (id.data (), id.size (), g);
+        return toBase58 (id);
+    };
+
+    SavedLedger ledger;
+    ledger.info.seq = seq;
+    ledger.info.hash = randomID ();
+    ledger.info.parentHash = randomID ();
+    ledger.info.txHash = randomID ();
+    ledger.info.accountHash = randomID ();
+    ledger.info.drops = XRPAmount {99999999999999999};
+    ledger.info.closeTime = NetClock::time_point {
+        NetClock::duration {seq * 4}};
+    ledger.info.parentCloseTime = NetClock::time_point {
+        NetClock::duration {seq * 4 - 4}};
+    ledger.info.closeTimeResolution = NetClock::duration {10};
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        SavedLedger::Transaction t;
+        t.id = to_string (randomID ());
+        t.type = "Payment";
+        t.account = randomAccount ();
+        t.sequence = static_cast<std::uint32_t> (g () % 100000);
+        t.txnSeq = static_cast<std::uint32_t> (i);
+        t.raw = random (200);
+        t.meta = random (400);
+        t.affected.push_back (t.account);
+        while (t.affected.size () < accounts)
+            t.affected.push_back (randomAccount ());
+        ledger.transactions.push_back (std::move (t));
+    }
+    return ledger;
+}
+
+} // detail
+
+class LedgerSaver_test : public beast::unit_test::suite
+{
+    std::size_t
+    count (DatabaseCon& dbc, std::string const& sql)
+    {
+        auto db = dbc.checkoutDb ();
+        std::size_t n = 0;
+        *db << sql, soci::into (n);
+        return n;
+    }
+
+    void
+    testWrite ()
+    {
+        testcase ("write");
+
+        detail::SavedLedgerDBs dbs;
+        SavedLedgerWriter writer (dbs.txnDB, dbs.ledgerDB);
+        beast::xor_shift_engine g (5);
+
+        std::vector<SavedLedger> ledgers;
+        for (LedgerIndex seq = 10; seq < 13; ++seq)
+            ledgers.push_back (detail::makeSavedLedger (seq, 20, 3, g));
+        writer.write (ledgers);
+
+        BEAST_EXPECT(count (dbs.ledgerDB,
+            "SELECT COUNT(*) FROM Ledgers;") == 3);
+        BEAST_EXPECT(count (dbs.txnDB,
+            "SELECT COUNT(*) FROM Transactions;") == 60);
+        BEAST_EXPECT(count (dbs.txnDB,
+            "SELECT COUNT(*) FROM AccountTransactions;") == 180);
+
+        {
+            // Every column reads back as written
+            auto const& l = ledgers[1];
+            auto const& t = l.transactions[7];
+
+            auto db = dbs.txnDB.checkoutDb ();
+            std::string type, account, status;
+            std::uint32_t sequence = 0, seq = 0;
+            soci::blob raw (*db), meta (*db);
+            *db << "SELECT TransType, FromAcct, FromSeq, LedgerSeq, Status, "
+                "RawTxn, TxnMeta FROM Transactions WHERE TransID = :id;",
+                soci::use (t.id), soci::into (type), soci::into (account),
+                soci::into (sequence), soci::into (seq), soci::into (status),
+                soci::into (raw), soci::into (meta);
+            Blob rawTxn, txnMeta;
+            convert (raw, rawTxn);
+            convert (meta, txnMeta);
+            BEAST_EXPECT(type == t.type);
+            BEAST_EXPECT(account == t.account);
+            BEAST_EXPECT(sequence == t.sequence);
+            BEAST_EXPECT(seq == l.info.seq);
+            BEAST_EXPECT(status == "V");
+            BEAST_EXPECT(rawTxn == t.raw);
+            BEAST_EXPECT(txnMeta == t.meta);
+
+            std::uint32_t txnSeq = 0;
+            *db << "SELECT TxnSeq FROM AccountTransactions "
+                "WHERE TransID = :id AND Account = :account;",
+                soci::use (t.id), soci::use (t.affected[2]),
+                soci::into (txnSeq);
+            BEAST_EXPECT(txnSeq == t.txnSeq);
+        }
+
+        {
+            auto const& l = ledgers[2];
+            auto db = dbs.ledgerDB.checkoutDb ();
+            std::string hash, txHash;
+            std::uint32_t closeTime = 0;
+            *db << "SELECT LedgerHash, TransSetHash, ClosingTime FROM Ledgers "
+                "WHERE LedgerSeq = :seq;",
+                soci::use (l.info.seq), soci::into (hash),
+                soci::into (txHash), soci::into (closeTime);
+            BEAST_EXPECT(hash == to_string (l.info.hash));
+            BEAST_EXPECT(txHash == to_string (l.info.txHash));
+            BEAST_EXPECT(closeTime ==
+                l.info.closeTime.time_since_epoch ().count ());
+        }
+
+        // Saving a ledger again replaces what was recorded for it
+        ledgers.erase (ledgers.begin ());
+        ledgers.front () = detail::makeSavedLedger (11, 5, 2, g);
+        ledgers.back ().transactions.resize (10);
+        writer.write (ledgers);
+
+        BEAST_EXPECT(count (dbs.ledgerDB,
+            "SELECT COUNT(*) FROM Ledgers;") == 3);
+        BEAST_EXPECT(count (dbs.txnDB,
+            "SELECT COUNT(*) FROM Transactions;") == 20 + 5 + 10);
+        BEAST_EXPECT(count (dbs.txnDB,
+            "SELECT COUNT(*) FROM AccountTransactions;") == 60 + 10 + 30);
+        BEAST_EXPECT(count (dbs.txnDB,
+            "SELECT COUNT(*) FROM AccountTransactions "
+            "WHERE LedgerSeq = 11;") == 10);
+
+        // A ledger without transactions
+        std::vector<SavedLedger> empty (1);
+        empty.front ().info.seq = 13;
+        writer.write (empty);
+        BEAST_EXPECT(count (dbs.ledgerDB,
+            "SELECT COUNT(*) FROM Ledgers;") == 4);
+    }
+
+    void
+    run () override
+    {
+        testWrite ();
+    }
+};
+
+// Measures how many ledgers per second are recorded in the
+// Transactions and AccountTransactions tables, writing each
+// ledger with statements built from strings as saveValidatedLedger
+// used to, and with SavedLedgerWriter in batches of various sizes.
+class LedgerSaverBench_test : public beast::unit_test::suite
+{
+    static std::size_t constexpr ledgerCount = 500;
+    static std::size_t constexpr txnsPerLedger = 100;
+    static std::size_t constexpr accountsPerTxn = 3;
+
+    // One statement per row, each parsed from a string
+    static
+    void
+    writeStrings (detail::SavedLedgerDBs& dbs, SavedLedger const& ledger)
+    {
+        auto const seq = ledger.info.seq;
+        auto const ledgerSeq = std::to_string (seq);
+        {
+            auto db = dbs.ledgerDB.checkoutDb ();
+            *db << "DELETE FROM Ledgers WHERE LedgerSeq = " + ledgerSeq + ";";
+        }
+        {
+            auto db = dbs.txnDB.checkoutDb ();
+            soci::transaction tr (*db);
+            *db << "DELETE FROM Transactions WHERE LedgerSeq = " +
+                ledgerSeq + ";";
+            *db << "DELETE FROM AccountTransactions WHERE LedgerSeq = " +
+                ledgerSeq + ";";
+            for (auto const& t : ledger.transactions)
+            {
+                auto const txnSeq = std::to_string (t.txnSeq);
+                *db << "DELETE FROM AccountTransactions WHERE TransID = '" +
+                    t.id + "';";
+
+                std::string sql (
+                    "INSERT INTO AccountTransactions "
+                    "(TransID, Account, LedgerSeq, TxnSeq) VALUES ");
+                bool first = true;
+                for (auto const& account : t.affected)
+                {
+                    sql += first ? "('" : ", ('";
+                    first = false;
+                    sql += t.id + "','" + account + "'," +
+                        ledgerSeq + "," + txnSeq + ")";
+                }
+                *db << sql + ";";
+
+                *db << "INSERT OR REPLACE INTO Transactions "
+                    "(TransID, TransType, FromAcct, FromSeq, LedgerSeq, "
+                    "Status, RawTxn, TxnMeta) VALUES ('" + t.id + "', '" +
+                    t.type + "', '" + t.account + "', '" +
+                    std::to_string (t.sequence) + "', '" + ledgerSeq +
+                    "', 'V', " + sqlEscape (t.raw) + ", " +
+                    sqlEscape (t.meta) + ");";
+            }
+            tr.commit ();
+        }
+        {
+            auto db = dbs.ledgerDB.checkoutDb ();
+            *db << "INSERT OR REPLACE INTO Ledgers "
+                "(LedgerHash, LedgerSeq) VALUES ('" +
+                to_string (ledger.info.hash) + "', " + ledgerSeq + ");";
+        }
+    }
+
+    void
+    report (std::string const& name, std::chrono::nanoseconds elapsed)
+    {
+        using namespace std::chrono;
+        log <<
+            "    " << name << ": " <<
+            duration_cast<milliseconds> (elapsed).count () << " ms, " <<
+            static_cast<std::uint64_t> (ledgerCount * 1e9 /
+                std::max<nanoseconds::rep> (elapsed.count (), 1)) <<
+            " ledgers/sec" << std::endl;
+    }
+
+public:
+    void
+    run () override
+    {
+        using namespace std::chrono;
+        using clock_type = steady_clock;
+
+        testcase ("ledgers per second");
+
+        std::vector<SavedLedger> ledgers;
+        {
+            beast::xor_shift_engine g (1);
+            for (std::size_t i = 0; i < ledgerCount; ++i)
+                ledgers.push_back (detail::makeSavedLedger (
+                    static_cast<LedgerIndex> (30000000 + i),
+                        txnsPerLedger, accountsPerTxn, g));
+        }
+
+        {
+            detail::SavedLedgerDBs dbs;
+            auto const start = clock_type::now ();
+            for (auto const& ledger : ledgers)
+                writeStrings (dbs, ledger);
+            report ("string statements", clock_type::now () - start);
+        }
+
+        for (std::size_t batch : {1, 8, 32, 128})
+        {
+            std::vector<std::vector<SavedLedger>> batches;
+            for (std::size_t i = 0; i < ledgers.size (); i += batch)
+            {
+                auto const last = std::min (i + batch, ledgers.size ());
+                batches.emplace_back (
+                    ledgers.begin () + i, ledgers.begin () + last);
+            }
+
+            detail::SavedLedgerDBs dbs;
+            SavedLedgerWriter writer (dbs.txnDB, dbs.ledgerDB);
+
+            auto const start = clock_type::now ();
+            for (auto const& b : batches)
+                writer.write (b);
+            report ("prepared statements, " + std::to_string (batch) +
+                " ledger(s) per write", clock_type::now () - start);
+        }
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerSaver,app,ripple);
+BEAST_DEFINE_TESTSUITE_MANUAL(LedgerSaverBench,app,ripple);
+
+} // test
+} // ripple
@@ -0,0 +1,260 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <ripple/app/ledger/OrderBookDB.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/core/Stoppable.h>
+
+namespace ripple {
+namespace test {
+
+class OrderBookDB_test : public beast::unit_test::suite
+{
+    // Books built from scratch must match the books maintained
+    // incrementally.
+    void
+    expectSame (OrderBookDB& db, jtx::Env& env,
+        std::vector<Issue> const& issues)
+    {
+        RootStoppable parent ("OrderBookDB_test");
+        OrderBookDB full (env.app(), parent);
+        full.setup (env.closed());
+        for (auto const& issue : issues)
+        {
+            BEAST_EXPECT(db.getBookSize (issue) == full.getBookSize (issue));
+            BEAST_EXPECT(db.isBookToXRP (issue) == full.isBookToXRP (issue));
+        }
+    }
+
+    void
+    testIncremental ()
+    {
+        testcase ("incremental");
+
+        using namespace jtx;
+        Env env (*this);
+        auto const gw = Account ("gateway");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+        env.fund (XRP(10000), "alice", "bob", gw);
+        env.trust (USD(1000), "alice", "bob");
+        env.trust (EUR(1000), "alice", "bob");
+        env (pay (gw, "alice", USD(100)));
+        env (pay (gw, "alice", EUR(100)));
+        env.close ();
+
+        RootStoppable parent ("OrderBookDB_test");
+        OrderBookDB db (env.app(), parent);
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 0);
+        BEAST_EXPECT(! db.isBookToXRP (USD));
+
+        // Each ledger is applied from its metadata
+        auto const s1 = env.seq ("alice");
+        env (offer ("alice", USD(10), XRP(10)));
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 1);
+        BEAST_EXPECT(db.isBookToXRP (USD));
+        expectSame (db, env, {USD.issue(), EUR.issue(), xrpIssue()});
+
+        // A second quality in the same book, and a book between IOUs
+        auto const s2 = env.seq ("alice");
+        env (offer ("alice", USD(10), XRP(20)));
+        env (offer ("alice", USD(10), EUR(10)));
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 2);
+        expectSame (db, env, {USD.issue(), EUR.issue(), xrpIssue()});
+
+        // The book remains while any quality directory remains
+        env (offer_cancel ("alice", s1));
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 2);
+        BEAST_EXPECT(db.isBookToXRP (USD));
+
+        env (offer_cancel ("alice", s2));
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 1);
+        BEAST_EXPECT(! db.isBookToXRP (USD));
+        expectSame (db, env, {USD.issue(), EUR.issue(), xrpIssue()});
+
+        // Books from XRP
+        env (offer ("alice", XRP(10), EUR(10)));
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (xrpIssue()) == 1);
+        expectSame (db, env, {USD.issue(), EUR.issue(), xrpIssue()});
+    }
+
+    void
+    testGap ()
+    {
+        testcase ("gap");
+
+        using namespace jtx;
+        Env env (*this);
+        auto const gw = Account ("gateway");
+        auto const USD = gw["USD"];
+        env.fund (XRP(10000), "alice", gw);
+        env.trust (USD(1000), "alice");
+        env (pay (gw, "alice", USD(100)));
+        env.close ();
+
+        RootStoppable parent ("OrderBookDB_test");
+        OrderBookDB db (env.app(), parent);
+        db.setup (env.closed());
+
+        // A ledger that does not follow the last one rebuilds the books
+        auto const seq = env.seq ("alice");
+        env (offer ("alice", USD(10), XRP(10)));
+        env.close ();
+        auto const skipped = env.closed();
+        env (offer_cancel ("alice", seq));
+        env (offer ("alice", XRP(10), USD(10)));
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 0);
+        BEAST_EXPECT(! db.isBookToXRP (USD));
+        BEAST_EXPECT(db.getBookSize (xrpIssue()) == 1);
+
+        // An earlier ledger is ignored
+        db.setup (skipped);
+        BEAST_EXPECT(db.getBookSize (USD) == 0);
+        BEAST_EXPECT(db.getBookSize (xrpIssue()) == 1);
+    }
+
+    void
+    testSameLedger ()
+    {
+        testcase ("create and delete in one ledger");
+
+        using namespace jtx;
+        Env env (*this);
+        auto const gw = Account ("gateway");
+        auto const USD = gw["USD"];
+        env.fund (XRP(10000), "alice", gw);
+        env.trust (USD(1000), "alice");
+        env (pay (gw, "alice", USD(100)));
+        env.close ();
+
+        RootStoppable parent ("OrderBookDB_test");
+        OrderBookDB db (env.app(), parent);
+        db.setup (env.closed());
+
+        // The transactions of a ledger are listed by hash, so each
+        // ledger gets a different order to undo
+        for (int i = 1; i <= 8; ++i)
+        {
+            auto const seq = env.seq ("alice");
+            env (offer ("alice", USD(10), XRP(10 * i)));
+            env (offer_cancel ("alice", seq));
+            env.close ();
+            db.setup (env.closed());
+            BEAST_EXPECT(db.getBookSize (USD) == 0);
+            BEAST_EXPECT(! db.isBookToXRP (USD));
+        }
+
+        // A book that outlives its ledger is still counted
+        env (offer ("alice", USD(10), XRP(10)));
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 1);
+        expectSame (db, env, {USD.issue(), xrpIssue()});
+    }
+
+    void
+    testUnconfirmed ()
+    {
+        testcase ("open ledger books");
+
+        using namespace jtx;
+        Env env (*this);
+        auto const gw = Account ("gateway");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+        env.fund (XRP(10000), "alice", gw);
+        env.trust (USD(1000), "alice");
+        env.trust (EUR(1000), "alice");
+        env (pay (gw, "alice", USD(100)));
+        env (pay (gw, "alice", EUR(100)));
+        env.close ();
+
+        RootStoppable parent ("OrderBookDB_test");
+        OrderBookDB db (env.app(), parent);
+        db.setup (env.closed());
+
+        // Books added from the open ledger are available at once
+        db.addOrderBook (Book (USD.issue(), xrpIssue()));
+        db.addOrderBook (Book (EUR.issue(), xrpIssue()));
+        BEAST_EXPECT(db.getBookSize (USD) == 1);
+        BEAST_EXPECT(db.getBookSize (EUR) == 1);
+        BEAST_EXPECT(db.isBookToXRP (USD));
+
+        // Only the EUR book is confirmed by a validated ledger
+        env (offer ("alice", EUR(10), XRP(10)));
+        for (int i = 1; i < 4; ++i)
+        {
+            env.close ();
+            db.setup (env.closed());
+            BEAST_EXPECT(db.getBookSize (USD) == 1);
+            BEAST_EXPECT(db.getBookSize (EUR) == 1);
+        }
+
+        // The USD book waited too long
+        env.close ();
+        db.setup (env.closed());
+        BEAST_EXPECT(db.getBookSize (USD) == 0);
+        BEAST_EXPECT(! db.isBookToXRP (USD));
+        BEAST_EXPECT(db.getBookSize (EUR) == 1);
+        expectSame (db, env, {USD.issue(), EUR.issue(), xrpIssue()});
+
+        // A book that is added again comes back
+        db.addOrderBook (Book (USD.issue(), xrpIssue()));
+        BEAST_EXPECT(db.getBookSize (USD) == 1);
+        env (offer ("alice", USD(10), XRP(10)));
+        for (int i = 0; i < 6; ++i)
+        {
+            env.close ();
+            db.setup (env.closed());
+        }
+        BEAST_EXPECT(db.getBookSize (USD) == 1);
+        expectSame (db, env, {USD.issue(), EUR.issue(), xrpIssue()});
+    }
+
+public:
+    void
+    run () override
+    {
+        testIncremental ();
+        testGap ();
+        testSameLedger ();
+        testUnconfirmed ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(OrderBookDB,app,ripple);
+
+} // test
+} // ripple
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <test/jtx.h>
+#include <ripple/app/paths/PathRequests.h>
+#include <ripple/app/paths/RippleLineCache.h>
+#include <ripple/beast/unit_test.h>
+#include <thread>
+
+namespace ripple {
+namespace test {
+
+class PathRequests_test : public beast::unit_test::suite
+{
+    void
+    testHistogram ()
+    {
+        testcase ("latency histogram");
+
+        using namespace std::chrono;
+        auto const last = PathLatencyHistogram::buckets - 1;
+
+        {
+            PathLatencyHistogram h;
+            BEAST_EXPECT(h.getJson ().size () == 0);
+        }
+
+        // A reply that took 2^i - 1 milliseconds lands in "lt_2^i ms".
+        for (std::size_t i = 0; i < last; ++i)
+        {
+            auto const bound = 1ull << i;
+            PathLatencyHistogram h;
+            h.notify (milliseconds (bound - 1));
+            h.notify (milliseconds (bound - 1));
+            auto const key = "lt_" + std::to_string (bound) + "ms";
+            auto const j = h.getJson ();
+            BEAST_EXPECTS(j.size () == 1 && j.isMember (key), key);
+            BEAST_EXPECT(j[key].asUInt () == 2);
+        }
+
+        // Everything from 2^(buckets - 2) milliseconds up shares the
+        // last bucket.
+        {
+            auto const bound = 1ull << (last - 1);
+            auto const key = "ge_" + std::to_string (bound) + "ms";
+            PathLatencyHistogram h;
+            h.notify (milliseconds (bound));
+            h.notify (milliseconds (2 * bound));
+            h.notify (hours (1));
+            auto const j = h.getJson ();
+            BEAST_EXPECTS(j.size () == 1 && j.isMember (key), key);
+            BEAST_EXPECT(j[key].asUInt () == 3);
+        }
+
+        {
+            PathLatencyHistogram h;
+            h.notify (milliseconds (0));
+            h.notify (milliseconds (1));
+            h.notify (milliseconds (3));
+            h.notify (milliseconds (4));
+            auto const j = h.getJson ();
+            BEAST_EXPECT(j.size () == 4);
+            BEAST_EXPECT(j["lt_1ms"].asUInt () == 1);
+            BEAST_EXPECT(j["lt_2ms"].asUInt () == 1);
+            BEAST_EXPECT(j["lt_4ms"].asUInt () == 1);
+            BEAST_EXPECT(j["lt_8ms"].asUInt () == 1);
+            BEAST_EXPECT(! j.isMember ("lt_16ms"));
+        }
+    }
+
+    void
+    testLineCacheConcurrent ()
+    {
+        testcase ("line cache concurrent loads");
+
+        using namespace jtx;
+        Env env (*this);
+        auto const gw = Account ("gateway");
+        std::vector<Account> accounts;
+        for (int i = 0; i < 8; ++i)
+            accounts.emplace_back ("a" + std::to_string (i));
+        env.fund (XRP(10000), gw);
+        for (auto const& a : accounts)
+        {
+            env.fund (XRP(10000), a);
+            env.close ();
+            env.trust (gw["USD"](1000), a);
+            env.trust (gw["EUR"](1000), a);
+        }
+        env.close ();
+
+        RippleLineCache cache (env.closed ());
+
+        // Lines loaded before the other threads start must not move
+        // while they fill in the rest of the cache.
+        auto const& first = cache.getRippleLines (accounts[0].id ());
+        auto const& gwLines = cache.getRippleLines (gw.id ());
+        BEAST_EXPECT(first.size () == 2);
+        BEAST_EXPECT(gwLines.size () == 2 * accounts.size ());
+        auto const firstData = first.data ();
+
+        std::vector<std::vector<RippleState::pointer> const*> seen (
+            accounts.size () * 4);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back ([&, t]
+            {
+                for (std::size_t i = 0; i < accounts.size (); ++i)
+                {
+                    // Walk the accounts in a different order per thread
+                    auto const n = (i + 3 * t) % accounts.size ();
+                    seen[t * accounts.size () + n] =
+                        &cache.getRippleLines (accounts[n].id ());
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join ();
+
+        BEAST_EXPECT(&cache.getRippleLines (accounts[0].id ()) == &first);
+        BEAST_EXPECT(&cache.getRippleLines (gw.id ()) == &gwLines);
+        BEAST_EXPECT(first.data () == firstData);
+        BEAST_EXPECT(first.size () == 2);
+        BEAST_EXPECT(gwLines.size () == 2 * accounts.size ());
+        for (std::size_t n = 0; n < accounts.size (); ++n)
+        {
+            auto const& lines = cache.getRippleLines (accounts[n].id ());
+            BEAST_EXPECT(lines.size () == 2);
+            for (std::size_t t = 0; t < 4; ++t)
+                BEAST_EXPECT(seen[t * accounts.size () + n] == &lines);
+        }
+    }
+
+public:
+    void
+    run ()
+    {
+        testHistogram ();
+        testLineCacheConcurrent ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(PathRequests,app,ripple);
+
+}
+}
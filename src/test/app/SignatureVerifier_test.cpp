@@ -0,0 +1,233 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/app/misc/SignatureVerifier.h>
+#include <ripple/basics/Log.h>
+#include <ripple/core/JobQueue.h>
+#include <ripple/protocol/SecretKey.h>
+#include <ripple/protocol/digest.h>
+#include <ripple/beast/insight/NullCollector.h>
+#include <ripple/beast/unit_test.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ripple {
+namespace test {
+
+class SignatureVerifier_test : public beast::unit_test::suite
+{
+public:
+    void
+    testVerify (int threads)
+    {
+        testcase ("verify with " + std::to_string (threads) + " thread(s)");
+
+        Logs logs (beast::severities::kError);
+        RootStoppable parent ("TestRootStoppable");
+        JobQueue jq (beast::insight::NullCollector::New (),
+            parent, beast::Journal (), logs);
+        jq.setThreadCount (threads, false);
+        parent.prepare ();
+        parent.start ();
+
+        {
+            auto const ed = generateKeyPair (KeyType::ed25519,
+                generateSeed ("ed25519"));
+            auto const secp = generateKeyPair (KeyType::secp256k1,
+                generateSeed ("secp256k1"));
+
+            SignatureVerifier verifier (jq, jtTRANSACTION, "test");
+
+            // More than one batch, with some bad of each kind
+            int const count = 500;
+            std::vector<std::atomic<int>> results (count);
+            std::vector<int> expected (count, 1);
+            for (int i = 0; i < count; ++i)
+            {
+                results[i] = -1;
+                bool const bad = i % 9 == 4;
+                if (bad)
+                    expected[i] = 0;
+
+                auto const done = [&results, i](bool valid)
+                {
+                    results[i] = valid ? 1 : 0;
+                };
+
+                auto const message = "message " + std::to_string (i);
+                Blob const data (message.begin (), message.end ());
+                if (i % 3 == 2)
+                {
+                    auto const digest = sha512Half (makeSlice (data));
+                    auto const sig = signDigest (
+                        secp.first, secp.second, digest);
+                    verifier.verifyDigest (secp.first,
+                        bad ? sha512Half (digest) : digest,
+                        Blob (sig.data (), sig.data () + sig.size ()),
+                        true, done);
+                }
+                else
+                {
+                    auto const& key = i % 3 ? secp : ed;
+                    auto sig = sign (key.first, key.second,
+                        makeSlice (data));
+                    if (bad)
+                        sig.data ()[5] ^= 0x80;
+                    verifier.verify (key.first, data,
+                        Blob (sig.data (), sig.data () + sig.size ()),
+                        true, done);
+                }
+            }
+
+            jq.rendezvous ();
+            BEAST_EXPECT(verifier.size () == 0);
+
+            bool matched = true;
+            for (int i = 0; i < count; ++i)
+                matched = matched && results[i] == expected[i];
+            BEAST_EXPECT(matched);
+
+            // A digest signed by an ed25519 key is never valid
+            std::atomic<int> result {-1};
+            verifier.verifyDigest (ed.first, uint256 (),
+                Blob (64, 0), false,
+                [&result](bool valid) { result = valid ? 1 : 0; });
+            jq.rendezvous ();
+            BEAST_EXPECT(result == 0);
+        }
+
+        parent.stop (beast::Journal ());
+    }
+
+    void
+    run () override
+    {
+        testVerify (1);
+        testVerify (4);
+    }
+};
+
+// Measures how many signatures per second reach their callbacks, when
+// each is checked in a job of its own and when they go through a
+// SignatureVerifier, as the number of job threads grows.
+class SignatureVerifierBench_test : public beast::unit_test::suite
+{
+    static int constexpr count = 10000;
+
+    struct Signed
+    {
+        PublicKey publicKey;
+        Blob message;
+        Blob signature;
+    };
+
+public:
+    void
+    run () override
+    {
+        using namespace std::chrono;
+        using clock_type = steady_clock;
+
+        testcase ("throughput");
+
+        std::vector<Signed> items;
+        items.reserve (count);
+        for (int i = 0; i < count; ++i)
+        {
+            auto const key = generateKeyPair (
+                i % 4 ? KeyType::secp256k1 : KeyType::ed25519,
+                generateSeed ("bench" + std::to_string (i % 32)));
+            Blob message (200, static_cast<std::uint8_t> (i));
+            auto const sig = sign (key.first, key.second,
+                makeSlice (message));
+            items.push_back ({key.first, std::move (message),
+                Blob (sig.data (), sig.data () + sig.size ())});
+        }
+
+        for (int threads : {1, 2, 4, 8})
+        {
+            auto const rate = [](clock_type::duration d)
+            {
+                return static_cast<std::uint64_t> (count /
+                    duration_cast<duration<double>> (d).count ());
+            };
+
+            Logs logs (beast::severities::kError);
+            RootStoppable parent ("TestRootStoppable");
+            JobQueue jq (beast::insight::NullCollector::New (),
+                parent, beast::Journal (), logs);
+            jq.setThreadCount (threads, false);
+            parent.prepare ();
+            parent.start ();
+
+            std::atomic<int> good {0};
+            auto start = clock_type::now ();
+            for (auto const& item : items)
+            {
+                jq.addJob (jtTRANSACTION, "bench",
+                    [&good, &item](Job&)
+                    {
+                        if (verify (item.publicKey,
+                                makeSlice (item.message),
+                                    makeSlice (item.signature)))
+                            ++good;
+                    });
+            }
+            jq.rendezvous ();
+            auto const single = clock_type::now () - start;
+            BEAST_EXPECT(good == count);
+
+            {
+                SignatureVerifier verifier (jq, jtTRANSACTION, "bench");
+                good = 0;
+                start = clock_type::now ();
+                for (auto const& item : items)
+                {
+                    verifier.verify (item.publicKey, item.message,
+                        item.signature, true,
+                        [&good](bool valid)
+                        {
+                            if (valid)
+                                ++good;
+                        });
+                }
+                jq.rendezvous ();
+            }
+            auto const batched = clock_type::now () - start;
+            BEAST_EXPECT(good == count);
+
+            parent.stop (beast::Journal ());
+
+            log <<
+                "    " << threads << " thread(s): " << rate (batched) <<
+                " signatures/sec batched, " << rate (single) <<
+                " signatures/sec one job each" << std::endl;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SignatureVerifier,app,ripple);
+BEAST_DEFINE_TESTSUITE_MANUAL(SignatureVerifierBench,app,ripple);
+
+} // test
+} // ripple
@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/basics/base_uint.h>
+#include <ripple/basics/chrono.h>
+#include <ripple/basics/TaggedCache.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+// Measures TaggedCache throughput when many threads fetch and
+// canonicalize at once while another thread sweeps, the way the
+// NodeStore and tree node caches are used by the job threads.
+class TaggedCacheContention_test : public beast::unit_test::suite
+{
+    using Cache = TaggedCache <uint256, int>;
+
+    std::vector <uint256> keys_;
+
+    // Each thread performs `ops` operations, one in eight of which
+    // canonicalizes a new object. Returns the elapsed wall time.
+    std::chrono::nanoseconds
+    hammer (Cache& c, unsigned threads, std::size_t ops)
+    {
+        using namespace std::chrono;
+
+        std::atomic <bool> done {false};
+        std::vector <std::thread> workers;
+        workers.reserve (threads);
+
+        std::thread sweeper (
+            [&]()
+            {
+                while (! done)
+                {
+                    c.sweep ();
+                    std::this_thread::sleep_for (milliseconds (10));
+                }
+            });
+
+        auto const start = steady_clock::now ();
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            workers.emplace_back (
+                [&, t]()
+                {
+                    beast::xor_shift_engine g (t + 1);
+                    for (std::size_t i = 0; i < ops; ++i)
+                    {
+                        auto const& key = keys_[g() % keys_.size()];
+                        if ((i & 7) == 0)
+                        {
+                            auto p = std::make_shared <int> (i);
+                            c.canonicalize (key, p);
+                        }
+                        else
+                        {
+                            c.fetch (key);
+                        }
+                    }
+                });
+        }
+        for (auto& w : workers)
+            w.join ();
+        auto const elapsed = steady_clock::now () - start;
+
+        done = true;
+        sweeper.join ();
+        return duration_cast <nanoseconds> (elapsed);
+    }
+
+public:
+    TaggedCacheContention_test ()
+    {
+        beast::xor_shift_engine g (19207813);
+        keys_.resize (100000);
+        for (auto& key : keys_)
+            beast::rngfill (key.data(), key.size(), g);
+    }
+
+    void
+    run () override
+    {
+        using namespace std::chrono;
+
+        testcase ("contention");
+
+        beast::Journal const j;
+        TestStopwatch clock;
+
+        std::size_t const ops = 500000;
+
+        std::vector <unsigned> counts;
+        auto const cores = std::max (1u, std::thread::hardware_concurrency ());
+        for (unsigned t = 1; t < cores; t *= 2)
+            counts.push_back (t);
+        counts.push_back (cores);
+
+        for (auto const threads : counts)
+        {
+            Cache c ("bench", 65536, 60, clock, j);
+            for (auto const& key : keys_)
+                c.insert (key, 0);
+
+            auto const d = hammer (c, threads, ops);
+            auto const total = ops * threads;
+            log <<
+                "    " << threads << " thread(s): " <<
+                duration_cast <milliseconds> (d).count() << " ms, " <<
+                static_cast <std::uint64_t> (total * 1e9 /
+                    std::max <nanoseconds::rep> (d.count(), 1)) <<
+                " ops/sec, hit rate " << c.getHitRate () << "%" << std::endl;
+        }
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(TaggedCacheContention,common,ripple);
+
+}
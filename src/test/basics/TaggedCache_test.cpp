@@ -144,6 +144,29 @@ public:
             BEAST_EXPECT(c.getCacheSize() == 0);
             BEAST_EXPECT(c.getTrackSize() == 0);
         }
+
+        // Insert enough keys to land in every partition and make sure
+        // the totals, the key list and sweeping span all of them.
+        {
+            for (int i = 0; i < 256; ++i)
+                BEAST_EXPECT(! c.insert (1000 + i, std::to_string (i)));
+            BEAST_EXPECT(c.getCacheSize() == 256);
+            BEAST_EXPECT(c.getTrackSize() == 256);
+            BEAST_EXPECT(c.getKeys().size() == 256);
+
+            for (int i = 0; i < 256; ++i)
+            {
+                std::string s;
+                BEAST_EXPECT(c.retrieve (1000 + i, s));
+                BEAST_EXPECT(s == std::to_string (i));
+            }
+
+            ++clock;
+            c.sweep ();
+            BEAST_EXPECT(c.getCacheSize() == 0);
+            BEAST_EXPECT(c.getTrackSize() == 0);
+            BEAST_EXPECT(c.getKeys().empty());
+        }
     }
 };
 
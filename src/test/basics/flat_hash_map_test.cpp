@@ -0,0 +1,425 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/basics/base_uint.h>
+#include <ripple/basics/flat_hash_map.h>
+#include <ripple/basics/hardened_hash.h>
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ripple {
+
+class flat_hash_map_test : public beast::unit_test::suite
+{
+    // Sends every key to the same group
+    struct bad_hash
+    {
+        std::size_t
+        operator() (int key) const
+        {
+            return static_cast<std::size_t> (key & 0x7f);
+        }
+    };
+
+    static
+    uint256
+    random_key (beast::xor_shift_engine& g)
+    {
+        uint256 key;
+        beast::rngfill (key.data(), key.size(), g);
+        return key;
+    }
+
+    template <class Map, class Model>
+    bool
+    same (Map const& m, Model const& model)
+    {
+        if (m.size () != model.size ())
+            return false;
+        std::size_t n = 0;
+        for (auto const& v : m)
+        {
+            auto const it = model.find (v.first);
+            if (it == model.end () || it->second != v.second)
+                return false;
+            ++n;
+        }
+        return n == model.size ();
+    }
+
+public:
+    void
+    testHash ()
+    {
+        testcase ("hash");
+
+        flat_hash <uint256> const h;
+        uint256 a;
+        uint256 b;
+        BEAST_EXPECT(h (a) == h (b));
+
+        // Every byte of the key matters
+        for (std::size_t i = 0; i < a.size (); ++i)
+        {
+            b = a;
+            b.data ()[i] ^= 1;
+            BEAST_EXPECT(h (a) != h (b));
+        }
+
+        // Both halves of the seed are used
+        flat_hash <uint160> const h160;
+        BEAST_EXPECT(h160 (uint160 ()) != h160 (uint160 (1)));
+    }
+
+    void
+    testBasics ()
+    {
+        testcase ("basics");
+
+        flat_hash_map <uint256, std::string> m;
+        BEAST_EXPECT(m.empty ());
+        BEAST_EXPECT(m.bucket_count () == 0);
+        BEAST_EXPECT(m.begin () == m.end ());
+        BEAST_EXPECT(m.find (uint256 ()) == m.end ());
+        BEAST_EXPECT(m.erase (uint256 ()) == 0);
+
+        auto r = m.try_emplace (uint256 (1), "one");
+        BEAST_EXPECT(r.second);
+        BEAST_EXPECT(r.first->second == "one");
+        r = m.try_emplace (uint256 (1), "uno");
+        BEAST_EXPECT(! r.second);
+        BEAST_EXPECT(r.first->second == "one");
+        BEAST_EXPECT(m.size () == 1);
+
+        m[uint256 (2)] = "two";
+        BEAST_EXPECT(m.size () == 2);
+        BEAST_EXPECT(m.count (uint256 (2)) == 1);
+        BEAST_EXPECT(m.find (uint256 (2))->second == "two");
+
+        auto const copy = m;
+        BEAST_EXPECT(copy.size () == 2);
+        BEAST_EXPECT(copy.find (uint256 (1))->second == "one");
+
+        BEAST_EXPECT(m.erase (uint256 (1)) == 1);
+        BEAST_EXPECT(m.find (uint256 (1)) == m.end ());
+        BEAST_EXPECT(copy.count (uint256 (1)) == 1);
+
+        auto moved = std::move (m);
+        BEAST_EXPECT(moved.size () == 1);
+        BEAST_EXPECT(m.empty ());
+
+        moved.clear ();
+        BEAST_EXPECT(moved.empty ());
+        BEAST_EXPECT(moved.begin () == moved.end ());
+    }
+
+    void
+    testRandom ()
+    {
+        testcase ("random");
+
+        beast::xor_shift_engine g (1234);
+        std::vector <uint256> keys (2000);
+        for (auto& key : keys)
+            key = random_key (g);
+
+        flat_hash_map <uint256, int> m;
+        std::unordered_map <uint256, int, hardened_hash<>> model;
+        bool ok = true;
+        for (int i = 0; i < 200000; ++i)
+        {
+            auto const& key = keys[g () % keys.size ()];
+            switch (g () % 4)
+            {
+            case 0:
+            case 1:
+                if (m.try_emplace (key, i).second !=
+                        model.emplace (key, i).second)
+                    ok = false;
+                break;
+            case 2:
+                if (m.erase (key) != model.erase (key))
+                    ok = false;
+                break;
+            default:
+            {
+                auto const it = m.find (key);
+                auto const mit = model.find (key);
+                if ((it == m.end ()) != (mit == model.end ()))
+                    ok = false;
+                else if (it != m.end () && it->second != mit->second)
+                    ok = false;
+            }
+            }
+            if ((i % 10000) == 0 && ! same (m, model))
+                ok = false;
+        }
+        BEAST_EXPECT(ok);
+        BEAST_EXPECT(same (m, model));
+        BEAST_EXPECT(m.load_factor () <= m.max_load_factor ());
+    }
+
+    void
+    testCollisions ()
+    {
+        testcase ("collisions");
+
+        // With every key in the same probe sequence, erasing
+        // leaves deleted slots that lookups must step over.
+        flat_hash_map <int, int, bad_hash> m;
+        for (int i = 0; i < 1000; ++i)
+            m.try_emplace (i, -i);
+        BEAST_EXPECT(m.size () == 1000);
+
+        for (int i = 0; i < 1000; i += 2)
+            BEAST_EXPECT(m.erase (i) == 1);
+        bool ok = true;
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto const it = m.find (i);
+            if ((it == m.end ()) != (i % 2 == 0))
+                ok = false;
+            else if (it != m.end () && it->second != -i)
+                ok = false;
+        }
+        BEAST_EXPECT(ok);
+
+        // Churn must not grow a table whose size is stable
+        auto const buckets = m.bucket_count ();
+        for (int i = 1000; i < 100000; ++i)
+        {
+            m.try_emplace (i, -i);
+            m.erase (i);
+        }
+        BEAST_EXPECT(m.size () == 500);
+        BEAST_EXPECT(m.bucket_count () == buckets);
+    }
+
+    void
+    testErase ()
+    {
+        testcase ("erase");
+
+        flat_hash_map <int, std::unique_ptr <int>> m;
+        for (int i = 0; i < 1000; ++i)
+            m.try_emplace (i, std::make_unique <int> (i));
+
+        // Erase every odd element while iterating
+        std::size_t visited = 0;
+        for (auto it = m.begin (); it != m.end ();)
+        {
+            ++visited;
+            if (*it->second % 2)
+                it = m.erase (it);
+            else
+                ++it;
+        }
+        BEAST_EXPECT(visited == 1000);
+        BEAST_EXPECT(m.size () == 500);
+        for (auto const& v : m)
+            BEAST_EXPECT(v.first == *v.second && v.first % 2 == 0);
+
+        m.reserve (10000);
+        BEAST_EXPECT(m.bucket_count () * m.max_load_factor () >= 10000);
+        BEAST_EXPECT(m.size () == 500);
+        BEAST_EXPECT(*m.find (42)->second == 42);
+
+        m.rehash (0);
+        BEAST_EXPECT(m.bucket_count () == 1024);
+        BEAST_EXPECT(*m.find (42)->second == 42);
+    }
+
+    void
+    run () override
+    {
+        testHash ();
+        testBasics ();
+        testRandom ();
+        testCollisions ();
+        testErase ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(flat_hash_map,basics,ripple);
+
+//------------------------------------------------------------------------------
+
+// Compares flat_hash_map with the node based hardened_hash_map it
+// replaces, for the uint256 keys of the ledger and node caches.
+class flat_hash_map_bench_test : public beast::unit_test::suite
+{
+    // Counts the bytes allocated by a container
+    template <class T>
+    struct counting_allocator
+    {
+        using value_type = T;
+
+        std::size_t* bytes;
+
+        explicit
+        counting_allocator (std::size_t* b)
+            : bytes (b)
+        {
+        }
+
+        template <class U>
+        counting_allocator (counting_allocator <U> const& other)
+            : bytes (other.bytes)
+        {
+        }
+
+        T*
+        allocate (std::size_t n)
+        {
+            *bytes += n * sizeof (T);
+            return std::allocator <T> ().allocate (n);
+        }
+
+        void
+        deallocate (T* p, std::size_t n)
+        {
+            *bytes -= n * sizeof (T);
+            std::allocator <T> ().deallocate (p, n);
+        }
+
+        template <class U>
+        bool
+        operator== (counting_allocator <U> const& other) const
+        {
+            return bytes == other.bytes;
+        }
+
+        template <class U>
+        bool
+        operator!= (counting_allocator <U> const& other) const
+        {
+            return bytes != other.bytes;
+        }
+    };
+
+    using value_type = std::shared_ptr <int>;
+
+    template <class F>
+    double
+    time_per_op (std::size_t ops, F&& f)
+    {
+        using namespace std::chrono;
+        auto const start = steady_clock::now ();
+        f ();
+        auto const d = steady_clock::now () - start;
+        return duration_cast <nanoseconds> (d).count () /
+            static_cast<double> (ops);
+    }
+
+    template <class Map>
+    void
+    measure (std::string const& name, Map& m, std::size_t const* memory,
+        std::vector <uint256> const& keys,
+        std::vector <uint256> const& missing)
+    {
+        std::size_t found = 0;
+        auto const insert = time_per_op (keys.size (),
+            [&]
+            {
+                for (auto const& key : keys)
+                    m.emplace (key, value_type ());
+            });
+        std::size_t const bytes = memory ? *memory :
+            m.bucket_count () * (sizeof (typename Map::value_type) + 1);
+
+        std::size_t const rounds = 10;
+        auto const hit = time_per_op (rounds * keys.size (),
+            [&]
+            {
+                for (std::size_t i = 0; i < rounds; ++i)
+                    for (auto const& key : keys)
+                        found += m.find (key) != m.end ();
+            });
+        auto const miss = time_per_op (rounds * missing.size (),
+            [&]
+            {
+                for (std::size_t i = 0; i < rounds; ++i)
+                    for (auto const& key : missing)
+                        found += m.find (key) != m.end ();
+            });
+        auto const erase = time_per_op (keys.size (),
+            [&]
+            {
+                for (auto const& key : keys)
+                    m.erase (key);
+            });
+
+        log <<
+            "    " << name << ": insert " << insert <<
+            " ns, hit " << hit << " ns, miss " << miss <<
+            " ns, erase " << erase << " ns, " <<
+            bytes / keys.size () << " bytes/entry" << std::endl;
+        BEAST_EXPECT(found == rounds * keys.size ());
+        BEAST_EXPECT(m.empty ());
+    }
+
+public:
+    void
+    run () override
+    {
+        beast::xor_shift_engine g (19207813);
+        auto random_keys = [&](std::size_t n)
+        {
+            std::vector <uint256> v (n);
+            for (auto& key : v)
+                beast::rngfill (key.data(), key.size(), g);
+            return v;
+        };
+
+        for (std::size_t const n : { 1000, 100000, 1000000 })
+        {
+            testcase (std::to_string (n) + " entries");
+            auto const keys = random_keys (n);
+            auto const missing = random_keys (n);
+
+            {
+                using alloc = counting_allocator <
+                    std::pair <uint256 const, value_type>>;
+                std::size_t bytes = 0;
+                hardened_hash_map <uint256, value_type,
+                    hardened_hash<>, std::equal_to <uint256>, alloc>
+                        m (0, hardened_hash<> (),
+                            std::equal_to <uint256> (), alloc (&bytes));
+                measure ("hardened_hash_map", m, &bytes, keys, missing);
+            }
+            {
+                flat_hash_map <uint256, value_type> m;
+                measure ("flat_hash_map", m, nullptr, keys, missing);
+            }
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(flat_hash_map_bench,basics,ripple);
+
+}
@@ -0,0 +1,317 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/core/JobQueue.h>
+#include <ripple/basics/Log.h>
+#include <ripple/beast/insight/NullCollector.h>
+#include <ripple/beast/unit_test.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+namespace test {
+
+namespace detail {
+
+// A JobQueue with the parent it needs to be stopped cleanly
+class TestJobQueue
+{
+    Logs logs_;
+    RootStoppable parent_;
+    JobQueue jq_;
+
+public:
+    explicit
+    TestJobQueue (int threads)
+        : logs_ (beast::severities::kError)
+        , parent_ ("TestRootStoppable")
+        , jq_ (beast::insight::NullCollector::New (),
+            parent_, beast::Journal (), logs_)
+    {
+        jq_.setThreadCount (threads, false);
+        parent_.prepare ();
+        parent_.start ();
+    }
+
+    ~TestJobQueue ()
+    {
+        parent_.stop (beast::Journal ());
+    }
+
+    JobQueue&
+    operator* ()
+    {
+        return jq_;
+    }
+
+    JobQueue*
+    operator-> ()
+    {
+        return &jq_;
+    }
+};
+
+// Blocks a job thread until opened
+class Gate
+{
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool open_ = false;
+
+public:
+    void
+    wait ()
+    {
+        std::unique_lock <std::mutex> lock (mutex_);
+        cv_.wait (lock, [this]{ return open_; });
+    }
+
+    void
+    open ()
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        open_ = true;
+        cv_.notify_all ();
+    }
+};
+
+} // detail
+
+class JobQueue_test : public beast::unit_test::suite
+{
+public:
+    void
+    testPriority ()
+    {
+        testcase ("priority");
+
+        detail::TestJobQueue jq (1);
+        detail::Gate started;
+        detail::Gate gate;
+        std::mutex mutex;
+        std::vector <std::pair <JobType, int>> order;
+
+        // Occupy the only thread so everything below waits
+        jq->addJob (jtADMIN, "gate",
+            [&](Job&)
+            {
+                started.open ();
+                gate.wait ();
+            });
+        started.wait ();
+
+        JobType const types[] = {
+            jtCLIENT, jtPACK, jtPROPOSAL_t, jtCLIENT,
+            jtTRANSACTION, jtPACK, jtPROPOSAL_t, jtTRANSACTION };
+        int i = 0;
+        for (auto const type : types)
+        {
+            jq->addJob (type, "test",
+                [&, type, i](Job&)
+                {
+                    std::lock_guard <std::mutex> lock (mutex);
+                    order.emplace_back (type, i);
+                });
+            ++i;
+        }
+        BEAST_EXPECT(jq->getJobCount (jtCLIENT) == 2);
+        BEAST_EXPECT(jq->getJobCountGE (jtCLIENT) == 6);
+
+        gate.open ();
+        jq->rendezvous ();
+
+        // Highest type first, and in the order added within a type
+        std::vector <std::pair <JobType, int>> const expected = {
+            {jtPROPOSAL_t, 2}, {jtPROPOSAL_t, 6},
+            {jtTRANSACTION, 4}, {jtTRANSACTION, 7},
+            {jtCLIENT, 0}, {jtCLIENT, 3},
+            {jtPACK, 1}, {jtPACK, 5} };
+        BEAST_EXPECT(order == expected);
+        BEAST_EXPECT(jq->getJobCountGE (jtPACK) == 0);
+    }
+
+    void
+    testLimit ()
+    {
+        testcase ("limit");
+
+        detail::TestJobQueue jq (8);
+        std::atomic <int> running {0};
+        std::atomic <int> peak {0};
+        std::atomic <int> done {0};
+        int const count = 40;
+
+        for (int i = 0; i < count; ++i)
+        {
+            jq->addJob (jtLEDGER_DATA, "test",
+                [&](Job&)
+                {
+                    auto const n = ++running;
+                    int p = peak.load ();
+                    while (n > p && ! peak.compare_exchange_weak (p, n))
+                        ;
+                    std::this_thread::sleep_for (
+                        std::chrono::milliseconds (1));
+                    --running;
+                    ++done;
+                });
+        }
+
+        // Jobs of other types are not held up by the limit
+        std::atomic <bool> other {false};
+        jq->addJob (jtCLIENT, "test", [&](Job&) { other = true; });
+
+        jq->rendezvous ();
+        BEAST_EXPECT(other);
+        BEAST_EXPECT(done == count);
+        BEAST_EXPECT(peak > 0 && peak <= 2);
+        BEAST_EXPECT(jq->getJobCountTotal (jtLEDGER_DATA) == 0);
+    }
+
+    void
+    testManyProducers ()
+    {
+        testcase ("many producers");
+
+        detail::TestJobQueue jq (4);
+        std::atomic <int> done {0};
+        int const producers = 8;
+        int const each = 2000;
+
+        JobType const types[] = {
+            jtTRANSACTION, jtCLIENT, jtLEDGER_DATA, jtVALIDATION_t };
+
+        std::vector <std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back (
+                [&, p]()
+                {
+                    for (int i = 0; i < each; ++i)
+                        jq->addJob (types[(p + i) % 4], "test",
+                            [&](Job&) { ++done; });
+                });
+        }
+        for (auto& t : threads)
+            t.join ();
+
+        jq->rendezvous ();
+        BEAST_EXPECT(done == producers * each);
+        BEAST_EXPECT(jq->getJobCountGE (jtPACK) == 0);
+    }
+
+    void
+    run () override
+    {
+        testPriority ();
+        testLimit ();
+        testManyProducers ();
+    }
+};
+
+// Measures how many jobs per second the JobQueue dispatches, and how
+// long each waits to start, as the number of job threads grows while
+// several threads add a mix of job types at once.
+class JobQueueStress_test : public beast::unit_test::suite
+{
+    static int constexpr producers = 4;
+    static int constexpr jobsPerProducer = 50000;
+
+public:
+    void
+    run () override
+    {
+        using namespace std::chrono;
+        using clock_type = Job::clock_type;
+
+        testcase ("stress");
+
+        JobType const types[] = {
+            jtTRANSACTION, jtTRANSACTION, jtTRANSACTION, jtCLIENT,
+            jtPROPOSAL_t, jtVALIDATION_t, jtLEDGER_DATA, jtWRITE };
+
+        for (int threads : {1, 2, 4, 8, 16, 32, 64})
+        {
+            std::size_t const total = producers * jobsPerProducer;
+            std::vector <clock_type::duration> latency (total);
+
+            clock_type::time_point start;
+            clock_type::duration elapsed;
+            {
+                detail::TestJobQueue jq (threads);
+
+                std::vector <std::thread> workers;
+                start = clock_type::now ();
+                for (int p = 0; p < producers; ++p)
+                {
+                    workers.emplace_back (
+                        [&, p]()
+                        {
+                            for (int i = 0; i < jobsPerProducer; ++i)
+                            {
+                                auto const slot = p * jobsPerProducer + i;
+                                auto const queued = clock_type::now ();
+                                jq->addJob (types[i % 8], "stress",
+                                    [&latency, slot, queued](Job&)
+                                    {
+                                        latency[slot] =
+                                            clock_type::now () - queued;
+                                    });
+                            }
+                        });
+                }
+                for (auto& w : workers)
+                    w.join ();
+                jq->rendezvous ();
+                elapsed = clock_type::now () - start;
+            }
+
+            std::sort (latency.begin (), latency.end ());
+            clock_type::duration sum {0};
+            for (auto const& d : latency)
+                sum += d;
+
+            auto const us = [](clock_type::duration d)
+            {
+                return duration_cast <microseconds> (d).count ();
+            };
+            log <<
+                "    " << threads << " thread(s): " <<
+                static_cast <std::uint64_t> (total /
+                    duration_cast <duration <double>> (elapsed).count ()) <<
+                " jobs/sec, latency mean " << us (sum / total) <<
+                " us, p50 " << us (latency[total / 2]) <<
+                " us, p99 " << us (latency[total * 99 / 100]) <<
+                " us, max " << us (latency.back ()) << " us" << std::endl;
+        }
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(JobQueue,core,ripple);
+BEAST_DEFINE_TESTSUITE_MANUAL(JobQueueStress,core,ripple);
+
+} // test
+} // ripple
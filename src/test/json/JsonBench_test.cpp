@@ -0,0 +1,276 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/json/json_reader.h>
+#include <ripple/json/json_value.h>
+#include <ripple/json/to_string.h>
+#include <ripple/beast/unit_test.h>
+#include <chrono>
+#include <string>
+
+namespace ripple {
+
+/** Times parsing and serializing of typical RPC payloads. */
+class JsonBench_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    static char const* txJson ()
+    {
+        return R"({
+    "Account": "rf1BiGeXwwQoi8Z2ueFYTEXSwuJYfV2Jpn",
+    "Amount": {
+        "currency": "USD",
+        "issuer": "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B",
+        "value": "1.2345678901234"
+    },
+    "Destination": "ra5nK24KXen9AHvsdFTKHSANinZseWnPcX",
+    "DestinationTag": 13,
+    "Fee": "12",
+    "Flags": 2147614720,
+    "LastLedgerSequence": 31243411,
+    "Memos": [
+        {
+            "Memo": {
+                "MemoData": "72656E74",
+                "MemoFormat": "746578742F706C61696E",
+                "MemoType": "687474703A2F2F6578616D706C652E636F6D2F6D656D6F2F67656E65726963"
+            }
+        }
+    ],
+    "Paths": [
+        [
+            {
+                "account": "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B",
+                "type": 1,
+                "type_hex": "0000000000000001"
+            }
+        ],
+        [
+            {
+                "currency": "XRP",
+                "type": 16,
+                "type_hex": "0000000000000010"
+            },
+            {
+                "currency": "USD",
+                "issuer": "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B",
+                "type": 48,
+                "type_hex": "0000000000000030"
+            }
+        ]
+    ],
+    "SendMax": "1500000",
+    "Sequence": 4,
+    "SigningPubKey": "03AB40A0490F9B7ED8DF29D246BF2D6269820A0EE7742ACDD457BEA7C7D0931EDB",
+    "TransactionType": "Payment",
+    "TxnSignature": "3045022100D184EB4AE5956FF600E7536EE459345C7BBCF097A84CC61A93B9AF7197EDB98702201CEA8009B7BEEBAA2AACC0359B41C427C1C5B550A4CA4B80CF2174AF2D6D5DCE",
+    "hash": "7BF105CFE4EFE78ADB63FE4E03A851440551FE189FD4B51CAAD9279C9F534F0E"
+})";
+    }
+
+    static std::string submitRequest ()
+    {
+        return std::string (R"({"method":"submit","params":[{"secret":)"
+            R"("snoPBrXtMeMyMHUVTgbuqAfg1SUTb","fee_mult_max":1000,)"
+            R"("tx_json":)") + compact (parse (txJson ())) + "}]}";
+    }
+
+    static std::string ledger (int transactions)
+    {
+        auto tx = parse (txJson ());
+        tx["metaData"] = meta ();
+
+        Json::Value result (Json::objectValue);
+        auto& ledger = result["ledger"];
+        ledger["accepted"] = true;
+        ledger["account_hash"] =
+            "B258A8BB4743FB74CBBD6E9F67E4A56C4432EA09E5805E4CC2DA26F2DBE8F3D1";
+        ledger["close_flags"] = 0;
+        ledger["close_time"] = 590427121;
+        ledger["close_time_human"] = "2018-Sep-17 15:32:01.000000000 UTC";
+        ledger["close_time_resolution"] = 10;
+        ledger["closed"] = true;
+        ledger["ledger_hash"] =
+            "8C3C7BEC2DA6B8FF8E6A1C2C5A7B1A3E1A6C88D4E7BD9B7CE0E7E7BB7D6F2C13";
+        ledger["ledger_index"] = "31243404";
+        ledger["parent_hash"] =
+            "6A4F0F2DA2D4E5AB3C5FBB2C1E7C4A1CB22E4F57EDEFF44A30EE6B95E2C02F48";
+        ledger["total_coins"] = "99991024049661559";
+        ledger["transaction_hash"] =
+            "F2C0AC0F4C4F2E7E4C4F6A7E3B8F1E2DAF2BB1C7A6A3F0DE0D5B8F8F4F2E7E4C";
+        auto& txs = ledger["transactions"] = Json::Value (Json::arrayValue);
+        for (int i = 0; i < transactions; ++i)
+        {
+            tx["Sequence"] = i;
+            txs.append (tx);
+        }
+        result["validated"] = true;
+        return compact (result);
+    }
+
+    static Json::Value meta ()
+    {
+        return parse (R"({
+    "AffectedNodes": [
+        {
+            "ModifiedNode": {
+                "FinalFields": {
+                    "Account": "rf1BiGeXwwQoi8Z2ueFYTEXSwuJYfV2Jpn",
+                    "Balance": "9999999880",
+                    "Flags": 0,
+                    "OwnerCount": 2,
+                    "Sequence": 5
+                },
+                "LedgerEntryType": "AccountRoot",
+                "LedgerIndex": "4F83A2CF7E70F77F79A307E6A472BFC2585B806A70833CCD1C26105BAE0D6E05",
+                "PreviousFields": {
+                    "Balance": "9999999892",
+                    "Sequence": 4
+                },
+                "PreviousTxnID": "B24159F8552C355D35E43623F0E5AD965ADBF034D482421529E2703904E1EC09",
+                "PreviousTxnLgrSeq": 31243399
+            }
+        },
+        {
+            "ModifiedNode": {
+                "FinalFields": {
+                    "Balance": {
+                        "currency": "USD",
+                        "issuer": "rrrrrrrrrrrrrrrrrrrrBZbvji",
+                        "value": "-1.2345678901234"
+                    },
+                    "Flags": 131072,
+                    "HighLimit": {
+                        "currency": "USD",
+                        "issuer": "ra5nK24KXen9AHvsdFTKHSANinZseWnPcX",
+                        "value": "100"
+                    },
+                    "LowLimit": {
+                        "currency": "USD",
+                        "issuer": "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B",
+                        "value": "0"
+                    }
+                },
+                "LedgerEntryType": "RippleState",
+                "LedgerIndex": "EA4BF03B4700123CDFFB6EB09DC1D6E28D5CEB7F680FB00FC24BC1C3BB2DB959",
+                "PreviousFields": {
+                    "Balance": {
+                        "currency": "USD",
+                        "issuer": "rrrrrrrrrrrrrrrrrrrrBZbvji",
+                        "value": "0"
+                    }
+                }
+            }
+        }
+    ],
+    "TransactionIndex": 3,
+    "TransactionResult": "tesSUCCESS",
+    "delivered_amount": {
+        "currency": "USD",
+        "issuer": "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B",
+        "value": "1.2345678901234"
+    }
+})");
+    }
+
+    static Json::Value parse (std::string const& json)
+    {
+        Json::Value v;
+        Json::Reader ().parse (json, v);
+        return v;
+    }
+
+    static std::string compact (Json::Value const& v)
+    {
+        return Json::to_string (v);
+    }
+
+    template <class Parse>
+    std::chrono::nanoseconds
+    time (std::string const& json, int iterations, Parse&& parse)
+    {
+        auto const start = clock_type::now ();
+        for (int i = 0; i < iterations; ++i)
+        {
+            Json::Value v;
+            if (! parse (json, v))
+                fail ();
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds> (
+            clock_type::now () - start);
+    }
+
+    void
+    bench (std::string const& name, std::string const& json, int iterations)
+    {
+        using namespace std::chrono;
+
+        auto const plain = time (json, iterations,
+            [](std::string const& s, Json::Value& v)
+            {
+                return Json::Reader ().parse (s, v);
+            });
+
+        auto const arena = time (json, iterations,
+            [](std::string const& s, Json::Value& v)
+            {
+                Json::ScopedArena arena;
+                return Json::Reader ().parse (s, v);
+            });
+
+        auto const v = parse (json);
+        std::size_t written = 0;
+        auto const start = clock_type::now ();
+        for (int i = 0; i < iterations; ++i)
+            written += Json::to_string (v).size ();
+        auto const serialize = duration_cast<nanoseconds> (
+            clock_type::now () - start);
+        BEAST_EXPECT(written == iterations * compact (v).size ());
+
+        auto const mbps = [&](nanoseconds d)
+        {
+            return static_cast<std::uint64_t> (json.size () * iterations /
+                duration_cast<duration<double>> (d).count () / 1e6);
+        };
+
+        log <<
+            "    " << name << " (" << json.size () << " bytes): " <<
+            "parse " << mbps (plain) << " MB/s, " <<
+            "parse with arena " << mbps (arena) << " MB/s, " <<
+            "serialize " << mbps (serialize) << " MB/s" << std::endl;
+    }
+
+public:
+    void
+    run () override
+    {
+        std::string const tx = txJson ();
+        bench ("submit", submitRequest (), 20000);
+        bench ("tx_json", tx, 20000);
+        bench ("tx_json compact", compact (parse (tx)), 20000);
+        bench ("ledger", ledger (500), 20);
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(JsonBench,json,ripple);
+
+} // ripple
@@ -22,6 +22,7 @@
 #include <ripple/json/json_reader.h>
 #include <ripple/beast/unit_test.h>
 #include <ripple/beast/type_name.h>
+#include <thread>
 
 namespace ripple {
 
@@ -120,6 +121,94 @@ struct json_value_test : beast::unit_test::suite
         pass ();
     }
 
+    void test_strings ()
+    {
+        auto parse = [](std::string const& json, Json::Value& j)
+        {
+            Json::Reader r;
+            return r.parse (json, j);
+        };
+
+        // Long enough for the vectorized scanners to see several blocks,
+        // with escapes and whitespace runs at every offset.
+        for (std::size_t pad = 0; pad < 40; ++pad)
+        {
+            std::string const filler (pad, 'x');
+            std::string const spaces (pad, ' ');
+            std::string const json = "{" + spaces + "\"" + filler +
+                "\"" + spaces + ":" + spaces + "\"" + filler +
+                "\\\"q\\\\" + filler + "\\n\\u0041\"" + spaces +
+                ",\"\t\r\n" + filler + "\": [" + spaces + "]}";
+
+            Json::Value j;
+            if (! BEAST_EXPECT(parse (json, j)))
+                continue;
+            BEAST_EXPECT(j.size () == 2);
+            BEAST_EXPECT(j[filler] ==
+                filler + "\"q\\" + filler + "\nA");
+            BEAST_EXPECT(j["\t\r\n" + filler].isArray ());
+        }
+
+        Json::Value j;
+        BEAST_EXPECT(! parse ("{\"unterminated", j));
+        BEAST_EXPECT(! parse ("{\"a\":\"b\\", j));
+        BEAST_EXPECT(! parse ("{\"a\":\"b\\\"}", j));
+        BEAST_EXPECT(! parse ("{\"a\":\"\\q\"}", j));
+        BEAST_EXPECT(parse ("{\"a\":\"\\/\\b\\f\\r\\t\"}", j));
+        BEAST_EXPECT(j["a"] == "/\b\f\r\t");
+    }
+
+    void test_duplicate_keys ()
+    {
+        Json::Reader r;
+        Json::Value j;
+
+        BEAST_EXPECT(! r.parse ("{\"a\":1,\"b\":2,\"a\":3}", j));
+        BEAST_EXPECT(r.getFormatedErrorMessages ().find (
+            "Key 'a' appears twice.") != std::string::npos);
+
+        BEAST_EXPECT(r.parse ("{\"a\":{\"a\":1},\"b\":{\"a\":2}}", j));
+        BEAST_EXPECT(j["b"]["a"] == 2);
+    }
+
+    void test_arena ()
+    {
+        Json::Value outer;
+        Json::Value inner;
+        {
+            Json::ScopedArena arena (1024);
+            Json::Reader r;
+            BEAST_EXPECT(r.parse (
+                "{\"key\":\"value\",\"list\":[\"a\",\"b\",{\"c\":\"d\"}]}",
+                    outer));
+            {
+                Json::ScopedArena nested;
+                inner["nested"] = "string";
+                inner["copy"] = outer["list"];
+            }
+            // Enough members to need more than one block
+            for (int i = 0; i < 100; ++i)
+                outer[std::to_string (i)] = std::string (i, 'v');
+        }
+
+        // Values outlive the arena they were built in, and may be
+        // modified or destroyed anywhere.
+        BEAST_EXPECT(outer["key"] == "value");
+        BEAST_EXPECT(outer["list"][2u]["c"] == "d");
+        BEAST_EXPECT(outer["99"] == std::string (99, 'v'));
+        BEAST_EXPECT(inner["copy"] == outer["list"]);
+        outer["key"] = "replaced";
+        BEAST_EXPECT(outer["key"] == "replaced");
+
+        Json::Value copy = outer;
+        std::thread ([v = std::move (outer)]() mutable
+        {
+            v.clear ();
+        }).join ();
+        BEAST_EXPECT(copy["list"][1u] == "b");
+        BEAST_EXPECT(inner["nested"] == "string");
+    }
+
     void
     test_copy ()
     {
@@ -227,6 +316,9 @@ struct json_value_test : beast::unit_test::suite
         test_bool ();
         test_bad_json ();
         test_edge_cases ();
+        test_strings ();
+        test_duplicate_keys ();
+        test_arena ();
         test_copy ();
         test_move ();
         test_comparisons ();
@@ -24,6 +24,7 @@
 #include <ripple/nodestore/Manager.h>
 #include <ripple/beast/utility/temp_dir.h>
 #include <algorithm>
+#include <thread>
 
 namespace ripple {
 namespace NodeStore {
@@ -60,9 +61,23 @@ public:
             std::unique_ptr <Backend> backend =
                 Manager::instance().make_Backend (params, scheduler, j);
 
+            auto const dat = boost::filesystem::path (
+                tempDir.path()) / "nudb.dat";
+            auto const datSize = [&]
+            {
+                return type == "nudb" ?
+                    boost::filesystem::file_size (dat) : 0;
+            };
+            auto const before = datSize ();
+
             // Write the batch
             storeBatch (*backend, batch);
 
+            // Once synced, the batch is in the files
+            backend->sync ();
+            if (type == "nudb")
+                BEAST_EXPECT(datSize () > before);
+
             {
                 // Read it back in
                 Batch copy;
@@ -97,6 +112,119 @@ public:
         }
     }
 
+    // Batches and single objects stored from several threads at once,
+    // as happens when the branches of a SHAMap are flushed in parallel
+    void testConcurrentStore (
+        std::string const& type, std::uint64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+
+        testcase ("Backend concurrent store type=" + type);
+
+        Section params;
+        beast::temp_dir tempDir;
+        params.set ("type", type);
+        params.set ("path", tempDir.path());
+
+        auto const batch = createPredictableBatch (2000, seedValue);
+
+        beast::Journal j;
+        std::unique_ptr <Backend> backend =
+            Manager::instance().make_Backend (params, scheduler, j);
+
+        // Each thread stores every fourth group of 50 objects, half
+        // of them as batches and half one at a time.
+        std::size_t const threads = 4;
+        std::size_t const group = 50;
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back ([&, t]
+            {
+                for (auto i = t * group; i < batch.size ();
+                    i += threads * group)
+                {
+                    auto const first = batch.begin () + i;
+                    auto const last = batch.begin () +
+                        std::min (i + group, batch.size ());
+                    if ((i / (threads * group)) % 2 == 0)
+                        backend->storeBatch (Batch (first, last));
+                    else
+                        std::for_each (first, last,
+                            [&](auto const& object)
+                            {
+                                backend->store (object);
+                            });
+                }
+
+                // Runs alongside the other threads' stores
+                backend->sync ();
+            });
+        }
+        for (auto& w : workers)
+            w.join ();
+
+        // Close the backend so deferred writes complete
+        backend.reset ();
+        backend = Manager::instance().make_Backend (params, scheduler, j);
+
+        Batch copy;
+        fetchCopyOfBatch (*backend, &copy, batch);
+        BEAST_EXPECT(areBatchesEqual (batch, copy));
+    }
+
+    // Objects stored with and without a dictionary stay readable
+    void testDictionary (std::uint64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+
+        testcase ("Backend dictionary");
+
+        Section params;
+        beast::temp_dir tempDir;
+        params.set ("type", "nudb");
+        params.set ("path", tempDir.path());
+
+        auto batch = createPredictableBatch (400, seedValue);
+        Batch const first (batch.begin (), batch.begin () + 200);
+        Batch const second (batch.begin () + 200, batch.end ());
+
+        beast::Journal j;
+
+        {
+            std::unique_ptr <Backend> backend =
+                Manager::instance().make_Backend (params, scheduler, j);
+            storeBatch (*backend, first);
+            BEAST_EXPECT(trainDictionary (*backend, 100, j));
+            storeBatch (*backend, second);
+
+            Batch copy;
+            fetchCopyOfBatch (*backend, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+        }
+
+        {
+            // The dictionary is reloaded with the backend
+            std::unique_ptr <Backend> backend =
+                Manager::instance().make_Backend (params, scheduler, j);
+            BEAST_EXPECT(backend->addDictionary (Blob (64, 0x55)));
+
+            Batch copy;
+            fetchCopyOfBatch (*backend, &copy, batch);
+            BEAST_EXPECT(areBatchesEqual (batch, copy));
+        }
+
+        {
+            Section memory;
+            memory.set ("type", "memory");
+            memory.set ("path", "dictionary");
+            std::unique_ptr <Backend> backend =
+                Manager::instance().make_Backend (memory, scheduler, j);
+            storeBatch (*backend, first);
+            BEAST_EXPECT(! trainDictionary (*backend, 100, j));
+        }
+    }
+
     //--------------------------------------------------------------------------
 
     void run ()
@@ -105,8 +233,14 @@ public:
 
         testBackend ("nudb", seedValue);
 
+        testDictionary (seedValue);
+
+        testConcurrentStore ("nudb", seedValue);
+        testConcurrentStore ("memory", seedValue);
+
     #if RIPPLE_ROCKSDB_AVAILABLE
         testBackend ("rocksdb", seedValue);
+        testConcurrentStore ("rocksdb", seedValue);
     #endif
 
     #ifdef RIPPLE_ENABLE_SQLITE_BACKEND_TESTS
@@ -23,6 +23,8 @@
 #include <ripple/nodestore/Manager.h>
 #include <ripple/nodestore/impl/DecodedBlob.h>
 #include <ripple/nodestore/impl/EncodedBlob.h>
+#include <ripple/nodestore/impl/codec.h>
+#include <nudb/detail/buffer.hpp>
 
 namespace ripple {
 namespace NodeStore {
@@ -77,6 +79,137 @@ public:
         }
     }
 
+    // Objects shaped like trust lines: the same field headers
+    // around a few currencies and issuers, and unique balances.
+    static
+    Blob
+    makeEntry (beast::xor_shift_engine& rng)
+    {
+        auto append = [](Blob& b, std::initializer_list<std::uint8_t> v)
+        {
+            b.insert (b.end (), v.begin (), v.end ());
+        };
+        auto random = [&rng](Blob& b, std::size_t n)
+        {
+            auto const size = b.size ();
+            b.resize (size + n);
+            beast::rngfill (&b[size], n, rng);
+        };
+        auto shared = [&rng](Blob& b, std::size_t n, int choices)
+        {
+            beast::xor_shift_engine g (rand_int (rng, 1, choices));
+            auto const size = b.size ();
+            b.resize (size + n);
+            beast::rngfill (&b[size], n, g);
+        };
+
+        Blob b (9, 0);
+        b[8] = hotACCOUNT_NODE;
+        append (b, {0x4D, 0x4C, 0x4E, 0x00, 0x11, 0x00, 0x72, 0x22});
+        random (b, 4);
+        append (b, {0x25});
+        random (b, 4);
+        append (b, {0x37, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            0x38, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x55});
+        random (b, 32);
+        for (int i = 0; i < 3; ++i)
+        {
+            append (b, {std::uint8_t (0x62 + i), 0xD4});
+            random (b, 7);
+            shared (b, 20, 3);      // currency
+            shared (b, 20, 8);      // issuer
+        }
+        random (b, 32);
+        return b;
+    }
+
+    // Checks compression with and without a dictionary
+    void testCodec (std::uint64_t const seedValue)
+    {
+        testcase ("codec");
+
+        beast::xor_shift_engine rng (seedValue);
+        std::vector<Blob> samples;
+        for (int i = 0; i < 1000; ++i)
+            samples.push_back (makeEntry (rng));
+
+        auto const trained = train_dictionary (samples);
+        BEAST_EXPECT(! trained.empty ());
+        BEAST_EXPECT(trained.size () <= CodecDictionary::maxSize);
+        BEAST_EXPECT(train_dictionary (samples, 256).size () <= 256);
+
+        CodecDictionaries dicts;
+        auto const& dict = dicts.add (3, trained);
+        BEAST_EXPECT(dicts.current () == &dict);
+        BEAST_EXPECT(dicts.find (3) == &dict);
+        BEAST_EXPECT(dicts.find (1) == nullptr);
+
+        auto roundTrip = [&](Blob const& in,
+            CodecDictionary const* with,
+            CodecDictionaries const* from)
+        {
+            nudb::detail::buffer bf;
+            auto const out = nodeobject_compress (
+                in.data (), in.size (), bf, with);
+            nudb::detail::buffer bf2;
+            auto const check = nodeobject_decompress (
+                out.first, out.second, bf2, from);
+            BEAST_EXPECT(check.second == in.size ());
+            BEAST_EXPECT(std::memcmp (
+                check.first, in.data (), in.size ()) == 0);
+            return out.second;
+        };
+
+        std::size_t before = 0;
+        std::size_t after = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            auto const entry = makeEntry (rng);
+            before += roundTrip (entry, nullptr, nullptr);
+            after += roundTrip (entry, &dict, &dicts);
+
+            // Objects stored before a dictionary remain readable
+            roundTrip (entry, nullptr, &dicts);
+        }
+        BEAST_EXPECT(after < before * 3 / 4);
+
+        {
+            // Compressed with a dictionary that isn't available
+            auto const entry = makeEntry (rng);
+            nudb::detail::buffer bf;
+            auto const out = nodeobject_compress (
+                entry.data (), entry.size (), bf, &dict);
+            CodecDictionaries other;
+            other.add (1, trained);
+            for (auto const from : {&other, (CodecDictionaries*)nullptr})
+            {
+                nudb::detail::buffer bf2;
+                try
+                {
+                    nodeobject_decompress (
+                        out.first, out.second, bf2, from);
+                    fail ();
+                }
+                catch (std::runtime_error const&)
+                {
+                    pass ();
+                }
+            }
+        }
+
+        // Dictionaries are only ever added
+        try
+        {
+            dicts.add (2, trained);
+            fail ();
+        }
+        catch (std::runtime_error const&)
+        {
+            pass ();
+        }
+        BEAST_EXPECT(dicts.current () == &dict);
+    }
+
     void run ()
     {
         std::uint64_t const seedValue = 50;
@@ -84,6 +217,8 @@ public:
         testBatches (seedValue);
 
         testBlobs (seedValue);
+
+        testCodec (seedValue);
     }
 };
 
@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/nodestore/TestBase.h>
+#include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/Manager.h>
+#include <ripple/beast/utility/temp_dir.h>
+
+namespace ripple {
+namespace NodeStore {
+
+class DatabaseShard_test : public TestBase
+{
+    static std::uint32_t constexpr ledgersPerShard = 8;
+
+    Section
+    makeConfig (beast::temp_dir const& dir)
+    {
+        Section config;
+        config.set ("path", dir.path ());
+        config.set ("ledgers_per_shard", std::to_string (ledgersPerShard));
+        return config;
+    }
+
+    // Store a ledger's objects and mark it stored
+    void
+    storeLedger (DatabaseShard& db, std::uint32_t seq, Batch const& batch)
+    {
+        for (auto const& object : batch)
+        {
+            Blob data (object->getData ());
+            BEAST_EXPECT(db.store (object->getType (),
+                std::move (data), object->getHash (), seq));
+        }
+        db.setStored (seq);
+    }
+
+public:
+    void
+    testAcquire ()
+    {
+        testcase ("acquire");
+
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+        beast::temp_dir dir;
+        beast::Journal j;
+
+        std::map <std::uint32_t, Batch> ledgers;
+        std::uint32_t index;
+        {
+            auto db = Manager::instance ().make_DatabaseShard (
+                "test", scheduler, 2, parent, makeConfig (dir), j);
+            BEAST_EXPECT(db->getCompleteShards () == "empty");
+
+            // Nothing is acquired until a whole shard is validated
+            BEAST_EXPECT(! db->prepare (ledgersPerShard));
+
+            auto seq = db->prepare (ledgersPerShard + 1);
+            if (! BEAST_EXPECT(seq))
+                return;
+            BEAST_EXPECT(*seq == ledgersPerShard);
+            index = db->seqToShardIndex (*seq);
+            BEAST_EXPECT(index == 0);
+
+            // Ledgers are acquired from the top down
+            for (std::uint32_t n = 0; n < ledgersPerShard / 2; ++n)
+            {
+                seq = db->prepare (ledgersPerShard + 1);
+                if (! BEAST_EXPECT(seq && *seq == ledgersPerShard - n))
+                    return;
+                ledgers[*seq] = createPredictableBatch (20, *seq);
+                storeLedger (*db, *seq, ledgers[*seq]);
+                BEAST_EXPECT(db->contains (*seq));
+            }
+            BEAST_EXPECT(! db->contains (1));
+
+            // Ledgers in other shards are refused
+            Blob data (ledgers.begin ()->second.front ()->getData ());
+            BEAST_EXPECT(! db->store (hotLEDGER, std::move (data),
+                uint256 (1), ledgersPerShard + 1));
+        }
+
+        {
+            // The shard picks up where it left off
+            auto db = Manager::instance ().make_DatabaseShard (
+                "test", scheduler, 2, parent, makeConfig (dir), j);
+            for (auto const& ledger : ledgers)
+                BEAST_EXPECT(db->contains (ledger.first));
+
+            for (;;)
+            {
+                auto const seq = db->prepare (ledgersPerShard + 1);
+                if (! seq)
+                    break;
+                if (! BEAST_EXPECT(db->seqToShardIndex (*seq) == index))
+                    return;
+                ledgers[*seq] = createPredictableBatch (20, *seq);
+                storeLedger (*db, *seq, ledgers[*seq]);
+            }
+            BEAST_EXPECT(ledgers.size () == ledgersPerShard);
+            BEAST_EXPECT(db->getCompleteShards () == "0");
+        }
+
+        {
+            // Complete shards are found on open, and read by sequence
+            auto db = Manager::instance ().make_DatabaseShard (
+                "test", scheduler, 2, parent, makeConfig (dir), j);
+            BEAST_EXPECT(db->getCompleteShards () == "0");
+
+            // Only the shard holding the ledger is read
+            auto const& first = ledgers.begin ()->second.front ();
+            BEAST_EXPECT(! db->fetch (
+                first->getHash (), ledgersPerShard + 1));
+            BEAST_EXPECT(! db->fetch (uint256 (1), 1));
+
+            for (std::uint32_t seq = 1; seq <= ledgersPerShard; ++seq)
+                BEAST_EXPECT(db->contains (seq));
+            BEAST_EXPECT(! db->contains (ledgersPerShard + 1));
+
+            auto& database = dynamic_cast <Database&> (*db);
+            bool found = true;
+            for (auto const& ledger : ledgers)
+            {
+                for (auto const& object : ledger.second)
+                {
+                    auto const result = db->fetch (
+                        object->getHash (), ledger.first);
+                    found = found && result && isSame (result, object);
+                    auto const other = database.fetch (object->getHash ());
+                    found = found && other && isSame (other, object);
+                }
+            }
+            BEAST_EXPECT(found);
+
+            // The next shard is one not yet held
+            auto const seq = db->prepare (ledgersPerShard * 2 + 1);
+            BEAST_EXPECT(seq && db->seqToShardIndex (*seq) == 1);
+        }
+    }
+
+    void
+    testEarliest ()
+    {
+        testcase ("earliest");
+
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+        beast::temp_dir dir;
+        beast::Journal j;
+
+        auto config = makeConfig (dir);
+        config.set ("earliest_seq", std::to_string (ledgersPerShard + 2));
+        auto db = Manager::instance ().make_DatabaseShard (
+            "test", scheduler, 2, parent, config, j);
+
+        // Shards holding ledgers before the earliest are never acquired
+        BEAST_EXPECT(! db->prepare (ledgersPerShard * 3));
+        auto const seq = db->prepare (ledgersPerShard * 3 + 1);
+        BEAST_EXPECT(seq && db->seqToShardIndex (*seq) == 2);
+    }
+
+    void
+    run () override
+    {
+        testAcquire ();
+        testEarliest ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(DatabaseShard,NodeStore,ripple);
+
+}
+}
@@ -21,6 +21,7 @@
 #include <test/nodestore/TestBase.h>
 #include <ripple/nodestore/DummyScheduler.h>
 #include <ripple/nodestore/Manager.h>
+#include <ripple/nodestore/impl/BloomFilter.h>
 #include <ripple/beast/utility/temp_dir.h>
 
 namespace ripple {
@@ -160,6 +161,250 @@ public:
 
     //--------------------------------------------------------------------------
 
+    void testBloomFilter (std::int64_t const seedValue)
+    {
+        testcase ("bloom filter");
+
+        auto const present = createPredictableBatch (
+            numObjectsToTest, seedValue);
+        auto const missing = createPredictableBatch (
+            numObjectsToTest, seedValue + 1);
+
+        BloomFilter filter (numObjectsToTest);
+        for (auto const& object : present)
+            BEAST_EXPECT(! filter.mayContain (object->getHash ()));
+        for (auto const& object : present)
+            filter.insert (object->getHash ());
+
+        bool found = true;
+        for (auto const& object : present)
+            found = found && filter.mayContain (object->getHash ());
+        BEAST_EXPECT(found);
+
+        // About one percent at the expected size
+        int falsePositives = 0;
+        for (auto const& object : missing)
+            if (filter.mayContain (object->getHash ()))
+                ++falsePositives;
+        BEAST_EXPECT(falsePositives < numObjectsToTest / 20);
+    }
+
+    // Fetch each object, returning the number found
+    static int fetchAll (Database& db, Batch const& batch)
+    {
+        int found = 0;
+        for (auto const& object : batch)
+            if (auto const result = db.fetch (object->getHash ()))
+                found += isSame (result, object);
+        return found;
+    }
+
+    // Fetch the objects as one batch, returning the number found
+    static int fetchBatchAll (Database& db, Batch const& batch)
+    {
+        std::vector <uint256> hashes;
+        for (auto const& object : batch)
+            hashes.push_back (object->getHash ());
+
+        auto const objects = db.fetchBatch (hashes);
+        int found = 0;
+        for (std::size_t i = 0; i < batch.size (); ++i)
+            if (objects[i])
+                found += isSame (objects[i], batch[i]);
+        return found;
+    }
+
+    void testFetchBatch (std::string const& type,
+        std::int64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("batch fetch from NodeStore backend '" + type + "'");
+
+        beast::temp_dir node_db;
+        Section nodeParams;
+        nodeParams.set ("type", type);
+        nodeParams.set ("path", node_db.path());
+
+        auto const present = createPredictableBatch (
+            numObjectsToTest, seedValue);
+        auto const missing = createPredictableBatch (
+            numObjectsToTest, seedValue + 1);
+        beast::Journal j;
+
+        {
+            std::unique_ptr <Database> db = Manager::instance().make_Database (
+                "test", scheduler, 2, parent, nodeParams, j);
+            storeBatch (*db, present);
+        }
+
+        {
+            // Objects come back in the order asked for, whether they
+            // are read from the backend or found in the caches
+            std::unique_ptr <Database> db = Manager::instance().make_Database (
+                "test", scheduler, 2, parent, nodeParams, j);
+
+            Batch mixed;
+            for (std::size_t i = 0; i < present.size (); ++i)
+            {
+                mixed.push_back (present[i]);
+                mixed.push_back (missing[i]);
+            }
+
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                std::vector <uint256> hashes;
+                for (auto const& object : mixed)
+                    hashes.push_back (object->getHash ());
+                auto const objects = db->fetchBatch (hashes);
+
+                bool same = objects.size () == mixed.size ();
+                for (std::size_t i = 0; same && i < mixed.size (); i += 2)
+                {
+                    same = objects[i] && isSame (objects[i], mixed[i]) &&
+                        ! objects[i + 1];
+                }
+                BEAST_EXPECT(same);
+            }
+            BEAST_EXPECT(db->getFetchTotalCount () == mixed.size ());
+            BEAST_EXPECT(db->getFetchHitCount () == present.size ());
+        }
+
+        {
+            // Async reads go to the backend in batches
+            std::unique_ptr <Database> db = Manager::instance().make_Database (
+                "test", scheduler, 2, parent, nodeParams, j);
+
+            for (auto const& object : present)
+            {
+                std::shared_ptr <NodeObject> result;
+                db->asyncFetch (object->getHash (), result);
+            }
+            db->waitReads ();
+            BEAST_EXPECT(fetchAll (*db, present) == present.size ());
+            BEAST_EXPECT(db->getFetchHitCount () == present.size ());
+        }
+    }
+
+    void testFilter (std::string const& type, std::int64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("filtered NodeStore backend '" + type + "'");
+
+        beast::temp_dir node_db;
+        Section nodeParams;
+        nodeParams.set ("type", type);
+        nodeParams.set ("path", node_db.path());
+        nodeParams.set ("filter_size", std::to_string (numObjectsToTest));
+
+        auto const present = createPredictableBatch (
+            numObjectsToTest, seedValue);
+        beast::Journal j;
+
+        auto const check = [&](Database& db, std::uint64_t seed)
+        {
+            // Objects we have are always fetched
+            BEAST_EXPECT(fetchAll (db, present) == present.size ());
+
+            // Objects we don't have rarely go to the backend
+            auto const hits = db.getFilterHitCount ();
+            auto const falsePositives = db.getFilterFalsePositiveCount ();
+            auto const missing = createPredictableBatch (
+                numObjectsToTest, seed);
+            BEAST_EXPECT(fetchAll (db, missing) == 0);
+            BEAST_EXPECT(db.getFilterHitCount () - hits +
+                db.getFilterFalsePositiveCount () - falsePositives ==
+                    missing.size ());
+            BEAST_EXPECT(db.getFilterFalsePositiveCount () -
+                falsePositives < missing.size () / 20);
+        };
+
+        {
+            std::unique_ptr <Database> db = Manager::instance().make_Database (
+                "test", scheduler, 2, parent, nodeParams, j);
+            storeBatch (*db, present);
+            check (*db, seedValue + 1);
+        }
+
+        {
+            // The filter is filled from the backend on open
+            std::unique_ptr <Database> db = Manager::instance().make_Database (
+                "test", scheduler, 2, parent, nodeParams, j);
+            check (*db, seedValue + 2);
+        }
+    }
+
+    void testFilterRotating (std::string const& type,
+        std::int64_t const seedValue)
+    {
+        DummyScheduler scheduler;
+        RootStoppable parent ("TestRootStoppable");
+
+        testcase ("filtered rotating NodeStore backend '" + type + "'");
+
+        beast::temp_dir node_db;
+        beast::Journal j;
+        auto const makeBackend = [&](std::string const& name)
+        {
+            Section params;
+            params.set ("type", type);
+            params.set ("path", node_db.file (name));
+            return std::shared_ptr <Backend> (
+                Manager::instance().make_Backend (params, scheduler, j));
+        };
+
+        auto const first = createPredictableBatch (
+            numObjectsToTest, seedValue);
+        auto const second = createPredictableBatch (
+            numObjectsToTest, seedValue + 1);
+        auto const missing = createPredictableBatch (
+            numObjectsToTest, seedValue + 2);
+
+        auto dbr = Manager::instance().make_DatabaseRotating (
+            "test", scheduler, 2, parent, makeBackend ("a"),
+            makeBackend ("b"), numObjectsToTest, j);
+        auto& db = dynamic_cast <Database&> (*dbr);
+        storeBatch (db, first);
+
+        std::shared_ptr <Backend> oldBackend;
+        {
+            std::lock_guard <std::mutex> lock (dbr->peekMutex ());
+            oldBackend = dbr->rotateBackends (makeBackend ("c"));
+        }
+        storeBatch (db, second);
+
+        // Rotated objects are found, and copied forward
+        dbr->getPositiveCache ().clear ();
+        BEAST_EXPECT(fetchAll (db, first) == first.size ());
+        BEAST_EXPECT(fetchAll (db, second) == second.size ());
+        BEAST_EXPECT(fetchAll (db, missing) == 0);
+        BEAST_EXPECT(db.getFilterHitCount () >= missing.size ());
+
+        {
+            std::lock_guard <std::mutex> lock (dbr->peekMutex ());
+            oldBackend = dbr->rotateBackends (makeBackend ("d"));
+        }
+
+        dbr->getPositiveCache ().clear ();
+        BEAST_EXPECT(fetchAll (db, first) == first.size ());
+        BEAST_EXPECT(fetchBatchAll (db, second) == second.size ());
+
+        // Objects copied forward by a batch fetch survive a rotation
+        {
+            std::lock_guard <std::mutex> lock (dbr->peekMutex ());
+            oldBackend = dbr->rotateBackends (makeBackend ("e"));
+        }
+
+        dbr->getPositiveCache ().clear ();
+        BEAST_EXPECT(fetchBatchAll (db, second) == second.size ());
+        BEAST_EXPECT(fetchBatchAll (db, missing) == 0);
+    }
+
+    //--------------------------------------------------------------------------
+
     void runBackendTests (std::int64_t const seedValue)
     {
         testNodeStore ("nudb", true, seedValue);
@@ -195,6 +440,17 @@ public:
         runBackendTests (seedValue);
 
         runImportTests (seedValue);
+
+        testFetchBatch ("memory", seedValue);
+        testFetchBatch ("nudb", seedValue);
+    #if RIPPLE_ROCKSDB_AVAILABLE
+        testFetchBatch ("rocksdb", seedValue);
+    #endif
+
+        testBloomFilter (seedValue);
+
+        testFilter ("nudb", seedValue);
+        testFilterRotating ("nudb", seedValue);
     }
 };
 
@@ -21,6 +21,7 @@
 #include <test/nodestore/TestBase.h>
 #include <ripple/nodestore/DummyScheduler.h>
 #include <ripple/nodestore/Manager.h>
+#include <ripple/nodestore/impl/BloomFilter.h>
 #include <ripple/basics/BasicConfig.h>
 #include <ripple/unity/rocksdb.h>
 #include <ripple/beast/utility/temp_dir.h>
@@ -143,6 +144,9 @@ public:
     {
         // percent of fetches for missing nodes
         missingNodePercent = 20
+
+        // keys per batch fetch
+        ,fetchBatchSize = 64
     };
 
     std::size_t const default_repeat = 3;
@@ -383,6 +387,91 @@ public:
         backend->close();
     }
 
+    // Fetch existing keys, several at a time
+    void
+    do_fetch_batch (Section const& config, Params const& params)
+    {
+        beast::Journal journal;
+        DummyScheduler scheduler;
+        auto backend = make_Backend (config, scheduler, journal);
+        BEAST_EXPECT(backend != nullptr);
+
+        class Body
+        {
+        private:
+            suite& suite_;
+            Backend& backend_;
+            Sequence seq1_;
+            beast::xor_shift_engine gen_;
+            std::uniform_int_distribution<std::size_t> dist_;
+            std::vector<std::shared_ptr<NodeObject>> objs_;
+            std::vector<uint256> keys_;
+
+        public:
+            Body (std::size_t id, suite& s,
+                    Params const& params, Backend& backend)
+                : suite_(s)
+                , backend_ (backend)
+                , seq1_ (1)
+                , gen_ (id + 1)
+                , dist_ (0, params.items - 1)
+            {
+            }
+
+            void
+            operator()(std::size_t i)
+            {
+                objs_.push_back (seq1_.obj(dist_(gen_)));
+                keys_.push_back (objs_.back()->getHash());
+                if (keys_.size() < fetchBatchSize)
+                    return;
+
+                try
+                {
+                    std::vector<void const*> keys;
+                    for (auto const& key : keys_)
+                        keys.push_back (key.data());
+
+                    std::vector<std::shared_ptr<NodeObject>> results;
+                    if (backend_.canFetchBatch())
+                    {
+                        results = backend_.fetchBatch (
+                            keys.size(), keys.data());
+                    }
+                    else
+                    {
+                        results.resize (keys.size());
+                        for (std::size_t j = 0; j < keys.size(); ++j)
+                            backend_.fetch (keys[j], &results[j]);
+                    }
+
+                    for (std::size_t j = 0; j < objs_.size(); ++j)
+                        suite_.expect(results[j] &&
+                            isSame(results[j], objs_[j]));
+                }
+                catch(std::exception const& e)
+                {
+                    suite_.fail(e.what());
+                }
+                objs_.clear();
+                keys_.clear();
+            }
+        };
+        try
+        {
+            parallel_for_id<Body>(params.items, params.threads,
+                std::ref(*this), std::ref(params), std::ref(*backend));
+        }
+        catch (std::exception const&)
+        {
+        #if NODESTORE_TIMING_DO_VERIFY
+            backend->verify();
+        #endif
+            Rethrow();
+        }
+        backend->close();
+    }
+
     // Perform lookups of non-existent keys
     void
     do_missing (Section const& config, Params const& params)
@@ -446,6 +535,77 @@ public:
         backend->close();
     }
 
+    // Perform lookups of non-existent keys, skipping the ones a filter
+    // rules out. Includes the time to fill the filter from the backend.
+    void
+    do_filtered (Section const& config, Params const& params)
+    {
+        beast::Journal journal;
+        DummyScheduler scheduler;
+        auto backend = make_Backend (config, scheduler, journal);
+        BEAST_EXPECT(backend != nullptr);
+
+        BloomFilter filter (params.items);
+        backend->for_each (
+            [&filter](std::shared_ptr<NodeObject> object)
+            {
+                filter.insert (object->getHash());
+            });
+
+        class Body
+        {
+        private:
+            suite& suite_;
+            Backend& backend_;
+            BloomFilter const& filter_;
+            Sequence seq2_;
+
+        public:
+            Body (std::size_t id, suite& s,
+                    Params const& params, Backend& backend,
+                        BloomFilter const& filter)
+                : suite_ (s)
+                , backend_ (backend)
+                , filter_ (filter)
+                , seq2_ (2)
+            {
+            }
+
+            void
+            operator()(std::size_t i)
+            {
+                try
+                {
+                    auto const key = seq2_.key(i);
+                    if (! filter_.mayContain (key))
+                        return;
+                    std::shared_ptr<NodeObject> result;
+                    backend_.fetch(key.data(), &result);
+                    suite_.expect(! result);
+                }
+                catch(std::exception const& e)
+                {
+                    suite_.fail(e.what());
+                }
+            }
+        };
+
+        try
+        {
+            parallel_for_id<Body>(params.items, params.threads,
+                std::ref(*this), std::ref(params), std::ref(*backend),
+                    std::cref(filter));
+        }
+        catch (std::exception const&)
+        {
+        #if NODESTORE_TIMING_DO_VERIFY
+            backend->verify();
+        #endif
+            Rethrow();
+        }
+        backend->close();
+    }
+
     // Fetch with present and missing keys
     void
     do_mixed (Section const& config, Params const& params)
@@ -717,7 +877,9 @@ public:
             {
                  { "Insert",    &Timing_test::do_insert }
                 ,{ "Fetch",     &Timing_test::do_fetch }
+                ,{ "Batch",     &Timing_test::do_fetch_batch }
                 ,{ "Missing",   &Timing_test::do_missing }
+                ,{ "Filtered",  &Timing_test::do_filtered }
                 ,{ "Mixed",     &Timing_test::do_mixed }
                 ,{ "Work",      &Timing_test::do_work }
             };
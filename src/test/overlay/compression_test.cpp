@@ -0,0 +1,302 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/overlay/Message.h>
+#include <ripple/overlay/impl/ProtocolMessage.h>
+#include <ripple/overlay/impl/TMHello.h>
+#include <ripple/overlay/impl/TrafficCount.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <beast/http/empty_body.hpp>
+#include <beast/http/message.hpp>
+#include <boost/asio/buffer.hpp>
+#include <string>
+
+namespace ripple {
+
+class compression_test : public beast::unit_test::suite
+{
+    // Records what invokeProtocolMessage delivers
+    struct Handler
+    {
+        int type = 0;
+        std::size_t size = 0;
+        std::size_t uncompressedSize = 0;
+        std::string payload;
+
+        boost::system::error_code
+        onMessageUnknown (std::uint16_t)
+        {
+            return {};
+        }
+
+        boost::system::error_code
+        onMessageBegin (std::uint16_t t,
+            std::shared_ptr <::google::protobuf::Message> const& m,
+            std::size_t n, std::size_t uncompressed)
+        {
+            type = t;
+            size = n;
+            uncompressedSize = uncompressed;
+            payload = m->SerializeAsString ();
+            return {};
+        }
+
+        template <class T>
+        void
+        onMessage (std::shared_ptr <T> const&)
+        {
+        }
+
+        void
+        onMessageEnd (std::uint16_t,
+            std::shared_ptr <::google::protobuf::Message> const&)
+        {
+        }
+    };
+
+    // A fetch pack style reply: ledger nodes share a lot of structure
+    static
+    protocol::TMGetObjectByHash
+    makeObjects (std::size_t count)
+    {
+        beast::xor_shift_engine g (count);
+        protocol::TMGetObjectByHash tm;
+        tm.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
+        tm.set_query (false);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::string hash (32, '\0');
+            beast::rngfill (&hash[0], hash.size (), g);
+
+            // An inner node with a few children, the rest empty
+            std::string data (512 + 4, '\0');
+            for (std::size_t c = 0; c < 16; c += 5)
+                beast::rngfill (&data[c * 32], 32, g);
+            data.replace (512, 4, "MIN\0", 4);
+
+            auto& obj = *tm.add_objects ();
+            obj.set_hash (hash);
+            obj.set_data (data);
+            obj.set_ledgerseq (30000000);
+        }
+        return tm;
+    }
+
+    void
+    testRoundTrip ()
+    {
+        testcase ("round trip");
+
+        auto const tm = makeObjects (100);
+        Message const m (tm, protocol::mtGET_OBJECTS);
+
+        auto const& plain = m.getBuffer ();
+        auto const& compressed = m.getBuffer (true);
+        BEAST_EXPECT(! Message::compressed (boost::asio::buffer (plain)));
+        BEAST_EXPECT(Message::compressed (boost::asio::buffer (compressed)));
+        BEAST_EXPECT(compressed.size () < plain.size ());
+        BEAST_EXPECT(&m.getBuffer (false) == &plain);
+
+        // Compressed once, no matter how many peers it goes to
+        BEAST_EXPECT(&m.getBuffer (true) == &compressed);
+
+        BEAST_EXPECT(Message::type (boost::asio::buffer (compressed)) ==
+            protocol::mtGET_OBJECTS);
+        BEAST_EXPECT(Message::kHeaderBytes +
+            Message::size (boost::asio::buffer (compressed)) ==
+                compressed.size ());
+
+        for (auto const* buf : {&plain, &compressed})
+        {
+            Handler h;
+            auto const result = invokeProtocolMessage (
+                boost::asio::buffer (*buf), true, h);
+            BEAST_EXPECT(! result.second);
+            BEAST_EXPECT(result.first == buf->size ());
+            BEAST_EXPECT(h.type == protocol::mtGET_OBJECTS);
+            BEAST_EXPECT(h.size == buf->size ());
+            BEAST_EXPECT(h.uncompressedSize == plain.size ());
+            BEAST_EXPECT(h.payload == tm.SerializeAsString ());
+        }
+
+        {
+            // Nothing is consumed until the whole message arrives
+            Handler h;
+            auto const result = invokeProtocolMessage (
+                boost::asio::buffer (compressed.data (),
+                    compressed.size () - 1), true, h);
+            BEAST_EXPECT(! result.second);
+            BEAST_EXPECT(result.first == 0);
+            BEAST_EXPECT(h.type == 0);
+        }
+    }
+
+    void
+    testThreshold ()
+    {
+        testcase ("threshold");
+
+        {
+            // Too small to bother
+            protocol::TMPing tm;
+            tm.set_type (protocol::TMPing::ptPING);
+            tm.set_seq (1);
+            Message const m (tm, protocol::mtPING);
+            BEAST_EXPECT(&m.getBuffer (true) == &m.getBuffer ());
+        }
+
+        {
+            // Large, but nothing to gain
+            beast::xor_shift_engine g (17);
+            std::string data (16384, '\0');
+            beast::rngfill (&data[0], data.size (), g);
+
+            protocol::TMTransaction tm;
+            tm.set_rawtransaction (data);
+            tm.set_status (protocol::tsNEW);
+            Message const m (tm, protocol::mtTRANSACTION);
+            BEAST_EXPECT(&m.getBuffer (true) == &m.getBuffer ());
+        }
+    }
+
+    void
+    testMalformed ()
+    {
+        testcase ("malformed");
+
+        Message const m (makeObjects (50), protocol::mtGET_OBJECTS);
+        auto const& compressed = m.getBuffer (true);
+        BEAST_EXPECT(compressed.size () < m.getBuffer ().size ());
+
+        auto check = [&](std::vector <std::uint8_t> const& buf)
+        {
+            Handler h;
+            auto const result = invokeProtocolMessage (
+                boost::asio::buffer (buf), true, h);
+            return result.second && h.type == 0;
+        };
+
+        {
+            // Claims to expand past the limit
+            auto buf = compressed;
+            buf[Message::kHeaderBytes] = 0xFF;
+            BEAST_EXPECT(check (buf));
+        }
+
+        {
+            // Claims a different uncompressed size
+            auto buf = compressed;
+            ++buf[Message::kHeaderBytes + 3];
+            BEAST_EXPECT(check (buf));
+        }
+
+        {
+            // Truncated compressed data
+            auto buf = compressed;
+            buf.resize (buf.size () - 16);
+            auto const n = static_cast <unsigned> (
+                buf.size () - Message::kHeaderBytes);
+            buf[0] = static_cast <std::uint8_t> (0x80 | (n >> 24));
+            buf[1] = static_cast <std::uint8_t> (n >> 16);
+            buf[2] = static_cast <std::uint8_t> (n >> 8);
+            buf[3] = static_cast <std::uint8_t> (n);
+            BEAST_EXPECT(check (buf));
+        }
+
+        {
+            // Compression was not negotiated with the sender
+            Handler h;
+            auto const result = invokeProtocolMessage (
+                boost::asio::buffer (compressed), false, h);
+            BEAST_EXPECT(result.second ==
+                boost::system::errc::invalid_argument);
+            BEAST_EXPECT(h.type == 0);
+
+            // Uncompressed frames are still accepted
+            auto const& plain = m.getBuffer ();
+            auto const ok = invokeProtocolMessage (
+                boost::asio::buffer (plain), false, h);
+            BEAST_EXPECT(! ok.second);
+            BEAST_EXPECT(ok.first == plain.size ());
+            BEAST_EXPECT(h.type == protocol::mtGET_OBJECTS);
+        }
+    }
+
+    void
+    testNegotiation ()
+    {
+        testcase ("negotiation");
+
+        using request_type =
+            beast::http::request<beast::http::empty_body>;
+
+        request_type h;
+        BEAST_EXPECT(! peerSupportsCompression (h));
+        appendCompression (h);
+        BEAST_EXPECT(peerSupportsCompression (h));
+
+        request_type other;
+        other.insert ("Compression", "zstd, LZ4");
+        BEAST_EXPECT(peerSupportsCompression (other));
+
+        request_type none;
+        none.insert ("Compression", "zstd");
+        BEAST_EXPECT(! peerSupportsCompression (none));
+    }
+
+    void
+    testTraffic ()
+    {
+        testcase ("traffic");
+
+        TrafficCount traffic;
+        auto const cat = TrafficCount::category::CT_share_ledger;
+        traffic.addCount (cat, false, 400, 1000);
+        traffic.addCount (cat, false, 300, 300);
+        traffic.addCount (cat, true, 50, 200);
+
+        auto const counts = traffic.getCounts ();
+        auto const iter = counts.find (TrafficCount::getName (cat));
+        if (! BEAST_EXPECT(iter != counts.end ()))
+            return;
+        BEAST_EXPECT(iter->second.bytesOut == 700);
+        BEAST_EXPECT(iter->second.bytesOutUncompressed == 1300);
+        BEAST_EXPECT(iter->second.messagesOut == 2);
+        BEAST_EXPECT(iter->second.bytesIn == 50);
+        BEAST_EXPECT(iter->second.bytesInUncompressed == 200);
+        BEAST_EXPECT(iter->second.messagesIn == 1);
+    }
+
+    void
+    run () override
+    {
+        testRoundTrip ();
+        testThreshold ();
+        testMalformed ();
+        testNegotiation ();
+        testTraffic ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(compression,overlay,ripple);
+
+}
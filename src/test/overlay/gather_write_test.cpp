@@ -0,0 +1,251 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/overlay/Message.h>
+#include <ripple/overlay/impl/ProtocolMessage.h>
+#include <ripple/overlay/impl/TrafficCount.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/asio/buffer.hpp>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace ripple {
+
+class gather_write_test : public beast::unit_test::suite
+{
+    // Records the messages invokeProtocolMessage delivers, in order
+    struct Handler
+    {
+        std::vector<std::uint32_t> seqs;
+        int others = 0;
+
+        boost::system::error_code
+        onMessageUnknown (std::uint16_t)
+        {
+            return boost::system::errc::make_error_code (
+                boost::system::errc::invalid_argument);
+        }
+
+        boost::system::error_code
+        onMessageBegin (std::uint16_t,
+            std::shared_ptr <::google::protobuf::Message> const&,
+            std::size_t, std::size_t)
+        {
+            return {};
+        }
+
+        void
+        onMessage (std::shared_ptr <protocol::TMPing> const& m)
+        {
+            seqs.push_back (m->seq ());
+        }
+
+        template <class T>
+        void
+        onMessage (std::shared_ptr <T> const&)
+        {
+            ++others;
+        }
+
+        void
+        onMessageEnd (std::uint16_t,
+            std::shared_ptr <::google::protobuf::Message> const&)
+        {
+        }
+    };
+
+    // A queue of pings numbered from zero
+    static
+    std::deque<Message::pointer>
+    makeQueue (std::size_t count)
+    {
+        std::deque<Message::pointer> queue;
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            protocol::TMPing tm;
+            tm.set_type (protocol::TMPing::ptPING);
+            tm.set_seq (i);
+            queue.push_back (std::make_shared<Message> (
+                tm, protocol::mtPING));
+        }
+        return queue;
+    }
+
+    // The bytes a single gathered write puts on the wire
+    static
+    std::string
+    flatten (std::vector<boost::asio::const_buffer> const& buffers)
+    {
+        std::string s (boost::asio::buffer_size (buffers), '\0');
+        boost::asio::buffer_copy (boost::asio::buffer (&s[0], s.size ()),
+            buffers);
+        return s;
+    }
+
+    // Reads back every message in the bytes of a write, the way a
+    // peer's read buffer sees them
+    bool
+    readAll (std::string const& wire, Handler& h)
+    {
+        std::size_t used = 0;
+        while (used < wire.size ())
+        {
+            auto const r = invokeProtocolMessage (
+                boost::asio::buffer (wire.data () + used,
+                    wire.size () - used), true, h);
+            if (! BEAST_EXPECT(! r.second && r.first > 0))
+                return false;
+            used += r.first;
+        }
+        return true;
+    }
+
+    void
+    testOrder ()
+    {
+        testcase ("order");
+
+        auto const queue = makeQueue (10);
+        std::vector<boost::asio::const_buffer> buffers;
+        BEAST_EXPECT(gatherMessages (queue, false, buffers) == 10);
+        BEAST_EXPECT(buffers.size () == 10);
+
+        // The whole queue goes out as one write, in queue order
+        auto const wire = flatten (buffers);
+        Handler h;
+        BEAST_EXPECT(readAll (wire, h));
+        if (BEAST_EXPECT(h.seqs.size () == 10))
+        {
+            for (std::uint32_t i = 0; i < 10; ++i)
+                BEAST_EXPECT(h.seqs[i] == i);
+        }
+
+        // A write takes from the front of what is left
+        std::deque<Message::pointer> rest (queue.begin () + 4, queue.end ());
+        BEAST_EXPECT(gatherMessages (rest, false, buffers) == 6);
+        BEAST_EXPECT(flatten (buffers) == wire.substr (
+            wire.size () - boost::asio::buffer_size (buffers)));
+    }
+
+    void
+    testMixed ()
+    {
+        testcase ("compressed and uncompressed");
+
+        protocol::TMGetObjectByHash tm;
+        tm.set_type (protocol::TMGetObjectByHash::otLEDGER);
+        tm.set_query (false);
+        tm.add_objects ()->set_hash (std::string (4096, 'x'));
+
+        auto queue = makeQueue (2);
+        queue.insert (queue.begin () + 1,
+            std::make_shared<Message> (tm, protocol::mtGET_OBJECTS));
+
+        std::vector<boost::asio::const_buffer> buffers;
+        BEAST_EXPECT(gatherMessages (queue, true, buffers) == 3);
+        BEAST_EXPECT(Message::compressed (buffers[1]));
+
+        // Each message is read on its own, even though the bytes
+        // of the next one follow it in the same read
+        Handler h;
+        BEAST_EXPECT(readAll (flatten (buffers), h));
+        BEAST_EXPECT(h.others == 1);
+        if (BEAST_EXPECT(h.seqs.size () == 2))
+        {
+            BEAST_EXPECT(h.seqs[0] == 0);
+            BEAST_EXPECT(h.seqs[1] == 1);
+        }
+    }
+
+    void
+    testLimits ()
+    {
+        testcase ("limits");
+
+        std::vector<boost::asio::const_buffer> buffers;
+
+        {
+            std::deque<Message::pointer> const empty;
+            BEAST_EXPECT(gatherMessages (empty, false, buffers) == 0);
+        }
+
+        {
+            // No more than maxWriteMessages in one write
+            auto const queue = makeQueue (Tuning::maxWriteMessages + 10);
+            BEAST_EXPECT(gatherMessages (queue, false, buffers) ==
+                Tuning::maxWriteMessages);
+        }
+
+        {
+            // Stop once the write holds maxWriteBytes
+            protocol::TMGetObjectByHash tm;
+            tm.set_type (protocol::TMGetObjectByHash::otLEDGER);
+            tm.set_query (false);
+            tm.add_objects ()->set_hash (std::string (20 * 1024, 'x'));
+            auto const m = std::make_shared<Message> (
+                tm, protocol::mtGET_OBJECTS);
+            std::deque<Message::pointer> const queue (10, m);
+
+            auto const n = gatherMessages (queue, false, buffers);
+            BEAST_EXPECT(n == 4);
+            BEAST_EXPECT(boost::asio::buffer_size (buffers) >=
+                Tuning::maxWriteBytes);
+
+            // A message larger than the limit still goes out alone
+            tm.mutable_objects (0)->set_hash (
+                std::string (Tuning::maxWriteBytes * 2, 'x'));
+            std::deque<Message::pointer> const big (3,
+                std::make_shared<Message> (tm, protocol::mtGET_OBJECTS));
+            BEAST_EXPECT(gatherMessages (big, false, buffers) == 1);
+        }
+    }
+
+    void
+    testStats ()
+    {
+        testcase ("stats");
+
+        using namespace std::chrono;
+        TrafficCount traffic;
+        traffic.addWrite (1, microseconds (40));
+        traffic.addWrite (12, microseconds (110));
+        auto const& writes = traffic.getWriteStats ();
+        BEAST_EXPECT(writes.writes == 2);
+        BEAST_EXPECT(writes.messages == 13);
+        BEAST_EXPECT(writes.microseconds == 150);
+    }
+
+    void
+    run () override
+    {
+        testOrder ();
+        testMixed ();
+        testLimits ();
+        testStats ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(gather_write,overlay,ripple);
+
+}
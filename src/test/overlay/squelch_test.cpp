@@ -0,0 +1,331 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/basics/chrono.h>
+#include <ripple/overlay/Message.h>
+#include <ripple/overlay/impl/ProtocolMessage.h>
+#include <ripple/overlay/impl/Squelch.h>
+#include <ripple/overlay/impl/TrafficCount.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <ripple/protocol/SecretKey.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/asio/buffer.hpp>
+#include <chrono>
+#include <map>
+
+namespace ripple {
+
+class squelch_test : public beast::unit_test::suite
+{
+    // Records the squelches in effect
+    struct Handler : Squelch::Handler
+    {
+        std::map <Peer::id_t, std::chrono::seconds> squelches;
+        int unsquelches = 0;
+
+        void
+        squelch (PublicKey const&, Peer::id_t peer,
+            std::chrono::seconds duration) override
+        {
+            squelches[peer] = duration;
+        }
+
+        void
+        unsquelch (PublicKey const&, Peer::id_t peer) override
+        {
+            squelches.erase (peer);
+            ++unsquelches;
+        }
+    };
+
+    // Records what invokeProtocolMessage delivers
+    struct Reader
+    {
+        int type = 0;
+        std::string payload;
+
+        boost::system::error_code
+        onMessageUnknown (std::uint16_t)
+        {
+            return {};
+        }
+
+        boost::system::error_code
+        onMessageBegin (std::uint16_t t,
+            std::shared_ptr <::google::protobuf::Message> const& m,
+            std::size_t, std::size_t)
+        {
+            type = t;
+            payload = m->SerializeAsString ();
+            return {};
+        }
+
+        template <class T>
+        void
+        onMessage (std::shared_ptr <T> const&)
+        {
+        }
+
+        void
+        onMessageEnd (std::uint16_t,
+            std::shared_ptr <::google::protobuf::Message> const&)
+        {
+        }
+    };
+
+    static
+    PublicKey
+    randomValidator ()
+    {
+        return derivePublicKey (KeyType::secp256k1, randomSecretKey ());
+    }
+
+    // Every peer delivers each of `rounds` messages, in peer order
+    static
+    void
+    deliver (Squelch& squelch, PublicKey const& validator,
+        Peer::id_t peers, std::size_t rounds)
+    {
+        for (std::size_t i = 0; i < rounds; ++i)
+            for (Peer::id_t p = 1; p <= peers; ++p)
+                squelch.onMessage (validator, p);
+    }
+
+    void
+    testSelection ()
+    {
+        testcase ("selection");
+
+        using namespace std::chrono;
+        auto const v = randomValidator ();
+
+        {
+            // Too few peers to choose from
+            TestStopwatch clock;
+            Handler h;
+            Squelch squelch (h, clock);
+            deliver (squelch, v, Tuning::squelchSelectedPeers, 100);
+            BEAST_EXPECT(h.squelches.empty ());
+            BEAST_EXPECT(squelch.squelched () == 0);
+        }
+
+        TestStopwatch clock;
+        Handler h;
+        Squelch squelch (h, clock);
+
+        deliver (squelch, v, 8, Tuning::squelchMessageThreshold - 1);
+        BEAST_EXPECT(h.squelches.empty ());
+
+        // Peers 1 through 5 reach the threshold first
+        deliver (squelch, v, 8, 1);
+        BEAST_EXPECT(h.squelches.size () == 3);
+        BEAST_EXPECT(squelch.squelched () == 3);
+        for (Peer::id_t p = 6; p <= 8; ++p)
+        {
+            auto const iter = h.squelches.find (p);
+            if (! BEAST_EXPECT(iter != h.squelches.end ()))
+                continue;
+            BEAST_EXPECT(iter->second >=
+                seconds (Tuning::squelchMinSeconds));
+            BEAST_EXPECT(iter->second <=
+                seconds (Tuning::squelchMaxSeconds));
+        }
+
+        // Squelched peers stay squelched only once
+        deliver (squelch, v, 8, 1);
+        BEAST_EXPECT(h.squelches.size () == 3);
+
+        // A peer that shows up later is squelched for the rest of
+        // the period
+        auto const d = h.squelches[6];
+        clock.advance (seconds (10));
+        squelch.onMessage (v, 9);
+        BEAST_EXPECT(h.squelches.size () == 4);
+        BEAST_EXPECT(h.squelches[9] == d - seconds (10));
+
+        // Other validators are unaffected
+        squelch.onMessage (randomValidator (), 10);
+        BEAST_EXPECT(squelch.squelched () == 4);
+    }
+
+    void
+    testExpiry ()
+    {
+        testcase ("expiry");
+
+        using namespace std::chrono;
+        auto const v = randomValidator ();
+        TestStopwatch clock;
+        Handler h;
+        Squelch squelch (h, clock);
+
+        deliver (squelch, v, 8, Tuning::squelchMessageThreshold);
+        BEAST_EXPECT(h.squelches.size () == 3);
+        auto const d = h.squelches.begin ()->second;
+
+        // The selected peers keep delivering until the period ends
+        for (auto elapsed = seconds (0); elapsed <= d; elapsed += seconds (1))
+        {
+            deliver (squelch, v, Tuning::squelchSelectedPeers, 1);
+            squelch.onTimer ();
+            clock.advance (seconds (1));
+        }
+
+        // The peers lift their own squelches, so none are sent
+        BEAST_EXPECT(squelch.squelched () == 0);
+        BEAST_EXPECT(h.unsquelches == 0);
+
+        // And selection starts over, from every peer
+        h.squelches.clear ();
+        deliver (squelch, v, 8, Tuning::squelchMessageThreshold);
+        BEAST_EXPECT(h.squelches.size () == 3);
+    }
+
+    void
+    testIdle ()
+    {
+        testcase ("idle");
+
+        using namespace std::chrono;
+        auto const v = randomValidator ();
+        TestStopwatch clock;
+        Handler h;
+        Squelch squelch (h, clock);
+
+        deliver (squelch, v, 8, Tuning::squelchMessageThreshold);
+        BEAST_EXPECT(h.squelches.size () == 3);
+
+        // Peer 5 goes quiet
+        for (int i = 0; i <= Tuning::squelchIdleSeconds; ++i)
+        {
+            deliver (squelch, v, 4, 1);
+            squelch.onTimer ();
+            clock.advance (seconds (1));
+        }
+        BEAST_EXPECT(h.squelches.size () == 3);
+
+        deliver (squelch, v, 4, 1);
+        squelch.onTimer ();
+        BEAST_EXPECT(h.squelches.empty ());
+        BEAST_EXPECT(h.unsquelches == 3);
+        BEAST_EXPECT(squelch.squelched () == 0);
+    }
+
+    void
+    testDeactivate ()
+    {
+        testcase ("deactivate");
+
+        auto const v = randomValidator ();
+        TestStopwatch clock;
+        Handler h;
+        Squelch squelch (h, clock);
+
+        deliver (squelch, v, 8, Tuning::squelchMessageThreshold);
+        BEAST_EXPECT(h.squelches.size () == 3);
+
+        // Losing a squelched peer changes nothing else
+        squelch.onPeerDeactivate (8);
+        h.squelches.erase (8);
+        BEAST_EXPECT(h.unsquelches == 0);
+        BEAST_EXPECT(squelch.squelched () == 2);
+
+        // Losing a selected peer lifts the squelches
+        squelch.onPeerDeactivate (1);
+        BEAST_EXPECT(h.squelches.empty ());
+        BEAST_EXPECT(h.unsquelches == 2);
+
+        // Selection starts over among the remaining peers
+        deliver (squelch, v, 7, Tuning::squelchMessageThreshold);
+        BEAST_EXPECT(h.squelches.size () == 2);
+        BEAST_EXPECT(h.squelches.count (6) == 1);
+        BEAST_EXPECT(h.squelches.count (7) == 1);
+    }
+
+    void
+    testForget ()
+    {
+        testcase ("forget");
+
+        using namespace std::chrono;
+        auto const v = randomValidator ();
+        TestStopwatch clock;
+        Handler h;
+        Squelch squelch (h, clock);
+
+        deliver (squelch, v, 8, Tuning::squelchMessageThreshold);
+        BEAST_EXPECT(h.squelches.size () == 3);
+
+        // The validator goes away
+        clock.advance (seconds (Tuning::squelchForgetSeconds + 1));
+        squelch.onTimer ();
+        BEAST_EXPECT(h.squelches.empty ());
+        BEAST_EXPECT(squelch.squelched () == 0);
+
+        // Counting starts from scratch when it comes back
+        h.squelches.clear ();
+        deliver (squelch, v, 8, Tuning::squelchMessageThreshold - 1);
+        BEAST_EXPECT(h.squelches.empty ());
+    }
+
+    void
+    testMessage ()
+    {
+        testcase ("message");
+
+        auto const v = randomValidator ();
+        protocol::TMSquelch tm;
+        tm.set_squelch (true);
+        tm.set_validatorpubkey (v.data (), v.size ());
+        tm.set_squelchduration (Tuning::squelchMinSeconds);
+
+        Message const m (tm, protocol::mtSQUELCH);
+        Reader r;
+        auto const result = invokeProtocolMessage (
+            boost::asio::buffer (m.getBuffer ()), false, r);
+        BEAST_EXPECT(! result.second);
+        BEAST_EXPECT(result.first == m.getBuffer ().size ());
+        BEAST_EXPECT(r.type == protocol::mtSQUELCH);
+        BEAST_EXPECT(r.payload == tm.SerializeAsString ());
+
+        BEAST_EXPECT(TrafficCount::categorize (
+            tm, protocol::mtSQUELCH, true) ==
+                TrafficCount::category::CT_squelch);
+        BEAST_EXPECT(std::string (TrafficCount::getName (
+            TrafficCount::category::CT_squelch_suppressed)) ==
+                "squelch_suppressed");
+    }
+
+    void
+    run () override
+    {
+        testSelection ();
+        testExpiry ();
+        testIdle ();
+        testDeactivate ();
+        testForget ();
+        testMessage ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(squelch,overlay,ripple);
+
+}
@@ -0,0 +1,272 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/protocol/digest.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <ripple/beast/unit_test.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace ripple {
+
+namespace {
+
+using detail::sha512_batch_kernel;
+
+struct KernelName
+{
+    sha512_batch_kernel kernel;
+    char const* name;
+};
+
+KernelName const kernels[] =
+{
+    { sha512_batch_kernel::scalar, "scalar" },
+    { sha512_batch_kernel::avx2,   "avx2" },
+    { sha512_batch_kernel::avx512, "avx512" }
+};
+
+std::vector<Slice>
+makeSlices (std::vector<Blob> const& messages)
+{
+    std::vector<Slice> slices;
+    slices.reserve (messages.size ());
+    for (auto const& m : messages)
+        slices.emplace_back (m.data (), m.size ());
+    return slices;
+}
+
+} // (anon)
+
+class digest_batch_test : public beast::unit_test::suite
+{
+    beast::xor_shift_engine g_{5483};
+
+    Blob
+    randomBlob (std::size_t size)
+    {
+        Blob b (size);
+        if (size != 0)
+            beast::rngfill (b.data (), b.size (), g_);
+        return b;
+    }
+
+    // Checks every kernel this CPU has against sha512Half
+    void
+    check (std::vector<Blob> const& messages)
+    {
+        auto const slices = makeSlices (messages);
+
+        std::vector<uint256> expected;
+        for (auto const& s : slices)
+            expected.push_back (sha512Half (s));
+
+        for (auto const& k : kernels)
+        {
+            if (! detail::sha512HalfBatchSupported (k.kernel))
+                continue;
+
+            std::vector<uint256> digests (slices.size ());
+            detail::sha512HalfBatch (k.kernel,
+                slices.data (), digests.data (), slices.size ());
+            BEAST_EXPECTS (digests == expected, k.name);
+        }
+
+        std::vector<uint256> digests (slices.size ());
+        sha512HalfBatch (slices.data (), digests.data (), slices.size ());
+        BEAST_EXPECT (digests == expected);
+    }
+
+    void
+    testKnownAnswer ()
+    {
+        testcase ("known answer");
+
+        // The first half of SHA-512("abc")
+        uint256 expected;
+        BEAST_EXPECT (expected.SetHex (
+            "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"));
+
+        std::vector<Blob> messages (9, Blob { 'a', 'b', 'c' });
+        auto const slices = makeSlices (messages);
+
+        for (auto const& k : kernels)
+        {
+            if (! detail::sha512HalfBatchSupported (k.kernel))
+                continue;
+
+            std::vector<uint256> digests (slices.size ());
+            detail::sha512HalfBatch (k.kernel,
+                slices.data (), digests.data (), slices.size ());
+            for (auto const& d : digests)
+                BEAST_EXPECTS (d == expected, k.name);
+        }
+    }
+
+    void
+    testLengths ()
+    {
+        testcase ("lengths");
+
+        // Every length around the one and two block boundaries, in
+        // groups that fill and underfill the lanes.
+        std::vector<Blob> messages;
+        for (std::size_t size = 0; size != 300; ++size)
+            messages.push_back (randomBlob (size));
+        check (messages);
+
+        for (std::size_t count = 0; count != 20; ++count)
+        {
+            for (std::size_t size : { 0, 111, 112, 128, 239, 240, 516 })
+            {
+                messages.clear ();
+                for (std::size_t i = 0; i != count; ++i)
+                    messages.push_back (randomBlob (size));
+                check (messages);
+            }
+        }
+    }
+
+    void
+    testMixed ()
+    {
+        testcase ("mixed lengths");
+
+        std::uniform_int_distribution<std::size_t> size (0, 1200);
+        for (int i = 0; i != 50; ++i)
+        {
+            std::vector<Blob> messages;
+            auto const count = size (g_) % 40;
+            for (std::size_t j = 0; j != count; ++j)
+                messages.push_back (randomBlob (size (g_)));
+            check (messages);
+        }
+    }
+
+public:
+    void
+    run () override
+    {
+        testKnownAnswer ();
+        testLengths ();
+        testMixed ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(digest_batch,ripple_data,ripple);
+
+//------------------------------------------------------------------------------
+
+// Measures sha512HalfBatch throughput for each kernel
+class digest_batch_bench_test : public beast::unit_test::suite
+{
+    void
+    measure (char const* label, std::vector<Blob> const& messages)
+    {
+        using namespace std::chrono;
+
+        auto const slices = makeSlices (messages);
+        std::size_t bytes = 0;
+        for (auto const& s : slices)
+            bytes += s.size ();
+
+        std::vector<uint256> digests (slices.size ());
+
+        log << label << ": " << slices.size () << " messages, " <<
+            bytes << " bytes" << std::endl;
+
+        for (auto const& k : kernels)
+        {
+            if (! detail::sha512HalfBatchSupported (k.kernel))
+            {
+                log << "    " << k.name << ": not supported" << std::endl;
+                continue;
+            }
+
+            // Warm up, then keep the best of a few runs
+            detail::sha512HalfBatch (k.kernel,
+                slices.data (), digests.data (), slices.size ());
+
+            auto best = nanoseconds::max ();
+            for (int i = 0; i != 5; ++i)
+            {
+                auto const start = steady_clock::now ();
+                detail::sha512HalfBatch (k.kernel,
+                    slices.data (), digests.data (), slices.size ());
+                best = std::min (best, duration_cast<nanoseconds> (
+                    steady_clock::now () - start));
+            }
+
+            auto const secs = duration<double> (best).count ();
+            log << "    " << k.name << ": " <<
+                duration_cast<milliseconds> (best).count () << " ms, " <<
+                static_cast<std::size_t> (bytes / secs / 1e6) << " MB/s, " <<
+                static_cast<std::size_t> (slices.size () / secs) <<
+                " digests/s" << std::endl;
+        }
+    }
+
+public:
+    void
+    run () override
+    {
+        beast::xor_shift_engine g (19207813);
+        auto const make = [&g](std::size_t size)
+        {
+            Blob b (size);
+            beast::rngfill (b.data (), b.size (), g);
+            return b;
+        };
+
+        {
+            // Serialized inner nodes: prefix plus sixteen hashes
+            std::vector<Blob> messages;
+            for (int i = 0; i != 200000; ++i)
+                messages.push_back (make (4 + 16 * 32));
+            measure ("inner nodes", messages);
+        }
+
+        {
+            // Leaves of assorted sizes
+            std::uniform_int_distribution<std::size_t> size (64, 400);
+            std::vector<Blob> messages;
+            for (int i = 0; i != 200000; ++i)
+                messages.push_back (make (size (g)));
+            measure ("leaves", messages);
+        }
+
+        {
+            // Hashes of hashes
+            std::vector<Blob> messages;
+            for (int i = 0; i != 1000000; ++i)
+                messages.push_back (make (32));
+            measure ("32 bytes", messages);
+        }
+
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(digest_batch_bench,ripple_data,ripple);
+
+} // ripple
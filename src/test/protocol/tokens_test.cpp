@@ -0,0 +1,330 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/protocol/AccountID.h>
+#include <ripple/protocol/PublicKey.h>
+#include <ripple/protocol/SecretKey.h>
+#include <ripple/protocol/tokens.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <ripple/beast/unit_test.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+class tokens_test : public beast::unit_test::suite
+{
+    beast::xor_shift_engine g_{2904};
+
+    std::string
+    randomBytes (std::size_t size, std::size_t zeroes)
+    {
+        std::string s (size, '\0');
+        if (size > zeroes)
+            beast::rngfill (&s[zeroes], size - zeroes, g_);
+        return s;
+    }
+
+    void
+    testKnownValues ()
+    {
+        testcase ("known values");
+
+        BEAST_EXPECT(toBase58 (AccountID{}) ==
+            "rrrrrrrrrrrrrrrrrrrrrhoLvTp");
+        BEAST_EXPECT(toBase58 (AccountID{1}) ==
+            "rrrrrrrrrrrrrrrrrrrrBZbvji");
+
+        auto const genesis = parseBase58<AccountID> (
+            "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh");
+        BEAST_EXPECT(genesis);
+        BEAST_EXPECT(genesis && toBase58 (*genesis) ==
+            "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh");
+
+        // Wrong alphabet, bad checksum, bad character
+        BEAST_EXPECT(! parseBase58<AccountID> (
+            "1Hb9CJAWyB4rj91VRWn96DkukG4bwdtyTh"));
+        BEAST_EXPECT(! parseBase58<AccountID> (
+            "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTj"));
+        BEAST_EXPECT(! parseBase58<AccountID> (
+            "rHb9CJAWyB4rj91VRWn96DkukG4bwdty0h"));
+        BEAST_EXPECT(! parseBase58<AccountID> (""));
+
+        BEAST_EXPECT(detail::encodeBase58 ("", 0).empty ());
+        BEAST_EXPECT(detail::decodeBase58 ("").empty ());
+        BEAST_EXPECT(detail::encodeBase58 ("\0\0\x01", 3) == "rrp");
+        BEAST_EXPECT(detail::decodeBase58 ("rrp") ==
+            std::string ("\0\0\x01", 3));
+    }
+
+    void
+    testEncode ()
+    {
+        testcase ("encode");
+
+        // Every length up to and past the longest the fast
+        // conversion handles, with and without leading zeroes
+        for (std::size_t size = 0; size != 160; ++size)
+        {
+            for (std::size_t zeroes : { 0, 1, 3 })
+            {
+                auto const bytes =
+                    randomBytes (size, std::min (size, zeroes));
+                auto const fast = detail::encodeBase58 (
+                    bytes.data (), bytes.size ());
+                auto const reference = detail::encodeBase58 (
+                    bytes.data (), bytes.size (), true);
+                BEAST_EXPECT(fast == reference);
+                BEAST_EXPECT(detail::decodeBase58 (fast) == bytes);
+            }
+        }
+    }
+
+    void
+    testDecode ()
+    {
+        testcase ("decode");
+
+        std::string const alphabet =
+            "rpshnaf39wBUDNEGHJKLM4PQRST7VWXYZ2bcdeCg65jkm8oFqi1tuvAxyz";
+        std::uniform_int_distribution<std::size_t> pick (
+            0, alphabet.size () - 1);
+
+        for (std::size_t size = 0; size != 220; ++size)
+        {
+            std::string s;
+            for (std::size_t i = 0; i != size; ++i)
+                s += alphabet[pick (g_)];
+            BEAST_EXPECT(detail::decodeBase58 (s) ==
+                detail::decodeBase58 (s, true));
+
+            // Characters outside the alphabet
+            if (size != 0)
+            {
+                for (char c : { '0', 'O', 'I', 'l', '\0', '\xff' })
+                {
+                    auto t = s;
+                    t[pick (g_) % size] = c;
+                    BEAST_EXPECT(detail::decodeBase58 (t).empty ());
+                    BEAST_EXPECT(detail::decodeBase58 (t, true).empty ());
+                }
+            }
+        }
+    }
+
+    void
+    testTokens ()
+    {
+        testcase ("tokens");
+
+        for (int i = 0; i != 1000; ++i)
+        {
+            AccountID id;
+            beast::rngfill (id.data (), id.size (), g_);
+            // Leading zero bytes add leading 'r's
+            std::fill_n (id.data (), i % 4, 0);
+            auto const s = toBase58 (id);
+            BEAST_EXPECT(parseBase58<AccountID> (s) == id);
+
+            auto const pk = derivePublicKey (KeyType::secp256k1,
+                randomSecretKey ());
+            auto const n = toBase58 (TOKEN_NODE_PUBLIC, pk);
+            BEAST_EXPECT(parseBase58<PublicKey> (
+                TOKEN_NODE_PUBLIC, n) == pk);
+            BEAST_EXPECT(! parseBase58<PublicKey> (
+                TOKEN_ACCOUNT_PUBLIC, n));
+        }
+    }
+
+    void
+    testAccountIDCache ()
+    {
+        testcase ("AccountIDCache");
+
+        std::vector<AccountID> ids (64);
+        for (auto& id : ids)
+            beast::rngfill (id.data (), id.size (), g_);
+
+        {
+            AccountIDCache cache (16);
+            for (int round = 0; round != 3; ++round)
+                for (auto const& id : ids)
+                    BEAST_EXPECT(cache.toBase58 (id) == toBase58 (id));
+        }
+
+        // Threads racing over a few entries must never see
+        // another account's string
+        AccountIDCache cache (4);
+        std::atomic<int> errors {0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t != 4; ++t)
+        {
+            threads.emplace_back ([&, t]
+            {
+                for (int i = 0; i != 20000; ++i)
+                {
+                    auto const& id = ids[(i * (t + 1)) % ids.size ()];
+                    if (cache.toBase58 (id) != toBase58 (id))
+                        ++errors;
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join ();
+        BEAST_EXPECT(errors == 0);
+    }
+
+public:
+    void
+    run () override
+    {
+        testKnownValues ();
+        testEncode ();
+        testDecode ();
+        testTokens ();
+        testAccountIDCache ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(tokens,protocol,ripple);
+
+//------------------------------------------------------------------------------
+
+// Measures the base58 token conversions
+class tokens_bench_test : public beast::unit_test::suite
+{
+    template <class F>
+    void
+    measure (char const* label, std::size_t count, F&& f)
+    {
+        using namespace std::chrono;
+
+        // Warm up, then keep the best of a few runs
+        f ();
+        auto best = nanoseconds::max ();
+        for (int i = 0; i != 5; ++i)
+        {
+            auto const start = steady_clock::now ();
+            f ();
+            best = std::min (best, duration_cast<nanoseconds> (
+                steady_clock::now () - start));
+        }
+        log << "    " << label << ": " <<
+            best.count () / count << " ns" << std::endl;
+    }
+
+public:
+    void
+    run () override
+    {
+        beast::xor_shift_engine g (19207813);
+        std::size_t const count = 100000;
+
+        std::vector<AccountID> ids (count);
+        for (auto& id : ids)
+            beast::rngfill (id.data (), id.size (), g);
+        std::vector<std::string> idText;
+        for (auto const& id : ids)
+            idText.push_back (toBase58 (id));
+
+        std::vector<PublicKey> keys;
+        for (std::size_t i = 0; i != count / 10; ++i)
+            keys.push_back (derivePublicKey (
+                KeyType::secp256k1, randomSecretKey ()));
+        std::vector<std::string> keyText;
+        for (auto const& pk : keys)
+            keyText.push_back (toBase58 (TOKEN_NODE_PUBLIC, pk));
+
+        std::size_t sink = 0;
+
+        log << "AccountID" << std::endl;
+        measure ("toBase58", count, [&]
+        {
+            for (auto const& id : ids)
+                sink += toBase58 (id).size ();
+        });
+        measure ("parseBase58", count, [&]
+        {
+            for (auto const& s : idText)
+                sink += parseBase58<AccountID> (s) ? 1 : 0;
+        });
+        {
+            // The accounts in a busy server's responses come from a
+            // much smaller set than the cache holds
+            AccountIDCache cache (128000);
+            measure ("AccountIDCache::toBase58", count, [&]
+            {
+                for (std::size_t i = 0; i != count; ++i)
+                    sink += cache.toBase58 (ids[i % 10000]).size ();
+            });
+        }
+
+        log << "NodePublic" << std::endl;
+        measure ("toBase58", keys.size (), [&]
+        {
+            for (auto const& pk : keys)
+                sink += toBase58 (TOKEN_NODE_PUBLIC, pk).size ();
+        });
+        measure ("parseBase58", keys.size (), [&]
+        {
+            for (auto const& s : keyText)
+                sink += parseBase58<PublicKey> (
+                    TOKEN_NODE_PUBLIC, s) ? 1 : 0;
+        });
+
+        log << "Without type or checksum, 38 bytes" << std::endl;
+        std::vector<std::string> raw;
+        for (std::size_t i = 0; i != count; ++i)
+        {
+            std::string s (38, '\0');
+            beast::rngfill (&s[0], s.size (), g);
+            raw.push_back (std::move (s));
+        }
+        std::vector<std::string> rawText;
+        for (auto const& s : raw)
+            rawText.push_back (detail::encodeBase58 (s.data (), s.size ()));
+        for (bool reference : { true, false })
+        {
+            auto const name = reference ? "reference" : "fast";
+            measure ((std::string ("encode, ") + name).c_str (), count, [&]
+            {
+                for (auto const& s : raw)
+                    sink += detail::encodeBase58 (
+                        s.data (), s.size (), reference).size ();
+            });
+            measure ((std::string ("decode, ") + name).c_str (), count, [&]
+            {
+                for (auto const& s : rawText)
+                    sink += detail::decodeBase58 (s, reference).size ();
+            });
+        }
+
+        BEAST_EXPECT(sink != 0);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(tokens_bench,protocol,ripple);
+
+} // ripple
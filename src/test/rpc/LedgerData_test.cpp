@@ -21,6 +21,8 @@
 #include <ripple/protocol/Feature.h>
 #include <ripple/protocol/JsonFields.h>
 #include <test/jtx.h>
+#include <test/jtx/JSONRPCClient.h>
+#include <test/jtx/WSClient.h>
 
 namespace ripple {
 
@@ -426,6 +428,53 @@ public:
         }
     }
 
+    void testStreamed()
+    {
+        // Large replies are streamed over HTTP and WebSocket connections
+        // and must arrive the same as a reply built all at once.
+        using namespace test::jtx;
+        Env env {*this};
+
+        int const num_accounts = 300;
+        for (auto i = 0; i < num_accounts; i++)
+        {
+            Account const bob {std::string("bob") + std::to_string(i)};
+            env.fund(XRP(1000), bob);
+        }
+        env.close();
+
+        Json::Value jvParams;
+        jvParams[jss::ledger_index] = "current";
+        jvParams[jss::limit] = 2 * num_accounts;
+        auto const expected = env.rpc ( "json", "ledger_data",
+            boost::lexical_cast<std::string>(jvParams)) [jss::result];
+        BEAST_EXPECT( checkArraySize(expected[jss::state], num_accounts + 2) );
+
+        {
+            auto const client = test::makeJSONRPCClient(env.app().config());
+            auto const jrr = client->invoke("ledger_data", jvParams)[jss::result];
+            BEAST_EXPECT(jrr[jss::status] == "success");
+            BEAST_EXPECT(jrr[jss::state] == expected[jss::state]);
+            BEAST_EXPECT(jrr[jss::ledger] == expected[jss::ledger]);
+        }
+
+        {
+            auto const client = test::makeWSClient(env.app().config());
+            auto const jrr = client->invoke("ledger_data", jvParams)[jss::result];
+            BEAST_EXPECT(jrr[jss::status] == "success");
+            BEAST_EXPECT(jrr[jss::state] == expected[jss::state]);
+
+            // Errors keep their usual form
+            Json::Value jvBad;
+            jvBad[jss::marker] = "NOT_A_MARKER";
+            auto const jre = client->invoke("ledger_data", jvBad);
+            BEAST_EXPECT(jre[jss::status] == "error");
+            BEAST_EXPECT(jre[jss::error] == "invalidParams");
+            BEAST_EXPECT(jre[jss::result][jss::error_message] ==
+                "Invalid field 'marker', not valid.");
+        }
+    }
+
     void run()
     {
         testCurrentLedgerToLimits(true);
@@ -435,6 +484,7 @@ public:
         testMarkerFollow();
         testLedgerHeader();
         testLedgerType();
+        testStreamed();
     }
 };
 
@@ -0,0 +1,245 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/net/InfoSub.h>
+#include <ripple/server/WSSession.h>
+#include <ripple/beast/unit_test.h>
+#include <beast/core/multi_buffer.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace ripple {
+namespace test {
+
+namespace detail {
+
+// A transaction stream message of typical size and shape
+inline
+Json::Value
+makeTransactionMessage (int seq)
+{
+    Json::Value jv (Json::objectValue);
+    jv["type"] = "transaction";
+    jv["engine_result"] = "tesSUCCESS";
+    jv["engine_result_code"] = 0;
+    jv["engine_result_message"] =
+        "The transaction was applied. Only final in a validated ledger.";
+    jv["ledger_index"] = 30000000 + seq;
+    jv["validated"] = true;
+
+    auto& tx = jv["transaction"];
+    tx["Account"] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+    tx["Destination"] = "rPT1Sjq2YGrBMTttX4GZHjKu9dyfzbpAYe";
+    tx["Amount"]["currency"] = "USD";
+    tx["Amount"]["issuer"] = "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B";
+    tx["Amount"]["value"] = "1234.5678";
+    tx["Fee"] = "12";
+    tx["Flags"] = 2147483648u;
+    tx["Sequence"] = seq;
+    tx["SigningPubKey"] =
+        "0330E7FC9D56BB25D6893BA3F317AE5BCF33B3291BD63DB32654A313222F7FD020";
+    tx["TransactionType"] = "Payment";
+    tx["TxnSignature"] =
+        "3045022100D0A2C1A7E8F0F5B3B9A0E6B2F4B5D8C9E3A1F2B4C6D8E0F1A3B5C7D9"
+        "E1F3A5B702207F1E2D3C4B5A69788796A5B4C3D2E1F0A9B8C7D6E5F4A3B2C1D0E9"
+        "F8A7B6C5";
+    tx["hash"] =
+        "E08D6E9754025BA2534A78707605E0601F03ACE063687A0CA1BDDACFCD1698C7";
+
+    auto& nodes = jv["meta"]["AffectedNodes"];
+    for (int i = 0; i < 4; ++i)
+    {
+        auto& node = nodes[i]["ModifiedNode"];
+        node["LedgerEntryType"] = "RippleState";
+        node["LedgerIndex"] =
+            "5A7AF3ADC4F4C0A8A2D9F3B0B4C64E2E6F3B5A2D1E8C9A0F7B6D5C4E3F2A1B0C";
+        auto& fields = node["FinalFields"];
+        fields["Balance"]["currency"] = "USD";
+        fields["Balance"]["issuer"] = "rrrrrrrrrrrrrrrrrrrrBZbvji";
+        fields["Balance"]["value"] = "-98765.4321";
+        fields["Flags"] = 131072;
+        fields["HighLimit"]["currency"] = "USD";
+        fields["HighLimit"]["issuer"] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+        fields["HighLimit"]["value"] = "1000000";
+        fields["LowLimit"]["currency"] = "USD";
+        fields["LowLimit"]["issuer"] = "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B";
+        fields["LowLimit"]["value"] = "0";
+        node["PreviousTxnID"] =
+            "A1B2C3D4E5F60718293A4B5C6D7E8F90A1B2C3D4E5F60718293A4B5C6D7E8F90";
+        node["PreviousTxnLgrSeq"] = 29999999;
+    }
+    jv["meta"]["TransactionIndex"] = seq % 100;
+    jv["meta"]["TransactionResult"] = "tesSUCCESS";
+    return jv;
+}
+
+// Write a message out the way a session does, returning its text
+inline
+std::string
+drain (WSMsg& m, std::size_t chunk)
+{
+    std::string s;
+    for (;;)
+    {
+        auto const result = m.prepare (chunk, [](){});
+        for (auto const& b : result.second)
+            s.append (boost::asio::buffer_cast<char const*>(b),
+                boost::asio::buffer_size (b));
+        if (result.first)
+            break;
+    }
+    return s;
+}
+
+// Serialize for one subscriber, as each session used to
+inline
+std::shared_ptr<WSMsg>
+makeStreambufMsg (Json::Value const& jv)
+{
+    beast::multi_buffer sb;
+    Json::stream (jv,
+        [&](void const* data, std::size_t n)
+        {
+            sb.commit (boost::asio::buffer_copy (
+                sb.prepare (n), boost::asio::buffer (data, n)));
+        });
+    return std::make_shared<
+        StreambufWSMsg<decltype(sb)>>(std::move(sb));
+}
+
+} // detail
+
+class WSMsg_test : public beast::unit_test::suite
+{
+public:
+    void
+    testStringWSMsg ()
+    {
+        testcase ("StringWSMsg");
+
+        auto const jv = detail::makeTransactionMessage (1);
+        std::string expected;
+        Json::stream (jv,
+            [&expected](void const* data, std::size_t n)
+            {
+                expected.append (static_cast<char const*>(data), n);
+            });
+
+        InfoSub::Message const msg (jv);
+        BEAST_EXPECT(*msg.text() == expected);
+        // The text is serialized once and then shared
+        BEAST_EXPECT(msg.text() == msg.text());
+
+        // Any number of sessions can write the same payload,
+        // each at its own pace.
+        for (std::size_t chunk : {1, 7, 64, 1024, 1 << 20})
+        {
+            StringWSMsg m (msg.text());
+            BEAST_EXPECT(detail::drain (m, chunk) == expected);
+        }
+
+        {
+            StringWSMsg m (std::make_shared<std::string const>());
+            auto const result = m.prepare (1024, [](){});
+            BEAST_EXPECT(result.first == true);
+            BEAST_EXPECT(result.second.empty());
+        }
+    }
+
+    void
+    run () override
+    {
+        testStringWSMsg ();
+    }
+};
+
+// Compares the cost of publishing one ledger's worth of transactions
+// when each subscriber serializes its own copy against serializing
+// each message once and sharing it among all subscribers.
+class PublishCost_test : public beast::unit_test::suite
+{
+    static std::size_t constexpr txPerLedger = 100;
+
+    template <class Publish>
+    std::chrono::microseconds
+    measure (std::vector<Json::Value> const& txs,
+        std::size_t subscribers, Publish&& publish)
+    {
+        using namespace std::chrono;
+        std::vector<std::shared_ptr<WSMsg>> queue;
+        queue.reserve (subscribers);
+
+        auto const start = steady_clock::now ();
+        for (auto const& jv : txs)
+        {
+            queue.clear ();
+            publish (jv, subscribers, queue);
+            for (auto& m : queue)
+                detail::drain (*m, 4096);
+        }
+        return duration_cast<microseconds>(steady_clock::now () - start);
+    }
+
+public:
+    void
+    run () override
+    {
+        testcase ("publish cost per ledger");
+
+        std::vector<Json::Value> txs;
+        for (std::size_t i = 0; i < txPerLedger; ++i)
+            txs.push_back (detail::makeTransactionMessage (i));
+
+        for (std::size_t subscribers : {1, 10, 100, 1000, 5000})
+        {
+            auto const each = measure (txs, subscribers,
+                [](Json::Value const& jv, std::size_t n,
+                    std::vector<std::shared_ptr<WSMsg>>& queue)
+                {
+                    for (std::size_t i = 0; i < n; ++i)
+                        queue.push_back (detail::makeStreambufMsg (jv));
+                });
+
+            auto const shared = measure (txs, subscribers,
+                [](Json::Value const& jv, std::size_t n,
+                    std::vector<std::shared_ptr<WSMsg>>& queue)
+                {
+                    InfoSub::Message const msg (jv);
+                    for (std::size_t i = 0; i < n; ++i)
+                        queue.push_back (
+                            std::make_shared<StringWSMsg>(msg.text()));
+                });
+
+            log <<
+                "    " << subscribers << " subscriber(s): " <<
+                "serialize each " << each.count() << " us/ledger, " <<
+                "serialize once " << shared.count() << " us/ledger" <<
+                std::endl;
+        }
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(WSMsg,server,ripple);
+BEAST_DEFINE_TESTSUITE_MANUAL(PublishCost,server,ripple);
+
+} // test
+} // ripple
@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/shamap/SHAMap.h>
+#include <test/shamap/common.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+namespace tests {
+
+// Measures how SHAMap descent scales when many threads walk the
+// same map at once, both while child nodes are being canonicalized
+// from the NodeStore and once the tree is fully hooked up.
+class SHAMapConcurrency_test : public beast::unit_test::suite
+{
+    std::vector<uint256> keys_;
+
+    static Blob
+    makeData (beast::xor_shift_engine& g)
+    {
+        Blob data (64);
+        beast::rngfill (data.data(), data.size(), g);
+        return data;
+    }
+
+    // Look up every key, splitting the keys evenly among `threads`
+    // threads. Returns the elapsed wall clock time.
+    std::chrono::nanoseconds
+    lookup (SHAMap const& map, unsigned threads)
+    {
+        using namespace std::chrono;
+
+        std::atomic<std::size_t> found {0};
+        std::vector<std::thread> workers;
+        workers.reserve (threads);
+
+        auto const start = steady_clock::now ();
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            workers.emplace_back (
+                [&, t]()
+                {
+                    std::size_t n = 0;
+                    for (auto i = t; i < keys_.size(); i += threads)
+                    {
+                        if (map.hasItem (keys_[i]))
+                            ++n;
+                    }
+                    found += n;
+                });
+        }
+        for (auto& w : workers)
+            w.join ();
+        auto const elapsed = steady_clock::now () - start;
+
+        BEAST_EXPECT(found == keys_.size());
+        return duration_cast<nanoseconds>(elapsed);
+    }
+
+    void
+    report (char const* name, unsigned threads, std::chrono::nanoseconds d)
+    {
+        using namespace std::chrono;
+        auto const ms = duration_cast<milliseconds>(d).count();
+        auto const rate = d.count() == 0 ? 0 :
+            static_cast<std::uint64_t>(keys_.size() * 1e9 / d.count());
+        log <<
+            "    " << name << ", " << threads << " thread(s): " <<
+            ms << " ms, " << rate << " lookups/sec" << std::endl;
+    }
+
+    void
+    testScaling (SHAMap::version v)
+    {
+        testcase (v == SHAMap::version{2} ?
+            "descend, version 2" : "descend, version 1");
+
+        beast::Journal const j;
+        TestFamily f (j);
+
+        SHAMapHash rootHash;
+        {
+            beast::xor_shift_engine g (19207813);
+            SHAMap source (SHAMapType::STATE, f, v);
+            for (auto const& key : keys_)
+                source.addItem (SHAMapItem{key, makeData (g)}, false, false);
+            source.flushDirty (hotACCOUNT_NODE, 1);
+            rootHash = source.getHash ();
+        }
+
+        std::vector<unsigned> counts;
+        auto const cores = std::max (1u, std::thread::hardware_concurrency ());
+        for (unsigned t = 1; t < cores; t *= 2)
+            counts.push_back (t);
+        counts.push_back (cores);
+
+        for (auto const threads : counts)
+        {
+            // A fresh map has no children hooked up, so the first pass
+            // canonicalizes every inner node while the others descend.
+            SHAMap map (SHAMapType::STATE, rootHash.as_uint256(), f, v);
+            if (! BEAST_EXPECT(map.fetchRoot (rootHash, nullptr)))
+                return;
+            map.setImmutable ();
+
+            report ("cold", threads, lookup (map, threads));
+            report ("warm", threads, lookup (map, threads));
+        }
+    }
+
+public:
+    SHAMapConcurrency_test ()
+    {
+        beast::xor_shift_engine g (48271);
+        keys_.resize (250000);
+        for (auto& key : keys_)
+            beast::rngfill (key.data(), key.size(), g);
+    }
+
+    void
+    run () override
+    {
+        testScaling (SHAMap::version{1});
+        testScaling (SHAMap::version{2});
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapConcurrency,shamap,ripple);
+
+} // tests
+} // ripple
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/shamap/SHAMap.h>
+#include <test/shamap/common.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+namespace tests {
+
+// Measures how long it takes to hash, and to hash and store, every
+// node of a newly built state map as the number of flush threads
+// grows. The number of entries may be given as the argument, for
+// example: --unittest-arg=20000000
+class SHAMapFlush_test : public beast::unit_test::suite
+{
+    std::size_t entries_ = 1000000;
+
+    // Build a map whose nodes all need flushing
+    std::unique_ptr<SHAMap>
+    build (TestFamily& f)
+    {
+        beast::xor_shift_engine g (entries_);
+        auto map = std::make_unique<SHAMap> (SHAMapType::STATE, f,
+            SHAMap::version{1});
+        for (std::size_t i = 0; i < entries_; ++i)
+        {
+            uint256 key;
+            beast::rngfill (key.data(), key.size(), g);
+            Blob data (100);
+            beast::rngfill (data.data(), data.size(), g);
+            map->addItem (SHAMapItem{key, std::move (data)}, false, false);
+        }
+        return map;
+    }
+
+public:
+    void
+    run () override
+    {
+        using namespace std::chrono;
+        using clock_type = steady_clock;
+
+        if (! arg().empty())
+            entries_ = std::stoul (arg());
+
+        testcase ("flush " + std::to_string (entries_) + " entries");
+
+        beast::Journal const j;
+        TestFamily f (j);
+
+        // Hashing alone: a mutable snapshot clones and hashes every
+        // node, leaving the source map untouched.
+        auto const source = build (f);
+        SHAMapHash hash;
+        for (int threads : {1, 2, 4, 8, 16})
+        {
+            f.setFlushThreads (threads);
+            auto const start = clock_type::now ();
+            auto const copy = source->snapShot (true);
+            auto const elapsed = clock_type::now () - start;
+            if (hash.isZero ())
+                hash = copy->getHash ();
+            BEAST_EXPECT(copy->getHash () == hash);
+
+            log <<
+                "    hash, " << threads << " thread(s): " <<
+                duration_cast<milliseconds> (elapsed).count () <<
+                " ms" << std::endl;
+        }
+
+        for (int threads : {1, 2, 4, 8, 16})
+        {
+            f.setFlushThreads (threads);
+            auto const map = build (f);
+            auto const start = clock_type::now ();
+            map->flushDirty (hotACCOUNT_NODE, 1);
+            auto const elapsed = clock_type::now () - start;
+            BEAST_EXPECT(map->getHash () == hash);
+
+            log <<
+                "    hash and store, " << threads << " thread(s): " <<
+                duration_cast<milliseconds> (elapsed).count () <<
+                " ms" << std::endl;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapFlush,shamap,ripple);
+
+} // tests
+} // ripple
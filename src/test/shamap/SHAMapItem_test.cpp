@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/shamap/SHAMapItem.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <set>
+#include <thread>
+
+namespace ripple {
+namespace tests {
+
+class SHAMapItem_test : public beast::unit_test::suite
+{
+    static
+    Blob
+    makeData (std::size_t size, beast::xor_shift_engine& g)
+    {
+        Blob data (size);
+        beast::rngfill (data.data(), data.size(), g);
+        return data;
+    }
+
+    void
+    testMake ()
+    {
+        testcase ("make");
+
+        beast::xor_shift_engine g (7);
+        uint256 key;
+        beast::rngfill (key.data(), key.size(), g);
+
+        // Every size class boundary, and sizes too large for any of them
+        for (std::size_t size : {0, 1, 12, 63, 64, 65, 128, 129, 500,
+            1023, 1024, 1025, 4096})
+        {
+            auto const data = makeData (size, g);
+            auto const item = make_shamapitem (key, makeSlice (data));
+            BEAST_EXPECT(item->key() == key);
+            BEAST_EXPECT(item->size() == size);
+            BEAST_EXPECT(item->slice() == makeSlice (data));
+
+            // A copy owns its own data
+            SHAMapItem copy (*item);
+            BEAST_EXPECT(copy.key() == key);
+            BEAST_EXPECT(copy.slice() == makeSlice (data));
+            if (size != 0)
+                BEAST_EXPECT(copy.data() != item->data());
+        }
+    }
+
+    void
+    testValue ()
+    {
+        testcase ("value");
+
+        beast::xor_shift_engine g (11);
+        uint256 k1, k2;
+        beast::rngfill (k1.data(), k1.size(), g);
+        beast::rngfill (k2.data(), k2.size(), g);
+        auto const d1 = makeData (100, g);
+        auto const d2 = makeData (300, g);
+
+        SHAMapItem a (k1, d1);
+        SHAMapItem b (k2, d2);
+        BEAST_EXPECT(a.slice() == makeSlice (d1));
+
+        b = a;
+        BEAST_EXPECT(b.key() == k1);
+        BEAST_EXPECT(b.slice() == makeSlice (d1));
+        BEAST_EXPECT(b.data() != a.data());
+
+        auto const p = a.data();
+        SHAMapItem c (k2, d2);
+        c = std::move (a);
+        BEAST_EXPECT(c.key() == k1);
+        BEAST_EXPECT(c.data() == p);
+        BEAST_EXPECT(c.slice() == makeSlice (d1));
+
+        SHAMapItem d (std::move (c));
+        BEAST_EXPECT(d.key() == k1);
+        BEAST_EXPECT(d.slice() == makeSlice (d1));
+    }
+
+    void
+    testReuse ()
+    {
+        testcase ("reuse");
+
+        beast::xor_shift_engine g (13);
+        uint256 key;
+        beast::rngfill (key.data(), key.size(), g);
+
+        // Released items of the same size are recycled. A thread's
+        // cache can hold blocks no item used yet, so every block
+        // handed out over two rounds counts as seen.
+        std::set<void const*> seen;
+        std::vector<std::shared_ptr<SHAMapItem const>> items;
+        for (int round = 0; round < 2; ++round)
+        {
+            for (int i = 0; i < 100; ++i)
+                items.push_back (make_shamapitem (key, makeSlice (makeData (200, g))));
+            for (auto const& item : items)
+                seen.insert (item.get());
+            items.clear ();
+        }
+
+        std::size_t reused = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            auto const data = makeData (200, g);
+            items.push_back (make_shamapitem (key, makeSlice (data)));
+            BEAST_EXPECT(items.back()->slice() == makeSlice (data));
+            if (seen.count (items.back().get()))
+                ++reused;
+        }
+        BEAST_EXPECT(reused == 100);
+    }
+
+    void
+    testThreads ()
+    {
+        testcase ("threads");
+
+        // Each thread frees the items another thread made, while
+        // making its own, so blocks move between thread caches.
+        std::size_t const threads = 4;
+        std::vector<std::vector<std::shared_ptr<SHAMapItem const>>>
+            made (threads);
+        std::vector<std::vector<Blob>> data (threads);
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            beast::xor_shift_engine g (t + 1);
+            for (int i = 0; i < 2000; ++i)
+                data[t].push_back (makeData (g () % 1100, g));
+        }
+
+        auto make = [&](std::size_t t)
+        {
+            uint256 key;
+            key.data()[0] = static_cast<std::uint8_t> (t);
+            for (auto const& d : data[t])
+                made[t].push_back (make_shamapitem (key, makeSlice (d)));
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; ++t)
+            workers.emplace_back (make, t);
+        for (auto& w : workers)
+            w.join ();
+
+        std::vector<std::vector<std::shared_ptr<SHAMapItem const>>>
+            taken (threads);
+        for (std::size_t t = 0; t < threads; ++t)
+            taken[t] = std::move (made[t]);
+
+        workers.clear ();
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back ([&, t]
+            {
+                taken[(t + 1) % threads].clear ();
+                make (t);
+            });
+        }
+        for (auto& w : workers)
+            w.join ();
+
+        for (std::size_t t = 0; t < threads; ++t)
+        {
+            if (! BEAST_EXPECT(made[t].size () == data[t].size ()))
+                continue;
+            bool ok = true;
+            for (std::size_t i = 0; i < data[t].size (); ++i)
+                ok = ok && made[t][i]->slice () == makeSlice (data[t][i]) &&
+                    made[t][i]->key().data()[0] == t;
+            BEAST_EXPECT(ok);
+        }
+    }
+
+public:
+    void
+    run () override
+    {
+        testMake ();
+        testValue ();
+        testReuse ();
+        testThreads ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHAMapItem,shamap,ripple);
+
+} // tests
+} // ripple
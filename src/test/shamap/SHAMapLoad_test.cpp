@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2017 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+
+#include <BeastConfig.h>
+#include <ripple/basics/random.h>
+#include <ripple/shamap/SHAMap.h>
+#include <test/shamap/common.h>
+#include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <chrono>
+#include <vector>
+
+namespace ripple {
+namespace tests {
+
+// Measures the time taken to create leaf items, and to load a state
+// map from the NodeStore. The number of entries may be given as the
+// argument, for example: --unittest-arg=5000000
+class SHAMapLoad_test : public beast::unit_test::suite
+{
+    std::size_t entries_ = 1000000;
+
+    // Sizes typical of account state entries
+    static
+    Blob
+    makeData (beast::xor_shift_engine& g)
+    {
+        Blob data (rand_int (g, 80, 400));
+        beast::rngfill (data.data(), data.size(), g);
+        return data;
+    }
+
+    template <class Make>
+    void
+    testCreate (char const* name, Make&& make)
+    {
+        using namespace std::chrono;
+
+        beast::xor_shift_engine g (31);
+        std::vector<Blob> data;
+        std::vector<uint256> keys (100000);
+        for (auto& key : keys)
+        {
+            beast::rngfill (key.data(), key.size(), g);
+            data.push_back (makeData (g));
+        }
+
+        std::vector<std::shared_ptr<SHAMapItem const>> items;
+        items.reserve (keys.size());
+        auto const start = steady_clock::now ();
+        for (int pass = 0; pass < 10; ++pass)
+        {
+            for (std::size_t i = 0; i < keys.size(); ++i)
+                items.push_back (make (keys[i], makeSlice (data[i])));
+            items.clear ();
+        }
+        auto const elapsed = steady_clock::now () - start;
+
+        log <<
+            "    create " << name << ": " <<
+            duration_cast<nanoseconds> (elapsed).count () /
+                (10 * keys.size()) << " ns per item" << std::endl;
+        pass ();
+    }
+
+    void
+    testLoad ()
+    {
+        using namespace std::chrono;
+
+        beast::Journal const j;
+        TestFamily f (j);
+
+        SHAMapHash hash;
+        {
+            beast::xor_shift_engine g (entries_);
+            SHAMap source (SHAMapType::STATE, f, SHAMap::version{1});
+            for (std::size_t i = 0; i < entries_; ++i)
+            {
+                uint256 key;
+                beast::rngfill (key.data(), key.size(), g);
+                source.addItem (SHAMapItem{key, makeData (g)}, false, false);
+            }
+            source.flushDirty (hotACCOUNT_NODE, 1);
+            hash = source.getHash ();
+        }
+
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            // Start cold: every node comes from the NodeStore
+            f.treecache().clear ();
+            f.fullbelow().clear ();
+
+            auto const start = steady_clock::now ();
+            SHAMap map (SHAMapType::STATE, hash.as_uint256(), f,
+                SHAMap::version{1});
+            if (! BEAST_EXPECT(map.fetchRoot (hash, nullptr)))
+                return;
+            std::size_t count = 0;
+            for (auto const& item : map)
+            {
+                (void)item;
+                ++count;
+            }
+            auto const elapsed = steady_clock::now () - start;
+            BEAST_EXPECT(count == entries_);
+
+            log <<
+                "    load " << entries_ << " entries: " <<
+                duration_cast<milliseconds> (elapsed).count () <<
+                " ms" << std::endl;
+        }
+    }
+
+public:
+    void
+    run () override
+    {
+        if (! arg().empty())
+            entries_ = std::stoul (arg());
+
+        testcase ("create");
+        testCreate ("inline",
+            [](uint256 const& key, Slice data)
+            {
+                return make_shamapitem (key, data);
+            });
+        testCreate ("separate buffer",
+            [](uint256 const& key, Slice data)
+            {
+                return std::make_shared<SHAMapItem const> (key, data);
+            });
+
+        testcase ("load " + std::to_string (entries_) + " entries");
+        testLoad ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapLoad,shamap,ripple);
+
+} // tests
+} // ripple
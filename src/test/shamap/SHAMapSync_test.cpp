@@ -24,6 +24,8 @@
 #include <ripple/basics/random.h>
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/beast/unit_test.h>
+#include <algorithm>
+#include <limits>
 
 namespace ripple {
 namespace tests {
@@ -82,6 +84,171 @@ public:
         return true;
     }
 
+    // Fill a map with items whose keys depend only on their index
+    static void fillMap (SHAMap& map, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            Serializer s;
+            s.add32 (i);
+            s.add64 (i);
+            map.addItem (SHAMapItem (s.getSHA512Half (), s.peekData ()),
+                false, false);
+        }
+        map.getHash ();
+        map.setImmutable ();
+    }
+
+    // Start syncing destination from source's root node
+    void addRoot (SHAMap const& source, SHAMap& destination)
+    {
+        std::vector<SHAMapNodeID> nodeIDs;
+        std::vector<Blob> nodes;
+        destination.setSynching ();
+        BEAST_EXPECT(source.getNodeFat (
+            SHAMapNodeID (), nodeIDs, nodes, false, 0));
+        BEAST_EXPECT(destination.addRootNode (source.getHash (),
+            makeSlice (nodes.front ()), snfWIRE, nullptr).isGood ());
+    }
+
+    // Fetch, one level deep, the nodes destination is missing
+    void getMissing (SHAMap const& source, SHAMap& destination,
+        std::vector<SHAMapNodeID>& nodeIDs, std::vector<Blob>& nodes)
+    {
+        for (auto const& missing : destination.getMissingNodes (2048, nullptr))
+            BEAST_EXPECT(source.getNodeFat (
+                missing.first, nodeIDs, nodes, false, 0));
+        BEAST_EXPECT(nodeIDs.size () == nodes.size ());
+    }
+
+    void testAddKnownNodes (int version)
+    {
+        testcase ("addKnownNodes, version " + std::to_string (version));
+        SHAMap::version const v {version};
+
+        beast::Journal const j;
+        TestFamily f (j), f2 (j), f3 (j);
+        SHAMap source (SHAMapType::FREE, f, v);
+        fillMap (source, 1000);
+
+        // Every node of a batch is added
+        {
+            SHAMap destination (SHAMapType::FREE, f2, v);
+            addRoot (source, destination);
+
+            int batches = 0;
+            while (true)
+            {
+                std::vector<SHAMapNodeID> nodeIDs;
+                std::vector<Blob> nodes;
+                getMissing (source, destination, nodeIDs, nodes);
+                if (nodeIDs.empty ())
+                    break;
+
+                std::vector<std::pair<SHAMapNodeID, Slice>> batch;
+                for (std::size_t i = 0; i < nodeIDs.size (); ++i)
+                    batch.emplace_back (nodeIDs[i], makeSlice (nodes[i]));
+
+                auto const result = destination.addKnownNodes (batch, nullptr);
+                BEAST_EXPECT(result.getGood () ==
+                    static_cast<int> (batch.size ()));
+                BEAST_EXPECT(! result.isInvalid ());
+
+                // A batch of nodes already added is all duplicates
+                auto const again = destination.addKnownNodes (batch, nullptr);
+                BEAST_EXPECT(again.getGood () == 0);
+                BEAST_EXPECT(! again.isInvalid ());
+                ++batches;
+            }
+            BEAST_EXPECT(batches > 1);
+
+            destination.clearSynching ();
+            BEAST_EXPECT(source.deepCompare (destination));
+        }
+
+        // Adding stops after the first invalid node
+        {
+            SHAMap destination (SHAMapType::FREE, f3, v);
+            addRoot (source, destination);
+
+            std::vector<SHAMapNodeID> nodeIDs;
+            std::vector<Blob> nodes;
+            getMissing (source, destination, nodeIDs, nodes);
+            if (! BEAST_EXPECT(nodeIDs.size () > 4))
+                return;
+
+            // The third node carries the fourth node's data, which
+            // parses but does not match the hash its parent expects.
+            std::vector<std::pair<SHAMapNodeID, Slice>> batch;
+            for (std::size_t i = 0; i < nodeIDs.size (); ++i)
+                batch.emplace_back (nodeIDs[i],
+                    makeSlice (nodes[i == 2 ? 3 : i]));
+
+            auto const result = destination.addKnownNodes (batch, nullptr);
+            BEAST_EXPECT(result.isInvalid ());
+            BEAST_EXPECT(result.getGood () == 2);
+
+            // The nodes before the invalid one were added and the
+            // ones after it were not.
+            BEAST_EXPECT(! destination.addKnownNode (nodeIDs[0],
+                makeSlice (nodes[0]), nullptr).isUseful ());
+            BEAST_EXPECT(! destination.addKnownNode (nodeIDs[1],
+                makeSlice (nodes[1]), nullptr).isUseful ());
+            for (std::size_t i = 2; i < nodeIDs.size (); ++i)
+                BEAST_EXPECT(destination.addKnownNode (nodeIDs[i],
+                    makeSlice (nodes[i]), nullptr).isUseful ());
+        }
+    }
+
+    void testFetchPackResume (int version)
+    {
+        testcase ("getFetchPack resume, version " + std::to_string (version));
+        SHAMap::version const v {version};
+
+        beast::Journal const j;
+        TestFamily f (j);
+        SHAMap source (SHAMapType::FREE, f, v);
+        fillMap (source, 1000);
+        SHAMap have (SHAMapType::FREE, f, v);
+        fillMap (have, 900);
+
+        for (auto const* other : {&have, static_cast<SHAMap*> (nullptr)})
+        {
+            std::vector<uint256> all;
+            source.getFetchPack (other, true,
+                std::numeric_limits<int>::max (),
+                [&](SHAMapHash const& hash, Blob const&)
+                {
+                    all.push_back (hash.as_uint256 ());
+                });
+
+            // Small steps visit the same nodes, each step
+            // going past its limit by at most one node's children
+            std::vector<uint256> steps;
+            SHAMap::FetchPackStack stack;
+            int calls = 0;
+            bool done = false;
+            while (! done && calls < 10000)
+            {
+                auto const before = steps.size ();
+                done = source.getFetchPack (other, true, 10, stack,
+                    [&](SHAMapHash const& hash, Blob const&)
+                    {
+                        steps.push_back (hash.as_uint256 ());
+                    });
+                BEAST_EXPECT(steps.size () - before <= 10 + 16);
+                ++calls;
+            }
+            BEAST_EXPECT(done);
+            BEAST_EXPECT(calls > 1);
+
+            std::sort (all.begin (), all.end ());
+            std::sort (steps.begin (), steps.end ());
+            BEAST_EXPECT(! all.empty ());
+            BEAST_EXPECT(steps == all);
+        }
+    }
+
     void run()
     {
         log << "Run, version 1\n" << std::endl;
@@ -89,6 +256,12 @@ public:
 
         log << "Run, version 2\n" << std::endl;
         run(SHAMap::version{2});
+
+        testAddKnownNodes (1);
+        testAddKnownNodes (2);
+
+        testFetchPackResume (1);
+        testFetchPackResume (2);
     }
 
     void run(SHAMap::version v)
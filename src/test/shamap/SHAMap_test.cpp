@@ -23,6 +23,8 @@
 #include <ripple/basics/Blob.h>
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/beast/unit_test.h>
+#include <ripple/beast/utility/rngfill.h>
+#include <ripple/beast/xor_shift_engine.h>
 #include <ripple/beast/utility/Journal.h>
 
 namespace ripple {
@@ -124,6 +126,120 @@ public:
         run (false, SHAMap::version{1});
         run (true,  SHAMap::version{2});
         run (false, SHAMap::version{2});
+        testParallelFlush (SHAMap::version{1});
+        testParallelFlush (SHAMap::version{2});
+        testInnerNodes (SHAMap::version{1});
+        testInnerNodes (SHAMap::version{2});
+    }
+
+    void testInnerNodes (SHAMap::version v)
+    {
+        testcase (v == SHAMap::version{2} ?
+            "inner nodes, version 2" : "inner nodes, version 1");
+
+        beast::xor_shift_engine g (v == SHAMap::version{2} ? 4 : 3);
+        std::vector<uint256> keys (2000);
+        for (auto& key : keys)
+            beast::rngfill (key.data(), key.size(), g);
+
+        auto const before = SHAMapInnerNode::getMemoryUsage ();
+        {
+            tests::TestFamily f {beast::Journal{}};
+            SHAMap a {SHAMapType::STATE, f, v};
+            SHAMap b {SHAMapType::STATE, f, v};
+            for (auto const& key : keys)
+                a.addItem (SHAMapItem{key, IntToVUC(key.data()[1])}, false, false);
+
+            // Branches are packed in order whatever order they arrive in
+            for (auto it = keys.rbegin(); it != keys.rend(); ++it)
+                b.addItem (SHAMapItem{*it, IntToVUC(it->data()[1])}, false, false);
+            BEAST_EXPECT(a.getHash() == b.getHash());
+
+            // Removing branches and adding them back restores the map
+            for (std::size_t i = 0; i < keys.size(); i += 3)
+                BEAST_EXPECT(b.delItem (keys[i]));
+            BEAST_EXPECT(a.getHash() != b.getHash());
+            for (std::size_t i = 0; i < keys.size(); i += 3)
+                b.addItem (SHAMapItem{keys[i], IntToVUC(keys[i].data()[1])},
+                    false, false);
+            BEAST_EXPECT(a.getHash() == b.getHash());
+
+            int inner = 0;
+            a.visitNodes (
+                [&](SHAMapAbstractNode& node)
+                {
+                    if (node.isInner ())
+                        ++inner;
+                    return true;
+                });
+
+            // Sparse inner nodes use less than a full node each
+            auto const during = SHAMapInnerNode::getMemoryUsage ();
+            auto const nodes = during.nodes - before.nodes;
+            BEAST_EXPECT(nodes >= inner);
+            BEAST_EXPECT(during.bytes - before.bytes <
+                nodes * static_cast<std::int64_t>(SHAMapInnerNode::fullSize ()));
+            log << "inner nodes: " << nodes << ", " <<
+                (during.bytes - before.bytes) / nodes << " bytes each, " <<
+                SHAMapInnerNode::fullSize () << " when full" << std::endl;
+        }
+        auto const after = SHAMapInnerNode::getMemoryUsage ();
+        BEAST_EXPECT(after.nodes == before.nodes);
+        BEAST_EXPECT(after.bytes == before.bytes);
+    }
+
+    void testParallelFlush (SHAMap::version v)
+    {
+        testcase (v == SHAMap::version{2} ?
+            "parallel flush, version 2" : "parallel flush, version 1");
+
+        beast::xor_shift_engine g (v == SHAMap::version{2} ? 2 : 1);
+        std::vector<uint256> keys (3000);
+        for (auto& key : keys)
+            beast::rngfill (key.data(), key.size(), g);
+
+        tests::TestFamily serial {beast::Journal{}};
+        tests::TestFamily parallel {beast::Journal{}};
+        parallel.setFlushThreads (4);
+
+        SHAMap a {SHAMapType::STATE, serial, v};
+        SHAMap b {SHAMapType::STATE, parallel, v};
+        for (auto const& key : keys)
+        {
+            a.addItem (SHAMapItem{key, IntToVUC(key.data()[0])}, false, false);
+            b.addItem (SHAMapItem{key, IntToVUC(key.data()[0])}, false, false);
+        }
+
+        auto const flushed = a.flushDirty (hotACCOUNT_NODE, 1);
+        BEAST_EXPECT(b.flushDirty (hotACCOUNT_NODE, 1) == flushed);
+        BEAST_EXPECT(flushed > keys.size());
+        BEAST_EXPECT(a.getHash() == b.getHash());
+
+        // Change some of the map through a snapshot, so that
+        // unmodified nodes are shared and modified ones cloned
+        auto const c = b.snapShot (true);
+        for (std::size_t i = 0; i < keys.size(); i += 7)
+        {
+            BEAST_EXPECT(c->updateGiveItem (std::make_shared<SHAMapItem> (
+                keys[i], IntToVUC(i)), false, false));
+            BEAST_EXPECT(a.updateGiveItem (std::make_shared<SHAMapItem> (
+                keys[i], IntToVUC(i)), false, false));
+        }
+        BEAST_EXPECT(c->flushDirty (hotACCOUNT_NODE, 2) ==
+            a.flushDirty (hotACCOUNT_NODE, 2));
+        BEAST_EXPECT(a.getHash() == c->getHash());
+        BEAST_EXPECT(a.getHash() != b.getHash());
+
+        // Every node was written
+        std::size_t missing = 0;
+        c->visitNodes (
+            [&](SHAMapAbstractNode& node)
+            {
+                if (! parallel.db().fetch (node.getNodeHash().as_uint256()))
+                    ++missing;
+                return true;
+            });
+        BEAST_EXPECT(missing == 0);
     }
 
     void run (bool backed, SHAMap::version v)
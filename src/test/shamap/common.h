@@ -39,6 +39,7 @@ private:
     RootStoppable parent_;
     std::unique_ptr<NodeStore::Database> db_;
     beast::Journal j_;
+    FlushPool flushPool_ {1};
 
 public:
     TestFamily (beast::Journal j)
@@ -102,6 +103,18 @@ public:
         return *db_;
     }
 
+    FlushPool&
+    flushPool() override
+    {
+        return flushPool_;
+    }
+
+    void
+    setFlushThreads (int threads)
+    {
+        flushPool_.setThreads (threads);
+    }
+
     void
     missing_node (std::uint32_t refNum) override
     {
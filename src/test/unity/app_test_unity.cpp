@@ -27,19 +27,23 @@
 #include <test/app/Freeze_test.cpp>
 #include <test/app/HashRouter_test.cpp>
 #include <test/app/LedgerLoad_test.cpp>
+#include <test/app/LedgerSaver_test.cpp>
 #include <test/app/LoadFeeTrack_test.cpp>
 #include <test/app/Manifest_test.cpp>
 #include <test/app/MultiSign_test.cpp>
 #include <test/app/OfferStream_test.cpp>
 #include <test/app/Offer_test.cpp>
+#include <test/app/OrderBookDB_test.cpp>
 #include <test/app/OversizeMeta_test.cpp>
 #include <test/app/Path_test.cpp>
+#include <test/app/PathRequests_test.cpp>
 #include <test/app/PayChan_test.cpp>
 #include <test/app/PayStrand_test.cpp>
 #include <test/app/Regression_test.cpp>
 #include <test/app/SetAuth_test.cpp>
 #include <test/app/SetRegularKey_test.cpp>
 #include <test/app/SHAMapStore_test.cpp>
+#include <test/app/SignatureVerifier_test.cpp>
 #include <test/app/Escrow_test.cpp>
 #include <test/app/Taker_test.cpp>
 #include <test/app/Transaction_ordering_test.cpp>
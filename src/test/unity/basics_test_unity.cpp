@@ -22,6 +22,7 @@
 #include <test/basics/Buffer_test.cpp>
 #include <test/basics/CheckLibraryVersions_test.cpp>
 #include <test/basics/contract_test.cpp>
+#include <test/basics/flat_hash_map_test.cpp>
 #include <test/basics/hardened_hash_test.cpp>
 #include <test/basics/KeyCache_test.cpp>
 #include <test/basics/mulDiv_test.cpp>
@@ -29,3 +30,4 @@
 #include <test/basics/Slice_test.cpp>
 #include <test/basics/StringUtilities_test.cpp>
 #include <test/basics/TaggedCache_test.cpp>
+#include <test/basics/TaggedCacheContention_test.cpp>
@@ -21,6 +21,7 @@
 #include <test/nodestore/Backend_test.cpp>
 #include <test/nodestore/Basics_test.cpp>
 #include <test/nodestore/Database_test.cpp>
+#include <test/nodestore/DatabaseShard_test.cpp>
 #include <test/nodestore/import_test.cpp>
 #include <test/nodestore/Timing_test.cpp>
 #include <test/nodestore/varint_test.cpp>
\ No newline at end of file
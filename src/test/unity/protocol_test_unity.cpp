@@ -20,6 +20,7 @@
 
 #include <test/protocol/BuildInfo_test.cpp>
 #include <test/protocol/digest_test.cpp>
+#include <test/protocol/digest_batch_test.cpp>
 #include <test/protocol/InnerObjectFormats_test.cpp>
 #include <test/protocol/IOUAmount_test.cpp>
 #include <test/protocol/Issue_test.cpp>
@@ -32,5 +33,6 @@
 #include <test/protocol/STObject_test.cpp>
 #include <test/protocol/STTx_test.cpp>
 #include <test/protocol/TER_test.cpp>
+#include <test/protocol/tokens_test.cpp>
 #include <test/protocol/types_test.cpp>
 #include <test/protocol/XRPAmount_test.cpp>
\ No newline at end of file
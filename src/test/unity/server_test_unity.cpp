@@ -20,3 +20,4 @@
 
 #include <test/server/Server_test.cpp>
 #include <test/server/ServerStatus_test.cpp>
+#include <test/server/WSMsg_test.cpp>
@@ -19,5 +19,9 @@
 //==============================================================================
 
 #include <test/shamap/FetchPack_test.cpp>
+#include <test/shamap/SHAMapConcurrency_test.cpp>
+#include <test/shamap/SHAMapFlush_test.cpp>
+#include <test/shamap/SHAMapItem_test.cpp>
+#include <test/shamap/SHAMapLoad_test.cpp>
 #include <test/shamap/SHAMapSync_test.cpp>
 #include <test/shamap/SHAMap_test.cpp>
\ No newline at end of file